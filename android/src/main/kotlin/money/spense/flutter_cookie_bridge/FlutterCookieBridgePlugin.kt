@@ -1,5 +1,7 @@
 package money.spense.flutter_cookie_bridge
 
+import android.net.Uri
+import android.webkit.CookieManager
 import androidx.annotation.NonNull
 
 import io.flutter.embedding.engine.plugins.FlutterPlugin
@@ -22,13 +24,72 @@ class FlutterCookieBridgePlugin: FlutterPlugin, MethodCallHandler {
   }
 
   override fun onMethodCall(call: MethodCall, result: Result) {
-    if (call.method == "getPlatformVersion") {
-      result.success("Android ${android.os.Build.VERSION.RELEASE}")
-    } else {
-      result.notImplemented()
+    when (call.method) {
+      "getPlatformVersion" -> {
+        result.success("Android ${android.os.Build.VERSION.RELEASE}")
+      }
+      "syncCookies" -> {
+        val url = call.argument<String>("url")
+        val cookies = call.argument<Map<String, String>>("cookies")
+        if (url == null || cookies == null) {
+          result.error("BAD_ARGUMENTS", "Expected a url string and a cookies map", null)
+          return
+        }
+        result.success(syncCookies(url, cookies))
+      }
+      else -> result.notImplemented()
     }
   }
 
+  /// Makes [cookies] the host-only cookies with path / that the WebView holds
+  /// for the host of [url], touching only the ones that differ, and returns
+  /// how many were set or removed.
+  ///
+  /// CookieManager only reports names and values, so a stale name may belong
+  /// to a parent domain or a narrower path that no setCookie call can reach;
+  /// removals are counted by what actually left the WebView.
+  private fun syncCookies(url: String, cookies: Map<String, String>): Int {
+    val manager = CookieManager.getInstance()
+    if (Uri.parse(url).host == null) return 0
+    val existing = readCookies(manager, url)
+
+    var changed = 0
+    for ((name, value) in cookies) {
+      if (existing[name]?.contains(value) != true) {
+        manager.setCookie(url, "$name=$value; Path=/")
+        changed++
+      }
+    }
+    val stale = existing.keys.filter { !cookies.containsKey(it) }
+    if (stale.isNotEmpty()) {
+      for (name in stale) {
+        manager.setCookie(url, "$name=; Path=/; Max-Age=0")
+      }
+      val remaining = readCookies(manager, url)
+      for (name in stale) {
+        changed += existing.getValue(name).size - (remaining[name]?.size ?: 0)
+      }
+    }
+    if (changed > 0) {
+      manager.flush()
+    }
+    return changed
+  }
+
+  /// The values CookieManager sends to [url], by name; a name that several
+  /// domains or paths set has several values.
+  private fun readCookies(manager: CookieManager, url: String): Map<String, List<String>> {
+    val cookies = HashMap<String, MutableList<String>>()
+    manager.getCookie(url)?.split(';')?.forEach { pair ->
+      val separator = pair.indexOf('=')
+      if (separator > 0) {
+        cookies.getOrPut(pair.substring(0, separator).trim()) { ArrayList() }
+          .add(pair.substring(separator + 1).trim())
+      }
+    }
+    return cookies
+  }
+
   override fun onDetachedFromEngine(binding: FlutterPlugin.FlutterPluginBinding) {
     channel.setMethodCallHandler(null)
   }
@@ -0,0 +1,148 @@
+// Measures what content coding saves on the wire and costs in CPU: GETs of a
+// transaction history of about 4 MiB through NetworkManager from a server
+// that gzips responses for clients that accept it, first accepting no
+// coding and then the default ones; and POSTs of a body of about 150 KiB
+// sent as it is and then gzipped.
+//
+// For each phase it records the wall time per request and, from
+// NetworkManager.compressionStats, the bytes of the bodies against the
+// bytes on the wire and the CPU time the codecs took.
+//
+// Run on Linux, where the plugin's native library is loaded:
+// $ flutter drive --driver=test_driver/integration_test.dart \
+//     --target=integration_test/compression_benchmark_test.dart -d linux
+// The results are written under "compression" to
+// build/integration_response_data.json, and printed as one JSON line
+// starting with "BENCHMARK ", so runs of two versions can be diffed.
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/native_http_client_adapter.dart';
+import 'package:flutter_cookie_bridge/network_manager.dart';
+
+const int _warmup = 2;
+const int _requests = 20;
+const int _payloadBytes = 4 << 20;
+const String _host = '127.0.0.1';
+
+Map<String, int> _percentiles(List<int> samples) {
+  final sorted = [...samples]..sort();
+  int at(double fraction) => sorted[((sorted.length - 1) * fraction).round()];
+  return {'p50': at(0.5), 'p90': at(0.9), 'max': sorted.last};
+}
+
+String _transactions() {
+  final text = StringBuffer('{"account":"XX1234","transactions":[');
+  for (int i = 0; text.length < _payloadBytes; i++) {
+    text
+      ..write(i == 0 ? '{' : ',{')
+      ..write('"id":${1000000 + i},"amount":${i % 10000}.${i % 100},')
+      ..write('"currency":"INR","booked":${i % 7 != 0},')
+      ..write('"memo":"UPI/${i * 7919}/Caf\\u00e9 payment",')
+      ..write('"tags":["upi","food"]}');
+  }
+  text.write(']}');
+  return text.toString();
+}
+
+Map<String, dynamic> _upload() => {
+      'events': [
+        for (int i = 0; i < 2500; i++)
+          {'id': i, 'screen': 'transactions', 'action': 'scroll', 'ms': i % 97}
+      ],
+    };
+
+// Runs [request] [_warmup] + [_requests] times and summarizes the timed
+// runs with what the transport counted for them.
+Future<Map<String, Object>> _phase(
+    NetworkManager manager, Future<void> Function(int i) request) async {
+  for (int i = 0; i < _warmup; i++) {
+    await request(i);
+  }
+  final before = await manager.compressionStats(host: _host);
+  final wall = <int>[];
+  for (int i = 0; i < _requests; i++) {
+    final clock = Stopwatch()..start();
+    await request(_warmup + i);
+    wall.add(clock.elapsedMicroseconds);
+  }
+  final after = await manager.compressionStats(host: _host);
+  return {
+    'wall_us': _percentiles(wall),
+    'request_bytes': after.requestBytes - before.requestBytes,
+    'request_wire_bytes': after.requestWireBytes - before.requestWireBytes,
+    'response_bytes': after.responseBytes - before.responseBytes,
+    'response_wire_bytes':
+        after.responseWireBytes - before.responseWireBytes,
+    'encode_cpu_us': (after.encodeCpu - before.encodeCpu).inMicroseconds,
+    'decode_cpu_us': (after.decodeCpu - before.decodeCpu).inMicroseconds,
+  };
+}
+
+void main() {
+  final binding = IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('compression benchmark', (WidgetTester tester) async {
+    final body = utf8.encode(_transactions());
+    final server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    // Gzips responses for requests whose Accept-Encoding has gzip.
+    server.autoCompress = true;
+    server.listen((request) async {
+      if (request.method == 'POST') {
+        int received = 0;
+        await for (final chunk in request) {
+          received += chunk.length;
+        }
+        request.response.write('{"received":$received}');
+      } else {
+        request.response
+          ..headers.contentType = ContentType.json
+          ..add(body);
+      }
+      await request.response.close();
+    });
+    final base = 'http://$_host:${server.port}';
+
+    final manager = NetworkManager();
+    final results = <String, Object>{
+      'platform': Platform.operatingSystem,
+      'requests': _requests,
+      'payload_bytes': body.length,
+    };
+    await tester.runAsync(() async {
+      await manager.configureCompression(host: _host, accept: []);
+      results['get_identity'] = await _phase(manager, (i) async {
+        final response = await manager.get('$base/history?identity=$i');
+        expect(response!.statusCode, 200);
+      });
+      await manager.resetCompression(_host);
+      results['get_negotiated'] = await _phase(manager, (i) async {
+        final response = await manager.get('$base/history?negotiated=$i');
+        expect(response!.statusCode, 200);
+      });
+
+      results['post_identity'] = await _phase(manager, (i) async {
+        final response = await manager.post('$base/upload', _upload());
+        expect(response!.statusCode, 200);
+      });
+      await manager.configureCompression(
+          host: _host, requestEncoding: 'gzip', minRequestBytes: 1024);
+      results['post_gzip'] = await _phase(manager, (i) async {
+        final response = await manager.post('$base/upload', _upload());
+        expect(response!.statusCode, 200);
+      });
+      await manager.resetCompression(_host);
+      final CompressionStats total = await manager.compressionStats();
+      results['total_bytes_saved'] = total.bytesSaved;
+    });
+    await server.close(force: true);
+
+    binding.reportData = {'compression': results};
+    debugPrint('BENCHMARK ${jsonEncode(results)}');
+  });
+}
@@ -0,0 +1,141 @@
+// Measures what decoding a large JSON response costs the UI isolate: GETs of
+// a transaction history of about 8 MiB through NetworkManager, decoded the
+// usual way into maps and lists, against the same GETs with
+// Options(extra: {'lazyJson': true}), which hand over a JsonDocument parsed
+// off the UI isolate. Requests alternate between the two so that both see
+// the same machine noise.
+//
+// For each request it records the wall time, the longest gap between ticks
+// of a 1 ms timer on the UI isolate (how long it was blocked) and the
+// growth of the resident set over the request, sampled on every tick. The
+// lazy side also reads one field, as a screen would.
+//
+// Run on Linux, where the plugin's native library is loaded:
+// $ flutter drive --driver=test_driver/integration_test.dart \
+//     --target=integration_test/json_decoding_benchmark_test.dart -d linux
+// The results are written under "json_decoding" to
+// build/integration_response_data.json, and printed as one JSON line
+// starting with "BENCHMARK ", so runs of two versions can be diffed.
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/json_document.dart';
+import 'package:flutter_cookie_bridge/network_manager.dart';
+
+const int _warmup = 2;
+const int _requests = 20;
+const int _payloadBytes = 8 << 20;
+
+Map<String, int> _percentiles(List<int> samples) {
+  final sorted = [...samples]..sort();
+  int at(double fraction) => sorted[((sorted.length - 1) * fraction).round()];
+  return {'p50': at(0.5), 'p90': at(0.9), 'max': sorted.last};
+}
+
+String _transactions() {
+  final text = StringBuffer('{"account":"XX1234","transactions":[');
+  for (int i = 0; text.length < _payloadBytes; i++) {
+    text
+      ..write(i == 0 ? '{' : ',{')
+      ..write('"id":${1000000 + i},"amount":${i % 10000}.${i % 100},')
+      ..write('"currency":"INR","booked":${i % 7 != 0},')
+      ..write('"memo":"UPI/${i * 7919}/Caf\\u00e9 payment",')
+      ..write('"tags":["upi","food"]}');
+  }
+  text.write(']}');
+  return text.toString();
+}
+
+class _Sample {
+  int wallUs = 0;
+  int stallUs = 0;
+  int rssGrowth = 0;
+}
+
+// Runs [request] while a 1 ms timer watches the UI isolate.
+Future<_Sample> _measure(Future<void> Function() request) async {
+  final sample = _Sample();
+  final baseRss = ProcessInfo.currentRss;
+  final ticks = Stopwatch()..start();
+  int last = 0;
+  final timer = Timer.periodic(const Duration(milliseconds: 1), (_) {
+    final now = ticks.elapsedMicroseconds;
+    if (now - last > sample.stallUs) {
+      sample.stallUs = now - last;
+    }
+    last = now;
+    final growth = ProcessInfo.currentRss - baseRss;
+    if (growth > sample.rssGrowth) {
+      sample.rssGrowth = growth;
+    }
+  });
+  final clock = Stopwatch()..start();
+  await request();
+  sample.wallUs = clock.elapsedMicroseconds;
+  timer.cancel();
+  return sample;
+}
+
+void main() {
+  final binding = IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('json decoding benchmark', (WidgetTester tester) async {
+    final body = utf8.encode(_transactions());
+    final server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    server.listen((request) {
+      request.response
+        ..headers.contentType = ContentType.json
+        ..add(body)
+        ..close();
+    });
+    final base = 'http://127.0.0.1:${server.port}/transactions';
+
+    final manager = NetworkManager();
+    final eager = <_Sample>[];
+    final lazy = <_Sample>[];
+    await tester.runAsync(() async {
+      for (int i = 0; i < _warmup + _requests; i++) {
+        // Distinct URLs, so GETs are never coalesced.
+        final eagerSample = await _measure(() async {
+          final response = await manager.get('$base?i=$i');
+          final data = response!.data as Map<String, dynamic>;
+          expect((data['transactions'] as List)[1000]['id'], 1001000);
+        });
+        final lazySample = await _measure(() async {
+          final response = await manager.get('$base?i=$i',
+              options: Options(extra: {'lazyJson': true}));
+          final document = response!.data as JsonDocument;
+          expect(document.root['transactions']![1000]!['id']!.asInt, 1001000);
+        });
+        if (i >= _warmup) {
+          eager.add(eagerSample);
+          lazy.add(lazySample);
+        }
+      }
+    });
+    await server.close(force: true);
+
+    Map<String, Object> summary(List<_Sample> samples) => {
+          'wall_us': _percentiles([for (final s in samples) s.wallUs]),
+          'ui_stall_us': _percentiles([for (final s in samples) s.stallUs]),
+          'rss_growth_bytes':
+              _percentiles([for (final s in samples) s.rssGrowth]),
+        };
+    final results = {
+      'platform': Platform.operatingSystem,
+      'requests': _requests,
+      'payload_bytes': body.length,
+      'decoded': summary(eager),
+      'lazy_json': summary(lazy),
+    };
+    binding.reportData = {'json_decoding': results};
+    debugPrint('BENCHMARK ${jsonEncode(results)}');
+  });
+}
@@ -0,0 +1,78 @@
+// Compares the compiled navigation rules with the String.contains chain
+// the WebView ran on every navigation before them, across whitelist sizes.
+//
+// On Linux the rules run in the native library; elsewhere in Dart:
+// $ flutter test integration_test/navigation_rules_benchmark_test.dart
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/flutter_cookie_bridge_ffi.dart';
+import 'package:flutter_cookie_bridge/navigation_rules.dart';
+
+const String _hostName = 'app.example.com';
+
+List<String> _whitelist(int count) =>
+    List.generate(count, (i) => 'https://tenant$i.example.com');
+
+// The checks _shouldOverrideUrlLoading and _determineUserAgent made, up to
+// the whitelist; true when the URL may load in the WebView.
+bool _legacyChecks(String url, List<String> whitelist) {
+  if (url.contains('ms-outlook://') ||
+      url.contains('googlegmail://') ||
+      url.contains('ymail://') ||
+      url.contains('/redirect?status=') ||
+      url.contains('/session-expired?status=') ||
+      url.contains('/api/user/redirect') ||
+      url.contains('.pdf') ||
+      url.contains('/statements/') ||
+      url.contains('/download_statements') ||
+      url.contains('.jpeg') ||
+      url.contains('.png') ||
+      url.contains('sbmkyc')) {
+    return false;
+  }
+  return whitelist.any((white) => url.contains(white)) ||
+      url.contains(_hostName);
+}
+
+double _microsPerRun(bool Function() body) {
+  for (int i = 0; i < 200; i++) {
+    body();
+  }
+  const runs = 2000;
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < runs; i++) {
+    body();
+  }
+  return stopwatch.elapsedMicroseconds / runs;
+}
+
+void main() {
+  IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('navigation rules benchmark', (WidgetTester tester) async {
+    final where =
+        FlutterCookieBridgeBindings.instance == null ? 'dart' : 'native';
+    for (final size in [10, 100, 1000, 10000]) {
+      final whitelist = _whitelist(size);
+      // Only the last entry matches: the worst case for the chain.
+      final url = '${whitelist.last}/accounts/overview?session=${'a' * 32}';
+      final stopwatch = Stopwatch()..start();
+      final rules = NavigationRules(
+        whitelistedUrlsIos: whitelist,
+        hostName: _hostName,
+        karzaDomain: 'sbmkyc',
+      );
+      final compile = stopwatch.elapsedMicroseconds;
+      expect(rules.match(url).allowedOnIos, _legacyChecks(url, whitelist));
+
+      final legacy = _microsPerRun(() => _legacyChecks(url, whitelist));
+      final compiled = _microsPerRun(() => rules.match(url).allowedOnIos);
+      debugPrint('navigation x$size: contains chain '
+          '${legacy.toStringAsFixed(2)} us, compiled ($where) '
+          '${compiled.toStringAsFixed(2)} us, compile $compile us');
+    }
+  });
+}
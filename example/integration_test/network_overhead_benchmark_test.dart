@@ -0,0 +1,86 @@
+// Measures what the cookie bridge adds to each request: GETs through
+// NetworkManager (cookie lookup, scheduling, transport, Set-Cookie store)
+// against the same GETs through a plain Dio, both to a local server that
+// sets a cookie on every response. Requests alternate between the two so
+// that both see the same machine noise.
+//
+// Run on Linux, where the plugin's native library is loaded:
+// $ flutter drive --driver=test_driver/integration_test.dart \
+//     --target=integration_test/network_overhead_benchmark_test.dart -d linux
+// The results, in microseconds, are written under "network_overhead" to
+// build/integration_response_data.json, and printed as one JSON line
+// starting with "BENCHMARK ", so runs of two versions can be diffed.
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/network_manager.dart';
+
+const int _warmup = 200;
+const int _requests = 5000;
+
+Map<String, int> _percentiles(List<int> samples) {
+  final sorted = [...samples]..sort();
+  int at(double fraction) => sorted[((sorted.length - 1) * fraction).round()];
+  return {'p50': at(0.5), 'p99': at(0.99), 'p999': at(0.999)};
+}
+
+void main() {
+  final binding = IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('network overhead benchmark', (WidgetTester tester) async {
+    final server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    int served = 0;
+    server.listen((request) {
+      request.response
+        ..headers.contentType = ContentType.json
+        ..headers.add('set-cookie', 'session=${served++}; Path=/; HttpOnly')
+        ..write('{"ok":true}')
+        ..close();
+    });
+    final base = 'http://127.0.0.1:${server.port}/api';
+
+    final plain = Dio();
+    final manager = NetworkManager();
+    final baseline = <int>[];
+    final bridged = <int>[];
+    await tester.runAsync(() async {
+      for (int i = 0; i < _warmup + _requests; i++) {
+        // Distinct URLs, so GETs are never coalesced.
+        final url = '$base?i=$i';
+        final clock = Stopwatch()..start();
+        await plain.get(url);
+        final plainUs = clock.elapsedMicroseconds;
+        clock.reset();
+        final response = await manager.get(url);
+        final bridgedUs = clock.elapsedMicroseconds;
+        expect(response?.statusCode, 200);
+        if (i >= _warmup) {
+          baseline.add(plainUs);
+          bridged.add(bridgedUs);
+        }
+      }
+    });
+    await server.close(force: true);
+
+    final baselineUs = _percentiles(baseline);
+    final bridgedUs = _percentiles(bridged);
+    final results = {
+      'platform': Platform.operatingSystem,
+      'requests': _requests,
+      'baseline_us': baselineUs,
+      'bridge_us': bridgedUs,
+      'overhead_us': {
+        for (final key in baselineUs.keys)
+          key: bridgedUs[key]! - baselineUs[key]!,
+      },
+    };
+    binding.reportData = {'network_overhead': results};
+    debugPrint('BENCHMARK ${jsonEncode(results)}');
+  });
+}
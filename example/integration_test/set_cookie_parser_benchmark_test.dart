@@ -0,0 +1,79 @@
+// Compares the native Set-Cookie parser with the string splitting that
+// NetworkManager and the WebView cookie sync used before it.
+//
+// Run on Linux, where the plugin's native library is loaded:
+// $ flutter test integration_test/set_cookie_parser_benchmark_test.dart -d linux
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/flutter_cookie_bridge_ffi.dart';
+import 'package:flutter_cookie_bridge/set_cookie_parser.dart';
+
+List<String> _headers(int count) => List.generate(
+    count,
+    (i) => 'session_part_$i=${'v' * 48}$i; Domain=.example.com; '
+        'Path=/api/v$i; Expires=Wed, 21 Oct 2035 07:28:00 GMT; '
+        'Max-Age=3600; Secure; HttpOnly; SameSite=Lax');
+
+// The pre-parser code paths: keep only the name=value pair of each header,
+// then re-split the joined string the way the WebView sync did.
+int _legacySplit(List<String> headers) {
+  final pairs = <String>[];
+  for (final header in headers) {
+    final pair = header.split(';')[0];
+    if (pair.isNotEmpty && !pair.contains('redirect_url=')) {
+      pairs.add(pair);
+    }
+  }
+  int count = 0;
+  for (String cookie in Uri.decodeComponent(pairs.join('; ')).split(';')) {
+    cookie = cookie.trim();
+    final equals = cookie.indexOf('=');
+    if (equals > 0) {
+      cookie.substring(0, equals).trim();
+      cookie.substring(equals + 1).trim();
+      count++;
+    }
+  }
+  return count;
+}
+
+int _parser(List<String> headers) {
+  final cookies = SetCookieParser.parseAll(headers);
+  final joined = cookies.map((c) => c!.pair).join('; ');
+  return SetCookieParser.parseCookieHeader(joined).length;
+}
+
+double _microsPerRun(int Function(List<String>) body, List<String> headers) {
+  for (int i = 0; i < 20; i++) {
+    body(headers);
+  }
+  const runs = 200;
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < runs; i++) {
+    body(headers);
+  }
+  return stopwatch.elapsedMicroseconds / runs;
+}
+
+void main() {
+  IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('set-cookie parser benchmark', (WidgetTester tester) async {
+    expect(FlutterCookieBridgeBindings.instance, isNotNull,
+        reason: 'the native parser is only available on Linux');
+
+    for (final size in [100, 300, 600]) {
+      final headers = _headers(size);
+      expect(_parser(headers), _legacySplit(headers));
+
+      final legacy = _microsPerRun(_legacySplit, headers);
+      final native = _microsPerRun(_parser, headers);
+      debugPrint('set-cookie x$size: legacy split ${legacy.toStringAsFixed(1)}'
+          ' us, native parser ${native.toStringAsFixed(1)} us '
+          '(attributes kept: legacy no, native yes)');
+    }
+  });
+}
@@ -0,0 +1,85 @@
+// Builds Cookie headers from the process-wide native jar on 1..N isolates at
+// once, while the main isolate keeps storing cookies, to show that lookups
+// scale with cores instead of serializing on the jar.
+//
+// Run on Linux, where the plugin's native library is loaded:
+// $ flutter test integration_test/shared_cookie_jar_benchmark_test.dart -d linux
+
+import 'dart:io';
+import 'dart:isolate';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+
+import 'package:flutter_cookie_bridge/native_cookie_jar.dart';
+
+const int _lookupsPerIsolate = 200000;
+
+List<String> _urls() => List.generate(
+    16, (i) => 'https://api$i.example.com/v1/accounts/$i/transactions');
+
+// Runs on a worker isolate; returns the lookups per second it achieved.
+Future<double> _lookups(List<String> urls) {
+  return Isolate.run(() {
+    final stopwatch = Stopwatch()..start();
+    int found = 0;
+    for (int i = 0; i < _lookupsPerIsolate; i++) {
+      if (NativeCookieJar.cookieHeader(urls[i % urls.length]) != null) {
+        found++;
+      }
+    }
+    if (found != _lookupsPerIsolate) {
+      throw StateError('missing cookies: $found of $_lookupsPerIsolate');
+    }
+    return _lookupsPerIsolate / (stopwatch.elapsedMicroseconds / 1e6);
+  });
+}
+
+void main() {
+  IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  testWidgets('shared cookie jar isolate benchmark',
+      (WidgetTester tester) async {
+    expect(NativeCookieJar.isAvailable, isTrue,
+        reason: 'the native jar is only available on Linux');
+
+    final urls = _urls();
+    for (int i = 0; i < urls.length; i++) {
+      NativeCookieJar.setCookies(urls[i], [
+        for (int c = 0; c < 20; c++)
+          'cookie_$c=${'v' * 32}$i; Domain=example.com; Path=/',
+        'session=$i; Path=/v1',
+      ]);
+    }
+
+    final cores = Platform.numberOfProcessors;
+    double? single;
+    for (int isolates = 1; isolates <= cores; isolates *= 2) {
+      bool writing = true;
+      int writes = 0;
+      // Keeps a writer busy on the main isolate for the whole run.
+      final writer = Future.doWhile(() async {
+        NativeCookieJar.setCookies(urls[writes % urls.length],
+            ['rotating=${writes++}; Path=/']);
+        await Future<void>.delayed(Duration.zero);
+        return writing;
+      });
+
+      final stopwatch = Stopwatch()..start();
+      final rates =
+          await Future.wait(List.generate(isolates, (_) => _lookups(urls)));
+      final elapsed = stopwatch.elapsedMicroseconds / 1e6;
+      writing = false;
+      await writer;
+
+      final total = isolates * _lookupsPerIsolate / elapsed;
+      single ??= total;
+      final perIsolate = rates.reduce((a, b) => a + b) / isolates;
+      debugPrint('isolates=$isolates: ${total.toStringAsFixed(0)} lookups/s '
+          '(${(total / single).toStringAsFixed(2)}x of 1 isolate, '
+          '${perIsolate.toStringAsFixed(0)}/s per isolate, '
+          '$writes concurrent writes)');
+    }
+  });
+}
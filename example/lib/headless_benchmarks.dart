@@ -0,0 +1,186 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter/widgets.dart';
+import 'package:flutter_cookie_bridge/download_manager.dart';
+import 'package:flutter_cookie_bridge/native_cookie_jar.dart';
+import 'package:flutter_cookie_bridge/network_manager.dart';
+import 'package:flutter_cookie_bridge/set_cookie_parser.dart';
+
+// Benchmarks the headless runner (linux/headless_main.cc) runs when it is
+// given --benchmark=<name>. Each returns its results, with times in
+// microseconds; the runner prints them as JSON and exits.
+
+const String _argument = '--benchmark=';
+
+const MethodChannel _channel =
+    MethodChannel('flutter_cookie_bridge_example/headless');
+
+final Map<String, Future<Map<String, Object?>> Function()> _benchmarks = {
+  'cookies': _cookies,
+  'transport': _transport,
+  'downloads': _downloads,
+};
+
+/// The benchmark [arguments] ask for, or null to run the app.
+String? benchmarkFromArguments(List<String> arguments) {
+  for (final argument in arguments) {
+    if (argument.startsWith(_argument)) {
+      return argument.substring(_argument.length);
+    }
+  }
+  return null;
+}
+
+/// Runs the benchmark called [name] and hands its results to the runner.
+Future<void> runHeadlessBenchmark(String name) async {
+  WidgetsFlutterBinding.ensureInitialized();
+  int exitCode = 0;
+  Map<String, Object?> results;
+  try {
+    final benchmark = _benchmarks[name];
+    if (benchmark == null) {
+      throw ArgumentError('unknown benchmark "$name"; '
+          'known: ${_benchmarks.keys.join(', ')}');
+    }
+    results = {'benchmark': name, ...await benchmark()};
+  } catch (error) {
+    exitCode = 1;
+    results = {'benchmark': name, 'error': '$error'};
+  }
+  await _channel.invokeMethod<void>(
+      'finish', {'exitCode': exitCode, 'results': jsonEncode(results)});
+}
+
+Map<String, int> _percentiles(List<int> samples) {
+  final sorted = [...samples]..sort();
+  int at(double fraction) => sorted[((sorted.length - 1) * fraction).round()];
+  return {'p50': at(0.5), 'p99': at(0.99), 'p999': at(0.999)};
+}
+
+// Times [count] calls of [operation] one by one.
+Map<String, int> _time(int count, void Function(int i) operation) {
+  final samples = <int>[];
+  final clock = Stopwatch();
+  for (int i = 0; i < count; i++) {
+    clock
+      ..reset()
+      ..start();
+    operation(i);
+    samples.add(clock.elapsedMicroseconds);
+  }
+  return _percentiles(samples);
+}
+
+// The Dart side of the cookie path: parsing Set-Cookie headers, and storing
+// and looking up cookies in the native jar through dart:ffi.
+Future<Map<String, Object?>> _cookies() async {
+  const count = 20000;
+  final headers = List.generate(
+      10,
+      (i) => 'cookie_$i=${'v' * 32}; Domain=example.com; Path=/; '
+          'Max-Age=3600; Secure; HttpOnly');
+  final urls =
+      List.generate(100, (i) => 'https://api$i.example.com/v1/items/$i');
+  return {
+    'parse_us': _time(count, (_) => SetCookieParser.parseAll(headers)),
+    if (NativeCookieJar.isAvailable) ...{
+      'store_us': _time(count,
+          (i) => NativeCookieJar.setCookies(urls[i % urls.length], headers)),
+      'lookup_us': _time(
+          count, (i) => NativeCookieJar.cookieHeader(urls[i % urls.length])),
+    },
+  };
+}
+
+// Starts a local server that answers every request with [body] and a new
+// session cookie.
+Future<HttpServer> _serve(List<int> body) async {
+  final server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+  int served = 0;
+  server.listen((request) {
+    request.response
+      ..contentLength = body.length
+      ..headers.add('set-cookie', 'session=${served++}; Path=/; HttpOnly')
+      ..add(body)
+      ..close();
+  });
+  return server;
+}
+
+// GETs through NetworkManager next to the same GETs through a plain Dio.
+Future<Map<String, Object?>> _transport() async {
+  const warmup = 200;
+  const count = 5000;
+  final server = await _serve(utf8.encode('{"ok":true}'));
+  final base = 'http://127.0.0.1:${server.port}/api';
+  final plain = Dio();
+  final manager = NetworkManager();
+  final baseline = <int>[];
+  final bridged = <int>[];
+  try {
+    for (int i = 0; i < warmup + count; i++) {
+      final url = '$base?i=$i';
+      final clock = Stopwatch()..start();
+      await plain.get<String>(url);
+      final plainUs = clock.elapsedMicroseconds;
+      clock.reset();
+      final response = await manager.get(url);
+      final bridgedUs = clock.elapsedMicroseconds;
+      if (response?.statusCode != 200) {
+        throw StateError('GET $url failed: ${response?.statusCode}');
+      }
+      if (i >= warmup) {
+        baseline.add(plainUs);
+        bridged.add(bridgedUs);
+      }
+    }
+  } finally {
+    await server.close(force: true);
+  }
+  final baselineUs = _percentiles(baseline);
+  final bridgedUs = _percentiles(bridged);
+  return {
+    'requests': count,
+    'baseline_us': baselineUs,
+    'bridge_us': bridgedUs,
+    'overhead_us': {
+      for (final key in baselineUs.keys)
+        key: bridgedUs[key]! - baselineUs[key]!,
+    },
+  };
+}
+
+// Downloads of a 32 MiB file from a local server.
+Future<Map<String, Object?>> _downloads() async {
+  const count = 20;
+  const size = 32 << 20;
+  final server = await _serve(List.filled(size, 0x61));
+  final directory = await Directory.systemTemp.createTemp('downloads_');
+  final samples = <int>[];
+  try {
+    for (int i = 0; i < count; i++) {
+      final path = '${directory.path}/file$i';
+      final clock = Stopwatch()..start();
+      final result = await DownloadManager.instance
+          .download('http://127.0.0.1:${server.port}/file$i', path);
+      samples.add(clock.elapsedMicroseconds);
+      if (result.bytes != size) {
+        throw StateError('downloaded ${result.bytes} of $size bytes');
+      }
+      await File(path).delete();
+    }
+  } finally {
+    await server.close(force: true);
+    await directory.delete(recursive: true);
+  }
+  final times = _percentiles(samples);
+  return {
+    'downloads': count,
+    'bytes': size,
+    'time_us': times,
+    'p50_mib_per_s': size / (1 << 20) / (times['p50']! / 1e6),
+  };
+}
@@ -7,13 +7,19 @@ import 'package:flutter_cookie_bridge/web_view_callback.dart';
 import 'package:flutter_cookie_bridge/network_manager.dart';
 import 'package:flutter_cookie_bridge/flutter_cookie_bridge.dart';
 import 'package:flutter_cookie_bridge_example/DeviceInfoManager.dart';
+import 'package:flutter_cookie_bridge_example/headless_benchmarks.dart';
 import 'package:flutter_dotenv/flutter_dotenv.dart';
 import 'package:dart_jsonwebtoken/dart_jsonwebtoken.dart';
 import 'package:package_info_plus/package_info_plus.dart';
 
 final cookieBridge = FlutterCookieBridge();
 
-void main() async {
+void main(List<String> arguments) async {
+  final benchmark = benchmarkFromArguments(arguments);
+  if (benchmark != null) {
+    await runHeadlessBenchmark(benchmark);
+    return;
+  }
   await dotenv.load(fileName: "lib/.env");
 
   runApp(MyApp());
@@ -6,9 +6,13 @@
 
 #include "generated_plugin_registrant.h"
 
+#include <flutter_cookie_bridge/flutter_cookie_bridge_plugin.h>
 #include <url_launcher_linux/url_launcher_plugin.h>
 
 void fl_register_plugins(FlPluginRegistry* registry) {
+  g_autoptr(FlPluginRegistrar) flutter_cookie_bridge_registrar =
+      fl_plugin_registry_get_registrar_for_plugin(registry, "FlutterCookieBridgePlugin");
+  flutter_cookie_bridge_plugin_register_with_registrar(flutter_cookie_bridge_registrar);
   g_autoptr(FlPluginRegistrar) url_launcher_linux_registrar =
       fl_plugin_registry_get_registrar_for_plugin(registry, "UrlLauncherPlugin");
   url_launcher_plugin_register_with_registrar(url_launcher_linux_registrar);
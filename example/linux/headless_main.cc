@@ -0,0 +1,101 @@
+// Runs the example's Dart code on an engine with no window, so benchmarks
+// can run on a machine without an X or Wayland session:
+//
+//   $ flutter build linux --release
+//   $ cd build/linux/x64/release/bundle
+//   $ ./test_cookie_bridge_example_headless --benchmark=cookies
+//
+// The arguments go to Dart's main, which runs the named benchmark instead
+// of the app and sends its results back on kChannel. They are printed to
+// stdout as one line of JSON, and the process exits with the code Dart
+// reported.
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdio>
+
+#include <flutter_cookie_bridge/flutter_cookie_bridge_plugin.h>
+
+#include "flutter/generated_plugin_registrant.h"
+
+// Not in flutter_linux's public headers: a windowed app has FlView start
+// its engine when it is realized. The symbol is exported all the same, and
+// is how a headless engine gets started.
+extern "C" gboolean fl_engine_start(FlEngine* engine, GError** error);
+
+namespace {
+
+constexpr char kChannel[] = "flutter_cookie_bridge_example/headless";
+
+struct HeadlessRun {
+  GMainLoop* loop;
+  int exit_code;
+};
+
+// Handles finish({exitCode: int, results: String}), the last thing the
+// Dart side sends.
+void method_call_cb(FlMethodChannel* channel,
+                    FlMethodCall* method_call,
+                    gpointer user_data) {
+  HeadlessRun* run = static_cast<HeadlessRun*>(user_data);
+  g_autoptr(FlMethodResponse) response = nullptr;
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (g_strcmp0(fl_method_call_get_name(method_call), "finish") == 0 &&
+      fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* exit_code = fl_value_lookup_string(args, "exitCode");
+    FlValue* results = fl_value_lookup_string(args, "results");
+    run->exit_code =
+        exit_code != nullptr && fl_value_get_type(exit_code) ==
+                                    FL_VALUE_TYPE_INT
+            ? static_cast<int>(fl_value_get_int(exit_code))
+            : 1;
+    if (results != nullptr &&
+        fl_value_get_type(results) == FL_VALUE_TYPE_STRING) {
+      printf("%s\n", fl_value_get_string(results));
+      fflush(stdout);
+    }
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+    g_main_loop_quit(run->loop);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Plugins that keep per-app files find them under this name, apart from
+  // the windowed app's.
+  g_set_prgname(APPLICATION_ID ".headless");
+
+  flutter_cookie_bridge_plugin_trace_from_arguments(argv + 1);
+  flutter_cookie_bridge_plugin_preload_cookies();
+
+  g_autoptr(FlDartProject) project = fl_dart_project_new();
+  fl_dart_project_set_dart_entrypoint_arguments(project, argv + 1);
+  g_autoptr(FlEngine) engine = fl_engine_new_headless(project);
+
+  HeadlessRun run = {g_main_loop_new(nullptr, FALSE), 1};
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_autoptr(FlMethodChannel) channel =
+      fl_method_channel_new(fl_engine_get_binary_messenger(engine), kChannel,
+                            FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, &run,
+                                            nullptr);
+
+  fl_register_plugins(FL_PLUGIN_REGISTRY(engine));
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_engine_start(engine, &error)) {
+    g_warning("Failed to start the engine: %s", error->message);
+    g_main_loop_unref(run.loop);
+    return 1;
+  }
+  g_main_loop_run(run.loop);
+  g_main_loop_unref(run.loop);
+  return run.exit_code;
+}
@@ -5,6 +5,9 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include <flutter_cookie_bridge/flutter_cookie_bridge_ffi.h>
+#include <flutter_cookie_bridge/flutter_cookie_bridge_plugin.h>
+
 #include "flutter/generated_plugin_registrant.h"
 
 struct _MyApplication {
@@ -17,6 +20,7 @@ G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+  int64_t activate_start = flutter_cookie_bridge_trace_now();
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -49,6 +53,9 @@ static void my_application_activate(GApplication* application) {
 
   gtk_window_set_default_size(window, 1280, 720);
   gtk_widget_show(GTK_WIDGET(window));
+  int64_t engine_start = flutter_cookie_bridge_trace_now();
+  flutter_cookie_bridge_trace_record("runner.window", activate_start,
+                                     engine_start);
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
   fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
@@ -57,9 +64,18 @@ static void my_application_activate(GApplication* application) {
   gtk_widget_show(GTK_WIDGET(view));
   gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(view));
 
+  int64_t plugins_start = flutter_cookie_bridge_trace_now();
+  flutter_cookie_bridge_trace_record("runner.engine", engine_start,
+                                     plugins_start);
+
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
+  int64_t plugins_end = flutter_cookie_bridge_trace_now();
+  flutter_cookie_bridge_trace_record("runner.register_plugins", plugins_start,
+                                     plugins_end);
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
+  flutter_cookie_bridge_trace_record("runner.activate", activate_start,
+                                     flutter_cookie_bridge_trace_now());
 }
 
 // Implements GApplication::local_command_line.
@@ -68,6 +84,12 @@ static gboolean my_application_local_command_line(GApplication* application, gch
   // Strip out the first argument as it is the binary name.
   self->dart_entrypoint_arguments = g_strdupv(*arguments + 1);
 
+  // Pass --trace-cookie-bridge to trace startup; Dart reads the same flag.
+  flutter_cookie_bridge_plugin_trace_from_arguments(
+      self->dart_entrypoint_arguments);
+  // Read the cookie store while the window and engine start up.
+  flutter_cookie_bridge_plugin_preload_cookies();
+
   g_autoptr(GError) error = nullptr;
   if (!g_application_register(application, nullptr, &error)) {
      g_warning("Failed to register: %s", error->message);
@@ -0,0 +1,6 @@
+// Runs an integration test under `flutter drive` and writes the data it
+// reports through IntegrationTestWidgetsFlutterBinding.reportData to
+// build/integration_response_data.json.
+import 'package:integration_test/integration_test_driver.dart';
+
+Future<void> main() => integrationDriver();
@@ -0,0 +1,65 @@
+import 'dart:convert';
+import 'dart:io';
+
+// Compares two benchmark result files, as written by
+// flutter_cookie_bridge_benchmark --json or printed by the headless runner,
+// and prints every measurement in both with the change from the first to the
+// second.
+//
+// Usage: dart run tool/compare_benchmarks.dart <before.json> <after.json>
+
+void main(List<String> arguments) {
+  if (arguments.length != 2) {
+    stderr.writeln('usage: compare_benchmarks.dart <before> <after>');
+    exitCode = 2;
+    return;
+  }
+  final before = _figures(arguments[0]);
+  final after = _figures(arguments[1]);
+  final width = [
+    for (final key in before.keys) key.length,
+  ].fold<int>(0, (a, b) => a > b ? a : b);
+  for (final entry in before.entries) {
+    final now = after[entry.key];
+    // Unchanged counts are settings, such as samples per benchmark.
+    if (now == null || (now is int && now == entry.value)) {
+      continue;
+    }
+    final change =
+        entry.value == 0 ? 0.0 : (now - entry.value) / entry.value * 100;
+    stdout.writeln('${entry.key.padRight(width)}  '
+        '${_format(entry.value).padLeft(12)}  ${_format(now).padLeft(12)}  '
+        '${change >= 0 ? '+' : ''}${change.toStringAsFixed(1)}%');
+  }
+}
+
+// The numbers in [path], keyed by their path through the JSON. Entries of
+// a list are keyed by their name, and cookie count if they have one.
+Map<String, num> _figures(String path) {
+  final figures = <String, num>{};
+  void visit(String key, Object? value) {
+    if (value is num) {
+      figures[key] = value;
+    } else if (value is Map<String, Object?>) {
+      value.forEach(
+          (name, child) => visit(key.isEmpty ? name : '$key.$name', child));
+    } else if (value is List) {
+      for (int i = 0; i < value.length; i++) {
+        final child = value[i];
+        String name = '$i';
+        if (child is Map<String, Object?> && child['name'] is String) {
+          name = child['cookies'] is num
+              ? '${child['name']}@${child['cookies']}'
+              : child['name'] as String;
+        }
+        visit('$key[$name]', child);
+      }
+    }
+  }
+
+  visit('', jsonDecode(File(path).readAsStringSync()));
+  return figures;
+}
+
+String _format(num value) =>
+    value is int ? '$value' : value.toStringAsFixed(1);
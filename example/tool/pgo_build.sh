@@ -0,0 +1,77 @@
+#!/usr/bin/env bash
+# Builds the example's Linux release bundle with profile-guided and
+# link-time optimization of the runner and the native plugin, and reports
+# how the cookie and transport benchmarks moved:
+#
+#   1. a plain release build, benchmarked as the baseline;
+#   2. an instrumented build, which runs the benchmarks as its training
+#      workload and writes profiles to $PGO_DIR;
+#   3. a build optimized with those profiles plus LTO, benchmarked again.
+#
+# The benchmarks are the native micro-benchmarks
+# (flutter_cookie_bridge_benchmark) and the headless runner's cookies and
+# transport benchmarks; the training run adds downloads. Only native code is
+# affected: the Dart code is AOT-compiled the same way in every build.
+#
+# Usage, from example/:
+#   $ tool/pgo_build.sh [<output directory>]
+#
+# The optimized bundle is left in build/linux/x64/release/bundle, and the
+# benchmark results in the output directory (default build/pgo).
+
+set -euo pipefail
+
+cd "$(dirname "$0")/.."
+OUT="$(mkdir -p "${1:-build/pgo}" && cd "${1:-build/pgo}" && pwd)"
+PGO_DIR="$OUT/profiles"
+BUILD=build/linux/x64/release
+PLUGIN_BUILD="$BUILD/plugins/flutter_cookie_bridge"
+NATIVE_BENCHMARK="$PLUGIN_BUILD/flutter_cookie_bridge_benchmark"
+HEADLESS="$BUILD/bundle/test_cookie_bridge_example_headless"
+
+build() {
+  echo "=== flutter build linux --release ($1)"
+  flutter build linux --release
+}
+
+# Runs the headless benchmark $1 and writes its JSON line to $2.
+headless() {
+  "$HEADLESS" "--benchmark=$1" | tail -n 1 > "$2"
+}
+
+# Runs the benchmarks that are compared, writing results to $OUT/$1_*.json.
+benchmark() {
+  echo "=== Benchmarking ($1)"
+  "$NATIVE_BENCHMARK" "--json=$OUT/$1_native.json"
+  headless cookies "$OUT/$1_cookies.json"
+  headless transport "$OUT/$1_transport.json"
+}
+
+unset FLUTTER_COOKIE_BRIDGE_PGO FLUTTER_COOKIE_BRIDGE_LTO
+build baseline
+benchmark baseline
+
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+export FLUTTER_COOKIE_BRIDGE_PGO_DIR="$PGO_DIR"
+FLUTTER_COOKIE_BRIDGE_PGO=generate build instrumented
+echo "=== Training"
+"$NATIVE_BENCHMARK" > /dev/null
+for name in cookies transport downloads; do
+  headless "$name" /dev/null
+done
+# Clang writes raw profiles that need merging; GCC's are used as they are.
+if compgen -G "$PGO_DIR/*.profraw" > /dev/null; then
+  "${LLVM_PROFDATA:-llvm-profdata}" merge \
+    "-output=$PGO_DIR/merged.profdata" "$PGO_DIR"/*.profraw
+fi
+
+FLUTTER_COOKIE_BRIDGE_PGO=use FLUTTER_COOKIE_BRIDGE_LTO=ON \
+  build "profile-guided + LTO"
+benchmark optimized
+
+for name in native cookies transport; do
+  echo "=== $name"
+  dart run tool/compare_benchmarks.dart \
+    "$OUT/baseline_$name.json" "$OUT/optimized_$name.json"
+done
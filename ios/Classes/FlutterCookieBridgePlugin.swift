@@ -1,5 +1,6 @@
 import Flutter
 import UIKit
+import WebKit
 
 public class FlutterCookieBridgePlugin: NSObject, FlutterPlugin {
   public static func register(with registrar: FlutterPluginRegistrar) {
@@ -12,8 +13,54 @@ public class FlutterCookieBridgePlugin: NSObject, FlutterPlugin {
     switch call.method {
     case "getPlatformVersion":
       result("iOS " + UIDevice.current.systemVersion)
+    case "syncCookies":
+      guard let args = call.arguments as? [String: Any],
+            let urlString = args["url"] as? String,
+            let host = URL(string: urlString)?.host,
+            let cookies = args["cookies"] as? [String: String] else {
+        result(FlutterError(code: "BAD_ARGUMENTS",
+                            message: "Expected a url string and a cookies map",
+                            details: nil))
+        return
+      }
+      syncCookies(host: host, cookies: cookies, result: result)
     default:
       result(FlutterMethodNotImplemented)
     }
   }
+
+  /// Makes `cookies` the cookies with path / that the shared WebKit store holds
+  /// for `host`, touching only the ones that differ, and reports how many were
+  /// set or removed once every store operation has completed.
+  private func syncCookies(host: String, cookies: [String: String], result: @escaping FlutterResult) {
+    let store = WKWebsiteDataStore.default().httpCookieStore
+    store.getAllCookies { all in
+      var existing = [String: HTTPCookie]()
+      for cookie in all where cookie.path == "/" {
+        let domain = cookie.domain.hasPrefix(".") ? String(cookie.domain.dropFirst()) : cookie.domain
+        if domain.caseInsensitiveCompare(host) == .orderedSame {
+          existing[cookie.name] = cookie
+        }
+      }
+
+      let group = DispatchGroup()
+      var changed = 0
+      for (name, value) in cookies where existing[name]?.value != value {
+        guard let cookie = HTTPCookie(properties: [
+          .name: name, .value: value, .domain: host, .path: "/",
+        ]) else {
+          continue
+        }
+        group.enter()
+        store.setCookie(cookie) { group.leave() }
+        changed += 1
+      }
+      for (name, cookie) in existing where cookies[name] == nil {
+        group.enter()
+        store.delete(cookie) { group.leave() }
+        changed += 1
+      }
+      group.notify(queue: .main) { result(changed) }
+    }
+  }
 }
@@ -0,0 +1,95 @@
+import 'dart:convert';
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+
+import 'flutter_cookie_bridge_ffi.dart';
+
+/// Spans of the cookie bridge's work, recorded into the native plugin's
+/// per-thread trace buffers next to those of the runner and the plugin, and
+/// exported together as Chrome trace-event JSON for chrome://tracing or
+/// Perfetto.
+///
+/// Off by default. The Linux runner turns it on when the Dart entrypoint
+/// arguments contain [argument]; [configure] does the same from `main`, and
+/// [setEnabled] switches it at any time. Tracing needs the native library,
+/// so where [FlutterCookieBridgeBindings.instance] is null every call is a
+/// no-op.
+class CookieBridgeTrace {
+  CookieBridgeTrace._();
+
+  static const String argument = '--trace-cookie-bridge';
+
+  static bool? _enabled;
+
+  // Span names handed to the native side, which keeps the pointers. Never
+  // freed; there are only a handful.
+  static final Map<String, Pointer<Uint8>> _names = {};
+
+  static bool get enabled => _enabled ??=
+      (FlutterCookieBridgeBindings.instance?.traceEnabled() ?? 0) != 0;
+
+  /// Turns tracing on if [arguments], those passed to `main`, contain
+  /// [argument].
+  static void configure(List<String> arguments) {
+    if (arguments.contains(argument)) {
+      setEnabled(true);
+    }
+  }
+
+  static void setEnabled(bool enabled) {
+    final bindings = FlutterCookieBridgeBindings.instance;
+    bindings?.traceSetEnabled(enabled ? 1 : 0);
+    _enabled = enabled && bindings != null;
+  }
+
+  /// The start of a span to pass to [end], or -1 while tracing is off.
+  static int begin() =>
+      enabled ? FlutterCookieBridgeBindings.instance!.traceNow() : -1;
+
+  /// Records the span named [name] from [start], as returned by [begin],
+  /// until now.
+  static void end(String name, int start) {
+    if (start < 0) {
+      return;
+    }
+    final bindings = FlutterCookieBridgeBindings.instance!;
+    final nativeName = _names[name] ??= name.toNativeUtf8().cast<Uint8>();
+    bindings.traceRecord(nativeName, start, bindings.traceNow());
+  }
+
+  /// Runs [body] inside the span named [name].
+  static Future<T> span<T>(String name, Future<T> Function() body) async {
+    if (!enabled) {
+      return body();
+    }
+    final start = begin();
+    try {
+      return await body();
+    } finally {
+      end(name, start);
+    }
+  }
+
+  /// Every span still in the buffers, as Chrome trace-event JSON.
+  static String export() {
+    final bindings = FlutterCookieBridgeBindings.instance;
+    if (bindings == null) {
+      return '{"traceEvents":[]}';
+    }
+    int capacity = 64 * 1024;
+    while (true) {
+      final buffer = malloc<Uint8>(capacity);
+      try {
+        final length = bindings.traceExport(buffer, capacity);
+        // Spans recorded since the last call can make it longer again.
+        if (length <= capacity) {
+          return utf8.decode(buffer.asTypedList(length));
+        }
+        capacity = length * 2;
+      } finally {
+        malloc.free(buffer);
+      }
+    }
+  }
+}
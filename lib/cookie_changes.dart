@@ -0,0 +1,78 @@
+/// A cookie that was stored or removed.
+class CookieChange {
+  const CookieChange({
+    required this.name,
+    this.value = '',
+    this.domain = '',
+    this.path = '/',
+    this.removed = false,
+  });
+
+  factory CookieChange.fromMap(Map<Object?, Object?> map) {
+    return CookieChange(
+      name: map['name'] as String,
+      value: map['value'] as String? ?? '',
+      domain: map['domain'] as String? ?? '',
+      path: map['path'] as String? ?? '/',
+      removed: map['removed'] as bool? ?? false,
+    );
+  }
+
+  final String name;
+
+  /// Empty when [removed] is set.
+  final String value;
+
+  /// Canonical domain of the cookie, or empty when it applies to whichever
+  /// host the consumer is showing.
+  final String domain;
+  final String path;
+  final bool removed;
+
+  /// Whether the cookie is visible to pages on [host].
+  bool appliesTo(String host) {
+    return domain.isEmpty || host == domain || host.endsWith('.$domain');
+  }
+}
+
+/// The cookies that changed since a consumer's last [version].
+class CookieDelta {
+  const CookieDelta({
+    required this.version,
+    this.reset = false,
+    this.changes = const [],
+  });
+
+  factory CookieDelta.fromMap(Map<Object?, Object?> map) {
+    return CookieDelta(
+      version: map['version'] as int,
+      reset: map['reset'] as bool? ?? false,
+      changes: (map['changes'] as List<Object?>? ?? const [])
+          .map((c) => CookieChange.fromMap(c as Map<Object?, Object?>))
+          .toList(),
+    );
+  }
+
+  /// The version the consumer is at once [changes] are applied.
+  final int version;
+
+  /// Set when the consumer could not be caught up incrementally. It must drop
+  /// every cookie it holds before applying [changes], which then list every
+  /// live cookie.
+  final bool reset;
+
+  /// In the order they happened.
+  final List<CookieChange> changes;
+}
+
+/// Cookies a jar dropped on its own.
+class CookieJarStats {
+  const CookieJarStats({this.expired = 0, this.evicted = 0});
+
+  /// Removed because their expiry passed.
+  final int expired;
+
+  /// Removed to keep the jar within its limits, least recently stored
+  /// first.
+  final int evicted;
+}
@@ -0,0 +1,536 @@
+import 'dart:collection';
+import 'dart:convert';
+
+import 'cookie_changes.dart';
+import 'set_cookie_parser.dart';
+
+/// A cookie kept by [DomainCookieJar].
+class StoredCookie {
+  StoredCookie({
+    required this.name,
+    required this.value,
+    required this.domain,
+    this.path = '/',
+    this.hostOnly = true,
+    this.secure = false,
+    this.expires,
+    this.creation = 0,
+  });
+
+  factory StoredCookie.fromJson(Map<String, Object?> json) {
+    final expires = json['expires'] as int?;
+    return StoredCookie(
+      name: json['name'] as String,
+      value: json['value'] as String,
+      domain: json['domain'] as String,
+      path: json['path'] as String? ?? '/',
+      hostOnly: json['hostOnly'] as bool? ?? true,
+      secure: json['secure'] as bool? ?? false,
+      expires: expires == null
+          ? null
+          : DateTime.fromMillisecondsSinceEpoch(expires, isUtc: true),
+      creation: json['creation'] as int? ?? 0,
+    );
+  }
+
+  final String name;
+  final String value;
+
+  /// Canonical domain the cookie is stored under.
+  final String domain;
+  final String path;
+
+  /// Set when the response carried no Domain attribute, in which case the
+  /// cookie is only sent back to exactly [domain].
+  final bool hostOnly;
+  final bool secure;
+
+  /// Null for a session cookie.
+  final DateTime? expires;
+
+  /// Storage order, which breaks ties when ordering the `Cookie` header.
+  final int creation;
+
+  bool isExpiredAt(DateTime now) => expires != null && !expires!.isAfter(now);
+
+  Map<String, Object?> toJson() => {
+        'name': name,
+        'value': value,
+        'domain': domain,
+        'path': path,
+        'hostOnly': hostOnly,
+        'secure': secure,
+        if (expires != null) 'expires': expires!.millisecondsSinceEpoch,
+        'creation': creation,
+      };
+}
+
+/// Caps on the number of cookies a [DomainCookieJar] keeps. The defaults
+/// are the minimums RFC 6265 6.1 asks a user agent to support.
+class CookieJarLimits {
+  const CookieJarLimits({
+    this.maxCookiesPerDomain = 50,
+    this.maxCookies = 3000,
+  });
+
+  final int maxCookiesPerDomain;
+  final int maxCookies;
+}
+
+class _DomainNode {
+  _DomainNode(this.owner) : children = {};
+
+  // A copy for [owner] that shares the children and cookies of [other],
+  // until they change.
+  _DomainNode.copy(_DomainNode other, this.owner)
+      : children = Map.of(other.children),
+        cookies = other.cookies == null ? null : List.of(other.cookies!);
+
+  // The jar that may change this node in place. Nodes of a forked jar
+  // belong to neither jar, so each copies what it changes.
+  final Object owner;
+  final Map<String, _DomainNode> children;
+  List<StoredCookie>? cookies;
+}
+
+/// The Dart counterpart of the native CookieJar, for platforms without the
+/// plugin's native library: cookies matched to requests by domain and path
+/// as RFC 6265 describes.
+///
+/// Cookies are kept under their domain in a trie of reversed labels
+/// (com -> example -> api), so finding the cookies of a request is one walk
+/// of a step per label of its host, whatever the number of cookies stored.
+///
+/// Unlike the native jar, which checks the Public Suffix List, this only
+/// refuses cookies scoped to a whole top-level domain.
+///
+/// As in the native jar, every change first removes the cookies that have
+/// expired, and a domain or jar over its [limits] loses its least recently
+/// stored cookies.
+///
+/// A jar forks in constant time: the fork shares the trie, and either jar
+/// copies only the path to a domain it changes, so that [changesTo] can
+/// skip everything the two still share.
+class DomainCookieJar {
+  DomainCookieJar({this.limits = const CookieJarLimits()});
+
+  final CookieJarLimits limits;
+  Object _owner = Object();
+  late _DomainNode _root = _DomainNode(_owner);
+  int _nextCreation = 0;
+  // Set while [_stored] and [_expiry] are shared with a fork.
+  bool _sharedTracking = false;
+
+  // Every cookie, least recently stored first.
+  LinkedHashSet<StoredCookie> _stored = LinkedHashSet.identity();
+  // Persistent cookies by expiry, in milliseconds since the epoch.
+  SplayTreeMap<int, List<StoredCookie>> _expiry = SplayTreeMap();
+  int _expired = 0;
+  int _evicted = 0;
+
+  /// What the jar dropped on its own since it was created.
+  CookieJarStats get stats =>
+      CookieJarStats(expired: _expired, evicted: _evicted);
+
+  /// Stores the cookies of a response to [url], parsed from its
+  /// `set-cookie` headers, and returns what changed.
+  List<CookieChange> setCookies(Uri url, List<SetCookie?> cookies) {
+    final host = _canonicalHost(url.host);
+    if (host.isEmpty) {
+      return const [];
+    }
+    final now = DateTime.now().toUtc();
+    final changes = removeExpired(now);
+    for (final cookie in cookies) {
+      if (cookie == null || (cookie.secure && !_isSecure(url))) {
+        continue;
+      }
+      String domain = host;
+      bool hostOnly = true;
+      if (cookie.domain != null) {
+        final attribute = _canonicalHost(cookie.domain!.startsWith('.')
+            ? cookie.domain!.substring(1)
+            : cookie.domain!);
+        if (!_domainMatches(host, attribute)) {
+          continue;
+        }
+        if (!attribute.contains('.') && !_isIpAddress(attribute)) {
+          // A top-level domain can only keep host-only cookies of its own.
+          if (attribute != host) {
+            continue;
+          }
+        } else {
+          domain = attribute;
+          hostOnly = false;
+        }
+      }
+      final path = cookie.path ?? _defaultPath(url.path);
+      DateTime? expires;
+      if (cookie.maxAge != null) {
+        expires = now.add(Duration(seconds: cookie.maxAge!));
+      } else if (cookie.expires != null) {
+        expires = cookie.expires!.toUtc();
+      }
+
+      _ownTracking();
+      final node = _node(domain, create: !cookie.isExpired);
+      final bucket = node?.cookies ?? [];
+      final index = bucket.indexWhere(
+          (other) => other.name == cookie.name && other.path == path);
+      if (cookie.isExpired) {
+        if (index >= 0) {
+          _removeCookie(bucket[index]);
+          changes.add(CookieChange(
+              name: cookie.name, domain: domain, path: path, removed: true));
+        }
+        continue;
+      }
+      final stored = StoredCookie(
+        name: cookie.name,
+        value: cookie.value,
+        domain: domain,
+        path: path,
+        hostOnly: hostOnly,
+        secure: cookie.secure,
+        expires: expires,
+        // Replacing keeps the original creation time, as RFC 6265 5.3
+        // requires.
+        creation: index >= 0 ? bucket[index].creation : _nextCreation++,
+      );
+      // Buckets are kept in the order their cookies were stored, which
+      // makes the first one the one to evict.
+      if (index >= 0) {
+        _untrack(bucket.removeAt(index));
+      }
+      bucket.add(stored);
+      node!.cookies = bucket;
+      _track(stored);
+      changes.add(CookieChange(
+          name: stored.name, value: stored.value, domain: domain, path: path));
+      _enforceLimits(bucket, changes);
+    }
+    return changes;
+  }
+
+  /// Removes the cookies that expired at or before [now] and returns them
+  /// as removals.
+  List<CookieChange> removeExpired(DateTime now) {
+    final changes = <CookieChange>[];
+    final nowMillis = now.millisecondsSinceEpoch;
+    if (_expiry.isEmpty || _expiry.firstKey()! > nowMillis) {
+      return changes;
+    }
+    _ownTracking();
+    while (_expiry.isNotEmpty && _expiry.firstKey()! <= nowMillis) {
+      for (final cookie in _expiry.remove(_expiry.firstKey())!) {
+        _removeCookie(cookie);
+        _expired++;
+        changes.add(_removal(cookie));
+      }
+    }
+    return changes;
+  }
+
+  /// The `Cookie` header to send with a request to [url], or null when no
+  /// cookie applies.
+  String? cookieHeader(Uri url) {
+    final host = _canonicalHost(url.host);
+    final secure = _isSecure(url);
+    final requestPath = url.path.isEmpty ? '/' : url.path;
+    final now = DateTime.now().toUtc();
+    final matches = <StoredCookie>[];
+    _forEachSuffix(host, (bucket, exact) {
+      for (final cookie in bucket) {
+        if ((cookie.hostOnly && !exact) ||
+            (cookie.secure && !secure) ||
+            cookie.isExpiredAt(now) ||
+            !_pathMatches(cookie.path, requestPath)) {
+          continue;
+        }
+        matches.add(cookie);
+      }
+    });
+    if (matches.isEmpty) {
+      return null;
+    }
+    // Longer paths first, then older cookies first (RFC 6265 5.4).
+    matches.sort((a, b) => a.path.length != b.path.length
+        ? b.path.length - a.path.length
+        : a.creation - b.creation);
+    return matches.map((c) => '${c.name}=${c.value}').join('; ');
+  }
+
+  /// Every cookie, in no particular order.
+  List<StoredCookie> get cookies {
+    final all = <StoredCookie>[];
+    void visit(_DomainNode node) {
+      all.addAll(node.cookies ?? const []);
+      node.children.values.forEach(visit);
+    }
+
+    visit(_root);
+    return all;
+  }
+
+  void clear() {
+    _root = _DomainNode(_owner);
+    _stored = LinkedHashSet.identity();
+    _expiry = SplayTreeMap();
+    _sharedTracking = false;
+  }
+
+  /// A jar holding the same cookies, made in constant time. The two share
+  /// what neither has changed since.
+  DomainCookieJar fork() {
+    // Neither jar owns the shared nodes any more.
+    _owner = Object();
+    _sharedTracking = true;
+    return DomainCookieJar(limits: limits)
+      .._root = _root
+      .._nextCreation = _nextCreation
+      .._stored = _stored
+      .._expiry = _expiry
+      .._sharedTracking = true
+      .._expired = _expired
+      .._evicted = _evicted;
+  }
+
+  /// What changes when [other] replaces this jar: the cookies only this jar
+  /// holds as removals, and those [other] holds differently or alone as
+  /// stores. Domains the two jars still share with a fork are skipped
+  /// without looking at their cookies.
+  List<CookieChange> changesTo(DomainCookieJar other) {
+    final changes = <CookieChange>[];
+    void diff(_DomainNode? from, _DomainNode? to) {
+      if (identical(from, to)) {
+        return;
+      }
+      final before = from?.cookies ?? const <StoredCookie>[];
+      final after = to?.cookies ?? const <StoredCookie>[];
+      for (final cookie in before) {
+        if (!after.any((c) => c.name == cookie.name && c.path == cookie.path)) {
+          changes.add(_removal(cookie));
+        }
+      }
+      for (final cookie in after) {
+        // Stored cookies are immutable, so a shared one is unchanged.
+        if (!before.any((c) => identical(c, cookie))) {
+          changes.add(CookieChange(
+              name: cookie.name,
+              value: cookie.value,
+              domain: cookie.domain,
+              path: cookie.path));
+        }
+      }
+      for (final label in {...?from?.children.keys, ...?to?.children.keys}) {
+        diff(from?.children[label], to?.children[label]);
+      }
+    }
+
+    diff(_root, other._root);
+    return changes;
+  }
+
+  /// The cookies that have not expired, as JSON for [DomainCookieJar.decode].
+  /// They are listed least recently stored first, so the decoded jar evicts
+  /// in the same order.
+  String encode() {
+    final now = DateTime.now().toUtc();
+    return jsonEncode([
+      for (final cookie in _stored)
+        if (!cookie.isExpiredAt(now)) cookie.toJson(),
+    ]);
+  }
+
+  /// A jar holding the cookies [encode] returned.
+  static DomainCookieJar decode(String json,
+      {CookieJarLimits limits = const CookieJarLimits()}) {
+    final jar = DomainCookieJar(limits: limits);
+    final list = jsonDecode(json) as List<Object?>;
+    for (final entry in list) {
+      final cookie = StoredCookie.fromJson(entry as Map<String, Object?>);
+      final bucket = jar._node(cookie.domain, create: true)!.cookies ??= [];
+      bucket.add(cookie);
+      jar._track(cookie);
+      if (cookie.creation >= jar._nextCreation) {
+        jar._nextCreation = cookie.creation + 1;
+      }
+      jar._enforceLimits(bucket, []);
+    }
+    return jar;
+  }
+
+  // Copies [_stored] and [_expiry] if they are shared with a fork, before
+  // they change.
+  void _ownTracking() {
+    if (!_sharedTracking) {
+      return;
+    }
+    _sharedTracking = false;
+    _stored = LinkedHashSet.identity()..addAll(_stored);
+    _expiry = SplayTreeMap.of(
+        _expiry.map((expiry, due) => MapEntry(expiry, List.of(due))));
+  }
+
+  void _track(StoredCookie cookie) {
+    _stored.add(cookie);
+    if (cookie.expires != null) {
+      (_expiry[cookie.expires!.millisecondsSinceEpoch] ??= []).add(cookie);
+    }
+  }
+
+  void _untrack(StoredCookie cookie) {
+    _stored.remove(cookie);
+    if (cookie.expires != null) {
+      final key = cookie.expires!.millisecondsSinceEpoch;
+      final due = _expiry[key];
+      if (due != null && due.remove(cookie) && due.isEmpty) {
+        _expiry.remove(key);
+      }
+    }
+  }
+
+  // Drops [cookie] from its bucket and from the expiry and storing order.
+  void _removeCookie(StoredCookie cookie) {
+    _untrack(cookie);
+    final bucket = _node(cookie.domain, create: false)?.cookies;
+    if (bucket != null && bucket.remove(cookie) && bucket.isEmpty) {
+      _remove(cookie.domain);
+    }
+  }
+
+  // Evicts the least recently stored cookies of [bucket], then of the whole
+  // jar, until both are within [limits].
+  void _enforceLimits(List<StoredCookie> bucket, List<CookieChange> changes) {
+    while (bucket.length > limits.maxCookiesPerDomain) {
+      final oldest = bucket.first;
+      _removeCookie(oldest);
+      _evicted++;
+      changes.add(_removal(oldest));
+    }
+    while (_stored.length > limits.maxCookies) {
+      final oldest = _stored.first;
+      _removeCookie(oldest);
+      _evicted++;
+      changes.add(_removal(oldest));
+    }
+  }
+
+  static CookieChange _removal(StoredCookie cookie) => CookieChange(
+      name: cookie.name,
+      domain: cookie.domain,
+      path: cookie.path,
+      removed: true);
+
+  // The node of [domain], walking its labels from the last, to be changed:
+  // nodes on the way this jar does not own are replaced by copies it owns.
+  _DomainNode? _node(String domain, {required bool create}) {
+    if (!create && _find(domain) == null) {
+      return null;
+    }
+    _DomainNode node = _root = _own(_root);
+    final labels = domain.split('.');
+    for (int i = labels.length - 1; i >= 0; i--) {
+      final child = node.children[labels[i]];
+      node = node.children[labels[i]] =
+          child == null ? _DomainNode(_owner) : _own(child);
+    }
+    return node;
+  }
+
+  // The node of [domain], to be read.
+  _DomainNode? _find(String domain) {
+    _DomainNode? node = _root;
+    final labels = domain.split('.');
+    for (int i = labels.length - 1; i >= 0 && node != null; i--) {
+      node = node.children[labels[i]];
+    }
+    return node;
+  }
+
+  _DomainNode _own(_DomainNode node) =>
+      identical(node.owner, _owner) ? node : _DomainNode.copy(node, _owner);
+
+  // Drops [domain]'s cookies and the nodes left without any below them.
+  void _remove(String domain) {
+    if (_node(domain, create: false) == null) {
+      return;
+    }
+    final labels = domain.split('.');
+    final path = <_DomainNode>[_root];
+    for (int i = labels.length - 1; i >= 0; i--) {
+      path.add(path.last.children[labels[i]]!);
+    }
+    path.last.cookies = null;
+    for (int i = path.length - 1; i > 0; i--) {
+      final node = path[i];
+      if (node.cookies != null || node.children.isNotEmpty) {
+        break;
+      }
+      path[i - 1].children.remove(labels[labels.length - i]);
+    }
+  }
+
+  // Calls [visit] with the cookies of [host] and of every domain it is a
+  // subdomain of, from the top-level domain down. An IP address only
+  // matches itself.
+  void _forEachSuffix(String host,
+      void Function(List<StoredCookie> bucket, bool exact) visit) {
+    if (_isIpAddress(host)) {
+      final bucket = _find(host)?.cookies;
+      if (bucket != null) {
+        visit(bucket, true);
+      }
+      return;
+    }
+    _DomainNode node = _root;
+    final labels = host.split('.');
+    for (int i = labels.length - 1; i >= 0; i--) {
+      final child = node.children[labels[i]];
+      if (child == null) {
+        return;
+      }
+      node = child;
+      if (node.cookies != null) {
+        visit(node.cookies!, i == 0);
+      }
+    }
+  }
+
+  static String _canonicalHost(String host) {
+    final lower = host.toLowerCase();
+    return lower.endsWith('.') ? lower.substring(0, lower.length - 1) : lower;
+  }
+
+  static bool _isSecure(Uri url) =>
+      url.scheme == 'https' || url.scheme == 'wss';
+
+  static bool _isIpAddress(String host) =>
+      host.contains(':') || RegExp(r'^[0-9.]+$').hasMatch(host);
+
+  static bool _domainMatches(String host, String domain) {
+    if (host == domain) {
+      return true;
+    }
+    return !_isIpAddress(host) && host.endsWith('.$domain');
+  }
+
+  // RFC 6265 5.1.4.
+  static bool _pathMatches(String cookiePath, String requestPath) {
+    if (!requestPath.startsWith(cookiePath)) {
+      return false;
+    }
+    return requestPath.length == cookiePath.length ||
+        cookiePath.endsWith('/') ||
+        requestPath[cookiePath.length] == '/';
+  }
+
+  // RFC 6265 5.1.4.
+  static String _defaultPath(String requestPath) {
+    if (!requestPath.startsWith('/')) {
+      return '/';
+    }
+    final lastSlash = requestPath.lastIndexOf('/');
+    return lastSlash == 0 ? '/' : requestPath.substring(0, lastSlash);
+  }
+}
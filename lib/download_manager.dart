@@ -0,0 +1,307 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:crypto/crypto.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+import 'package:http/http.dart' as http;
+
+import 'flutter_cookie_bridge_platform_interface.dart';
+import 'request_scheduler.dart';
+import 'session_manager.dart';
+
+/// A file that finished downloading.
+class DownloadResult {
+  const DownloadResult({
+    required this.path,
+    required this.bytes,
+    this.segments = 1,
+    this.resumed = false,
+    this.sha256 = '',
+  });
+
+  factory DownloadResult.fromMap(Map<Object?, Object?> map) {
+    return DownloadResult(
+      path: map['path'] as String,
+      bytes: map['bytes'] as int,
+      segments: map['segments'] as int? ?? 1,
+      resumed: map['resumed'] as bool? ?? false,
+      sha256: map['sha256'] as String? ?? '',
+    );
+  }
+
+  final String path;
+  final int bytes;
+
+  /// How many parallel ranged requests fetched the body.
+  final int segments;
+
+  /// Whether an earlier interrupted download of the same file was continued.
+  final bool resumed;
+
+  /// Lower-case hex SHA-256 of the file, computed while it was written.
+  final String sha256;
+}
+
+/// Where a download stands. Updates are spaced by the interval the download
+/// was started with; the last one has [done] set.
+class DownloadProgress {
+  const DownloadProgress({
+    required this.id,
+    required this.received,
+    this.total,
+    this.bytesPerSecond = 0,
+    this.done = false,
+    this.path,
+    this.sha256,
+    this.error,
+  });
+
+  factory DownloadProgress.fromMap(Map<Object?, Object?> map) {
+    final total = map['total'] as int? ?? -1;
+    return DownloadProgress(
+      id: map['id'] as String,
+      received: map['received'] as int? ?? 0,
+      total: total < 0 ? null : total,
+      bytesPerSecond: (map['bytesPerSecond'] as num? ?? 0).toDouble(),
+      done: map['done'] as bool? ?? false,
+      path: map['path'] as String?,
+      sha256: map['sha256'] as String?,
+      error: map['error'] as String?,
+    );
+  }
+
+  /// Tells concurrent downloads apart.
+  final String id;
+  final int received;
+
+  /// Null while the server has not said.
+  final int? total;
+  final double bytesPerSecond;
+  final bool done;
+
+  /// Set on the last update of a successful download.
+  final String? path;
+  final String? sha256;
+
+  /// Set on the last update of a failed download.
+  final String? error;
+
+  /// Between 0 and 1, or null while the total is unknown.
+  double? get fraction =>
+      total == null || total == 0 ? null : received / total!;
+}
+
+class DownloadException implements Exception {
+  const DownloadException(this.message, {this.statusCode});
+
+  final String message;
+
+  /// The HTTP status of the last response, if one arrived.
+  final int? statusCode;
+
+  @override
+  String toString() => 'DownloadException: $message';
+}
+
+/// Downloads files straight to disk without holding them in memory.
+///
+/// Where the native cookie jar exists the plugin's native engine does the
+/// work: parallel ranged segments, resumable across runs, with the jar's
+/// cookies on every request and redirect. Elsewhere the body is streamed
+/// into a `.part` file that retries resume with a Range request.
+class DownloadManager {
+  DownloadManager._();
+
+  static final DownloadManager instance = DownloadManager._();
+
+  static const int _maxAttempts = 3;
+
+  final StreamController<DownloadProgress> _progress =
+      StreamController<DownloadProgress>.broadcast();
+  StreamSubscription<DownloadProgress>? _nativeProgress;
+  int _nextId = 0;
+
+  /// The progress of every download this manager runs.
+  Stream<DownloadProgress> get progress => _progress.stream;
+
+  /// Downloads [url] to [path]. [headers] are sent with every request; on
+  /// platforms without the native jar they must carry the cookies.
+  /// [onProgress] is called at most once per [progressInterval], and once
+  /// more when the download ends. Downloads wait for a slot in the
+  /// [RequestScheduler] shared with NetworkManager, in the background lane
+  /// unless [priority] says otherwise.
+  Future<DownloadResult> download(
+    String url,
+    String path, {
+    Map<String, String> headers = const {},
+    void Function(DownloadProgress progress)? onProgress,
+    Duration progressInterval = const Duration(milliseconds: 100),
+    RequestPriority priority = RequestPriority.background,
+  }) {
+    return RequestScheduler.instance.schedule(
+        url,
+        priority,
+        () => _download(url, path, headers, onProgress, progressInterval));
+  }
+
+  Future<DownloadResult> _download(
+    String url,
+    String path,
+    Map<String, String> headers,
+    void Function(DownloadProgress progress)? onProgress,
+    Duration progressInterval,
+  ) async {
+    final id = '${_nextId++}';
+    final subscription = onProgress == null
+        ? null
+        : _progress.stream.where((p) => p.id == id).listen(onProgress);
+    try {
+      if (!SessionManager.hasNativeJar) {
+        return await _streamToFile(id, url, path, headers, progressInterval);
+      }
+      // One subscription serves every download: an event channel only has
+      // one listener at a time.
+      _nativeProgress ??= FlutterCookieBridgePlatform.instance
+          .downloadProgress()
+          .listen(_progress.add);
+      try {
+        return await FlutterCookieBridgePlatform.instance.download(url, path,
+            headers: headers, id: id, progressInterval: progressInterval);
+      } on PlatformException catch (e) {
+        final details = e.details;
+        throw DownloadException(
+          e.message ?? e.code,
+          statusCode: details is Map ? details['status'] as int? : null,
+        );
+      }
+    } finally {
+      await subscription?.cancel();
+    }
+  }
+
+  Future<DownloadResult> _streamToFile(String id, String url, String path,
+      Map<String, String> headers, Duration progressInterval) async {
+    final part = File('$path.part');
+    if (await part.exists()) {
+      // Without the validator it was fetched under, its bytes cannot be
+      // trusted to belong to the current resource.
+      await part.delete();
+    }
+    final client = http.Client();
+    String? validator;
+    var resumed = false;
+    // Bytes go into the hash as they go into the file.
+    late _DigestSink digest;
+    late ByteConversionSink hasher;
+    final sinceReport = Stopwatch()..start();
+    var reported = 0;
+    void report(int received, int? total) {
+      if (sinceReport.elapsed < progressInterval) {
+        return;
+      }
+      final seconds = sinceReport.elapsedMicroseconds / 1e6;
+      _progress.add(DownloadProgress(
+        id: id,
+        received: received,
+        total: total,
+        bytesPerSecond: seconds > 0 ? (received - reported) / seconds : 0,
+      ));
+      reported = received;
+      sinceReport.reset();
+    }
+
+    try {
+      for (var attempt = 1;; attempt++) {
+        final offset = await part.exists() ? await part.length() : 0;
+        final request = http.Request('GET', Uri.parse(url))
+          ..headers.addAll(headers);
+        if (offset > 0 && validator != null) {
+          request.headers['Range'] = 'bytes=$offset-';
+          request.headers['If-Range'] = validator;
+        }
+        try {
+          final response = await client.send(request);
+          final status = response.statusCode;
+          if (status != 200 && status != 206) {
+            await response.stream.drain<void>();
+            throw DownloadException('HTTP $status', statusCode: status);
+          }
+          final etag = response.headers['etag'];
+          validator = etag != null && !etag.startsWith('W/')
+              ? etag
+              : response.headers['last-modified'];
+          resumed = resumed || status == 206;
+          if (status == 200) {
+            digest = _DigestSink();
+            hasher = sha256.startChunkedConversion(digest);
+          }
+          final start = status == 206 ? offset : 0;
+          final total = response.contentLength == null
+              ? null
+              : start + response.contentLength!;
+          var received = start;
+          final sink = part.openWrite(
+              mode: status == 206 ? FileMode.append : FileMode.write);
+          try {
+            await for (final chunk in response.stream) {
+              sink.add(chunk);
+              hasher.add(chunk);
+              received += chunk.length;
+              report(received, total);
+            }
+          } finally {
+            await sink.close();
+          }
+          final length = await part.length();
+          if (total != null && length != total) {
+            throw const HttpException('connection closed early');
+          }
+          hasher.close();
+          await part.rename(path);
+          final hex = digest.value.toString();
+          _progress.add(DownloadProgress(
+              id: id,
+              received: length,
+              total: length,
+              done: true,
+              path: path,
+              sha256: hex));
+          return DownloadResult(
+              path: path, bytes: length, resumed: resumed, sha256: hex);
+        } on DownloadException {
+          rethrow;
+        } catch (e) {
+          if (attempt == _maxAttempts) {
+            throw DownloadException('$e');
+          }
+          debugPrint('Download of $url interrupted, retrying: $e');
+          await Future.delayed(Duration(milliseconds: 200 * attempt));
+        }
+      }
+    } catch (e) {
+      if (await part.exists()) {
+        await part.delete();
+      }
+      _progress.add(DownloadProgress(
+          id: id, received: reported, done: true, error: '$e'));
+      rethrow;
+    } finally {
+      client.close();
+    }
+  }
+}
+
+/// Holds the digest a chunked hash conversion produces.
+class _DigestSink implements Sink<Digest> {
+  late Digest value;
+
+  @override
+  void add(Digest data) {
+    value = data;
+  }
+
+  @override
+  void close() {}
+}
@@ -2,6 +2,7 @@ import 'package:flutter/cupertino.dart';
 import 'package:flutter_cookie_bridge/web_view.dart';
 import 'package:flutter_cookie_bridge/web_view_callback.dart';
 
+import 'cookie_bridge_trace.dart';
 import 'network_manager.dart';
 import 'session_manager.dart';
 import 'flutter_cookie_bridge_platform_interface.dart';
@@ -25,6 +26,18 @@ class FlutterCookieBridge {
     await _sessionManager.clearSession();
   }
 
+  /// Switches to the cookie partition [name], such as another user profile
+  /// or a partner flow; see [SessionManager.switchPartition].
+  Future<void> switchSessionPartition(String name, {String? from}) {
+    return _sessionManager.switchPartition(name, from: from);
+  }
+
+  /// Drops the cookie partition [name]; see
+  /// [SessionManager.deletePartition].
+  Future<bool> deleteSessionPartition(String name) {
+    return _sessionManager.deletePartition(name);
+  }
+
   Future<WebView> getWebView(
       {required String url,
         Map<String, dynamic>? options,
@@ -33,11 +46,8 @@ class FlutterCookieBridge {
         List<String>? whitelistedUrlsIos,
         String? hostName,
         VoidCallback? onPageFinished}) async {
-    List<String> cookies = await _sessionManager.getSessionCookies();
-    String cookie = "";
-    if (cookies.isNotEmpty) {
-      cookie = cookies.join('; ');
-    }
+    // Only the cookies that apply to [url], by domain and path.
+    String cookie = await _sessionManager.getCookieHeader(url) ?? "";
     _webView = await WebView(
         key: GlobalKey<CustomWebViewState>(),
         url: url,
@@ -56,6 +66,12 @@ class FlutterCookieBridge {
     return _sessionManager.getSessionCookies();
   }
 
+  /// The spans recorded since tracing was turned on, as Chrome trace-event
+  /// JSON; see [CookieBridgeTrace].
+  String exportTrace() {
+    return CookieBridgeTrace.export();
+  }
+
   Future<String?> getPlatformVersion() {
     return FlutterCookieBridgePlatform.instance.getPlatformVersion();
   }
@@ -0,0 +1,168 @@
+import 'dart:ffi';
+import 'dart:io';
+
+/// A byte range inside a caller-owned native buffer.
+final class FlutterCookieBridgeSpan extends Struct {
+  @Uint32()
+  external int offset;
+
+  @Uint32()
+  external int length;
+}
+
+/// Mirrors `FlutterCookieBridgeSetCookie` in flutter_cookie_bridge_ffi.h.
+final class FlutterCookieBridgeSetCookie extends Struct {
+  external FlutterCookieBridgeSpan name;
+  external FlutterCookieBridgeSpan value;
+  external FlutterCookieBridgeSpan domain;
+  external FlutterCookieBridgeSpan path;
+
+  @Int64()
+  external int expires;
+
+  @Int64()
+  external int maxAge;
+
+  @Uint32()
+  external int flags;
+
+  @Uint32()
+  external int sameSite;
+}
+
+typedef _ParseSetCookiesNative = Int32 Function(
+    Pointer<Uint8> data,
+    Pointer<Uint32> lengths,
+    Int32 count,
+    Pointer<FlutterCookieBridgeSetCookie> out);
+typedef ParseSetCookies = int Function(Pointer<Uint8> data,
+    Pointer<Uint32> lengths, int count, Pointer<FlutterCookieBridgeSetCookie> out);
+
+typedef _ParseCookieHeaderNative = Int32 Function(Pointer<Uint8> data,
+    Uint32 length, Pointer<FlutterCookieBridgeSpan> out, Int32 capacity);
+typedef ParseCookieHeader = int Function(Pointer<Uint8> data, int length,
+    Pointer<FlutterCookieBridgeSpan> out, int capacity);
+
+typedef _JarSetCookiesNative = Int32 Function(Pointer<Uint8> url,
+    Uint32 urlLength, Pointer<Uint8> data, Pointer<Uint32> lengths, Int32 count);
+typedef JarSetCookies = int Function(Pointer<Uint8> url, int urlLength,
+    Pointer<Uint8> data, Pointer<Uint32> lengths, int count);
+
+typedef _JarGetCookieHeaderNative = Int32 Function(
+    Pointer<Uint8> url, Uint32 urlLength, Pointer<Uint8> out, Int32 capacity);
+typedef JarGetCookieHeader = int Function(
+    Pointer<Uint8> url, int urlLength, Pointer<Uint8> out, int capacity);
+
+typedef _JarStatsNative = Void Function(
+    Pointer<Uint64> expired, Pointer<Uint64> evicted);
+typedef JarStats = void Function(
+    Pointer<Uint64> expired, Pointer<Uint64> evicted);
+
+typedef _PatternsCreateNative = Pointer<Void> Function(Pointer<Uint8> data,
+    Pointer<Uint32> lengths, Pointer<Uint32> tags, Int32 count);
+typedef PatternsCreate = Pointer<Void> Function(Pointer<Uint8> data,
+    Pointer<Uint32> lengths, Pointer<Uint32> tags, int count);
+
+typedef _PatternsMatchNative = Uint32 Function(
+    Pointer<Void> patterns, Pointer<Uint8> url, Uint32 urlLength);
+typedef PatternsMatch = int Function(
+    Pointer<Void> patterns, Pointer<Uint8> url, int urlLength);
+
+typedef PatternsFreeNative = Void Function(Pointer<Void> patterns);
+
+typedef _TraceSetEnabledNative = Void Function(Int32 enabled);
+typedef TraceSetEnabled = void Function(int enabled);
+
+typedef _TraceEnabledNative = Int32 Function();
+typedef TraceEnabled = int Function();
+
+typedef _TraceNowNative = Int64 Function();
+typedef TraceNow = int Function();
+
+typedef _TraceRecordNative = Void Function(
+    Pointer<Uint8> name, Int64 startUs, Int64 endUs);
+typedef TraceRecord = void Function(
+    Pointer<Uint8> name, int startUs, int endUs);
+
+typedef _TraceExportNative = Int32 Function(Pointer<Uint8> out, Int32 capacity);
+typedef TraceExport = int Function(Pointer<Uint8> out, int capacity);
+
+/// Bindings to the C entry points of the plugin's native library.
+///
+/// The library only exists where the plugin has a native implementation
+/// (currently Linux); [FlutterCookieBridgeBindings.instance] is null
+/// everywhere else and callers fall back to their Dart implementation.
+class FlutterCookieBridgeBindings {
+  FlutterCookieBridgeBindings._(DynamicLibrary library)
+      : parseSetCookies = library.lookupFunction<_ParseSetCookiesNative,
+            ParseSetCookies>('flutter_cookie_bridge_parse_set_cookies',
+            isLeaf: true),
+        parseCookieHeader = library.lookupFunction<_ParseCookieHeaderNative,
+            ParseCookieHeader>('flutter_cookie_bridge_parse_cookie_header',
+            isLeaf: true),
+        jarSetCookies =
+            library.lookupFunction<_JarSetCookiesNative, JarSetCookies>(
+                'flutter_cookie_bridge_jar_set_cookies',
+                isLeaf: true),
+        jarGetCookieHeader = library.lookupFunction<_JarGetCookieHeaderNative,
+            JarGetCookieHeader>('flutter_cookie_bridge_jar_get_cookie_header',
+            isLeaf: true),
+        jarStats = library.lookupFunction<_JarStatsNative, JarStats>(
+            'flutter_cookie_bridge_jar_stats',
+            isLeaf: true),
+        patternsCreate =
+            library.lookupFunction<_PatternsCreateNative, PatternsCreate>(
+                'flutter_cookie_bridge_patterns_create',
+                isLeaf: true),
+        patternsMatch =
+            library.lookupFunction<_PatternsMatchNative, PatternsMatch>(
+                'flutter_cookie_bridge_patterns_match',
+                isLeaf: true),
+        patternsFree = library.lookup<NativeFunction<PatternsFreeNative>>(
+            'flutter_cookie_bridge_patterns_free'),
+        traceSetEnabled =
+            library.lookupFunction<_TraceSetEnabledNative, TraceSetEnabled>(
+                'flutter_cookie_bridge_trace_set_enabled',
+                isLeaf: true),
+        traceEnabled = library.lookupFunction<_TraceEnabledNative,
+            TraceEnabled>('flutter_cookie_bridge_trace_enabled', isLeaf: true),
+        traceNow = library.lookupFunction<_TraceNowNative, TraceNow>(
+            'flutter_cookie_bridge_trace_now',
+            isLeaf: true),
+        traceRecord = library.lookupFunction<_TraceRecordNative, TraceRecord>(
+            'flutter_cookie_bridge_trace_record',
+            isLeaf: true),
+        traceExport = library.lookupFunction<_TraceExportNative, TraceExport>(
+            'flutter_cookie_bridge_trace_export',
+            isLeaf: true);
+
+  static const String libraryName = 'libflutter_cookie_bridge_plugin.so';
+
+  static final FlutterCookieBridgeBindings? instance = _load();
+
+  static FlutterCookieBridgeBindings? _load() {
+    if (!Platform.isLinux) {
+      return null;
+    }
+    try {
+      return FlutterCookieBridgeBindings._(DynamicLibrary.open(libraryName));
+    } on ArgumentError {
+      return null;
+    }
+  }
+
+  final ParseSetCookies parseSetCookies;
+  final ParseCookieHeader parseCookieHeader;
+  final JarSetCookies jarSetCookies;
+  final JarGetCookieHeader jarGetCookieHeader;
+  final JarStats jarStats;
+  final PatternsCreate patternsCreate;
+  final PatternsMatch patternsMatch;
+  // A pointer rather than a function, for NativeFinalizer.
+  final Pointer<NativeFunction<PatternsFreeNative>> patternsFree;
+  final TraceSetEnabled traceSetEnabled;
+  final TraceEnabled traceEnabled;
+  final TraceNow traceNow;
+  final TraceRecord traceRecord;
+  final TraceExport traceExport;
+}
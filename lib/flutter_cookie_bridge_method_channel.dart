@@ -1,7 +1,10 @@
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
+import 'cookie_changes.dart';
+import 'download_manager.dart';
 import 'flutter_cookie_bridge_platform_interface.dart';
+import 'native_http_client_adapter.dart';
 
 /// An implementation of [FlutterCookieBridgePlatform] that uses method channels.
 class MethodChannelFlutterCookieBridge extends FlutterCookieBridgePlatform {
@@ -9,10 +12,159 @@ class MethodChannelFlutterCookieBridge extends FlutterCookieBridgePlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('flutter_cookie_bridge');
 
+  /// The event channel carrying cookie jar changes.
+  @visibleForTesting
+  final changesChannel =
+      const EventChannel('flutter_cookie_bridge/cookie_changes');
+
+  /// The event channel carrying download progress.
+  @visibleForTesting
+  final downloadsChannel =
+      const EventChannel('flutter_cookie_bridge/downloads');
+
   @override
   Future<String?> getPlatformVersion() async {
     final version =
         await methodChannel.invokeMethod<String>('getPlatformVersion');
     return version;
   }
+
+  @override
+  Future<void> setCookies(String url, List<String> setCookieHeaders) async {
+    await methodChannel.invokeMethod<int>(
+        'setCookies', {'url': url, 'cookies': setCookieHeaders});
+  }
+
+  @override
+  Future<int> syncCookies(String url, Map<String, String> cookies) async {
+    final changed = await methodChannel
+        .invokeMethod<int>('syncCookies', {'url': url, 'cookies': cookies});
+    return changed ?? 0;
+  }
+
+  @override
+  Future<String?> getCookieHeader(String url) {
+    return methodChannel.invokeMethod<String>('getCookieHeader', {'url': url});
+  }
+
+  @override
+  Future<List<String>> getCookies() async {
+    final cookies = await methodChannel.invokeListMethod<String>('getCookies');
+    return cookies ?? [];
+  }
+
+  @override
+  Future<void> clearCookies() async {
+    await methodChannel.invokeMethod<void>('clear');
+  }
+
+  @override
+  Future<void> switchCookiePartition(String name, {String? from}) async {
+    await methodChannel.invokeMethod<void>('switchCookiePartition', {
+      'name': name,
+      if (from != null) 'from': from,
+    });
+  }
+
+  @override
+  Future<bool> deleteCookiePartition(String name) async {
+    final deleted = await methodChannel
+        .invokeMethod<bool>('deleteCookiePartition', {'name': name});
+    return deleted ?? false;
+  }
+
+  @override
+  Stream<CookieDelta> cookieChanges({int? since}) {
+    return changesChannel
+        .receiveBroadcastStream(since)
+        .map((event) => CookieDelta.fromMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<DownloadResult> download(String url, String path,
+      {Map<String, String> headers = const {},
+      String? id,
+      Duration? progressInterval}) async {
+    final result =
+        await methodChannel.invokeMapMethod<Object?, Object?>('download', {
+      'url': url,
+      'path': path,
+      'headers': headers,
+      if (id != null) 'id': id,
+      if (progressInterval != null)
+        'progressIntervalMs': progressInterval.inMilliseconds,
+    });
+    return DownloadResult.fromMap(result!);
+  }
+
+  @override
+  Stream<DownloadProgress> downloadProgress() {
+    return downloadsChannel.receiveBroadcastStream().map((event) =>
+        DownloadProgress.fromMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<NativeHttpResponse> httpRequest(String method, String url,
+      {Map<String, String> headers = const {},
+      Uint8List? body,
+      Duration? timeout,
+      bool cache = false,
+      bool json = false}) async {
+    final result =
+        await methodChannel.invokeMapMethod<Object?, Object?>('httpRequest', {
+      'method': method,
+      'url': url,
+      'headers': headers,
+      if (body != null) 'body': body,
+      if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+      if (cache) 'cache': true,
+      if (json) 'json': true,
+    });
+    return NativeHttpResponse.fromMap(result!);
+  }
+
+  @override
+  Future<void> configureHttpCache({required bool enabled, int? maxBytes}) {
+    return methodChannel.invokeMethod<void>('configureHttpCache', {
+      'enabled': enabled,
+      if (maxBytes != null) 'maxBytes': maxBytes,
+    });
+  }
+
+  @override
+  Future<HttpCacheStats> httpCacheStats() async {
+    final stats =
+        await methodChannel.invokeMapMethod<Object?, Object?>('httpCacheStats');
+    return HttpCacheStats.fromMap(stats ?? const {});
+  }
+
+  @override
+  Future<void> clearHttpCache() {
+    return methodChannel.invokeMethod<void>('clearHttpCache');
+  }
+
+  @override
+  Future<void> configureCompression(
+      {String? host,
+      List<String>? accept,
+      String? requestEncoding,
+      int? minRequestBytes,
+      int? level,
+      bool reset = false}) {
+    return methodChannel.invokeMethod<void>('configureCompression', {
+      if (host != null) 'host': host,
+      if (accept != null) 'accept': accept,
+      if (requestEncoding != null) 'requestEncoding': requestEncoding,
+      if (minRequestBytes != null) 'minRequestBytes': minRequestBytes,
+      if (level != null) 'level': level,
+      if (reset) 'reset': true,
+    });
+  }
+
+  @override
+  Future<CompressionStats> compressionStats({String? host}) async {
+    final stats = await methodChannel.invokeMapMethod<Object?, Object?>(
+        'compressionStats', {if (host != null) 'host': host});
+    return CompressionStats.fromMap(stats ?? const {});
+  }
 }
@@ -1,5 +1,10 @@
+import 'dart:typed_data';
+
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
+import 'cookie_changes.dart';
+import 'download_manager.dart';
 import 'flutter_cookie_bridge_method_channel.dart';
+import 'native_http_client_adapter.dart';
 
 abstract class FlutterCookieBridgePlatform extends PlatformInterface {
   /// Constructs a FlutterCookieBridgePlatform.
@@ -26,4 +31,142 @@ abstract class FlutterCookieBridgePlatform extends PlatformInterface {
   Future<String?> getPlatformVersion() {
     throw UnimplementedError('platformVersion() has not been implemented.');
   }
+
+  /// Stores the raw `set-cookie` header values of a response to [url] in the
+  /// native cookie jar.
+  Future<void> setCookies(String url, List<String> setCookieHeaders) {
+    throw UnimplementedError('setCookies() has not been implemented.');
+  }
+
+  /// Makes [cookies], a map of names to values, the host-only cookies with
+  /// path `/` that the platform WebView holds for the host of [url]. Only the
+  /// difference is applied, in a single platform call. Returns the number of
+  /// cookies set or removed.
+  Future<int> syncCookies(String url, Map<String, String> cookies) {
+    throw UnimplementedError('syncCookies() has not been implemented.');
+  }
+
+  /// Returns the `Cookie` request header the native jar holds for [url], or
+  /// null when no cookie applies.
+  Future<String?> getCookieHeader(String url) {
+    throw UnimplementedError('getCookieHeader() has not been implemented.');
+  }
+
+  /// Returns the `name=value` pair of every cookie in the native cookie jar.
+  Future<List<String>> getCookies() {
+    throw UnimplementedError('getCookies() has not been implemented.');
+  }
+
+  /// Removes every cookie from the native cookie jar.
+  Future<void> clearCookies() {
+    throw UnimplementedError('clearCookies() has not been implemented.');
+  }
+
+  /// Makes [name] the active partition of the native cookie jar, creating it
+  /// if needed: empty, or as a copy-on-write snapshot of partition [from].
+  /// Only the cookies that differ between the two partitions change, and
+  /// [cookieChanges] reports just those. Only the `default` partition is
+  /// persisted natively.
+  Future<void> switchCookiePartition(String name, {String? from}) {
+    throw UnimplementedError(
+        'switchCookiePartition() has not been implemented.');
+  }
+
+  /// Drops the native cookie jar partition [name]. Returns false when it is
+  /// the active or the `default` partition, or does not exist.
+  Future<bool> deleteCookiePartition(String name) {
+    throw UnimplementedError(
+        'deleteCookiePartition() has not been implemented.');
+  }
+
+  /// Streams what changes in the native cookie jar. With [since], the first
+  /// event catches up from that jar version; otherwise only changes made
+  /// after listening are reported.
+  Stream<CookieDelta> cookieChanges({int? since}) {
+    throw UnimplementedError('cookieChanges() has not been implemented.');
+  }
+
+  /// Downloads [url] to the file at [path] natively, streaming it to disk in
+  /// parallel ranged segments and resuming an earlier interrupted attempt.
+  /// The native jar supplies cookies; [headers] are added to every request.
+  /// Progress for [id] is reported on [downloadProgress] at most once per
+  /// [progressInterval]. Fails with a `DOWNLOAD_FAILED` platform exception.
+  Future<DownloadResult> download(String url, String path,
+      {Map<String, String> headers = const {},
+      String? id,
+      Duration? progressInterval}) {
+    throw UnimplementedError('download() has not been implemented.');
+  }
+
+  /// Streams the progress of every native download, ending with an update
+  /// that has [DownloadProgress.done] set.
+  Stream<DownloadProgress> downloadProgress() {
+    throw UnimplementedError('downloadProgress() has not been implemented.');
+  }
+
+  /// Sends a request through the native transport's pooled keep-alive
+  /// connections and returns the whole response. Redirects are not
+  /// followed. With [cache], a GET is answered from the HTTP cache when it
+  /// is on and holds a fresh response. With [json], a JSON body comes back
+  /// parsed, as [NativeHttpResponse.json]. Fails with an `HTTP_FAILED`
+  /// platform exception when no response arrives or the JSON is invalid.
+  Future<NativeHttpResponse> httpRequest(String method, String url,
+      {Map<String, String> headers = const {},
+      Uint8List? body,
+      Duration? timeout,
+      bool cache = false,
+      bool json = false}) {
+    throw UnimplementedError('httpRequest() has not been implemented.');
+  }
+
+  /// Turns the native HTTP cache on or off. It keeps up to [maxBytes] of
+  /// responses on disk, honoring `Cache-Control` and revalidating stale
+  /// responses with their validators. Responses are stored per `Cookie`
+  /// header, so sessions never see each other's.
+  Future<void> configureHttpCache({required bool enabled, int? maxBytes}) {
+    throw UnimplementedError(
+        'configureHttpCache() has not been implemented.');
+  }
+
+  /// Returns the native HTTP cache's counters.
+  Future<HttpCacheStats> httpCacheStats() {
+    throw UnimplementedError('httpCacheStats() has not been implemented.');
+  }
+
+  /// Removes every response from the native HTTP cache.
+  Future<void> clearHttpCache() {
+    throw UnimplementedError('clearHttpCache() has not been implemented.');
+  }
+
+  /// Sets the content codings the native transport negotiates with [host],
+  /// or with every host without its own settings when [host] is null.
+  /// Responses in one of the [accept] codings (`zstd`, `br`, `gzip`, most
+  /// preferred first) are decoded as they arrive. Request bodies of at least
+  /// [minRequestBytes] are compressed with [requestEncoding], which only
+  /// hosts known to accept it should get; a 415 sends the body again as it
+  /// is. [level] is the codec's own, null for its default. With [reset],
+  /// [host] goes back to the default settings.
+  ///
+  /// Downloads only negotiate a coding with hosts given settings of their
+  /// own, as a decoded file cannot be fetched in parallel ranges or
+  /// resumed.
+  ///
+  /// Fails with a `BAD_ARGUMENTS` platform exception for a coding this build
+  /// cannot compress with, or does not know.
+  Future<void> configureCompression(
+      {String? host,
+      List<String>? accept,
+      String? requestEncoding,
+      int? minRequestBytes,
+      int? level,
+      bool reset = false}) {
+    throw UnimplementedError(
+        'configureCompression() has not been implemented.');
+  }
+
+  /// Returns the native transport's compression counters for [host], or
+  /// for every host when it is null.
+  Future<CompressionStats> compressionStats({String? host}) {
+    throw UnimplementedError('compressionStats() has not been implemented.');
+  }
 }
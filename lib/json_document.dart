@@ -0,0 +1,278 @@
+import 'dart:convert';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+/// The kinds of JSON value a [JsonNode] can hold.
+enum JsonType { nullValue, boolean, integer, decimal, string, object, array }
+
+/// A JSON text parsed into a tape: one flat [Int64List] that lists the values
+/// in document order, and the UTF-8 bytes of every string in a second list.
+///
+/// Both are plain typed data, so a document parsed by the native transport
+/// or on another isolate reaches the UI isolate as two buffers instead of a
+/// tree of maps and lists to copy and allocate. Values are read off the
+/// tape when asked for; [JsonNode.value] builds the Dart objects of one
+/// subtree, and only that one.
+///
+/// The top byte of a word is the type of a value, as an ASCII character,
+/// and the 56 bits below it the payload:
+///  * `n`, `t`, `f`: null, true and false; one word.
+///  * `l`, `d`: an int or a double; the value is in the next word.
+///  * `s`: a string; the payload is its offset in [strings], the next word
+///    its length in bytes.
+///  * `{`, `[`: an object or an array; the payload is the index of the word
+///    after its last value, the next word its number of members. The values
+///    follow, keys before values.
+class JsonDocument {
+  JsonDocument(this.tape, this.strings)
+      : _doubles = Float64List.view(
+            tape.buffer, tape.offsetInBytes, tape.length);
+
+  /// The document as the native transport sends it: a map with the `tape`
+  /// and the `strings`.
+  factory JsonDocument.fromMap(Map<Object?, Object?> map) =>
+      JsonDocument(map['tape'] as Int64List, map['strings'] as Uint8List);
+
+  /// The tape of [value], which must be made of what [jsonDecode] returns:
+  /// null, bools, numbers, strings, and lists and string-keyed maps of them.
+  factory JsonDocument.fromValue(Object? value) {
+    final writer = _TapeWriter()..write(value);
+    return JsonDocument(
+        Int64List.fromList(writer.tape), writer.strings.takeBytes());
+  }
+
+  /// Decodes the UTF-8 JSON text [bytes] on another isolate, for platforms
+  /// without the native parser. Only the tape and the strings come back.
+  static Future<JsonDocument> decode(Uint8List bytes) => Isolate.run(
+      () => JsonDocument.fromValue(jsonDecode(utf8.decode(bytes))));
+
+  final Int64List tape;
+  final Uint8List strings;
+  // The tape again, to read doubles from.
+  final Float64List _doubles;
+
+  JsonNode get root => JsonNode._(this, 0);
+
+  /// Builds the whole document as [jsonDecode] would have.
+  Object? toObject() => root.value;
+
+  static const int _typeShift = 56;
+  static const int _payloadMask = 0x00ffffffffffffff;
+}
+
+/// A value of a [JsonDocument]. Cheap to make; reading it does not build
+/// anything but what it returns.
+class JsonNode {
+  const JsonNode._(this._document, this._index);
+
+  final JsonDocument _document;
+  final int _index;
+
+  int get _word => _document.tape[_index];
+  int get _tag => _word >> JsonDocument._typeShift;
+  int get _payload => _word & JsonDocument._payloadMask;
+
+  JsonType get type {
+    switch (_tag) {
+      case 0x74: // t
+      case 0x66: // f
+        return JsonType.boolean;
+      case 0x6c: // l
+        return JsonType.integer;
+      case 0x64: // d
+        return JsonType.decimal;
+      case 0x73: // s
+        return JsonType.string;
+      case 0x7b: // {
+        return JsonType.object;
+      case 0x5b: // [
+        return JsonType.array;
+      default:
+        return JsonType.nullValue;
+    }
+  }
+
+  bool get isNull => type == JsonType.nullValue;
+
+  bool? get asBool => type == JsonType.boolean ? _tag == 0x74 : null;
+
+  int? get asInt => type == JsonType.integer
+      ? _document.tape[_index + 1]
+      : type == JsonType.decimal
+          ? asDouble!.toInt()
+          : null;
+
+  double? get asDouble => type == JsonType.decimal
+      ? _document._doubles[_index + 1]
+      : type == JsonType.integer
+          ? _document.tape[_index + 1].toDouble()
+          : null;
+
+  String? get asString {
+    if (type != JsonType.string) {
+      return null;
+    }
+    // The native parser does not check that strings are valid UTF-8.
+    final start = _payload;
+    return const Utf8Decoder(allowMalformed: true).convert(
+        _document.strings, start, start + _document.tape[_index + 1]);
+  }
+
+  /// The number of members of an object or an array; 0 for other values.
+  int get length => type == JsonType.object || type == JsonType.array
+      ? _document.tape[_index + 1]
+      : 0;
+
+  /// The value of member [key] of an object, or element [key] of an array.
+  /// Null when there is none.
+  JsonNode? operator [](Object key) {
+    if (key is int && type == JsonType.array) {
+      if (key < 0 || key >= length) {
+        return null;
+      }
+      int at = _index + 2;
+      for (int i = 0; i < key; i++) {
+        at = JsonNode._(_document, at)._next;
+      }
+      return JsonNode._(_document, at);
+    }
+    if (key is String && type == JsonType.object) {
+      // Compared as bytes, so that no key is decoded to look one up.
+      final wanted = utf8.encode(key);
+      final strings = _document.strings;
+      final tape = _document.tape;
+      int at = _index + 2;
+      for (int i = 0; i < length; i++) {
+        final offset = tape[at] & JsonDocument._payloadMask;
+        if (tape[at + 1] == wanted.length) {
+          int j = 0;
+          while (j < wanted.length && strings[offset + j] == wanted[j]) {
+            j++;
+          }
+          if (j == wanted.length) {
+            return JsonNode._(_document, at + 2);
+          }
+        }
+        at = JsonNode._(_document, at + 2)._next;
+      }
+    }
+    return null;
+  }
+
+  /// The keys of an object in document order; empty for other values.
+  Iterable<String> get keys sync* {
+    if (type != JsonType.object) {
+      return;
+    }
+    int at = _index + 2;
+    for (int i = 0; i < length; i++) {
+      yield JsonNode._(_document, at).asString!;
+      at = JsonNode._(_document, at + 2)._next;
+    }
+  }
+
+  /// The elements of an array, or the values of an object, in document
+  /// order; empty for other values.
+  Iterable<JsonNode> get children sync* {
+    final object = type == JsonType.object;
+    int at = _index + 2;
+    for (int i = 0; i < length; i++) {
+      final child = JsonNode._(_document, object ? at + 2 : at);
+      yield child;
+      at = child._next;
+    }
+  }
+
+  /// The value and everything under it as [jsonDecode] would have built it.
+  Object? get value {
+    switch (type) {
+      case JsonType.nullValue:
+        return null;
+      case JsonType.boolean:
+        return asBool;
+      case JsonType.integer:
+        return asInt;
+      case JsonType.decimal:
+        return asDouble;
+      case JsonType.string:
+        return asString;
+      case JsonType.array:
+        return [for (final child in children) child.value];
+      case JsonType.object:
+        final result = <String, dynamic>{};
+        int at = _index + 2;
+        for (int i = 0; i < length; i++) {
+          final child = JsonNode._(_document, at + 2);
+          result[JsonNode._(_document, at).asString!] = child.value;
+          at = child._next;
+        }
+        return result;
+    }
+  }
+
+  // The index of the value after this one.
+  int get _next {
+    switch (type) {
+      case JsonType.nullValue:
+      case JsonType.boolean:
+        return _index + 1;
+      case JsonType.object:
+      case JsonType.array:
+        return _payload;
+      default:
+        return _index + 2;
+    }
+  }
+}
+
+/// Writes decoded JSON values to a tape, as the native parser does.
+class _TapeWriter {
+  final List<int> tape = [];
+  final BytesBuilder strings = BytesBuilder(copy: false);
+  final ByteData _bits = ByteData(8);
+
+  static int _word(String type, [int payload = 0]) =>
+      type.codeUnitAt(0) << JsonDocument._typeShift | payload;
+
+  void write(Object? value) {
+    if (value == null) {
+      tape.add(_word('n'));
+    } else if (value is bool) {
+      tape.add(_word(value ? 't' : 'f'));
+    } else if (value is int) {
+      tape
+        ..add(_word('l'))
+        ..add(value);
+    } else if (value is double) {
+      _bits.setFloat64(0, value, Endian.host);
+      tape
+        ..add(_word('d'))
+        ..add(_bits.getInt64(0, Endian.host));
+    } else if (value is String) {
+      final bytes = utf8.encode(value);
+      tape
+        ..add(_word('s', strings.length))
+        ..add(bytes.length);
+      strings.add(bytes);
+    } else if (value is Map) {
+      final open = tape.length;
+      tape
+        ..add(_word('{'))
+        ..add(value.length);
+      value.forEach((key, member) {
+        write(key as String);
+        write(member);
+      });
+      tape[open] |= tape.length;
+    } else if (value is List) {
+      final open = tape.length;
+      tape
+        ..add(_word('['))
+        ..add(value.length);
+      value.forEach(write);
+      tape[open] |= tape.length;
+    } else {
+      throw ArgumentError.value(value, 'value', 'Not a JSON value');
+    }
+  }
+}
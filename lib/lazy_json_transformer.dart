@@ -0,0 +1,65 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+
+import 'json_document.dart';
+
+/// A response whose JSON body the native transport already parsed into
+/// [document], on its own thread, as the bytes arrived.
+class JsonDocumentResponseBody extends ResponseBody {
+  JsonDocumentResponseBody(
+    this.document,
+    int statusCode, {
+    Map<String, List<String>> headers = const {},
+    bool isRedirect = false,
+    List<RedirectRecord>? redirects,
+  }) : super(const Stream.empty(), statusCode,
+            headers: headers, isRedirect: isRedirect, redirects: redirects);
+
+  final JsonDocument document;
+}
+
+/// Makes [Response.data] a [JsonDocument] for requests sent with
+/// `Options(extra: {'lazyJson': true})` that get a JSON body back, instead
+/// of the maps and lists [BackgroundTransformer] builds.
+///
+/// A large body decoded the usual way costs the UI isolate twice: the tree
+/// of objects built on a background isolate is copied back into it, object
+/// by object, and then stays there in full. A [JsonDocument] arrives as two
+/// typed lists and only builds what is read from it. Behind the
+/// `NativeHttpClientAdapter` the body is parsed natively as it streams in;
+/// elsewhere it is parsed on a background isolate that sends back only the
+/// tape. Other requests and responses are transformed as before.
+class LazyJsonTransformer extends BackgroundTransformer {
+  @override
+  Future transformResponse(
+      RequestOptions options, ResponseBody responseBody) async {
+    if (!wantsDocument(options)) {
+      return super.transformResponse(options, responseBody);
+    }
+    if (responseBody is JsonDocumentResponseBody) {
+      return responseBody.document;
+    }
+    final builder = BytesBuilder(copy: false);
+    await responseBody.stream.forEach(builder.add);
+    final bytes = builder.takeBytes();
+    final contentType =
+        responseBody.headers[Headers.contentTypeHeader]?.firstOrNull;
+    if (bytes.isEmpty || !Transformer.isJsonMimeType(contentType)) {
+      return super.transformResponse(
+          options,
+          ResponseBody.fromBytes(bytes, responseBody.statusCode,
+              headers: responseBody.headers,
+              statusMessage: responseBody.statusMessage,
+              isRedirect: responseBody.isRedirect,
+              redirects: responseBody.redirects));
+    }
+    return JsonDocument.decode(bytes);
+  }
+
+  /// Whether [options] asked for the body as a [JsonDocument].
+  static bool wantsDocument(RequestOptions options) =>
+      options.extra['lazyJson'] == true &&
+      options.responseType == ResponseType.json;
+}
@@ -0,0 +1,99 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'cookie_changes.dart';
+import 'flutter_cookie_bridge_ffi.dart';
+
+/// The plugin's process-wide native cookie jar, reached through dart:ffi.
+///
+/// Unlike the method channel this works from any isolate and answers
+/// synchronously, and every isolate sees the same cookies: the jar lives in
+/// the native library, not in Dart state. Header lookups never wait for
+/// writers. Only available where [FlutterCookieBridgeBindings.instance] is.
+class NativeCookieJar {
+  NativeCookieJar._();
+
+  static bool get isAvailable => FlutterCookieBridgeBindings.instance != null;
+
+  // Scratch buffer reused across calls of this isolate. Never freed, like
+  // the isolate's other statics.
+  static Pointer<Uint8> _buffer = nullptr;
+  static int _capacity = 0;
+
+  static Pointer<Uint8> _reserve(int size) {
+    if (size > _capacity) {
+      if (_buffer != nullptr) {
+        malloc.free(_buffer);
+      }
+      _capacity = size < 256 ? 256 : size * 2;
+      _buffer = malloc<Uint8>(_capacity);
+    }
+    return _buffer;
+  }
+
+  /// Stores the raw `set-cookie` header values of a response to [url].
+  /// Returns the number of cookies stored or removed.
+  static int setCookies(String url, List<String> setCookieHeaders) {
+    final bindings = FlutterCookieBridgeBindings.instance!;
+    return using((arena) {
+      final encodedUrl = utf8.encode(url);
+      final encoded = setCookieHeaders.map(utf8.encode).toList();
+      final total = encoded.fold<int>(0, (sum, bytes) => sum + bytes.length);
+      final urlData = arena<Uint8>(encodedUrl.length);
+      urlData.asTypedList(encodedUrl.length).setAll(0, encodedUrl);
+      final data = arena<Uint8>(total == 0 ? 1 : total);
+      final lengths = arena<Uint32>(encoded.isEmpty ? 1 : encoded.length);
+      final view = data.asTypedList(total);
+      int offset = 0;
+      for (int i = 0; i < encoded.length; i++) {
+        view.setRange(offset, offset + encoded[i].length, encoded[i]);
+        lengths[i] = encoded[i].length;
+        offset += encoded[i].length;
+      }
+      return bindings.jarSetCookies(
+          urlData, encodedUrl.length, data, lengths, encoded.length);
+    });
+  }
+
+  /// Returns the `Cookie` header to send with a request to [url], or null
+  /// when no cookie applies.
+  static String? cookieHeader(String url) {
+    final bindings = FlutterCookieBridgeBindings.instance!;
+    final encodedUrl = utf8.encode(url);
+    int length = 256;
+    int capacity;
+    Pointer<Uint8> buffer;
+    // Retried when the header does not fit, which a concurrent writer on
+    // another isolate can also cause.
+    do {
+      // The header goes after the url in the same buffer.
+      buffer = _reserve(encodedUrl.length + length);
+      buffer.asTypedList(encodedUrl.length).setAll(0, encodedUrl);
+      capacity = _capacity - encodedUrl.length;
+      length = bindings.jarGetCookieHeader(
+          buffer,
+          encodedUrl.length,
+          Pointer<Uint8>.fromAddress(buffer.address + encodedUrl.length),
+          capacity);
+    } while (length > capacity);
+    if (length == 0) {
+      return null;
+    }
+    return utf8.decode(Uint8List.sublistView(
+        buffer.asTypedList(encodedUrl.length + length), encodedUrl.length));
+  }
+
+  /// What the jar dropped on its own since the process started.
+  static CookieJarStats get stats {
+    final bindings = FlutterCookieBridgeBindings.instance!;
+    return using((arena) {
+      final counts = arena<Uint64>(2);
+      bindings.jarStats(counts,
+          Pointer<Uint64>.fromAddress(counts.address + sizeOf<Uint64>()));
+      return CookieJarStats(expired: counts[0], evicted: counts[1]);
+    });
+  }
+}
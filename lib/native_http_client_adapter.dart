@@ -0,0 +1,308 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+
+import 'flutter_cookie_bridge_platform_interface.dart';
+import 'json_document.dart';
+import 'lazy_json_transformer.dart';
+
+/// A response read in full by the native transport.
+class NativeHttpResponse {
+  const NativeHttpResponse({
+    required this.status,
+    this.headers = const {},
+    required this.body,
+    this.cacheStatus,
+    this.json,
+  });
+
+  factory NativeHttpResponse.fromMap(Map<Object?, Object?> map) {
+    final headers = map['headers'] as Map<Object?, Object?>? ?? const {};
+    return NativeHttpResponse(
+      status: map['status'] as int,
+      headers: {
+        for (final entry in headers.entries)
+          entry.key as String: (entry.value as List).cast<String>(),
+      },
+      body: map['body'] as Uint8List? ?? Uint8List(0),
+      cacheStatus: map['cache'] as String?,
+      json: map['json'] == null
+          ? null
+          : JsonDocument.fromMap(map['json'] as Map<Object?, Object?>),
+    );
+  }
+
+  final int status;
+
+  /// Names are lower-cased.
+  final Map<String, List<String>> headers;
+  final Uint8List body;
+
+  /// How the HTTP cache answered: `hit` without asking the server,
+  /// `revalidated` after a 304, or `miss`. Null when the request bypassed
+  /// the cache.
+  final String? cacheStatus;
+
+  /// The body parsed natively, when the request asked for it and the
+  /// response was JSON. [body] is then empty.
+  final JsonDocument? json;
+}
+
+/// Counters of the native HTTP cache since it was turned on.
+class HttpCacheStats {
+  const HttpCacheStats({
+    this.lookups = 0,
+    this.hits = 0,
+    this.revalidations = 0,
+    this.misses = 0,
+    this.bytesSaved = 0,
+    this.stores = 0,
+    this.evictions = 0,
+    this.entries = 0,
+    this.sizeBytes = 0,
+  });
+
+  factory HttpCacheStats.fromMap(Map<Object?, Object?> map) {
+    return HttpCacheStats(
+      lookups: map['lookups'] as int? ?? 0,
+      hits: map['hits'] as int? ?? 0,
+      revalidations: map['revalidations'] as int? ?? 0,
+      misses: map['misses'] as int? ?? 0,
+      bytesSaved: map['bytesSaved'] as int? ?? 0,
+      stores: map['stores'] as int? ?? 0,
+      evictions: map['evictions'] as int? ?? 0,
+      entries: map['entries'] as int? ?? 0,
+      sizeBytes: map['sizeBytes'] as int? ?? 0,
+    );
+  }
+
+  /// Cacheable requests, each answered by a hit, a revalidation or a miss.
+  final int lookups;
+  final int hits;
+  final int revalidations;
+  final int misses;
+
+  /// Body bytes served from the cache instead of the network.
+  final int bytesSaved;
+  final int stores;
+  final int evictions;
+
+  /// What the cache holds now.
+  final int entries;
+  final int sizeBytes;
+
+  /// The share of lookups answered without downloading the body again.
+  double get hitRatio => lookups == 0 ? 0 : (hits + revalidations) / lookups;
+}
+
+/// What content coding saved on the wire, and what it cost, since the app
+/// started; for one host or for all of them.
+class CompressionStats {
+  const CompressionStats({
+    this.requests = 0,
+    this.requestBytes = 0,
+    this.requestWireBytes = 0,
+    this.requestsCompressed = 0,
+    this.requestsRefused = 0,
+    this.responses = 0,
+    this.responseWireBytes = 0,
+    this.responseBytes = 0,
+    this.responsesDecoded = 0,
+    this.encodeCpu = Duration.zero,
+    this.decodeCpu = Duration.zero,
+  });
+
+  factory CompressionStats.fromMap(Map<Object?, Object?> map) {
+    return CompressionStats(
+      requests: map['requests'] as int? ?? 0,
+      requestBytes: map['requestBytes'] as int? ?? 0,
+      requestWireBytes: map['requestWireBytes'] as int? ?? 0,
+      requestsCompressed: map['requestsCompressed'] as int? ?? 0,
+      requestsRefused: map['requestsRefused'] as int? ?? 0,
+      responses: map['responses'] as int? ?? 0,
+      responseWireBytes: map['responseWireBytes'] as int? ?? 0,
+      responseBytes: map['responseBytes'] as int? ?? 0,
+      responsesDecoded: map['responsesDecoded'] as int? ?? 0,
+      encodeCpu: Duration(microseconds: map['encodeCpuUs'] as int? ?? 0),
+      decodeCpu: Duration(microseconds: map['decodeCpuUs'] as int? ?? 0),
+    );
+  }
+
+  /// Requests sent, the bytes of their bodies, and the bytes that went on
+  /// the wire for them.
+  final int requests;
+  final int requestBytes;
+  final int requestWireBytes;
+  final int requestsCompressed;
+
+  /// Compressed requests the server answered with 415, which were sent
+  /// again uncompressed.
+  final int requestsRefused;
+
+  /// Responses received, the bytes of their bodies as they came off the
+  /// wire and once decoded.
+  final int responses;
+  final int responseWireBytes;
+  final int responseBytes;
+  final int responsesDecoded;
+
+  /// CPU time spent compressing requests and decoding responses.
+  final Duration encodeCpu;
+  final Duration decodeCpu;
+
+  /// Body bytes that did not have to be sent or received.
+  int get bytesSaved =>
+      requestBytes - requestWireBytes + responseBytes - responseWireBytes;
+
+  /// The share of response bytes that went on the wire; 1 when nothing was
+  /// decoded.
+  double get responseRatio =>
+      responseBytes == 0 ? 1 : responseWireBytes / responseBytes;
+}
+
+/// A Dio [HttpClientAdapter] that sends requests through the plugin's native
+/// transport, where connections are pooled per host and kept alive across
+/// requests, and new TLS connections resume earlier sessions. Downloads use
+/// the same pool, so API calls and downloads to one host share connections.
+///
+/// With [cache] set, GET requests go through the native HTTP cache once it
+/// is turned on; `extra['cache']` of a request overrides this per request.
+/// Requests with `extra['lazyJson']` get a JSON body parsed natively, as it
+/// arrives, and handed to [LazyJsonTransformer] as a [JsonDocument].
+///
+/// Redirects are followed here, as Dio's own adapter does: the `Cookie`,
+/// `Cookie2`, `Authorization` and `WWW-Authenticate` headers are dropped when
+/// a redirect leaves the origin. With [storeCookies] the `Set-Cookie`
+/// headers of every redirect are stored against the URL that sent them, and
+/// with [cookiesFor] every hop then gets the `Cookie` header of its own URL,
+/// so a session cookie set by a 302 reaches the page it redirects to.
+///
+/// Only available where [SessionManager.hasNativeJar] holds. Cancelling is
+/// left to Dio, which stops waiting for the response; the native request
+/// still runs to completion.
+class NativeHttpClientAdapter implements HttpClientAdapter {
+  NativeHttpClientAdapter(
+      {this.cache = false, this.cookiesFor, this.storeCookies});
+
+  bool cache;
+
+  /// Returns the `Cookie` header for a URL redirected to, or null for none.
+  Future<String?> Function(String url)? cookiesFor;
+
+  /// Stores the `Set-Cookie` headers of a redirect response from [url]. Those
+  /// of the final response are left to the caller, which gets them with it.
+  Future<void> Function(String url, List<String> setCookieHeaders)?
+      storeCookies;
+
+  // Credentials that only the origin they were meant for may see.
+  static const Set<String> _originBound = {
+    'cookie',
+    'cookie2',
+    'authorization',
+    'www-authenticate',
+  };
+
+  @override
+  Future<ResponseBody> fetch(
+    RequestOptions options,
+    Stream<Uint8List>? requestStream,
+    Future<void>? cancelFuture,
+  ) async {
+    Uint8List? body;
+    if (requestStream != null) {
+      final builder = BytesBuilder(copy: false);
+      await requestStream.forEach(builder.add);
+      body = builder.takeBytes();
+    }
+    final headers = <String, String>{};
+    options.headers.forEach((name, value) {
+      // The native transport frames the body itself.
+      if (value != null && name.toLowerCase() != 'content-length') {
+        headers[name] = value is Iterable ? value.join(', ') : '$value';
+      }
+    });
+    final timeout = options.receiveTimeout ?? options.connectTimeout;
+    final useCache = options.extra['cache'] as bool? ?? cache;
+    final json = LazyJsonTransformer.wantsDocument(options);
+
+    var method = options.method;
+    var uri = options.uri;
+    final redirects = <RedirectRecord>[];
+    while (true) {
+      final NativeHttpResponse response;
+      try {
+        response = await FlutterCookieBridgePlatform.instance.httpRequest(
+            method, uri.toString(),
+            headers: headers,
+            body: body,
+            timeout: timeout,
+            cache: useCache,
+            json: json);
+      } on PlatformException catch (e) {
+        throw DioException.connectionError(
+            requestOptions: options, reason: e.message ?? e.code, error: e);
+      }
+      final location = response.headers['location'];
+      if (!options.followRedirects ||
+          !_isRedirect(response.status) ||
+          location == null ||
+          redirects.length >= options.maxRedirects) {
+        final document = response.json;
+        if (document != null) {
+          return JsonDocumentResponseBody(document, response.status,
+              headers: response.headers,
+              isRedirect: redirects.isNotEmpty,
+              redirects: redirects);
+        }
+        return ResponseBody.fromBytes(response.body, response.status,
+            headers: response.headers,
+            isRedirect: redirects.isNotEmpty,
+            redirects: redirects);
+      }
+      final previous = uri;
+      uri = uri.resolve(location.first);
+      final setCookies = response.headers['set-cookie'];
+      final store = storeCookies;
+      if (store != null && setCookies != null && setCookies.isNotEmpty) {
+        await store(previous.toString(), setCookies);
+      }
+      if (!_sameOrigin(previous, uri)) {
+        headers.removeWhere(
+            (name, _) => _originBound.contains(name.toLowerCase()));
+      }
+      final lookup = cookiesFor;
+      if (lookup != null) {
+        final cookies = await lookup(uri.toString());
+        if (cookies != null && cookies.isNotEmpty) {
+          headers.removeWhere((name, _) => name.toLowerCase() == 'cookie');
+          headers['Cookie'] = cookies;
+        }
+      }
+      if (response.status == 303 ||
+          (response.status <= 302 && method == 'POST')) {
+        // As browsers do: the redirect is followed with a GET.
+        method = 'GET';
+        body = null;
+        headers.removeWhere((name, _) => name.toLowerCase() == 'content-type');
+      }
+      redirects.add(RedirectRecord(response.status, method, uri));
+    }
+  }
+
+  static bool _sameOrigin(Uri a, Uri b) =>
+      a.scheme == b.scheme && a.host == b.host && a.port == b.port;
+
+  static bool _isRedirect(int status) =>
+      status == 301 ||
+      status == 302 ||
+      status == 303 ||
+      status == 307 ||
+      status == 308;
+
+  @override
+  void close({bool force = false}) {
+    // The connections belong to the process-wide native pool.
+  }
+}
@@ -0,0 +1,246 @@
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'flutter_cookie_bridge_ffi.dart';
+
+/// What [NavigationRules.match] found in one URL. The WebView decides what
+/// to do with it, in the order it always has.
+class NavigationMatch {
+  const NavigationMatch._(this._tags);
+
+  final int _tags;
+
+  bool _has(int tag) => _tags & tag != 0;
+
+  /// The URL opens Outlook, Gmail or Yahoo Mail on Android.
+  bool get outlookIntent => _has(NavigationRules._outlook);
+  bool get gmailIntent => _has(NavigationRules._gmail);
+  bool get yahooMailIntent => _has(NavigationRules._yahooMail);
+
+  /// The URL carries a `status` for the app: `/redirect?status=` or
+  /// `/session-expired?status=`.
+  bool get statusRedirect => _has(NavigationRules._statusRedirect);
+
+  /// The server ended the session: `/api/user/redirect`.
+  bool get sessionExpired => _has(NavigationRules._sessionExpired);
+
+  /// The URL is a statement or image to download rather than show.
+  bool get download => _has(NavigationRules._download);
+
+  /// The URL may load in the WebView on Android or iOS: it contains one of
+  /// the platform's whitelist entries or the host name. On Android the host
+  /// name only counts when the whitelist has entries, as it always has.
+  bool get allowedOnAndroid => _has(NavigationRules._allowedOnAndroid);
+  bool get allowedOnIos => _has(NavigationRules._allowedOnIos);
+
+  bool get aboutBlank => _has(NavigationRules._aboutBlank);
+
+  /// The URL needs the Karza user agent.
+  bool get karza => _has(NavigationRules._karza);
+}
+
+/// The URL checks of a WebView, compiled once into a single automaton.
+///
+/// Every check is "the URL contains this text", and a navigation used to
+/// run them one by one: a dozen fixed ones plus one per whitelist
+/// entry, each a scan of the URL. Here they all go into one Aho-Corasick
+/// automaton that finds every one of them in a single pass, so the cost of
+/// a navigation depends on the length of the URL and not on the size of
+/// the whitelists.
+///
+/// The automaton lives in the native library where
+/// [FlutterCookieBridgeBindings.instance] is available, and in Dart
+/// everywhere else.
+class NavigationRules implements Finalizable {
+  NavigationRules({
+    List<String> whitelistedUrlsAndroid = const [],
+    List<String> whitelistedUrlsIos = const [],
+    String hostName = '',
+    required String karzaDomain,
+  }) {
+    final patterns = <String, int>{};
+    void add(String pattern, int tag) =>
+        patterns[pattern] = (patterns[pattern] ?? 0) | tag;
+    add('ms-outlook://', _outlook);
+    add('googlegmail://', _gmail);
+    add('ymail://', _yahooMail);
+    add('/redirect?status=', _statusRedirect);
+    add('/session-expired?status=', _statusRedirect);
+    add('/api/user/redirect', _sessionExpired);
+    for (final pattern in _downloadPatterns) {
+      add(pattern, _download);
+    }
+    for (final white in whitelistedUrlsAndroid) {
+      add(white, _allowedOnAndroid);
+    }
+    for (final white in whitelistedUrlsIos) {
+      add(white, _allowedOnIos);
+    }
+    if (hostName.isNotEmpty) {
+      int tag = _allowedOnIos;
+      if (whitelistedUrlsAndroid.isNotEmpty) {
+        tag |= _allowedOnAndroid;
+      }
+      add(hostName, tag);
+    }
+    add('about:blank', _aboutBlank);
+    add(karzaDomain, _karza);
+
+    final bindings = FlutterCookieBridgeBindings.instance;
+    if (bindings == null) {
+      _dart = _PatternAutomaton(patterns);
+      return;
+    }
+    _native = using((arena) {
+      final encoded = patterns.keys.map(utf8.encode).toList();
+      final total = encoded.fold<int>(0, (sum, bytes) => sum + bytes.length);
+      final data = arena<Uint8>(total == 0 ? 1 : total);
+      final lengths = arena<Uint32>(encoded.length);
+      final tags = arena<Uint32>(encoded.length);
+      final view = data.asTypedList(total);
+      int offset = 0;
+      int i = 0;
+      for (final tag in patterns.values) {
+        view.setRange(offset, offset + encoded[i].length, encoded[i]);
+        lengths[i] = encoded[i].length;
+        tags[i] = tag;
+        offset += encoded[i].length;
+        i++;
+      }
+      return bindings.patternsCreate(data, lengths, tags, encoded.length);
+    });
+    _finalizer(bindings).attach(this, _native);
+  }
+
+  static const int _outlook = 1 << 0;
+  static const int _gmail = 1 << 1;
+  static const int _yahooMail = 1 << 2;
+  static const int _statusRedirect = 1 << 3;
+  static const int _sessionExpired = 1 << 4;
+  static const int _download = 1 << 5;
+  static const int _allowedOnAndroid = 1 << 6;
+  static const int _allowedOnIos = 1 << 7;
+  static const int _aboutBlank = 1 << 8;
+  static const int _karza = 1 << 9;
+
+  static const List<String> _downloadPatterns = [
+    '.pdf',
+    '/statements/',
+    '/download_statements',
+    '.jpeg',
+    '.png',
+  ];
+
+  static NativeFinalizer? _nativeFinalizer;
+
+  static NativeFinalizer _finalizer(FlutterCookieBridgeBindings bindings) =>
+      _nativeFinalizer ??= NativeFinalizer(bindings.patternsFree);
+
+  _PatternAutomaton? _dart;
+  Pointer<Void> _native = nullptr;
+
+  /// Runs every rule against [url] in one pass.
+  NavigationMatch match(String url) {
+    final dart = _dart;
+    if (dart != null) {
+      return NavigationMatch._(dart.match(url));
+    }
+    final bindings = FlutterCookieBridgeBindings.instance!;
+    return using((arena) {
+      final encoded = utf8.encode(url);
+      final data = arena<Uint8>(encoded.isEmpty ? 1 : encoded.length);
+      data.asTypedList(encoded.length).setAll(0, encoded);
+      return NavigationMatch._(
+          bindings.patternsMatch(_native, data, encoded.length));
+    });
+  }
+}
+
+/// The Dart twin of the native UrlPatternSet: an Aho-Corasick automaton
+/// turned into a full transition table over UTF-16 code units, where the
+/// code units no pattern uses share one column.
+class _PatternAutomaton {
+  _PatternAutomaton(Map<String, int> patterns) {
+    for (final pattern in patterns.keys) {
+      for (final unit in pattern.codeUnits) {
+        if (_classOf(unit) == 0) {
+          if (unit < 128) {
+            _asciiClasses[unit] = _classCount++;
+          } else {
+            _otherClasses[unit] = _classCount++;
+          }
+        }
+      }
+    }
+
+    // The trie of the patterns, with -1 for missing edges.
+    final next = List<int>.filled(_classCount, -1, growable: true);
+    final tags = <int>[0];
+    patterns.forEach((pattern, tag) {
+      int state = 0;
+      for (final unit in pattern.codeUnits) {
+        final edge = state * _classCount + _classOf(unit);
+        if (next[edge] == -1) {
+          next[edge] = tags.length;
+          tags.add(0);
+          next.addAll(List<int>.filled(_classCount, -1));
+        }
+        state = next[edge];
+      }
+      tags[state] |= tag;
+    });
+
+    // Breadth first, so that the failure state of each state is complete
+    // before the state borrows its missing edges and its tags from it.
+    final failure = List<int>.filled(tags.length, 0);
+    final queue = Queue<int>();
+    for (int c = 0; c < _classCount; c++) {
+      if (next[c] == -1) {
+        next[c] = 0;
+      } else {
+        tags[next[c]] |= tags[0];
+        queue.add(next[c]);
+      }
+    }
+    while (queue.isNotEmpty) {
+      final state = queue.removeFirst();
+      final fallback = failure[state] * _classCount;
+      for (int c = 0; c < _classCount; c++) {
+        final edge = state * _classCount + c;
+        if (next[edge] == -1) {
+          next[edge] = next[fallback + c];
+        } else {
+          final child = next[edge];
+          failure[child] = next[fallback + c];
+          tags[child] |= tags[failure[child]];
+          queue.add(child);
+        }
+      }
+    }
+    _next = Uint32List.fromList(next);
+    _tags = Uint32List.fromList(tags);
+  }
+
+  final Int32List _asciiClasses = Int32List(128);
+  final Map<int, int> _otherClasses = {};
+  int _classCount = 1;
+  late final Uint32List _next;
+  late final Uint32List _tags;
+
+  int _classOf(int unit) =>
+      unit < 128 ? _asciiClasses[unit] : _otherClasses[unit] ?? 0;
+
+  int match(String url) {
+    int state = 0;
+    int tags = _tags[0];
+    for (int i = 0; i < url.length; i++) {
+      state = _next[state * _classCount + _classOf(url.codeUnitAt(i))];
+      tags |= _tags[state];
+    }
+    return tags;
+  }
+}
@@ -1,6 +1,12 @@
 import 'package:dio/dio.dart';
 import 'package:flutter/foundation.dart';
+import 'cookie_bridge_trace.dart';
+import 'flutter_cookie_bridge_platform_interface.dart';
+import 'lazy_json_transformer.dart';
+import 'native_http_client_adapter.dart';
+import 'request_scheduler.dart';
 import 'session_manager.dart';
+import 'set_cookie_parser.dart';
 
 class NetworkManager {
   SessionManager? sessionManager;
@@ -17,54 +23,141 @@ class NetworkManager {
   }
 
   late Dio _dio;
+  NativeHttpClientAdapter? _nativeAdapter;
+  final Map<String, Future<Response>> _inFlightGets = {};
+  int _coalescedGets = 0;
+
+  /// Orders requests by priority under per-host limits; see [request].
+  RequestScheduler scheduler = RequestScheduler.instance;
 
   NetworkManager._internal() {
-    _dio = Dio();
+    // Requests with Options(extra: {'lazyJson': true}) get a JsonDocument
+    // parsed off the UI isolate; the rest are decoded as before.
+    _dio = Dio()..transformer = LazyJsonTransformer();
+    if (SessionManager.hasNativeJar) {
+      // Shares keep-alive connections and TLS sessions with downloads.
+      _dio.httpClientAdapter = _nativeAdapter = NativeHttpClientAdapter(
+          cookiesFor: (url) async => sessionManager?.getCookieHeader(url),
+          storeCookies: _storeSetCookies);
+    }
+  }
+
+  /// Whether [enableCache] can do anything on this platform. The cache lives
+  /// in the native transport, which only exists where
+  /// [SessionManager.hasNativeJar] holds.
+  bool get supportsCache => _nativeAdapter != null;
+
+  /// Answers GETs from an on-disk HTTP cache of up to [maxBytes], keyed by
+  /// URL and cookies, that honors `Cache-Control` and revalidates stale
+  /// responses with `If-None-Match`/`If-Modified-Since`. A request can opt
+  /// out with `Options(extra: {'cache': false})`.
+  Future<void> enableCache({int? maxBytes}) async {
+    final adapter = _nativeAdapter;
+    if (adapter == null) {
+      return;
+    }
+    await FlutterCookieBridgePlatform.instance
+        .configureHttpCache(enabled: true, maxBytes: maxBytes);
+    adapter.cache = true;
+  }
+
+  Future<void> disableCache() async {
+    final adapter = _nativeAdapter;
+    if (adapter == null) {
+      return;
+    }
+    adapter.cache = false;
+    await FlutterCookieBridgePlatform.instance
+        .configureHttpCache(enabled: false);
+  }
+
+  /// The cache's hit ratio, bytes saved and size; all zero without a cache.
+  Future<HttpCacheStats> cacheStats() {
+    if (_nativeAdapter == null) {
+      return Future.value(const HttpCacheStats());
+    }
+    return FlutterCookieBridgePlatform.instance.httpCacheStats();
+  }
+
+  Future<void> clearCache() async {
+    if (_nativeAdapter != null) {
+      await FlutterCookieBridgePlatform.instance.clearHttpCache();
+    }
+  }
+
+  /// Sets how request and response bodies to [host] are compressed, or
+  /// those of every host without its own settings when [host] is null; see
+  /// [FlutterCookieBridgePlatform.configureCompression]. Responses are
+  /// decoded natively, as they arrive, in any coding of [accept]. Bodies of
+  /// POST, PUT and PATCH requests of at least [minRequestBytes] are sent in
+  /// [requestEncoding], which should only be set for hosts that take it.
+  /// Does nothing where the native transport is unavailable, where Dio's
+  /// own client negotiates gzip responses.
+  Future<void> configureCompression(
+      {String? host,
+      List<String>? accept,
+      String? requestEncoding,
+      int? minRequestBytes,
+      int? level}) async {
+    if (_nativeAdapter == null) {
+      return;
+    }
+    await FlutterCookieBridgePlatform.instance.configureCompression(
+        host: host,
+        accept: accept,
+        requestEncoding: requestEncoding,
+        minRequestBytes: minRequestBytes,
+        level: level);
+  }
+
+  /// Puts [host] back on the settings of every host.
+  Future<void> resetCompression(String host) async {
+    if (_nativeAdapter != null) {
+      await FlutterCookieBridgePlatform.instance
+          .configureCompression(host: host, reset: true);
+    }
+  }
+
+  /// The bytes on the wire against the bytes of the bodies, and the CPU time
+  /// spent on codecs, for [host] or for every host; all zero without the
+  /// native transport.
+  Future<CompressionStats> compressionStats({String? host}) {
+    if (_nativeAdapter == null) {
+      return Future.value(const CompressionStats());
+    }
+    return FlutterCookieBridgePlatform.instance.compressionStats(host: host);
   }
 
   void setSessionManager(SessionManager sessionManager) {
     this.sessionManager = sessionManager;
   }
 
+  /// Sends a [method] request to [url] with the session's cookies. It waits
+  /// in [scheduler] for a slot, ahead of or behind others by [priority].
   Future<Response?> request({
     required String url,
     required String method,
     Map<String, dynamic>? body,
     Map<String, dynamic>? headers,
     Options? options,
+    RequestPriority priority = RequestPriority.normal,
   }) async {
+    final traceStart = CookieBridgeTrace.begin();
     try {
       headers = headers ?? {};
       options = options ?? Options(headers: headers);
 
-      List<String>? savedCookies = await sessionManager?.getSessionCookies();
-      if (savedCookies!.isNotEmpty) {
-        headers['Cookie'] = savedCookies.join('; ');
+      final lookupStart = CookieBridgeTrace.begin();
+      String? cookieHeader = await sessionManager?.getCookieHeader(url);
+      CookieBridgeTrace.end('network.cookie_lookup', lookupStart);
+      if (cookieHeader != null && cookieHeader.isNotEmpty) {
+        headers['Cookie'] = cookieHeader;
       }
 
-      Response response;
-
-      switch (method.toUpperCase()) {
-        case 'POST':
-          response = await _dio.post(url, data: body, options: options);
-          break;
-        case 'GET':
-          response = await _dio.get(url, options: options);
-          break;
-        case 'PUT':
-          response = await _dio.put(url, data: body, options: options);
-          break;
-        case 'PATCH':
-          response = await _dio.patch(url, data: body, options: options);
-          break;
-        case 'DELETE':
-          response = await _dio.delete(url, data: body, options: options);
-          break;
-        default:
-          throw UnsupportedError("Method not supported: $method");
+      if (method.toUpperCase() == 'GET') {
+        return await _coalescedGet(url, options, priority);
       }
-      _storeResponseCookies(response);
-      return response;
+      return await _send(url, method, body, options, priority);
     } on DioException catch (e) {
       if (kDebugMode) {
         print("Error during network request: $e");
@@ -75,74 +168,172 @@ class NetworkManager {
         print("Unexpected error during network request: $e");
       }
       return null;
+    } finally {
+      CookieBridgeTrace.end('network.request', traceStart);
+    }
+  }
+
+  /// GETs that joined one already in flight instead of sending their own.
+  int get coalescedGets => _coalescedGets;
+
+  @visibleForTesting
+  Dio get dio => _dio;
+
+  // Joins an identical GET already in flight, so that widgets mounting
+  // together send one request and store its cookies once. They all get the
+  // same Response, and the options of whichever asked first apply. GETs of
+  // different priorities are not joined, so that an interactive one never
+  // waits in the background lane.
+  Future<Response> _coalescedGet(
+      String url, Options options, RequestPriority priority) {
+    final key = '${priority.name}\n${_getKey(url, options)}';
+    final inFlight = _inFlightGets[key];
+    if (inFlight != null) {
+      _coalescedGets++;
+      return inFlight;
+    }
+    return _inFlightGets[key] = _send(url, 'GET', null, options, priority)
+        .whenComplete(() => _inFlightGets.remove(key));
+  }
+
+  // What makes two GETs interchangeable: the URL, the headers with the
+  // cookies among them, and how the response is decoded.
+  static String _getKey(String url, Options options) {
+    final headers = [
+      for (final entry in (options.headers ?? const {}).entries)
+        '${entry.key.toLowerCase()}: ${entry.value}'
+    ]..sort();
+    return [
+      url,
+      '${options.responseType}',
+      '${options.extra?['cache']}',
+      '${options.extra?['lazyJson']}',
+      ...headers,
+    ].join('\n');
+  }
+
+  Future<Response> _send(String url, String method,
+      Map<String, dynamic>? body, Options options,
+      RequestPriority priority) async {
+    final Future<Response> Function() send;
+
+    switch (method.toUpperCase()) {
+      case 'POST':
+        send = () => _dio.post(url, data: body, options: options);
+        break;
+      case 'GET':
+        send = () => _dio.get(url, options: options);
+        break;
+      case 'PUT':
+        send = () => _dio.put(url, data: body, options: options);
+        break;
+      case 'PATCH':
+        send = () => _dio.patch(url, data: body, options: options);
+        break;
+      case 'DELETE':
+        send = () => _dio.delete(url, data: body, options: options);
+        break;
+      default:
+        throw UnsupportedError("Method not supported: $method");
     }
+    final sendStart = CookieBridgeTrace.begin();
+    Response response = await scheduler.schedule(url, priority, send);
+    CookieBridgeTrace.end('network.send', sendStart);
+    final storeStart = CookieBridgeTrace.begin();
+    _storeResponseCookies(response);
+    CookieBridgeTrace.end('network.store_set_cookie', storeStart);
+    return response;
   }
 
+  // Stores the cookies against the URL that sent them, which is the last
+  // one redirected to.
   void _storeResponseCookies(Response response) {
     if (response.headers['set-cookie'] != null) {
-      List<String> cookiesList = response.headers['set-cookie']!;
+      _storeSetCookies(
+          response.realUri.toString(), response.headers['set-cookie']!);
+    }
+  }
 
-      List<String> filteredCookies = [];
+  // Stores the cookies a response from [url] set, but for redirect_url.
+  Future<void> _storeSetCookies(String url, List<String> cookiesList) async {
+    List<String> setCookieHeaders = [];
 
-      for (String cookie in cookiesList) {
-        String actualCookie = cookie.split(';')[0];
+    List<SetCookie?> parsedCookies = SetCookieParser.parseAll(cookiesList);
+    for (int i = 0; i < cookiesList.length; i++) {
+      SetCookie? parsed = parsedCookies[i];
 
-        if (actualCookie.isNotEmpty &&
-            !actualCookie.contains('redirect_url=')) {
-          filteredCookies.add(actualCookie);
-        }
+      if (parsed != null && parsed.name != 'redirect_url') {
+        setCookieHeaders.add(cookiesList[i]);
       }
+    }
 
-      if (filteredCookies.isNotEmpty) {
-        sessionManager?.saveSessionCookies(filteredCookies);
-      }
+    if (setCookieHeaders.isNotEmpty) {
+      await sessionManager?.storeResponseCookies(url, setCookieHeaders);
     }
   }
 
   Future<Response?> get(String url,
-      {Map<String, dynamic>? headers, Options? options}) {
-    return request(url: url, method: 'GET', headers: headers, options: options);
+      {Map<String, dynamic>? headers,
+      Options? options,
+      RequestPriority priority = RequestPriority.normal}) {
+    return request(
+        url: url,
+        method: 'GET',
+        headers: headers,
+        options: options,
+        priority: priority);
   }
 
   Future<Response?> post(String url, Map<String, dynamic> body,
-      {Map<String, dynamic>? headers, Options? options}) {
+      {Map<String, dynamic>? headers,
+      Options? options,
+      RequestPriority priority = RequestPriority.normal}) {
     return request(
         url: url,
         method: 'POST',
         body: body,
         headers: headers,
-        options: options);
+        options: options,
+        priority: priority);
   }
 
   Future<Response?> put(String url, Map<String, dynamic> body,
-      {Map<String, dynamic>? headers, Options? options}) {
+      {Map<String, dynamic>? headers,
+      Options? options,
+      RequestPriority priority = RequestPriority.normal}) {
     return request(
         url: url,
         method: 'PUT',
         body: body,
         headers: headers,
-        options: options);
+        options: options,
+        priority: priority);
   }
 
   Future<Response?> patch(String url, Map<String, dynamic> body,
-      {Map<String, dynamic>? headers, Options? options}) {
+      {Map<String, dynamic>? headers,
+      Options? options,
+      RequestPriority priority = RequestPriority.normal}) {
     return request(
         url: url,
         method: 'PATCH',
         body: body,
         headers: headers,
-        options: options);
+        options: options,
+        priority: priority);
   }
 
   Future<Response?> delete(String url,
       {Map<String, dynamic>? headers,
       Map<String, dynamic>? body,
-      Options? options}) {
+      Options? options,
+      RequestPriority priority = RequestPriority.normal}) {
     return request(
         url: url,
         method: 'DELETE',
         body: body,
         headers: headers,
-        options: options);
+        options: options,
+        priority: priority);
   }
 }
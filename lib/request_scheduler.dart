@@ -0,0 +1,227 @@
+import 'dart:async';
+
+/// How urgently a request is needed.
+enum RequestPriority {
+  /// Something the user is waiting on, such as the response to a tap.
+  interactive,
+
+  normal,
+
+  /// Prefetches and transfers nobody is waiting on, such as downloads.
+  background,
+}
+
+/// What one priority lane of a [RequestScheduler] is doing.
+class LaneStats {
+  const LaneStats({
+    this.queued = 0,
+    this.maxQueued = 0,
+    this.inFlight = 0,
+    this.started = 0,
+    this.p50Wait = Duration.zero,
+    this.p99Wait = Duration.zero,
+    this.maxWait = Duration.zero,
+  });
+
+  /// Requests waiting for a slot now, and the most there ever were.
+  final int queued;
+  final int maxQueued;
+  final int inFlight;
+  final int started;
+
+  /// Time from being scheduled to being sent, over the most recent
+  /// requests.
+  final Duration p50Wait;
+  final Duration p99Wait;
+  final Duration maxWait;
+
+  @override
+  String toString() => 'LaneStats(queued: $queued, inFlight: $inFlight, '
+      'started: $started, p50Wait: $p50Wait, p99Wait: $p99Wait)';
+}
+
+/// Decides when requests are sent, so that a tap does not wait behind a
+/// large transfer.
+///
+/// Each host gets at most [maxPerHost] requests at once, and requests that
+/// are not [RequestPriority.interactive] leave [reservedForInteractive] of
+/// them free. When a slot frees up, lanes take turns in proportion to their
+/// [weights], so background work slows down under load but never starves.
+/// Within a lane requests go first come, first served, except that one
+/// waiting for a busy host does not hold up those for other hosts.
+class RequestScheduler {
+  RequestScheduler({
+    this.maxPerHost = 6,
+    this.reservedForInteractive = 2,
+    this.weights = const {
+      RequestPriority.interactive: 8,
+      RequestPriority.normal: 4,
+      RequestPriority.background: 1,
+    },
+  }) : assert(reservedForInteractive < maxPerHost);
+
+  /// The scheduler NetworkManager and DownloadManager share, so that their
+  /// requests count against the same per-host limits.
+  static final RequestScheduler instance = RequestScheduler();
+
+  final int maxPerHost;
+  final int reservedForInteractive;
+  final Map<RequestPriority, int> weights;
+
+  static const int _waitSamples = 1024;
+
+  final Map<RequestPriority, _Lane> _lanes = {
+    for (final priority in RequestPriority.values) priority: _Lane(),
+  };
+  final Map<String, int> _inFlightByHost = {};
+
+  /// Runs [send] once a slot for the host of [url] is free for [priority],
+  /// and completes with its result.
+  Future<T> schedule<T>(
+      String url, RequestPriority priority, Future<T> Function() send) {
+    final task = _Task<T>(_hostOf(url), send);
+    final lane = _lanes[priority]!;
+    lane.queue.add(task);
+    if (lane.queue.length > lane.maxQueued) {
+      lane.maxQueued = lane.queue.length;
+    }
+    _pump();
+    return task.completer.future;
+  }
+
+  /// Queue depth, concurrency and wait times of every lane.
+  Map<RequestPriority, LaneStats> stats() {
+    return {
+      for (final entry in _lanes.entries) entry.key: entry.value.stats(),
+    };
+  }
+
+  int inFlightFor(String url) => _inFlightByHost[_hostOf(url)] ?? 0;
+
+  static String _hostOf(String url) {
+    final uri = Uri.tryParse(url);
+    return uri == null ? url : '${uri.scheme}://${uri.authority}';
+  }
+
+  int _limitFor(RequestPriority priority) =>
+      priority == RequestPriority.interactive
+          ? maxPerHost
+          : maxPerHost - reservedForInteractive;
+
+  // The first task of |priority| whose host has room for it.
+  int _firstReady(RequestPriority priority) {
+    final limit = _limitFor(priority);
+    final queue = _lanes[priority]!.queue;
+    for (int i = 0; i < queue.length; i++) {
+      if ((_inFlightByHost[queue[i].host] ?? 0) < limit) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Starts tasks until no lane has one that may go. Lanes are picked by
+  // smooth weighted round robin among those with a task ready.
+  void _pump() {
+    while (true) {
+      RequestPriority? chosen;
+      int chosenIndex = -1;
+      int totalWeight = 0;
+      for (final priority in RequestPriority.values) {
+        final index = _firstReady(priority);
+        if (index < 0) {
+          continue;
+        }
+        final lane = _lanes[priority]!;
+        final weight = weights[priority] ?? 1;
+        lane.credit += weight;
+        totalWeight += weight;
+        if (chosen == null || lane.credit > _lanes[chosen]!.credit) {
+          chosen = priority;
+          chosenIndex = index;
+        }
+      }
+      if (chosen == null) {
+        return;
+      }
+      final lane = _lanes[chosen]!;
+      lane.credit -= totalWeight;
+      _start(lane, lane.queue.removeAt(chosenIndex));
+    }
+  }
+
+  void _start(_Lane lane, _Task task) {
+    lane.recordWait(task.waiting.elapsed, _waitSamples);
+    lane.inFlight++;
+    lane.started++;
+    _inFlightByHost[task.host] = (_inFlightByHost[task.host] ?? 0) + 1;
+    task.run().whenComplete(() {
+      lane.inFlight--;
+      final left = _inFlightByHost[task.host]! - 1;
+      if (left == 0) {
+        _inFlightByHost.remove(task.host);
+      } else {
+        _inFlightByHost[task.host] = left;
+      }
+      _pump();
+    });
+  }
+}
+
+class _Task<T> {
+  _Task(this.host, this._send);
+
+  final String host;
+  final Future<T> Function() _send;
+  final Completer<T> completer = Completer<T>();
+  final Stopwatch waiting = Stopwatch()..start();
+
+  // Runs the request, passing its outcome on. The returned future never
+  // fails, so the scheduler can wait on it without handling errors.
+  Future<void> run() async {
+    try {
+      completer.complete(await _send());
+    } catch (error, stackTrace) {
+      completer.completeError(error, stackTrace);
+    }
+  }
+}
+
+class _Lane {
+  final List<_Task> queue = [];
+  int maxQueued = 0;
+  int inFlight = 0;
+  int started = 0;
+  int credit = 0;
+  final List<Duration> _waits = [];
+  int _nextWait = 0;
+  Duration _maxWait = Duration.zero;
+
+  void recordWait(Duration wait, int capacity) {
+    if (_waits.length < capacity) {
+      _waits.add(wait);
+    } else {
+      _waits[_nextWait] = wait;
+      _nextWait = (_nextWait + 1) % capacity;
+    }
+    if (wait > _maxWait) {
+      _maxWait = wait;
+    }
+  }
+
+  LaneStats stats() {
+    final sorted = [..._waits]..sort();
+    Duration at(double fraction) => sorted.isEmpty
+        ? Duration.zero
+        : sorted[((sorted.length - 1) * fraction).round()];
+    return LaneStats(
+      queued: queue.length,
+      maxQueued: maxQueued,
+      inFlight: inFlight,
+      started: started,
+      p50Wait: at(0.5),
+      p99Wait: at(0.99),
+      maxWait: _maxWait,
+    );
+  }
+}
@@ -1,11 +1,33 @@
+import 'dart:async';
+import 'dart:io';
+
 import 'package:shared_preferences/shared_preferences.dart';
 import 'package:flutter_inappwebview/flutter_inappwebview.dart';
+import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
 
-//Can use Encrypted Network Manager..
+import 'cookie_changes.dart';
+import 'domain_cookie_jar.dart';
+import 'flutter_cookie_bridge_platform_interface.dart';
+import 'native_cookie_jar.dart';
+import 'set_cookie_parser.dart';
+
+/// Keeps the session cookies: in the plugin's native jar where there is one,
+/// whose log on disk is encrypted record by record, and otherwise in a
+/// [DomainCookieJar] saved to SharedPreferences.
+///
+/// Cookies live in named partitions, one of which is active, so that an app
+/// can keep a session per user profile, or for a partner flow, and switch
+/// between them without logging out; see [switchPartition]. Only the
+/// [defaultPartition] outlives the process.
 class SessionManager {
   static final SessionManager _instance = SessionManager._internal();
+  // Written by older versions: name=value pairs without a domain.
   static const String _cookieKey = 'session_cookies';
+  static const String _jarKey = 'session_cookie_jar';
+
+  /// The partition cookies go to until [switchPartition] is called.
+  static const String defaultPartition = 'default';
 
   factory SessionManager() {
     return _instance;
@@ -13,25 +35,262 @@ class SessionManager {
 
   SessionManager._internal();
 
+  /// Whether cookies are kept in the plugin's native cookie jar, which is
+  /// looked up per URL and persisted natively instead of in
+  /// SharedPreferences.
+  static bool get hasNativeJar => !kIsWeb && Platform.isLinux;
+
+  // Moves the cookies an older version, or saveSessionCookies, saved into
+  // the jar, once; every lookup and store waits for it, so that requests
+  // sent together at startup all see them.
+  Future<void>? _legacyCookies;
+
+  // The jar of platforms without the native one, persisted in
+  // SharedPreferences, and its change feed, which it versions itself.
+  Future<DomainCookieJar>? _jar;
+  final StreamController<CookieDelta> _changes =
+      StreamController<CookieDelta>.broadcast();
+  int _version = 0;
+
+  String _partition = defaultPartition;
+  // The inactive partitions of the Dart jar.
+  final Map<String, DomainCookieJar> _partitions = {};
+
+  /// The partition cookies are stored in and read from.
+  String get activePartition => _partition;
+
+  /// Cookies stored or removed after listening, so that open WebViews can
+  /// apply only what changed instead of resetting every cookie.
+  Stream<CookieDelta> get cookieChanges {
+    if (hasNativeJar) {
+      return FlutterCookieBridgePlatform.instance.cookieChanges();
+    }
+    return _changes.stream;
+  }
+
+  /// Cookies the jar dropped on its own, because they expired or to stay
+  /// within its limits. Zero where the jar lives behind the method channel.
+  Future<CookieJarStats> get cookieJarStats async {
+    if (hasNativeJar) {
+      return NativeCookieJar.isAvailable
+          ? NativeCookieJar.stats
+          : const CookieJarStats();
+    }
+    return (await _dartJar(null)).stats;
+  }
+
+  /// Keeps [cookies], `name=value` pairs without a domain, as older versions
+  /// did: they are stored for the host of the next request, with path `/`,
+  /// like the cookies those versions left behind.
+  @Deprecated('Use storeResponseCookies, which keeps the domain and path '
+      'each server gave its cookies')
   Future<void> saveSessionCookies(List<String> cookies) async {
+    // A migration still running would remove them once it is done; one
+    // that failed is tried again with these.
+    final migration = _legacyCookies;
+    if (migration != null) {
+      try {
+        await migration;
+      } catch (_) {}
+    }
     SharedPreferences prefs = await SharedPreferences.getInstance();
-    String cookiesString = cookies.join('; ');
-    await prefs.setString(_cookieKey, cookiesString);
+    await prefs.setString(_cookieKey, cookies.join('; '));
+    _legacyCookies = null;
   }
 
+  /// Every stored cookie as a `name=value` pair, whatever its domain.
   Future<List<String>> getSessionCookies() async {
+    if (hasNativeJar) {
+      return FlutterCookieBridgePlatform.instance.getCookies();
+    }
+    final jar = await _dartJar(null);
+    final now = DateTime.now().toUtc();
+    return [
+      for (final cookie in jar.cookies)
+        if (!cookie.isExpiredAt(now)) '${cookie.name}=${cookie.value}',
+    ];
+  }
+
+  /// Stores the raw `set-cookie` header values of a response to [url], to be
+  /// sent back to the hosts and paths they are scoped to.
+  Future<void> storeResponseCookies(
+      String url, List<String> setCookieHeaders) async {
+    if (!hasNativeJar) {
+      final jar = await _dartJar(url);
+      final uri = Uri.tryParse(url);
+      if (uri == null) {
+        return;
+      }
+      final changes =
+          jar.setCookies(uri, SetCookieParser.parseAll(setCookieHeaders));
+      if (changes.isNotEmpty) {
+        _changes.add(CookieDelta(version: ++_version, changes: changes));
+        await _saveDartJar(jar);
+      }
+      return;
+    }
+    await _seedNativeJar(url);
+    if (NativeCookieJar.isAvailable) {
+      NativeCookieJar.setCookies(url, setCookieHeaders);
+      return;
+    }
+    await FlutterCookieBridgePlatform.instance
+        .setCookies(url, setCookieHeaders);
+  }
+
+  /// Returns the `Cookie` header to send with a request to [url], or null
+  /// when there is no cookie to send.
+  Future<String?> getCookieHeader(String url) async {
+    if (hasNativeJar) {
+      await _seedNativeJar(url);
+      if (NativeCookieJar.isAvailable) {
+        return NativeCookieJar.cookieHeader(url);
+      }
+      return FlutterCookieBridgePlatform.instance.getCookieHeader(url);
+    }
+    final jar = await _dartJar(url);
+    final uri = Uri.tryParse(url);
+    return uri == null ? null : jar.cookieHeader(uri);
+  }
+
+  // The Dart jar, loaded on first use. Cookies saved by an older version
+  // carry no domain, and used to be attached to every request, so they go
+  // to the host of the first [url] the app talks to.
+  Future<DomainCookieJar> _dartJar(String? url) async {
+    final jar = await (_jar ??= _loadDartJar());
+    Uri? uri = url == null ? null : Uri.tryParse(url);
+    if (uri != null) {
+      _legacyCookies ??= _migrate(() => _seedDartJar(jar, uri));
+    }
+    final migration = _legacyCookies;
+    if (migration != null) {
+      await migration;
+    }
+    return jar;
+  }
+
+  Future<void> _seedDartJar(DomainCookieJar jar, Uri uri) async {
     SharedPreferences prefs = await SharedPreferences.getInstance();
     String? cookieString = prefs.getString(_cookieKey);
     if (cookieString != null && cookieString.isNotEmpty) {
-      return cookieString.split('; ');
+      jar.setCookies(
+          uri,
+          cookieString
+              .split('; ')
+              .map((c) => SetCookieParser.parseDart('$c; Path=/'))
+              .toList());
+      await _saveDartJar(jar);
+    }
+    await prefs.remove(_cookieKey);
+  }
+
+  // Runs [seed] as the migration, which is tried again on the next request
+  // if it fails.
+  Future<void> _migrate(Future<void> Function() seed) async {
+    try {
+      await seed();
+    } catch (_) {
+      _legacyCookies = null;
+      rethrow;
+    }
+  }
+
+  Future<DomainCookieJar> _loadDartJar() async {
+    SharedPreferences prefs = await SharedPreferences.getInstance();
+    String? saved = prefs.getString(_jarKey);
+    try {
+      return saved == null ? DomainCookieJar() : DomainCookieJar.decode(saved);
+    } on FormatException {
+      return DomainCookieJar();
+    }
+  }
+
+  Future<void> _saveDartJar(DomainCookieJar jar) async {
+    if (_partition != defaultPartition) {
+      return;
+    }
+    SharedPreferences prefs = await SharedPreferences.getInstance();
+    await prefs.setString(_jarKey, jar.encode());
+  }
+
+  // Moves cookies persisted in SharedPreferences by an older version into
+  // the native store, once. They carry no domain, and used to be attached to
+  // every request, so they go to the first host the app talks to.
+  Future<void> _seedNativeJar(String url) {
+    return _legacyCookies ??= _migrate(() => _seedNativeJarFrom(url));
+  }
+
+  Future<void> _seedNativeJarFrom(String url) async {
+    SharedPreferences prefs = await SharedPreferences.getInstance();
+    String? cookieString = prefs.getString(_cookieKey);
+    if (cookieString != null && cookieString.isNotEmpty) {
+      await FlutterCookieBridgePlatform.instance.setCookies(
+          url, cookieString.split('; ').map((c) => '$c; Path=/').toList());
+    }
+    await prefs.remove(_cookieKey);
+  }
+
+  /// Makes [name] the active partition, for network requests and WebViews
+  /// alike, creating it if there is none of that name: empty, or,
+  /// with [from], as a snapshot of partition [from] that shares its cookies
+  /// until either changes them.
+  ///
+  /// The switch itself is a pointer swap. Open WebViews get one
+  /// [cookieChanges] delta with the cookies that differ between the two
+  /// partitions, and domains they still share cost nothing.
+  Future<void> switchPartition(String name, {String? from}) async {
+    if (name == _partition) {
+      return;
+    }
+    if (hasNativeJar) {
+      await FlutterCookieBridgePlatform.instance
+          .switchCookiePartition(name, from: from);
+      _partition = name;
+      return;
+    }
+    final current = await _dartJar(null);
+    DomainCookieJar? next = _partitions.remove(name);
+    if (next == null && from != null) {
+      next = (from == _partition ? current : _partitions[from])?.fork();
+    }
+    next ??= DomainCookieJar();
+    _partitions[_partition] = current;
+    _jar = Future.value(next);
+    _partition = name;
+    final changes = current.changesTo(next);
+    if (changes.isNotEmpty) {
+      _changes.add(CookieDelta(version: ++_version, changes: changes));
+    }
+  }
+
+  /// Drops partition [name] and its cookies. Returns false when it is the
+  /// active or the default partition, or does not exist.
+  Future<bool> deletePartition(String name) async {
+    if (name == _partition || name == defaultPartition) {
+      return false;
+    }
+    if (hasNativeJar) {
+      return FlutterCookieBridgePlatform.instance.deleteCookiePartition(name);
     }
-    return [];
+    return _partitions.remove(name) != null;
   }
 
+  /// Removes the cookies of the active partition, and every cookie of the
+  /// platform WebView.
   Future<void> clearSession() async {
     try {
       SharedPreferences prefs = await SharedPreferences.getInstance();
       await prefs.remove(_cookieKey);
+      if (hasNativeJar) {
+        _legacyCookies ??= Future.value();
+        await FlutterCookieBridgePlatform.instance.clearCookies();
+      } else {
+        (await _dartJar(null)).clear();
+        if (_partition == defaultPartition) {
+          await prefs.remove(_jarKey);
+        }
+        _changes.add(CookieDelta(version: ++_version, reset: true));
+      }
       await CookieManager.instance().deleteAllCookies();
     } catch (e) {
       debugPrint('Error clearing session: $e');
@@ -0,0 +1,251 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io' show HttpDate, HttpException;
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'flutter_cookie_bridge_ffi.dart';
+
+enum SameSite { unspecified, none, lax, strict }
+
+/// One cookie parsed from a `set-cookie` response header.
+class SetCookie {
+  const SetCookie({
+    required this.name,
+    required this.value,
+    this.domain,
+    this.path,
+    this.expires,
+    this.maxAge,
+    this.secure = false,
+    this.httpOnly = false,
+    this.sameSite = SameSite.unspecified,
+  });
+
+  final String name;
+  final String value;
+  final String? domain;
+  final String? path;
+  final DateTime? expires;
+  final int? maxAge;
+  final bool secure;
+  final bool httpOnly;
+  final SameSite sameSite;
+
+  /// The `name=value` pair as it is sent back in a `Cookie` header.
+  String get pair => '$name=$value';
+
+  /// Whether the header asks for the cookie to be deleted rather than stored.
+  /// Max-Age takes precedence over Expires, as in RFC 6265.
+  bool get isExpired {
+    if (maxAge != null) {
+      return maxAge! <= 0;
+    }
+    return expires != null && !expires!.isAfter(DateTime.now());
+  }
+}
+
+/// Parses `set-cookie` and `Cookie` header values.
+///
+/// Where the plugin's native library is available the headers are scanned by
+/// the native parser, which reports offsets into the header instead of
+/// building intermediate strings. Elsewhere an equivalent Dart
+/// implementation is used.
+class SetCookieParser {
+  SetCookieParser._();
+
+  // Must match SetCookieFlag in set_cookie_parser.h.
+  static const int _secure = 1 << 0;
+  static const int _httpOnly = 1 << 1;
+  static const int _hasDomain = 1 << 2;
+  static const int _hasPath = 1 << 3;
+  static const int _hasExpires = 1 << 4;
+  static const int _hasMaxAge = 1 << 5;
+
+  /// Parses every `set-cookie` header value in [headers]. The result lines
+  /// up with [headers] and holds null for values that carry no cookie.
+  static List<SetCookie?> parseAll(List<String> headers) {
+    final bindings = FlutterCookieBridgeBindings.instance;
+    if (bindings == null || headers.isEmpty) {
+      return headers.map(parseDart).toList();
+    }
+    return using((arena) {
+      final encoded = headers.map(utf8.encode).toList();
+      final total = encoded.fold<int>(0, (sum, bytes) => sum + bytes.length);
+      final data = arena<Uint8>(total == 0 ? 1 : total);
+      final lengths = arena<Uint32>(headers.length);
+      final out = arena<FlutterCookieBridgeSetCookie>(headers.length);
+
+      final dataView = data.asTypedList(total);
+      int offset = 0;
+      for (int i = 0; i < encoded.length; i++) {
+        dataView.setRange(offset, offset + encoded[i].length, encoded[i]);
+        lengths[i] = encoded[i].length;
+        offset += encoded[i].length;
+      }
+      bindings.parseSetCookies(data, lengths, headers.length, out);
+
+      final cookies = <SetCookie?>[];
+      for (int i = 0; i < headers.length; i++) {
+        final result = out[i];
+        if (result.name.length == 0) {
+          cookies.add(null);
+          continue;
+        }
+        String slice(FlutterCookieBridgeSpan span) =>
+            _slice(headers[i], encoded[i], span.offset, span.length);
+        final flags = result.flags;
+        cookies.add(SetCookie(
+          name: slice(result.name),
+          value: slice(result.value),
+          domain: flags & _hasDomain != 0 ? slice(result.domain) : null,
+          path: flags & _hasPath != 0 ? slice(result.path) : null,
+          expires: flags & _hasExpires != 0
+              ? DateTime.fromMillisecondsSinceEpoch(result.expires * 1000,
+                  isUtc: true)
+              : null,
+          maxAge: flags & _hasMaxAge != 0 ? result.maxAge : null,
+          secure: flags & _secure != 0,
+          httpOnly: flags & _httpOnly != 0,
+          sameSite: SameSite.values[result.sameSite],
+        ));
+      }
+      return cookies;
+    });
+  }
+
+  /// Splits a `Cookie` header such as `a=1; b=2` into name/value pairs.
+  static List<MapEntry<String, String>> parseCookieHeader(String header) {
+    final bindings = FlutterCookieBridgeBindings.instance;
+    if (bindings == null || header.isEmpty) {
+      return _parseCookieHeaderDart(header);
+    }
+    return using((arena) {
+      final encoded = utf8.encode(header);
+      final data = arena<Uint8>(encoded.length);
+      data.asTypedList(encoded.length).setAll(0, encoded);
+      // A pair needs at least two bytes ("a="), which bounds the count.
+      final capacity = encoded.length ~/ 2 + 1;
+      final spans = arena<FlutterCookieBridgeSpan>(capacity * 2);
+      final count =
+          bindings.parseCookieHeader(data, encoded.length, spans, capacity);
+
+      final pairs = <MapEntry<String, String>>[];
+      for (int i = 0; i < count && i < capacity; i++) {
+        final name = spans[i * 2];
+        final value = spans[i * 2 + 1];
+        pairs.add(MapEntry(
+          _slice(header, encoded, name.offset, name.length),
+          _slice(header, encoded, value.offset, value.length),
+        ));
+      }
+      return pairs;
+    });
+  }
+
+  // Native offsets are UTF-8 byte offsets. For the usual all-ASCII header
+  // they are also UTF-16 offsets, so the original string can be sliced
+  // without decoding anything.
+  static String _slice(
+      String header, Uint8List encoded, int offset, int length) {
+    if (encoded.length == header.length) {
+      return header.substring(offset, offset + length);
+    }
+    return utf8.decode(encoded.sublist(offset, offset + length));
+  }
+
+  /// The pure Dart fallback of [parseAll] for a single header value.
+  static SetCookie? parseDart(String header) {
+    final parts = header.split(';');
+    final pair = parts.first;
+    final equals = pair.indexOf('=');
+    if (equals < 0) {
+      return null;
+    }
+    final name = pair.substring(0, equals).trim();
+    if (name.isEmpty) {
+      return null;
+    }
+
+    String? domain;
+    String? path;
+    DateTime? expires;
+    int? maxAge;
+    bool secure = false;
+    bool httpOnly = false;
+    SameSite sameSite = SameSite.unspecified;
+    for (final attribute in parts.skip(1)) {
+      final attributeEquals = attribute.indexOf('=');
+      final key = (attributeEquals < 0
+              ? attribute
+              : attribute.substring(0, attributeEquals))
+          .trim()
+          .toLowerCase();
+      final value = attributeEquals < 0
+          ? ''
+          : attribute.substring(attributeEquals + 1).trim();
+      switch (key) {
+        case 'domain':
+          if (value.isNotEmpty) domain = value;
+          break;
+        case 'path':
+          if (value.startsWith('/')) path = value;
+          break;
+        case 'expires':
+          try {
+            expires = HttpDate.parse(value);
+          } on FormatException {
+            // Ignored, as RFC 6265 requires for unparseable dates.
+          } on HttpException {
+            // Ignored, as RFC 6265 requires for unparseable dates.
+          }
+          break;
+        case 'max-age':
+          maxAge = int.tryParse(value) ?? maxAge;
+          break;
+        case 'secure':
+          secure = true;
+          break;
+        case 'httponly':
+          httpOnly = true;
+          break;
+        case 'samesite':
+          sameSite = switch (value.toLowerCase()) {
+            'none' => SameSite.none,
+            'lax' => SameSite.lax,
+            'strict' => SameSite.strict,
+            _ => sameSite,
+          };
+          break;
+      }
+    }
+    return SetCookie(
+      name: name,
+      value: pair.substring(equals + 1).trim(),
+      domain: domain,
+      path: path,
+      expires: expires,
+      maxAge: maxAge,
+      secure: secure,
+      httpOnly: httpOnly,
+      sameSite: sameSite,
+    );
+  }
+
+  static List<MapEntry<String, String>> _parseCookieHeaderDart(
+      String header) {
+    final pairs = <MapEntry<String, String>>[];
+    for (final part in header.split(';')) {
+      final equals = part.indexOf('=');
+      if (equals < 0) {
+        continue;
+      }
+      final name = part.substring(0, equals).trim();
+      if (name.isNotEmpty) {
+        pairs.add(MapEntry(name, part.substring(equals + 1).trim()));
+      }
+    }
+    return pairs;
+  }
+}
@@ -1,17 +1,25 @@
+import 'dart:async';
 import 'dart:io';
 import 'package:android_intent_plus/android_intent.dart';
 import 'package:android_intent_plus/flag.dart';
 import 'package:device_info_plus/device_info_plus.dart';
+import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
 import 'package:flutter_cookie_bridge/custom_toast.dart';
 import 'package:flutter_cookie_bridge/web_view_callback.dart';
 import 'package:flutter_inappwebview/flutter_inappwebview.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:permission_handler/permission_handler.dart';
 import 'package:url_launcher/url_launcher.dart';
+import 'cookie_bridge_trace.dart';
+import 'cookie_changes.dart';
+import 'download_manager.dart';
+import 'flutter_cookie_bridge_platform_interface.dart';
+import 'navigation_rules.dart';
 import 'session_manager.dart';
+import 'set_cookie_parser.dart';
 import 'package:open_filex/open_filex.dart';
-import 'package:http/http.dart' as http;
 
 class WebView extends StatefulWidget {
   final String url;
@@ -54,6 +62,11 @@ class CustomWebViewState extends State<WebView> {
   Map<String, String>? _headers;
   bool _hasRedirected = false;
   String? _currentUserAgent;
+  // Every URL check of a navigation, compiled once; see NavigationRules.
+  late NavigationRules _navigationRules;
+  StreamSubscription<CookieDelta>? _cookieChanges;
+  // Deltas are applied one after the other, in the order they arrive.
+  Future<void> _cookieDeltas = Future.value();
 
   final SessionManager _sessionManager = SessionManager();
   final String _defaultUserAgent = Platform.isIOS
@@ -68,23 +81,39 @@ class CustomWebViewState extends State<WebView> {
   void initState() {
     super.initState();
     _currentUrl = widget.url;
+    _navigationRules = _compileNavigationRules();
     // WidgetsBinding.instance.addPostFrameCallback((_) async {
     // });
     _currentUserAgent = _determineUserAgent(widget.url);
+    _cookieChanges = _sessionManager.cookieChanges.listen((delta) {
+      _cookieDeltas = _cookieDeltas.then((_) => _applyCookieDelta(delta));
+    });
   }
 
-  String _determineUserAgent(String url) {
-    // Check if URL contains Karza domain or patterns
-    if (url.contains(widget.karzaDomain)) {
-      return _karzaUserAgent;
+  @override
+  void didUpdateWidget(WebView oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (!listEquals(oldWidget.whitelistedUrlsAndroid,
+            widget.whitelistedUrlsAndroid) ||
+        !listEquals(oldWidget.whitelistedUrlsIos, widget.whitelistedUrlsIos) ||
+        oldWidget.hostName != widget.hostName) {
+      _navigationRules = _compileNavigationRules();
     }
+  }
 
-    // Check if URL contains Razorpay domain or patterns
-    if (url.contains(widget.razorpayDomain)) {
-      return _defaultUserAgent;
-    }
-    // Default to Razorpay user agent if no match
-    return _defaultUserAgent;
+  NavigationRules _compileNavigationRules() => NavigationRules(
+        whitelistedUrlsAndroid: widget.whitelistedUrlsAndroid ?? [],
+        whitelistedUrlsIos: widget.whitelistedUrlsIos ?? [],
+        hostName: widget.hostName ?? '',
+        karzaDomain: widget.karzaDomain,
+      );
+
+  String _determineUserAgent(String url) {
+    // Karza needs its own user agent; Razorpay and everything else get the
+    // default one.
+    return _navigationRules.match(url).karza
+        ? _karzaUserAgent
+        : _defaultUserAgent;
   }
 
   @override
@@ -93,6 +122,7 @@ class CustomWebViewState extends State<WebView> {
       widget.onPageFinished!();
     }
     _webViewController = null;
+    _cookieChanges?.cancel();
     super.dispose();
   }
   Future<void> _handleRedirectTimeout(BuildContext context) async {
@@ -146,69 +176,81 @@ class CustomWebViewState extends State<WebView> {
     return await permission.request().isGranted;
   }
 
-  Future<void> _syncCookiesToWebView() async {
+  Future<void> _syncCookiesToWebView() =>
+      CookieBridgeTrace.span('webview.sync_cookies', _syncCookies);
+
+  Future<void> _syncCookies() async {
     Uri? uri = Uri.tryParse(_currentUrl!);
     String? domain = uri?.host;
 
     debugPrint('Syncing cookies to WebView for domain: $domain');
-    debugPrint('Original cookie: ${widget.cookie}');
 
-    try {
-      // IMPORTANT: Clear existing cookies for this domain first
-      await CookieManager.instance().deleteCookies(url: WebUri(_currentUrl!));
-      debugPrint('Cleared existing cookies');
-
-      String decodedCookie = Uri.decodeComponent(widget.cookie);
-      debugPrint('Decoded cookie: $decodedCookie');
+    String decodedCookie = Uri.decodeComponent(widget.cookie);
+    final cookies = Map<String, String>.fromEntries(
+        SetCookieParser.parseCookieHeader(decodedCookie));
 
-      if (!decodedCookie.contains(';')) {
-        // Handle single cookie case
-        List<String> cookieParts = decodedCookie.split('=');
+    try {
+      // One platform call applies the whole diff natively, so the time to
+      // first load no longer grows with the number of session cookies.
+      final changed = await FlutterCookieBridgePlatform.instance
+          .syncCookies(_currentUrl!, cookies);
+      debugPrint('Synced ${cookies.length} cookies, $changed changed');
+    } on MissingPluginException {
+      await _setCookiesIndividually(domain, cookies);
+    } catch (e) {
+      debugPrint('Error syncing cookies: $e');
+    }
+  }
 
-        if (cookieParts.length == 2) {
-          String cookieName = cookieParts[0];
-          String cookieValue = cookieParts[1];
-          await CookieManager.instance().setCookie(
-            url: WebUri(_currentUrl!),
-            name: cookieName,
-            value: cookieValue,
-            domain: domain,
-            path: '/',
-          );
+  // Brings the WebView's cookies for the current host up to date with the
+  // cookies the network manager stored since the last delta.
+  Future<void> _applyCookieDelta(CookieDelta delta) async {
+    if (_webViewController == null || _currentUrl == null) {
+      // The initial sync in onWebViewCreated picks these up.
+      return;
+    }
+    final url = WebUri(_currentUrl!);
+    final host = Uri.tryParse(_currentUrl!)?.host ?? '';
+    try {
+      if (delta.reset) {
+        await CookieManager.instance().deleteCookies(url: url);
+      }
+      for (CookieChange change in delta.changes) {
+        if (!change.appliesTo(host)) {
+          continue;
         }
-      } else {
-        // Handle multiple cookies
-        List<String> cookiesList = decodedCookie.split(';');
-
-        for (String cookieString in cookiesList) {
-          cookieString = cookieString.trim();
-          if (cookieString.isEmpty) continue;
-
-          int firstEqualIndex = cookieString.indexOf('=');
-          if (firstEqualIndex > 0) {
-            String cookieName =
-            cookieString.substring(0, firstEqualIndex).trim();
-            String cookieValue =
-            cookieString.substring(firstEqualIndex + 1).trim();
-
-            debugPrint('Setting cookie part: $cookieName=$cookieValue');
-
-            await CookieManager.instance().setCookie(
-              url: WebUri(_currentUrl!),
-              name: cookieName,
-              value: cookieValue,
+        final domain = change.domain.isEmpty ? host : change.domain;
+        if (change.removed) {
+          await CookieManager.instance().deleteCookie(
+              url: url, name: change.name, domain: domain, path: change.path);
+        } else {
+          await CookieManager.instance().setCookie(
+              url: url,
+              name: change.name,
+              value: change.value,
               domain: domain,
-              path: '/',
-            );
-          }
+              path: change.path);
         }
       }
+    } catch (e) {
+      debugPrint('Error applying cookie changes: $e');
+    }
+  }
 
-      // Verify cookies were set correctly
-      final cookies =
-      await CookieManager.instance().getCookies(url: WebUri(_currentUrl!));
-      debugPrint(
-          'Cookies after sync: ${cookies.map((c) => '${c.name}=${c.value}').join('; ')}');
+  /// Fallback for platforms without a native syncCookies implementation.
+  Future<void> _setCookiesIndividually(
+      String? domain, Map<String, String> cookies) async {
+    try {
+      await CookieManager.instance().deleteCookies(url: WebUri(_currentUrl!));
+      for (MapEntry<String, String> cookie in cookies.entries) {
+        await CookieManager.instance().setCookie(
+          url: WebUri(_currentUrl!),
+          name: cookie.key,
+          value: cookie.value,
+          domain: domain,
+          path: '/',
+        );
+      }
     } catch (e) {
       debugPrint('Error syncing cookies: $e');
     }
@@ -406,14 +448,15 @@ class CustomWebViewState extends State<WebView> {
         }
       }
 
-      // Get cookies for authentication
-      final cookies =
-      await CookieManager.instance().getCookies(url: request.url);
-      final cookieString =
-      cookies.map((c) => '${c.name}=${c.value}').join('; ');
-      final headers = {
-        'Cookie': cookieString,
-      };
+      // Get cookies for authentication. The native engine takes them from
+      // the shared jar itself.
+      final headers = <String, String>{};
+      if (!SessionManager.hasNativeJar) {
+        final cookies =
+            await CookieManager.instance().getCookies(url: request.url);
+        headers['Cookie'] =
+            cookies.map((c) => '${c.name}=${c.value}').join('; ');
+      }
 
       // Create unique filename using timestamp and suggested filename or default
       final timestamp = DateTime.now().millisecondsSinceEpoch;
@@ -433,52 +476,61 @@ class CustomWebViewState extends State<WebView> {
 
       debugPrint('Downloading file to: $filePath');
 
-      // Download file using http
-      final response = await http.get(
-        Uri.parse(request.url.toString()),
-        headers: headers,
-      );
+      // Stream the file to disk rather than buffering it in memory, showing
+      // progress while it runs
+      final progress = ValueNotifier<DownloadProgress?>(null);
+      final messenger = mounted ? ScaffoldMessenger.of(context) : null;
+      messenger?.showSnackBar(SnackBar(
+        duration: const Duration(days: 1),
+        content: _DownloadProgressView(progress: progress),
+      ));
+      final DownloadResult result;
+      try {
+        result = await DownloadManager.instance.download(
+          request.url.toString(),
+          filePath,
+          headers: headers,
+          onProgress: (update) => progress.value = update,
+        );
+      } finally {
+        messenger?.hideCurrentSnackBar();
+        progress.dispose();
+      }
+      final file = File(filePath);
+      debugPrint('File saved successfully at: $filePath '
+          '(${result.bytes} bytes, sha256 ${result.sha256})');
 
-      if (response.statusCode == 200) {
-        // Save the file
-        final file = File(filePath);
-        await file.writeAsBytes(response.bodyBytes);
-        debugPrint('File saved successfully at: $filePath');
+      // Show success message
+      if (mounted) {
+        ScaffoldMessenger.of(context).showSnackBar(
+          SnackBar(content: Text('File downloaded successfully')),
+        );
+      }
+
+      // Open the file
+      try {
+        int retries = 0;
+        var result;
+        while (retries < 5) {
+          if (await file.exists() && await file.length() > 0) {
+            result = await OpenFilex.open(filePath);
+            break;
+          }
+          await Future.delayed(Duration(milliseconds: 100));
+          retries++;
+        }
+        debugPrint('Open file result: ${result.type} - ${result.message}');
 
-        // Show success message
+        if (result.type != ResultType.done) {
+          throw Exception(result.message);
+        }
+      } catch (e) {
+        debugPrint('Error opening file: $e');
         if (mounted) {
           ScaffoldMessenger.of(context).showSnackBar(
-            SnackBar(content: Text('File downloaded successfully')),
+            SnackBar(content: Text('Error opening file: $e')),
           );
         }
-
-        // Open the file
-        try {
-          int retries = 0;
-          var result;
-          while (retries < 5) {
-            if (await file.exists() && await file.length() > 0) {
-              result = await OpenFilex.open(filePath);
-              break;
-            }
-            await Future.delayed(Duration(milliseconds: 100));
-            retries++;
-          }
-          debugPrint('Open file result: ${result.type} - ${result.message}');
-
-          if (result.type != ResultType.done) {
-            throw Exception(result.message);
-          }
-        } catch (e) {
-          debugPrint('Error opening file: $e');
-          if (mounted) {
-            ScaffoldMessenger.of(context).showSnackBar(
-              SnackBar(content: Text('Error opening file: $e')),
-            );
-          }
-        }
-      } else {
-        throw Exception('Failed to download file: ${response.statusCode}');
       }
     } catch (e) {
       debugPrint('Download/Open error: $e');
@@ -497,12 +549,13 @@ class CustomWebViewState extends State<WebView> {
     String url = uri.toString();
 
     debugPrint("Current url: $url");
+    final match = _navigationRules.match(url);
 
     if (!url.startsWith("https://")) {
       try {
         if (Platform.isAndroid) {
           debugPrint("entered in shouldOverrideUrlLoading");
-          if (url.contains("ms-outlook://")) {
+          if (match.outlookIntent) {
             debugPrint("Intent to open Outlook detected");
             const AndroidIntent intent = AndroidIntent(
               action: 'android.intent.action.MAIN',
@@ -513,7 +566,7 @@ class CustomWebViewState extends State<WebView> {
             );
             await intent.launch();
             return NavigationActionPolicy.CANCEL;
-          } else if (url.contains("googlegmail://")) {
+          } else if (match.gmailIntent) {
             debugPrint("Intent to open Gmail detected");
             const AndroidIntent intent = AndroidIntent(
               action: 'android.intent.action.MAIN',
@@ -530,7 +583,7 @@ class CustomWebViewState extends State<WebView> {
               showCustomToast(context, "Gmail app not found");
               return NavigationActionPolicy.CANCEL;
             }
-          } else if (url.contains("ymail://")) {
+          } else if (match.yahooMailIntent) {
             debugPrint("Intent to open Yahoo Mail detected");
             const intent = AndroidIntent(
                 package: 'com.yahoo.mobile.client.android.mail',
@@ -556,15 +609,9 @@ class CustomWebViewState extends State<WebView> {
       }
     }
 
-    // Get whitelisted URLs and hostname from widget, with fallback to empty values
-    final whitelistedUrlsAndroid = widget.whitelistedUrlsAndroid ?? [];
-    final whitelistedUrlsIos = widget.whitelistedUrlsIos ?? [];
-    final hostName = widget.hostName ?? '';
     debugPrint("Navigating to URL: $url");
 
-    if (!_hasRedirected &&
-        (url.contains('/redirect?status=') ||
-            url.contains('/session-expired?status='))) {
+    if (!_hasRedirected && match.statusRedirect) {
       _hasRedirected = true;
       String? status = uri.queryParameters['status'];
       if (status != null) {
@@ -574,8 +621,7 @@ class CustomWebViewState extends State<WebView> {
         return NavigationActionPolicy.CANCEL;
       }
     }
-    if (
-    (url.contains('/api/user/redirect') )) {
+    if (match.sessionExpired) {
       _hasRedirected = true;
       await logout(context);
       widget.onCallback?.call(WebViewCallback.redirect('SESSION_EXPIRED'));
@@ -583,11 +629,7 @@ class CustomWebViewState extends State<WebView> {
       return NavigationActionPolicy.CANCEL;
 
     }
-    if (url.contains(".pdf") ||
-        url.contains("/statements/") ||
-        url.contains("/download_statements") ||
-        url.contains(".jpeg") ||
-        url.contains(".png")) {
+    if (match.download) {
       await _onDownloadStartRequest(
         controller,
         DownloadStartRequest(
@@ -602,23 +644,16 @@ class CustomWebViewState extends State<WebView> {
       return NavigationActionPolicy.CANCEL;
     }
 
-    bool isAllowediOS =
-        whitelistedUrlsIos.any((white) => url.contains(white)) ||
-            (hostName.isNotEmpty && url.contains(hostName));
-
-    bool isAllowedAndroid = whitelistedUrlsAndroid.any((white) =>
-    url.contains(white) || (hostName.isNotEmpty && url.contains(hostName)));
-
-    if (Platform.isAndroid && isAllowedAndroid) {
+    if (Platform.isAndroid && match.allowedOnAndroid) {
       // URL is whitelisted - allow in WebView
       return NavigationActionPolicy.ALLOW;
     }
 
-    if (Platform.isIOS && isAllowediOS) {
+    if (Platform.isIOS && match.allowedOnIos) {
       // URL is whitelisted - allow in WebView
       return NavigationActionPolicy.ALLOW;
     }
-    if (url.contains("about:blank")) {
+    if (match.aboutBlank) {
       return NavigationActionPolicy.CANCEL;
     }
 
@@ -816,4 +851,40 @@ class CustomWebViewState extends State<WebView> {
       overlayEntry.remove();
     });
   }
-}
\ No newline at end of file
+}
+
+/// What a download snackbar shows while the file is coming in.
+class _DownloadProgressView extends StatelessWidget {
+  const _DownloadProgressView({required this.progress});
+
+  final ValueListenable<DownloadProgress?> progress;
+
+  static String _megabytes(num bytes) =>
+      (bytes / (1024 * 1024)).toStringAsFixed(1);
+
+  @override
+  Widget build(BuildContext context) {
+    return ValueListenableBuilder<DownloadProgress?>(
+      valueListenable: progress,
+      builder: (context, update, _) {
+        final total = update?.total;
+        final label = update == null
+            ? 'Downloading…'
+            : total == null
+                ? 'Downloading… ${_megabytes(update.received)} MB'
+                : 'Downloading… ${_megabytes(update.received)} of '
+                    '${_megabytes(total)} MB '
+                    '(${_megabytes(update.bytesPerSecond)} MB/s)';
+        return Column(
+          mainAxisSize: MainAxisSize.min,
+          crossAxisAlignment: CrossAxisAlignment.stretch,
+          children: [
+            Text(label),
+            const SizedBox(height: 8),
+            LinearProgressIndicator(value: update?.fraction),
+          ],
+        );
+      },
+    );
+  }
+}
@@ -0,0 +1,779 @@
+// Micro-benchmarks of the native cookie path: Set-Cookie and Cookie header
+// parsing, jar updates and lookups, Cookie header building and the
+// persistent store, plaintext and sealed, across jar sizes; the first
+// Cookie header after startup, with the store loaded at launch or opened on
+// registration; the
+// WebView's navigation rules, compiled and scanned one by one, across
+// rule-set sizes; JSON response bodies parsed whole and in socket-sized
+// pieces; the same bodies compressed and decoded with each content
+// coding; API requests to a local TLS server with a full handshake each, a
+// resumed one each, and through the connection pool; a large file
+// downloaded in parallel segments; what a trace span
+// costs, with tracing off and on; and how late
+// frame callbacks run while a burst of cookie writes
+// is handled on the main loop or on a worker.
+//
+// Every benchmark times batches of operations and reports the per-operation
+// time at p50/p99/p999 over the batches. Results go to stdout as a table
+// and, with --json=<path>, to a JSON file whose "benchmarks" entries are
+// keyed by name and jar size, for comparing one version with another.
+//
+// Usage: flutter_cookie_bridge_benchmark [--json=<path>] [--filter=<text>]
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "connection_pool.h"
+#include "content_coding.h"
+#include "cookie_jar.h"
+#include "cookie_store.h"
+#include "download_engine.h"
+#include "http_connection.h"
+#include "json_document.h"
+#include "set_cookie_parser.h"
+#include "shared_cookie_jar.h"
+#include "test/test_http_server.h"
+#include "trace.h"
+#include "url_pattern_set.h"
+#include "worker_pool.h"
+
+#ifndef FLUTTER_COOKIE_BRIDGE_VERSION
+#define FLUTTER_COOKIE_BRIDGE_VERSION "unknown"
+#endif
+
+namespace flutter_cookie_bridge {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kJarSizes[] = {10, 100, 1000, 10000};
+// Cookies per domain when filling a jar.
+constexpr size_t kCookiesPerDomain = 10;
+// The jars keep every cookie the benchmarks fill them with, whatever their
+// size.
+constexpr CookieJarLimits kNoLimits{std::numeric_limits<size_t>::max(),
+                                    std::numeric_limits<size_t>::max()};
+
+struct Result {
+  std::string name;
+  // Cookies in the jar, rules in the set for the navigation benchmarks, or
+  // 0 for benchmarks that use neither.
+  size_t cookies = 0;
+  size_t samples = 0;
+  size_t batch = 0;
+  double mean_ns = 0;
+  double p50_ns = 0;
+  double p99_ns = 0;
+  double p999_ns = 0;
+};
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+// Summarizes |per_op|, the per-operation times of batches of |batch|
+// operations, in nanoseconds.
+Result Summarize(const std::string& name,
+                 size_t cookies,
+                 size_t batch,
+                 std::vector<double> per_op) {
+  double total = 0;
+  for (double ns : per_op) {
+    total += ns;
+  }
+  std::sort(per_op.begin(), per_op.end());
+
+  Result result;
+  result.name = name;
+  result.cookies = cookies;
+  result.samples = per_op.size();
+  result.batch = batch;
+  result.mean_ns = total / per_op.size();
+  result.p50_ns = Percentile(per_op, 0.5);
+  result.p99_ns = Percentile(per_op, 0.99);
+  result.p999_ns = Percentile(per_op, 0.999);
+  return result;
+}
+
+// Times |samples| batches of |batch| calls of |op|, after a tenth as many
+// untimed batches to warm caches. |op| gets a running call index.
+Result Measure(const std::string& name,
+               size_t cookies,
+               size_t samples,
+               size_t batch,
+               const std::function<void(size_t)>& op) {
+  size_t index = 0;
+  for (size_t i = 0; i < samples / 10 * batch; ++i) {
+    op(index++);
+  }
+  std::vector<double> per_op;
+  per_op.reserve(samples);
+  for (size_t sample = 0; sample < samples; ++sample) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < batch; ++i) {
+      op(index++);
+    }
+    per_op.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count() /
+        batch);
+  }
+  return Summarize(name, cookies, batch, std::move(per_op));
+}
+
+double Nanos(Clock::duration duration) {
+  return std::chrono::duration<double, std::nano>(duration).count();
+}
+
+// Stands in for the GTK main loop: a frame callback every 8 ms for
+// |frames| frames, and |burst| dispatched 1 ms before the sixth is due,
+// like a batch of method calls arriving between frames. Appends how late
+// each frame callback ran to |lateness_ns|, and returns how long |burst|
+// kept the loop busy, in nanoseconds.
+double RunFrames(int frames,
+                 const std::function<void()>& burst,
+                 std::vector<double>* lateness_ns) {
+  constexpr auto kInterval = std::chrono::milliseconds(8);
+  double busy_ns = 0;
+  Clock::time_point start = Clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    Clock::time_point due = start + frame * kInterval;
+    if (frame == 5) {
+      std::this_thread::sleep_until(due - std::chrono::milliseconds(1));
+      Clock::time_point dispatched = Clock::now();
+      burst();
+      busy_ns = Nanos(Clock::now() - dispatched);
+    }
+    std::this_thread::sleep_until(due);
+    lateness_ns->push_back(Nanos(Clock::now() - due));
+  }
+  return busy_ns;
+}
+
+std::string DomainUrl(size_t domain) {
+  return "https://d" + std::to_string(domain) + ".example.com/app/";
+}
+
+std::string SetCookieHeader(size_t i) {
+  return "cookie" + std::to_string(i) + "=" + std::string(32, 'v') +
+         "; Path=/app; Max-Age=3600; Secure; HttpOnly; SameSite=Lax";
+}
+
+// Fills |jar| with |cookies| cookies, kCookiesPerDomain per domain.
+template <typename Jar>
+void Fill(Jar* jar, size_t cookies) {
+  for (size_t domain = 0; domain * kCookiesPerDomain < cookies; ++domain) {
+    std::vector<std::string> headers;
+    for (size_t i = 0;
+         i < kCookiesPerDomain && domain * kCookiesPerDomain + i < cookies;
+         ++i) {
+      headers.push_back(SetCookieHeader(i));
+    }
+    jar->SetCookies(DomainUrl(domain), headers);
+  }
+}
+
+// A JSON transaction history of about 4 MiB, as a banking API returns.
+std::string TransactionHistory() {
+  std::string text = "{\"account\":\"XX1234\",\"transactions\":[";
+  for (size_t i = 0; text.size() < (size_t{4} << 20); ++i) {
+    text += (i == 0 ? "{" : ",{") + std::string("\"id\":") +
+            std::to_string(1000000 + i) + ",\"amount\":" +
+            std::to_string(i % 10000) + "." + std::to_string(i % 100) +
+            ",\"currency\":\"INR\",\"booked\":" +
+            (i % 7 == 0 ? "false" : "true") + ",\"memo\":\"UPI/" +
+            std::to_string(i * 7919) +
+            "/Caf\\u00e9 payment\",\"tags\":[\"upi\",\"food\"]}";
+  }
+  return text + "]}";
+}
+
+class Benchmarks {
+ public:
+  Benchmarks(std::string filter, std::string directory)
+      : filter_(std::move(filter)), directory_(std::move(directory)) {}
+
+  void RunAll() {
+    // First, while the peak RSS is still that of a fresh process.
+    DownloadBenchmarks();
+    ParseBenchmarks();
+    for (size_t cookies : kJarSizes) {
+      JarBenchmarks(cookies);
+      StoreBenchmarks(cookies, false);
+      StoreBenchmarks(cookies, true);
+      NavigationBenchmarks(cookies);
+    }
+    StartupBenchmarks();
+    JsonBenchmarks();
+    CompressionBenchmarks();
+    TlsBenchmarks();
+    TraceBenchmarks();
+    MainLoopBenchmarks();
+  }
+
+  const std::vector<Result>& results() const { return results_; }
+
+ private:
+  bool Selected(const std::string& name) const {
+    return filter_.empty() || name.find(filter_) != std::string::npos;
+  }
+
+  void Run(const std::string& name,
+           size_t cookies,
+           size_t samples,
+           size_t batch,
+           const std::function<void(size_t)>& op) {
+    if (!Selected(name)) {
+      return;
+    }
+    Report(Measure(name, cookies, samples, batch, op));
+  }
+
+  // Records and prints |measured|, unless the filter leaves it out.
+  void Report(Result measured) {
+    if (!Selected(measured.name)) {
+      return;
+    }
+    results_.push_back(std::move(measured));
+    const Result& result = results_.back();
+    const std::string& name = result.name;
+    const char* unit = "cookies";
+    if (name.rfind("navigation.", 0) == 0) {
+      unit = "rules";
+    } else if (name.rfind("json.", 0) == 0 ||
+               name.rfind("compression.", 0) == 0) {
+      unit = "KiB";
+    } else if (name.rfind("download.", 0) == 0) {
+      unit = "MiB";
+    } else if (name.rfind("main_loop.", 0) == 0) {
+      unit = "writes";
+    }
+    printf("%-28s %6zu %-7s  p50 %10.0f ns  p99 %10.0f ns  p999 %10.0f ns\n",
+           result.name.c_str(), result.cookies, unit, result.p50_ns,
+           result.p99_ns, result.p999_ns);
+    fflush(stdout);
+  }
+
+  void ParseBenchmarks() {
+    const std::string set_cookie =
+        "session=" + std::string(64, 's') +
+        "; Domain=example.com; Path=/; Expires=Wed, 21 Oct 2037 07:28:00 GMT;"
+        " Secure; HttpOnly; SameSite=Strict";
+    Run("set_cookie.parse", 0, 2000, 64, [&](size_t) {
+      ParsedSetCookie parsed;
+      if (!ParseSetCookie(set_cookie, &parsed)) {
+        abort();
+      }
+    });
+
+    std::string header;
+    for (size_t i = 0; i < 20; ++i) {
+      header += (i == 0 ? "" : "; ") + std::string("cookie") +
+                std::to_string(i) + "=" + std::string(32, 'v');
+    }
+    Run("cookie_header.parse", 0, 2000, 64, [&](size_t) {
+      size_t pairs = ParseCookieHeader(
+          header, [](std::string_view, std::string_view) {});
+      if (pairs != 20) {
+        abort();
+      }
+    });
+  }
+
+  void JarBenchmarks(size_t cookies) {
+    size_t domains = (cookies + kCookiesPerDomain - 1) / kCookiesPerDomain;
+    CookieJar jar(kNoLimits);
+    Fill(&jar, cookies);
+    std::vector<std::string> urls;
+    for (size_t domain = 0; domain < domains; ++domain) {
+      urls.push_back(DomainUrl(domain));
+    }
+
+    Run("jar.set_cookie", cookies, 2000, 16, [&](size_t i) {
+      jar.SetCookies(urls[i % domains],
+                     {SetCookieHeader(i % kCookiesPerDomain)});
+    });
+    // A host without cookies: the lookup alone.
+    Run("jar.lookup_miss", cookies, 2000, 64, [&](size_t) {
+      if (!jar.GetCookieHeader("https://other.example.org/app/").empty()) {
+        abort();
+      }
+    });
+    // Lookup plus building the header from the matching cookies.
+    Run("jar.header_build", cookies, 2000, 64, [&](size_t i) {
+      if (jar.GetCookieHeader(urls[i % domains]).empty()) {
+        abort();
+      }
+    });
+
+    SharedCookieJar shared(kNoLimits);
+    Fill(&shared, cookies);
+    Run("shared_jar.header_build", cookies, 2000, 64, [&](size_t i) {
+      if (shared.GetCookieHeader(urls[i % domains]).empty()) {
+        abort();
+      }
+    });
+
+    // Two profiles that differ in one domain: readers move with a pointer
+    // swap, and the jar only replays that domain.
+    shared.ForkPartition("profile", SharedCookieJar::kDefaultPartition);
+    shared.SwitchPartition("profile");
+    shared.SetCookies(urls[0], {"profile=1"});
+    Run("shared_jar.partition_switch", cookies, 2000, 1, [&](size_t i) {
+      shared.SwitchPartition(i % 2 == 0 ? SharedCookieJar::kDefaultPartition
+                                        : "profile");
+    });
+  }
+
+  // With |sealed| set the store encrypts its records; see RecordCipher.
+  void StoreBenchmarks(size_t cookies, bool sealed) {
+    std::string prefix = sealed ? "sealed_store." : "store.";
+    std::string path = directory_ + "/cookies" + std::to_string(cookies);
+    auto keys = [sealed]() -> std::unique_ptr<CookieKeyProvider> {
+      if (!sealed) {
+        return nullptr;
+      }
+      CookieKey key;
+      key.fill(0x5a);
+      return std::make_unique<StaticKeyProvider>(key);
+    };
+    {
+      CookieJar jar(kNoLimits);
+      CookieStore store(path, CookieStore::kDefaultCompactionThreshold,
+                        keys());
+      if (!store.Open(&jar)) {
+        abort();
+      }
+      Fill(&jar, cookies);
+      size_t domains = (cookies + kCookiesPerDomain - 1) / kCookiesPerDomain;
+      // Serializing a changed cookie and appending its record.
+      Run(prefix + "append", cookies, 2000, 16, [&](size_t i) {
+        jar.SetCookies(DomainUrl(i % domains),
+                       {"rotating=" + std::to_string(i) + "; Max-Age=3600"});
+      });
+      store.WaitForCompaction();
+    }
+    size_t samples = cookies >= 10000 ? 50 : 200;
+    Run(prefix + "load", cookies, samples, 1, [&](size_t) {
+      CookieJar jar(kNoLimits);
+      CookieStore store(path, CookieStore::kDefaultCompactionThreshold,
+                        keys());
+      if (!store.Open(&jar)) {
+        abort();
+      }
+    });
+    unlink(path.c_str());
+  }
+
+  // The first Cookie header an app asks for, after a startup that takes as
+  // long as the engine's: with the store opened when the plugin registers
+  // it waits for the whole load; with the load started at launch it does
+  // not.
+  void StartupBenchmarks() {
+    constexpr size_t kCookies = 20000;
+    constexpr auto kStartup = std::chrono::milliseconds(100);
+    constexpr size_t kRounds = 10;
+    const char* names[] = {"startup.open_on_register",
+                           "startup.load_at_launch"};
+    if (std::none_of(std::begin(names), std::end(names),
+                     [this](const char* name) { return Selected(name); })) {
+      return;
+    }
+    std::string path = directory_ + "/startup";
+    {
+      SharedCookieJar jar(kNoLimits);
+      if (!jar.Persist(path)) {
+        abort();
+      }
+      Fill(&jar, kCookies);
+    }
+    const std::string url = DomainUrl(7);
+
+    for (bool at_launch : {false, true}) {
+      std::vector<double> per_op;
+      for (size_t round = 0; round < kRounds; ++round) {
+        SharedCookieJar jar(kNoLimits);
+        if (at_launch) {
+          jar.PersistInBackground(path);
+        }
+        std::this_thread::sleep_for(kStartup);
+        Clock::time_point start = Clock::now();
+        if (!jar.Persist(path) || jar.GetCookieHeader(url).empty()) {
+          abort();
+        }
+        per_op.push_back(Nanos(Clock::now() - start));
+      }
+      Report(Summarize(names[at_launch], kCookies, 1, std::move(per_op)));
+    }
+    unlink(path.c_str());
+  }
+
+  // The WebView's fixed rules plus |rules| whitelist entries, against a URL
+  // that matches only the last entry: the worst case for a chain of
+  // String.contains calls, which the compiled set should not notice.
+  void NavigationBenchmarks(size_t rules) {
+    std::vector<UrlPatternSet::Pattern> list = {
+        {"ms-outlook://", 1},
+        {"googlegmail://", 1},
+        {"ymail://", 1},
+        {"/redirect?status=", 2},
+        {"/session-expired?status=", 2},
+        {"/api/user/redirect", 4},
+        {".pdf", 8},
+        {"/statements/", 8},
+        {"/download_statements", 8},
+        {".jpeg", 8},
+        {".png", 8},
+    };
+    for (size_t i = 0; i < rules; ++i) {
+      list.emplace_back("https://tenant" + std::to_string(i) + ".example.com",
+                        16);
+    }
+    std::string url = "https://tenant" + std::to_string(rules - 1) +
+                      ".example.com/accounts/overview?session=" +
+                      std::string(32, 'a');
+    volatile uint32_t sink = 0;
+    Run("navigation.compile", rules, rules >= 10000 ? 50 : 200, 1,
+        [&](size_t) { sink = UrlPatternSet(list).state_count(); });
+    UrlPatternSet patterns(list);
+    Run("navigation.match", rules, 2000, 64,
+        [&](size_t) { sink = patterns.Match(url); });
+    Run("navigation.linear_scan", rules, rules >= 10000 ? 200 : 2000, 16,
+        [&](size_t) {
+          uint32_t tags = 0;
+          for (const UrlPatternSet::Pattern& pattern : list) {
+            if (url.find(pattern.first) != std::string::npos) {
+              tags |= pattern.second;
+            }
+          }
+          sink = tags;
+        });
+    (void)sink;
+  }
+
+  // A transaction history of about 4 MiB, the kind of body that stalls the
+  // UI isolate when decoded there. "cookies" is its size in KiB.
+  void JsonBenchmarks() {
+    std::string text = TransactionHistory();
+    size_t kib = text.size() >> 10;
+    volatile size_t sink = 0;
+    Run("json.parse", kib, 20, 1, [&](size_t) {
+      JsonParser parser;
+      JsonDocument document;
+      if (!parser.Feed(text.data(), text.size()) ||
+          !parser.Finish(&document)) {
+        abort();
+      }
+      sink = document.tape().size();
+    });
+    // As the body callback sees it: 16 KiB reads off the socket.
+    Run("json.parse_streamed", kib, 20, 1, [&](size_t) {
+      JsonParser parser;
+      JsonDocument document;
+      for (size_t at = 0; at < text.size(); at += 16384) {
+        if (!parser.Feed(text.data() + at,
+                         std::min<size_t>(16384, text.size() - at))) {
+          abort();
+        }
+      }
+      if (!parser.Finish(&document)) {
+        abort();
+      }
+      sink = document.tape().size();
+    });
+    (void)sink;
+  }
+
+  // The same history compressed and decoded with each coding this build
+  // supports, in one piece and in 16 KiB reads as they come off the
+  // socket. "cookies" is its size in KiB; the sizes on the wire are
+  // printed alongside.
+  void CompressionBenchmarks() {
+    std::string text = TransactionHistory();
+    size_t kib = text.size() >> 10;
+    for (ContentCoding coding : {ContentCoding::kGzip, ContentCoding::kBrotli,
+                                 ContentCoding::kZstd}) {
+      if (!IsContentCodingSupported(coding)) {
+        continue;
+      }
+      std::string prefix =
+          std::string("compression.") + ContentCodingName(coding);
+      std::string encoded;
+      Run(prefix + ".encode", kib, 20, 1, [&](size_t) {
+        if (!EncodeContent(coding, text, 0, &encoded)) {
+          abort();
+        }
+      });
+      if (!EncodeContent(coding, text, 0, &encoded)) {
+        abort();
+      }
+      volatile size_t sink = 0;
+      Run(prefix + ".decode", kib, 20, 1, [&](size_t) {
+        std::unique_ptr<ContentDecoder> decoder =
+            ContentDecoder::Create(coding);
+        size_t decoded = 0;
+        HttpBodyCallback out = [&](const char*, size_t size) {
+          decoded += size;
+          return true;
+        };
+        for (size_t at = 0; at < encoded.size(); at += 16384) {
+          if (!decoder->Update(encoded.data() + at,
+                               std::min<size_t>(16384, encoded.size() - at),
+                               out)) {
+            abort();
+          }
+        }
+        if (!decoder->finished() || decoded != text.size()) {
+          abort();
+        }
+        sink = decoded;
+      });
+      (void)sink;
+      if (Selected(prefix)) {
+        printf("%-28s %6zu KiB      on the wire: %zu KiB (%.1f%%)\n",
+               prefix.c_str(), kib, encoded.size() >> 10,
+               100.0 * encoded.size() / text.size());
+      }
+    }
+  }
+
+  // Sequential API-sized requests to a local TLS server: each on a
+  // connection of its own with a full handshake, as without the pool; each
+  // on a new connection that resumes the last session; and all through one
+  // pool, which keeps a single connection alive.
+  void TlsBenchmarks() {
+    const char* names[] = {"tls.full_handshake", "tls.resumed_handshake",
+                           "tls.pooled"};
+    if (std::none_of(std::begin(names), std::end(names),
+                     [this](const char* name) { return Selected(name); })) {
+      return;
+    }
+    test::TestHttpServer server(/*tls=*/true);
+    if (!HttpConnection::AddTrustedCertificates(server.certificate_pem())) {
+      abort();
+    }
+    server.Add("/api", test::TestResource{2048});
+    const std::string url = server.Url("/api");
+    auto fetch = [&url](ConnectionPool* pool) {
+      HttpRequest request;
+      request.url = url;
+      HttpResponse response;
+      std::string error;
+      if (!pool->Send(request, 5000, &response,
+                      [](const char*, size_t) { return true; }, &error) ||
+          response.status != 200) {
+        abort();
+      }
+    };
+
+    Run(names[0], 0, 200, 1, [&](size_t) {
+      ConnectionPool unpooled;
+      fetch(&unpooled);
+    });
+    ConnectionPoolOptions no_idle;
+    no_idle.max_idle_per_origin = 0;
+    ConnectionPool resuming(no_idle);
+    Run(names[1], 0, 200, 1, [&](size_t) { fetch(&resuming); });
+    ConnectionPool pool;
+    Run(names[2], 0, 200, 1, [&](size_t) { fetch(&pool); });
+  }
+
+  // A 128 MiB file from a local server in 8 MiB segments, four at a time.
+  // "cookies" is its size in MiB; the growth of the peak RSS is printed
+  // alongside, and stays near the buffers the segments stream through.
+  void DownloadBenchmarks() {
+    constexpr int64_t kMiB = 1024 * 1024;
+    constexpr int64_t kSize = 128 * kMiB;
+    if (!Selected("download.segmented")) {
+      return;
+    }
+    test::TestHttpServer server;
+    test::TestResource resource;
+    resource.size = kSize;
+    server.Add("/file", resource);
+    DownloadOptions options;
+    options.url = server.Url("/file");
+    options.path = directory_ + "/download";
+    options.min_segment_size = 8 * kMiB;
+
+    rusage before;
+    getrusage(RUSAGE_SELF, &before);
+    Run("download.segmented", kSize / kMiB, 5, 1, [&](size_t) {
+      DownloadResult result = Downloader(options).Run();
+      if (!result.ok || result.bytes != kSize) {
+        abort();
+      }
+      unlink(options.path.c_str());
+    });
+    rusage after;
+    getrusage(RUSAGE_SELF, &after);
+    printf("%-28s %6lld MiB      peak RSS: +%ld KiB\n", "download.segmented",
+           static_cast<long long>(kSize / kMiB),
+           after.ru_maxrss - before.ru_maxrss);
+  }
+
+  // What a ScopedTrace costs the code it wraps: a flag check with tracing
+  // off, and with it on, two clock reads and a ring buffer write.
+  void TraceBenchmarks() {
+    Tracer* tracer = Tracer::Get();
+    tracer->Clear();
+    tracer->SetEnabled(false);
+    Run("trace.span_disabled", 0, 2000, 256,
+        [](size_t) { ScopedTrace trace("benchmark.span"); });
+    tracer->SetEnabled(true);
+    Run("trace.span_enabled", 0, 2000, 256,
+        [](size_t) { ScopedTrace trace("benchmark.span"); });
+    tracer->SetEnabled(false);
+    tracer->Clear();
+  }
+
+  // A burst of setCookies calls against a persisted jar, as a frame-rate
+  // main loop sees it: handled on the loop they hold up the next frames;
+  // handed to a worker sequence, as the plugin does, the loop is free again
+  // at once. "cookies" is the number of writes in the burst; the lateness
+  // samples are every frame of every round.
+  void MainLoopBenchmarks() {
+    constexpr size_t kWrites = 1000;
+    constexpr int kFrames = 60;
+    constexpr int kRounds = 5;
+    const char* names[] = {"main_loop.burst_inline", "main_loop.frames_inline",
+                           "main_loop.burst_worker", "main_loop.frames_worker"};
+    if (std::none_of(std::begin(names), std::end(names),
+                     [this](const char* name) { return Selected(name); })) {
+      return;
+    }
+    std::string path = directory_ + "/main_loop";
+    auto write = [](SharedCookieJar* jar, size_t i) {
+      jar->SetCookies("https://example.com/",
+                      {"session" + std::to_string(i % 50) + "=" +
+                       std::to_string(i) + "; Path=/; Max-Age=3600"});
+    };
+
+    std::vector<double> inline_busy;
+    std::vector<double> inline_lateness;
+    for (int round = 0; round < kRounds; ++round) {
+      SharedCookieJar jar;
+      if (!jar.Persist(path)) {
+        abort();
+      }
+      inline_busy.push_back(RunFrames(
+          kFrames,
+          [&] {
+            for (size_t i = 0; i < kWrites; ++i) {
+              write(&jar, i);
+            }
+          },
+          &inline_lateness));
+      unlink(path.c_str());
+    }
+
+    std::vector<double> worker_busy;
+    std::vector<double> worker_lateness;
+    for (int round = 0; round < kRounds; ++round) {
+      SharedCookieJar jar;
+      if (!jar.Persist(path)) {
+        abort();
+      }
+      WorkerPool pool(2);
+      TaskSequence sequence(&pool);
+      std::atomic<size_t> written{0};
+      worker_busy.push_back(RunFrames(
+          kFrames,
+          [&] {
+            for (size_t i = 0; i < kWrites; ++i) {
+              sequence.Post([&, i] {
+                write(&jar, i);
+                ++written;
+              });
+            }
+          },
+          &worker_lateness));
+      while (written < kWrites) {
+        std::this_thread::yield();
+      }
+      unlink(path.c_str());
+    }
+
+    Report(Summarize(names[0], kWrites, 1, std::move(inline_busy)));
+    Report(Summarize(names[1], kWrites, 1, std::move(inline_lateness)));
+    Report(Summarize(names[2], kWrites, 1, std::move(worker_busy)));
+    Report(Summarize(names[3], kWrites, 1, std::move(worker_lateness)));
+  }
+
+  const std::string filter_;
+  const std::string directory_;
+  std::vector<Result> results_;
+};
+
+bool WriteJson(const std::string& path, const std::vector<Result>& results) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file, "{\n  \"version\": \"%s\",\n  \"unit\": \"ns\",\n",
+          FLUTTER_COOKIE_BRIDGE_VERSION);
+  fprintf(file, "  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    fprintf(file,
+            "%s\n    {\"name\": \"%s\", \"cookies\": %zu, \"samples\": %zu, "
+            "\"batch\": %zu, \"mean\": %.1f, \"p50\": %.1f, \"p99\": %.1f, "
+            "\"p999\": %.1f}",
+            i == 0 ? "" : ",", r.name.c_str(), r.cookies, r.samples, r.batch,
+            r.mean_ns, r.p50_ns, r.p99_ns, r.p999_ns);
+  }
+  fprintf(file, "\n  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+}  // namespace
+}  // namespace flutter_cookie_bridge
+
+int main(int argc, char** argv) {
+  std::string json_path;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--json=", 7) == 0) {
+      json_path = argv[i] + 7;
+    } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else {
+      fprintf(stderr, "usage: %s [--json=<path>] [--filter=<text>]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  char directory[] = "/tmp/flutter_cookie_bridge_benchmark_XXXXXX";
+  if (mkdtemp(directory) == nullptr) {
+    perror("mkdtemp");
+    return 1;
+  }
+  flutter_cookie_bridge::Benchmarks benchmarks(filter, directory);
+  benchmarks.RunAll();
+  rmdir(directory);
+
+  if (!json_path.empty() &&
+      !flutter_cookie_bridge::WriteJson(json_path, benchmarks.results())) {
+    perror(json_path.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,172 @@
+#include "connection_pool.h"
+
+#include <openssl/ssl.h>
+
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+ConnectionPool* ConnectionPool::Shared() {
+  static ConnectionPool* pool = new ConnectionPool();
+  return pool;
+}
+
+ConnectionPool::ConnectionPool(ConnectionPoolOptions options)
+    : options_(options) {}
+
+ConnectionPool::~ConnectionPool() {
+  Clear();
+}
+
+bool ConnectionPool::Send(const HttpRequest& request,
+                          int timeout_ms,
+                          HttpResponse* response,
+                          const HttpBodyCallback& on_body,
+                          std::string* error) {
+  HttpOrigin origin;
+  if (!ParseHttpOrigin(request.url, &origin)) {
+    *error = "unsupported url: " + request.url;
+    return false;
+  }
+  std::string key = (origin.tls ? "https://" : "http://") + origin.host +
+                    ":" + origin.port;
+  while (true) {
+    bool reused = false;
+    std::unique_ptr<HttpConnection> connection =
+        Acquire(key, origin, timeout_ms, &reused, error);
+    if (connection == nullptr) {
+      return false;
+    }
+    *response = HttpResponse();
+    bool ok = SendHttpRequest(connection.get(), request, response, on_body,
+                              error);
+    bool reusable = ok && response->complete && response->keep_alive;
+    Release(key, std::move(connection), reusable);
+    if (ok || !reused || response->status != 0) {
+      return ok;
+    }
+  }
+}
+
+std::unique_ptr<HttpConnection> ConnectionPool::Acquire(
+    const std::string& key,
+    const HttpOrigin& origin,
+    int timeout_ms,
+    bool* reused,
+    std::string* error) {
+  SSL_SESSION* session = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReapIdleLocked(Clock::now());
+    Origin& entry = origins_[key];
+    while (!entry.idle.empty()) {
+      std::unique_ptr<HttpConnection> connection =
+          std::move(entry.idle.back().connection);
+      entry.idle.pop_back();
+      if (connection->IsIdleUsable()) {
+        ++reuses_;
+        *reused = true;
+        return connection;
+      }
+      ++reaped_;
+    }
+    if (origin.tls && entry.session != nullptr) {
+      // The handshake runs unlocked, so it needs its own reference.
+      session = entry.session;
+      SSL_SESSION_up_ref(session);
+    }
+  }
+
+  *reused = false;
+  auto connection = std::make_unique<HttpConnection>();
+  bool connected = connection->Connect(origin.host, origin.port, origin.tls,
+                                       timeout_ms, error, session);
+  if (session != nullptr) {
+    SSL_SESSION_free(session);
+  }
+  if (!connected) {
+    return nullptr;
+  }
+  ++connects_;
+  if (connection->is_tls()) {
+    ++tls_handshakes_;
+    if (connection->tls_resumed()) {
+      ++tls_resumptions_;
+    }
+  }
+  return connection;
+}
+
+void ConnectionPool::Release(const std::string& key,
+                             std::unique_ptr<HttpConnection> connection,
+                             bool reusable) {
+  SSL_SESSION* session = connection->TakeTlsSession();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Origin& entry = origins_[key];
+  if (session != nullptr) {
+    if (entry.session != nullptr) {
+      SSL_SESSION_free(entry.session);
+    }
+    entry.session = session;
+  }
+  if (!reusable || options_.max_idle_per_origin == 0) {
+    return;
+  }
+  if (entry.idle.size() == options_.max_idle_per_origin) {
+    entry.idle.erase(entry.idle.begin());
+  }
+  entry.idle.push_back(IdleConnection{std::move(connection), Clock::now()});
+}
+
+size_t ConnectionPool::ReapIdle() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ReapIdleLocked(Clock::now());
+}
+
+size_t ConnectionPool::ReapIdleLocked(Clock::time_point now) {
+  Clock::time_point cutoff =
+      now - std::chrono::milliseconds(options_.idle_timeout_ms);
+  size_t reaped = 0;
+  for (auto& [key, entry] : origins_) {
+    // Oldest first, so the expired ones are a prefix.
+    auto end = entry.idle.begin();
+    while (end != entry.idle.end() && end->since <= cutoff) {
+      ++end;
+    }
+    reaped += static_cast<size_t>(end - entry.idle.begin());
+    entry.idle.erase(entry.idle.begin(), end);
+  }
+  reaped_ += reaped;
+  return reaped;
+}
+
+void ConnectionPool::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& [key, entry] : origins_) {
+    if (entry.session != nullptr) {
+      SSL_SESSION_free(entry.session);
+    }
+  }
+  origins_.clear();
+}
+
+ConnectionPoolStats ConnectionPool::stats() const {
+  ConnectionPoolStats stats;
+  stats.connects = connects_;
+  stats.tls_handshakes = tls_handshakes_;
+  stats.tls_resumptions = tls_resumptions_;
+  stats.reuses = reuses_;
+  stats.reaped = reaped_;
+  return stats;
+}
+
+size_t ConnectionPool::idle_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& [key, entry] : origins_) {
+    count += entry.idle.size();
+  }
+  return count;
+}
+
+}  // namespace flutter_cookie_bridge
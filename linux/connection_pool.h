@@ -0,0 +1,125 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_CONNECTION_POOL_H_
+#define FLUTTER_COOKIE_BRIDGE_CONNECTION_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "http_client.h"
+#include "http_connection.h"
+
+namespace flutter_cookie_bridge {
+
+struct ConnectionPoolOptions {
+  // Idle connections kept open per origin; more are closed on release.
+  size_t max_idle_per_origin = 6;
+  // Idle connections unused for this long are closed.
+  int idle_timeout_ms = 60000;
+};
+
+struct ConnectionPoolStats {
+  // Connections opened, and of those the ones over TLS and the TLS ones
+  // whose handshake resumed an earlier session.
+  uint64_t connects = 0;
+  uint64_t tls_handshakes = 0;
+  uint64_t tls_resumptions = 0;
+  // Requests sent over a connection that had carried one before.
+  uint64_t reuses = 0;
+  // Idle connections closed for outstaying the idle timeout, or found
+  // closed by the server when taken from the pool.
+  uint64_t reaped = 0;
+};
+
+// Keep-alive HTTP/1.1 connections shared by every native request of the
+// process, pooled per origin (scheme, host and port).
+//
+// A request takes the most recently used idle connection to its origin, or
+// opens one when there is none, and hands it back when its response was
+// read in full and both sides allow another request on it. New TLS
+// connections offer the origin's last session ticket, so even when no idle
+// connection is left the full handshake is usually avoided.
+class ConnectionPool {
+ public:
+  // The pool shared by API requests and downloads.
+  static ConnectionPool* Shared();
+
+  explicit ConnectionPool(ConnectionPoolOptions options = {});
+  ~ConnectionPool();
+
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  // Sends |request| and streams the response body to |on_body|, as
+  // SendHttpRequest does, over a pooled connection. A request that fails on
+  // a reused connection before any response arrived is sent once more on a
+  // new connection: the server may have closed the old one while it sat
+  // idle.
+  bool Send(const HttpRequest& request,
+            int timeout_ms,
+            HttpResponse* response,
+            const HttpBodyCallback& on_body,
+            std::string* error);
+
+  // Closes idle connections that outstayed the idle timeout. Returns how
+  // many were closed.
+  size_t ReapIdle();
+
+  // Closes every idle connection and forgets the session tickets.
+  void Clear();
+
+  ConnectionPoolStats stats() const;
+
+  // The number of idle connections across all origins.
+  size_t idle_count() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct IdleConnection {
+    std::unique_ptr<HttpConnection> connection;
+    Clock::time_point since;
+  };
+
+  struct Origin {
+    // Oldest first.
+    std::vector<IdleConnection> idle;
+    // The ticket new connections offer, owned.
+    SSL_SESSION* session = nullptr;
+  };
+
+  // Returns an idle connection to |key|, or a new one to |origin|, setting
+  // |reused| accordingly.
+  std::unique_ptr<HttpConnection> Acquire(const std::string& key,
+                                          const HttpOrigin& origin,
+                                          int timeout_ms,
+                                          bool* reused,
+                                          std::string* error);
+
+  // Keeps the connection's session ticket and, when |reusable|, the
+  // connection itself for the next request to |key|.
+  void Release(const std::string& key,
+               std::unique_ptr<HttpConnection> connection,
+               bool reusable);
+
+  size_t ReapIdleLocked(Clock::time_point now);
+
+  const ConnectionPoolOptions options_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Origin> origins_;
+
+  std::atomic<uint64_t> connects_{0};
+  std::atomic<uint64_t> tls_handshakes_{0};
+  std::atomic<uint64_t> tls_resumptions_{0};
+  std::atomic<uint64_t> reuses_{0};
+  std::atomic<uint64_t> reaped_{0};
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_CONNECTION_POOL_H_
@@ -0,0 +1,545 @@
+#include "content_coding.h"
+
+#include <time.h>
+#include <zlib.h>
+
+#include <iterator>
+#include <utility>
+
+#if defined(FLUTTER_COOKIE_BRIDGE_BROTLI)
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+#if defined(FLUTTER_COOKIE_BRIDGE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "set_cookie_parser.h"
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+// Brotli's default quality, 11, is meant for static assets and far too slow
+// for bodies compressed per request.
+constexpr int kBrotliQuality = 5;
+// Decoders need no more window than this, RFC 8878 7.2, which keeps a
+// response from making the decoder allocate hundreds of megabytes.
+constexpr int kZstdWindowLogMax = 23;
+
+uint64_t ThreadCpuMicros() {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000 +
+         static_cast<uint64_t>(now.tv_nsec) / 1000;
+}
+
+bool HasHeader(const std::vector<HttpHeader>& headers, std::string_view name) {
+  for (const HttpHeader& header : headers) {
+    if (EqualsIgnoreCase(header.name, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+class GzipDecoder : public ContentDecoder {
+ public:
+  GzipDecoder() : output_(new Bytef[kOutputSize]) {
+    // 32 detects a gzip or a zlib header, as some servers send the latter.
+    inflateInit2(&stream_, 15 + 32);
+  }
+  ~GzipDecoder() override { inflateEnd(&stream_); }
+
+  bool Update(const char* data,
+              size_t size,
+              const HttpBodyCallback& out) override {
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(size);
+    while (true) {
+      if (ended_) {
+        // Another gzip member may follow. Anything else is padding some
+        // servers append, and dropped.
+        if (stream_.avail_in == 0 || stream_.next_in[0] != 0x1f) {
+          return true;
+        }
+        inflateReset(&stream_);
+        ended_ = false;
+      }
+      uInt before = stream_.avail_in;
+      stream_.next_out = output_.get();
+      stream_.avail_out = kOutputSize;
+      int result = inflate(&stream_, Z_NO_FLUSH);
+      if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+        error_ = stream_.msg != nullptr ? stream_.msg : "invalid gzip data";
+        return false;
+      }
+      size_t produced = kOutputSize - stream_.avail_out;
+      if (produced > 0 &&
+          !out(reinterpret_cast<const char*>(output_.get()), produced)) {
+        return false;
+      }
+      ended_ = result == Z_STREAM_END;
+      bool progressed = produced > 0 || stream_.avail_in != before;
+      if (!ended_ &&
+          (!progressed || (stream_.avail_in == 0 && stream_.avail_out > 0))) {
+        return true;
+      }
+    }
+  }
+
+  bool finished() const override { return ended_; }
+
+ private:
+  z_stream stream_ = {};
+  std::unique_ptr<Bytef[]> output_;
+  bool ended_ = false;
+};
+
+#if defined(FLUTTER_COOKIE_BRIDGE_BROTLI)
+class BrotliDecoder : public ContentDecoder {
+ public:
+  BrotliDecoder()
+      : state_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr)),
+        output_(new uint8_t[kOutputSize]) {}
+  ~BrotliDecoder() override { BrotliDecoderDestroyInstance(state_); }
+
+  bool Update(const char* data,
+              size_t size,
+              const HttpBodyCallback& out) override {
+    const uint8_t* next_in = reinterpret_cast<const uint8_t*>(data);
+    size_t avail_in = size;
+    // A brotli stream cannot be followed by another; the rest is dropped.
+    while (!ended_) {
+      uint8_t* next_out = output_.get();
+      size_t avail_out = kOutputSize;
+      BrotliDecoderResult result = BrotliDecoderDecompressStream(
+          state_, &avail_in, &next_in, &avail_out, &next_out, nullptr);
+      if (result == BROTLI_DECODER_RESULT_ERROR) {
+        error_ = BrotliDecoderErrorString(BrotliDecoderGetErrorCode(state_));
+        return false;
+      }
+      size_t produced = kOutputSize - avail_out;
+      if (produced > 0 &&
+          !out(reinterpret_cast<const char*>(output_.get()), produced)) {
+        return false;
+      }
+      ended_ = result == BROTLI_DECODER_RESULT_SUCCESS;
+      if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool finished() const override { return ended_; }
+
+ private:
+  BrotliDecoderState* state_;
+  std::unique_ptr<uint8_t[]> output_;
+  bool ended_ = false;
+};
+#endif
+
+#if defined(FLUTTER_COOKIE_BRIDGE_ZSTD)
+class ZstdDecoder : public ContentDecoder {
+ public:
+  ZstdDecoder() : context_(ZSTD_createDCtx()), output_(new char[kOutputSize]) {
+    ZSTD_DCtx_setParameter(context_, ZSTD_d_windowLogMax, kZstdWindowLogMax);
+  }
+  ~ZstdDecoder() override { ZSTD_freeDCtx(context_); }
+
+  bool Update(const char* data,
+              size_t size,
+              const HttpBodyCallback& out) override {
+    ZSTD_inBuffer input = {data, size, 0};
+    while (true) {
+      ZSTD_outBuffer output = {output_.get(), kOutputSize, 0};
+      size_t result = ZSTD_decompressStream(context_, &output, &input);
+      if (ZSTD_isError(result)) {
+        error_ = ZSTD_getErrorName(result);
+        return false;
+      }
+      if (output.pos > 0 && !out(output_.get(), output.pos)) {
+        return false;
+      }
+      // 0 once a frame is complete; frames may follow one another.
+      ended_ = result == 0;
+      if (input.pos == input.size && output.pos < output.size) {
+        return true;
+      }
+    }
+  }
+
+  bool finished() const override { return ended_; }
+
+ private:
+  ZSTD_DCtx* context_;
+  std::unique_ptr<char[]> output_;
+  bool ended_ = false;
+};
+#endif
+
+}  // namespace
+
+const char* ContentCodingName(ContentCoding coding) {
+  switch (coding) {
+    case ContentCoding::kIdentity:
+      return "identity";
+    case ContentCoding::kGzip:
+      return "gzip";
+    case ContentCoding::kBrotli:
+      return "br";
+    case ContentCoding::kZstd:
+      return "zstd";
+  }
+  return "identity";
+}
+
+bool ParseContentCoding(std::string_view name, ContentCoding* coding) {
+  name = TrimWhitespace(name);
+  if (EqualsIgnoreCase(name, "identity")) {
+    *coding = ContentCoding::kIdentity;
+  } else if (EqualsIgnoreCase(name, "gzip") ||
+             EqualsIgnoreCase(name, "x-gzip")) {
+    *coding = ContentCoding::kGzip;
+  } else if (EqualsIgnoreCase(name, "br")) {
+    *coding = ContentCoding::kBrotli;
+  } else if (EqualsIgnoreCase(name, "zstd")) {
+    *coding = ContentCoding::kZstd;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool IsContentCodingSupported(ContentCoding coding) {
+  switch (coding) {
+    case ContentCoding::kIdentity:
+    case ContentCoding::kGzip:
+      return true;
+    case ContentCoding::kBrotli:
+#if defined(FLUTTER_COOKIE_BRIDGE_BROTLI)
+      return true;
+#else
+      return false;
+#endif
+    case ContentCoding::kZstd:
+#if defined(FLUTTER_COOKIE_BRIDGE_ZSTD)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+bool EncodeContent(ContentCoding coding,
+                   std::string_view data,
+                   int level,
+                   std::string* encoded) {
+  switch (coding) {
+    case ContentCoding::kIdentity:
+      encoded->assign(data);
+      return true;
+    case ContentCoding::kGzip: {
+      z_stream stream = {};
+      // 16 writes a gzip header and trailer instead of zlib's.
+      if (deflateInit2(&stream, level == 0 ? Z_DEFAULT_COMPRESSION : level,
+                       Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+      }
+      encoded->resize(deflateBound(&stream, data.size()));
+      stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+      stream.avail_in = static_cast<uInt>(data.size());
+      stream.next_out = reinterpret_cast<Bytef*>(&(*encoded)[0]);
+      stream.avail_out = static_cast<uInt>(encoded->size());
+      int result = deflate(&stream, Z_FINISH);
+      encoded->resize(stream.total_out);
+      deflateEnd(&stream);
+      return result == Z_STREAM_END;
+    }
+    case ContentCoding::kBrotli: {
+#if defined(FLUTTER_COOKIE_BRIDGE_BROTLI)
+      size_t size = BrotliEncoderMaxCompressedSize(data.size());
+      encoded->resize(size);
+      bool ok = BrotliEncoderCompress(
+          level == 0 ? kBrotliQuality : level, BROTLI_DEFAULT_WINDOW,
+          BROTLI_MODE_GENERIC, data.size(),
+          reinterpret_cast<const uint8_t*>(data.data()), &size,
+          reinterpret_cast<uint8_t*>(&(*encoded)[0]));
+      encoded->resize(ok ? size : 0);
+      return ok;
+#else
+      return false;
+#endif
+    }
+    case ContentCoding::kZstd: {
+#if defined(FLUTTER_COOKIE_BRIDGE_ZSTD)
+      encoded->resize(ZSTD_compressBound(data.size()));
+      size_t size =
+          ZSTD_compress(&(*encoded)[0], encoded->size(), data.data(),
+                        data.size(), level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+      if (ZSTD_isError(size)) {
+        encoded->clear();
+        return false;
+      }
+      encoded->resize(size);
+      return true;
+#else
+      return false;
+#endif
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<ContentDecoder> ContentDecoder::Create(ContentCoding coding) {
+  switch (coding) {
+    case ContentCoding::kIdentity:
+      return nullptr;
+    case ContentCoding::kGzip:
+      return std::make_unique<GzipDecoder>();
+    case ContentCoding::kBrotli:
+#if defined(FLUTTER_COOKIE_BRIDGE_BROTLI)
+      return std::make_unique<BrotliDecoder>();
+#else
+      return nullptr;
+#endif
+    case ContentCoding::kZstd:
+#if defined(FLUTTER_COOKIE_BRIDGE_ZSTD)
+      return std::make_unique<ZstdDecoder>();
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+void CompressionStats::Add(const CompressionStats& other) {
+  requests += other.requests;
+  request_bytes += other.request_bytes;
+  request_wire_bytes += other.request_wire_bytes;
+  requests_compressed += other.requests_compressed;
+  requests_refused += other.requests_refused;
+  responses += other.responses;
+  response_wire_bytes += other.response_wire_bytes;
+  response_bytes += other.response_bytes;
+  responses_decoded += other.responses_decoded;
+  encode_cpu_us += other.encode_cpu_us;
+  decode_cpu_us += other.decode_cpu_us;
+}
+
+CompressionOptions::CompressionOptions()
+    : accept(std::begin(kDefaultAccept), std::end(kDefaultAccept)) {}
+
+CompressionPolicy* CompressionPolicy::Shared() {
+  static CompressionPolicy* policy = new CompressionPolicy();
+  return policy;
+}
+
+void CompressionPolicy::Configure(const std::string& host,
+                                  CompressionOptions options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (host.empty()) {
+    default_ = std::move(options);
+  } else {
+    hosts_[host] = std::move(options);
+  }
+}
+
+void CompressionPolicy::Reset(const std::string& host) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  hosts_.erase(host);
+}
+
+CompressionOptions CompressionPolicy::OptionsFor(
+    const std::string& host) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = hosts_.find(host);
+  return it != hosts_.end() ? it->second : default_;
+}
+
+bool CompressionPolicy::HasOptionsFor(const std::string& host) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hosts_.count(host) != 0;
+}
+
+CompressionStats CompressionPolicy::Stats(const std::string& host) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (host.empty()) {
+    return total_;
+  }
+  auto it = stats_.find(host);
+  return it != stats_.end() ? it->second : CompressionStats();
+}
+
+void CompressionPolicy::Record(const std::string& host,
+                               const CompressionStats& stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_[host].Add(stats);
+  total_.Add(stats);
+}
+
+bool SendWithCompression(ConnectionPool* pool,
+                         CompressionPolicy* policy,
+                         const HttpRequest& request,
+                         int timeout_ms,
+                         HttpResponse* response,
+                         const HttpBodyCallback& on_body,
+                         std::string* error) {
+  if (policy == nullptr) {
+    return pool->Send(request, timeout_ms, response, on_body, error);
+  }
+  HttpOrigin origin;
+  ParseHttpOrigin(request.url, &origin);
+  CompressionOptions options = policy->OptionsFor(origin.host);
+  CompressionStats stats;
+  stats.requests = 1;
+  stats.request_bytes = request.body.size();
+
+  HttpRequest plain;
+  plain.method = request.method;
+  plain.url = request.url;
+  plain.headers = request.headers;
+  std::string accept;
+  if (!HasHeader(request.headers, "Accept-Encoding")) {
+    for (ContentCoding coding : options.accept) {
+      if (coding != ContentCoding::kIdentity &&
+          IsContentCodingSupported(coding)) {
+        accept += accept.empty() ? "" : ", ";
+        accept += ContentCodingName(coding);
+      }
+    }
+  }
+  if (!accept.empty()) {
+    plain.headers.push_back(HttpHeader{"Accept-Encoding", accept});
+  }
+
+  HttpRequest compressed;
+  bool compressing = false;
+  if (options.request_coding != ContentCoding::kIdentity &&
+      request.body.size() >= options.min_request_size &&
+      !HasHeader(request.headers, "Content-Encoding")) {
+    uint64_t start = ThreadCpuMicros();
+    std::string encoded;
+    if (EncodeContent(options.request_coding, request.body, options.level,
+                      &encoded) &&
+        encoded.size() < request.body.size()) {
+      compressed.method = plain.method;
+      compressed.url = plain.url;
+      compressed.headers = plain.headers;
+      compressed.headers.push_back(HttpHeader{
+          "Content-Encoding", ContentCodingName(options.request_coding)});
+      compressed.body = std::move(encoded);
+      compressing = true;
+    }
+    stats.encode_cpu_us = ThreadCpuMicros() - start;
+  }
+  if (!compressing) {
+    plain.body = request.body;
+  }
+
+  while (true) {
+    const HttpRequest& sent = compressing ? compressed : plain;
+    std::unique_ptr<ContentDecoder> decoder;
+    bool started = false;
+    bool refused = false;
+    uint64_t wire = 0;
+    uint64_t decoded = 0;
+    uint64_t decode_cpu = 0;
+    auto begin = [&]() {
+      started = true;
+      if (compressing && response->status == 415) {
+        refused = true;
+        return;
+      }
+      const std::string* encoding = response->FindHeader("Content-Encoding");
+      ContentCoding coding = ContentCoding::kIdentity;
+      if (accept.empty() || encoding == nullptr ||
+          !ParseContentCoding(*encoding, &coding)) {
+        return;
+      }
+      decoder = ContentDecoder::Create(coding);
+      if (decoder == nullptr) {
+        return;
+      }
+      std::vector<HttpHeader>& headers = response->headers;
+      for (size_t i = headers.size(); i-- > 0;) {
+        if (EqualsIgnoreCase(headers[i].name, "Content-Encoding") ||
+            EqualsIgnoreCase(headers[i].name, "Content-Length")) {
+          headers.erase(headers.begin() + i);
+        }
+      }
+      response->content_length = -1;
+      response->decoded_from = ContentCodingName(coding);
+    };
+    // Decoded pieces go on to |on_body|, whose own time is not the codec's.
+    uint64_t outside = 0;
+    HttpBodyCallback forward = [&](const char* data, size_t size) {
+      decoded += size;
+      uint64_t start = ThreadCpuMicros();
+      bool more = on_body(data, size);
+      outside += ThreadCpuMicros() - start;
+      return more;
+    };
+    std::string decode_error;
+    bool ok = pool->Send(
+        sent, timeout_ms, response,
+        [&](const char* data, size_t size) {
+          if (!started) {
+            begin();
+          }
+          wire += size;
+          if (refused) {
+            return true;
+          }
+          if (decoder == nullptr) {
+            decoded += size;
+            return on_body(data, size);
+          }
+          uint64_t start = ThreadCpuMicros();
+          outside = 0;
+          bool more = decoder->Update(data, size, forward);
+          decode_cpu += ThreadCpuMicros() - start - outside;
+          if (!more && !decoder->error().empty()) {
+            decode_error = decoder->error();
+          }
+          return more;
+        },
+        error);
+    // An empty body has nothing to decode, and keeps its headers.
+    refused = refused || (ok && !started && compressing &&
+                          response->status == 415);
+    if (!decode_error.empty()) {
+      *error = std::string("invalid ") + response->decoded_from +
+               " body: " + decode_error;
+      ok = false;
+    } else if (ok && response->complete && decoder != nullptr &&
+               !decoder->finished()) {
+      *error = std::string("truncated ") + response->decoded_from + " body";
+      ok = false;
+    }
+
+    stats.request_wire_bytes += sent.body.size();
+    stats.decode_cpu_us += decode_cpu;
+    if (ok && refused) {
+      // The server takes no compressed bodies: send it as it is.
+      stats.requests_refused = 1;
+      compressing = false;
+      plain.body = request.body;
+      continue;
+    }
+    stats.requests_compressed = compressing ? 1 : 0;
+    if (response->status != 0) {
+      stats.responses = 1;
+      stats.response_wire_bytes = wire;
+      stats.response_bytes = decoded;
+      stats.responses_decoded = decoder != nullptr ? 1 : 0;
+    }
+    policy->Record(origin.host, stats);
+    return ok;
+  }
+}
+
+}  // namespace flutter_cookie_bridge
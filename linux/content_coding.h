@@ -0,0 +1,164 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_CONTENT_CODING_H_
+#define FLUTTER_COOKIE_BRIDGE_CONTENT_CODING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "connection_pool.h"
+#include "http_client.h"
+
+namespace flutter_cookie_bridge {
+
+// The content codings the transport negotiates, RFC 9110 8.4.1. gzip is
+// always built in; brotli and zstd when their libraries were found at build
+// time, see IsContentCodingSupported.
+enum class ContentCoding : uint8_t { kIdentity, kGzip, kBrotli, kZstd };
+
+// The token of |coding| in Accept-Encoding and Content-Encoding.
+const char* ContentCodingName(ContentCoding coding);
+
+// Reads a Content-Encoding token, ignoring case and surrounding whitespace.
+// Returns false for codings the transport does not know.
+bool ParseContentCoding(std::string_view name, ContentCoding* coding);
+
+bool IsContentCodingSupported(ContentCoding coding);
+
+// Compresses |data| with |coding| into |encoded|. |level| is on the codec's
+// own scale, 0 meaning its default. Returns false when |coding| is not
+// supported.
+bool EncodeContent(ContentCoding coding,
+                   std::string_view data,
+                   int level,
+                   std::string* encoded);
+
+// Decodes a body in the pieces it arrives in, handing the output on in
+// pieces of at most 64 KiB, so that neither side is ever held in full.
+class ContentDecoder {
+ public:
+  // Null for identity and for codings that are not supported.
+  static std::unique_ptr<ContentDecoder> Create(ContentCoding coding);
+
+  virtual ~ContentDecoder() = default;
+
+  // Decodes the next |size| bytes into |out|. Returns false when they are
+  // not valid, see error(), or when |out| returns false.
+  virtual bool Update(const char* data,
+                      size_t size,
+                      const HttpBodyCallback& out) = 0;
+
+  // Whether the input so far ends a complete stream.
+  virtual bool finished() const = 0;
+
+  const std::string& error() const { return error_; }
+
+ protected:
+  static constexpr size_t kOutputSize = 64 * 1024;
+
+  std::string error_;
+};
+
+struct CompressionOptions {
+  static constexpr ContentCoding kDefaultAccept[] = {
+      ContentCoding::kZstd, ContentCoding::kBrotli, ContentCoding::kGzip};
+
+  // Offers kDefaultAccept.
+  CompressionOptions();
+
+  // The codings offered for responses, most preferred first. Those this
+  // build does not support are left out.
+  std::vector<ContentCoding> accept;
+  // The coding of request bodies of at least |min_request_size| bytes.
+  // Servers rarely take compressed requests, so this is for hosts known to,
+  // and identity sends every body as it is.
+  ContentCoding request_coding = ContentCoding::kIdentity;
+  size_t min_request_size = 1024;
+  // The compression level of request bodies; 0 for the codec's default.
+  int level = 0;
+};
+
+struct CompressionStats {
+  // Requests sent, the bytes of their bodies, and how many bytes went on
+  // the wire for them. Of those, the ones sent compressed.
+  uint64_t requests = 0;
+  uint64_t request_bytes = 0;
+  uint64_t request_wire_bytes = 0;
+  uint64_t requests_compressed = 0;
+  // Compressed requests the server refused with 415 and that were sent
+  // again as they are.
+  uint64_t requests_refused = 0;
+  // Responses received, the bytes of their bodies as they came off the
+  // wire and once decoded. Of those, the ones that were decoded.
+  uint64_t responses = 0;
+  uint64_t response_wire_bytes = 0;
+  uint64_t response_bytes = 0;
+  uint64_t responses_decoded = 0;
+  // CPU time the codecs took, on the threads that ran them.
+  uint64_t encode_cpu_us = 0;
+  uint64_t decode_cpu_us = 0;
+
+  void Add(const CompressionStats& other);
+};
+
+// What each host negotiates, and what that saved. Options are set per host
+// or as the default of every host without its own; stats are kept per host
+// and in total.
+class CompressionPolicy {
+ public:
+  // The policy of API requests and downloads.
+  static CompressionPolicy* Shared();
+
+  CompressionPolicy() = default;
+
+  CompressionPolicy(const CompressionPolicy&) = delete;
+  CompressionPolicy& operator=(const CompressionPolicy&) = delete;
+
+  // Sets the options of |host|, or the default ones when |host| is empty.
+  void Configure(const std::string& host, CompressionOptions options);
+
+  // Drops the options of |host|, which then gets the default ones.
+  void Reset(const std::string& host);
+
+  CompressionOptions OptionsFor(const std::string& host) const;
+
+  // Whether |host| was configured with options of its own.
+  bool HasOptionsFor(const std::string& host) const;
+
+  // The stats of |host|, or of every host when |host| is empty.
+  CompressionStats Stats(const std::string& host) const;
+
+  void Record(const std::string& host, const CompressionStats& stats);
+
+ private:
+  mutable std::mutex mutex_;
+  CompressionOptions default_;
+  std::unordered_map<std::string, CompressionOptions> hosts_;
+  std::unordered_map<std::string, CompressionStats> stats_;
+  CompressionStats total_;
+};
+
+// Sends |request| through |pool| as |policy| says for its host, and records
+// the request in |policy|. When |policy| is null the request goes as is.
+//
+// A large enough body is compressed, and sent again as it is when the
+// server answers 415. Unless the request names its own Accept-Encoding,
+// the supported codings are offered, and a response in one of them reaches
+// |on_body| decoded: the Content-Encoding and Content-Length headers are
+// dropped, the content length becomes unknown and |response->decoded_from|
+// names the coding.
+bool SendWithCompression(ConnectionPool* pool,
+                         CompressionPolicy* policy,
+                         const HttpRequest& request,
+                         int timeout_ms,
+                         HttpResponse* response,
+                         const HttpBodyCallback& on_body,
+                         std::string* error);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_CONTENT_CODING_H_
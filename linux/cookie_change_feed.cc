@@ -0,0 +1,86 @@
+#include "cookie_change_feed.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+CookieChangeFeed::CookieChangeFeed(CookieJar* jar, size_t max_tombstones)
+    : jar_(jar), max_tombstones_(max_tombstones) {
+  jar_->AddObserver(this);
+}
+
+CookieChangeFeed::~CookieChangeFeed() {
+  jar_->RemoveObserver(this);
+}
+
+CookieDelta CookieChangeFeed::ChangesSince(uint64_t since) const {
+  CookieDelta delta;
+  delta.version = jar_->version();
+  // A version ahead of the jar comes from before a restart.
+  delta.reset = since < floor_ || since > delta.version;
+  if (!delta.reset && since == delta.version) {
+    return delta;
+  }
+
+  uint64_t after = delta.reset ? 0 : since;
+  jar_->ForEach([&](const Cookie& cookie) {
+    if (cookie.version <= after) {
+      return;
+    }
+    CookieChange change;
+    change.name.assign(cookie.name);
+    change.value.assign(cookie.value);
+    change.domain.assign(cookie.domain);
+    change.path.assign(cookie.path);
+    change.version = cookie.version;
+    delta.changes.push_back(std::move(change));
+  });
+  if (!delta.reset) {
+    // Tombstones are in version order, so only the tail is of interest.
+    auto first = std::upper_bound(
+        tombstones_.begin(), tombstones_.end(), since,
+        [](uint64_t version, const CookieChange& tombstone) {
+          return version < tombstone.version;
+        });
+    delta.changes.insert(delta.changes.end(), first, tombstones_.end());
+  }
+  std::sort(delta.changes.begin(), delta.changes.end(),
+            [](const CookieChange& a, const CookieChange& b) {
+              return a.version < b.version;
+            });
+  return delta;
+}
+
+void CookieChangeFeed::SetListener(std::function<void()> listener) {
+  listener_ = std::move(listener);
+}
+
+void CookieChangeFeed::OnCookieChanged(const Cookie& cookie, bool removed) {
+  if (removed) {
+    CookieChange tombstone;
+    tombstone.name.assign(cookie.name);
+    tombstone.domain.assign(cookie.domain);
+    tombstone.path.assign(cookie.path);
+    tombstone.removed = true;
+    tombstone.version = cookie.version;
+    tombstones_.push_back(std::move(tombstone));
+    if (tombstones_.size() > max_tombstones_) {
+      floor_ = tombstones_.front().version;
+      tombstones_.pop_front();
+    }
+  }
+  if (listener_) {
+    listener_();
+  }
+}
+
+void CookieChangeFeed::OnCookiesCleared() {
+  tombstones_.clear();
+  floor_ = jar_->version();
+  if (listener_) {
+    listener_();
+  }
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,79 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_COOKIE_CHANGE_FEED_H_
+#define FLUTTER_COOKIE_BRIDGE_COOKIE_CHANGE_FEED_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cookie_jar.h"
+
+namespace flutter_cookie_bridge {
+
+// A cookie that was stored or removed after some jar version.
+struct CookieChange {
+  std::string name;
+  // Empty when |removed| is set.
+  std::string value;
+  std::string domain;
+  std::string path;
+  bool removed = false;
+  uint64_t version = 0;
+};
+
+// What a consumer at some jar version has to apply to catch up.
+struct CookieDelta {
+  // The jar version the consumer is at once |changes| are applied.
+  uint64_t version = 0;
+  // Set when the consumer's version is too old (or from another run) to be
+  // caught up incrementally. It must then drop every cookie it holds, and
+  // |changes| lists every live cookie.
+  bool reset = false;
+  // Ordered by version.
+  std::vector<CookieChange> changes;
+};
+
+// Answers "what changed since version N" for a CookieJar.
+//
+// Stored cookies carry their own version, so they come straight from the
+// jar. Removals leave nothing behind in the jar, so the feed keeps a bounded
+// queue of tombstones; consumers that fall behind the oldest tombstone, or
+// behind a Clear, get a reset instead.
+class CookieChangeFeed : public CookieJarObserver {
+ public:
+  // Tombstones kept before the oldest ones are forgotten.
+  static constexpr size_t kDefaultMaxTombstones = 1024;
+
+  // Starts observing |jar|, which must outlive the feed.
+  explicit CookieChangeFeed(CookieJar* jar,
+                            size_t max_tombstones = kDefaultMaxTombstones);
+  ~CookieChangeFeed() override;
+
+  CookieChangeFeed(const CookieChangeFeed&) = delete;
+  CookieChangeFeed& operator=(const CookieChangeFeed&) = delete;
+
+  // Returns the changes after version |since|. Pass 0 for everything.
+  CookieDelta ChangesSince(uint64_t since) const;
+
+  // Calls |listener| after every mutation of the jar. Pass an empty function
+  // to stop.
+  void SetListener(std::function<void()> listener);
+
+  // CookieJarObserver:
+  void OnCookieChanged(const Cookie& cookie, bool removed) override;
+  void OnCookiesCleared() override;
+
+ private:
+  CookieJar* jar_;
+  size_t max_tombstones_;
+  std::deque<CookieChange> tombstones_;
+  // Versions up to and including this one can no longer be caught up from.
+  uint64_t floor_ = 0;
+  std::function<void()> listener_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_COOKIE_CHANGE_FEED_H_
@@ -0,0 +1,634 @@
+#include "cookie_jar.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "public_suffix.h"
+#include "url.h"
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+// Returns true when |host| equals |domain| or is a subdomain of it.
+bool DomainMatches(std::string_view host, std::string_view domain) {
+  if (host == domain) {
+    return true;
+  }
+  return !IsIpAddress(host) && host.size() > domain.size() &&
+         host.compare(host.size() - domain.size(), domain.size(), domain) ==
+             0 &&
+         host[host.size() - domain.size() - 1] == '.';
+}
+
+// Returns true when |a| and |b|, which share an identity, would be sent and
+// kept alike.
+bool SameContent(const Cookie& a, const Cookie& b) {
+  return a.value == b.value && a.host_only == b.host_only &&
+         a.secure == b.secure && a.http_only == b.http_only &&
+         a.same_site == b.same_site && a.expires == b.expires &&
+         a.creation_index == b.creation_index;
+}
+
+// Applies the storage model of RFC 6265 5.3 to a parsed Set-Cookie header
+// received for |request_host|/|request_path|. Sets |remove| when the header
+// expires the cookie rather than storing it.
+// The returned cookie's views point into |parsed|'s header, |request_host|,
+// |request_path| and |domain_buffer|; call Own() before they go away.
+bool BuildCookie(const ParsedSetCookie& parsed,
+                 const std::string& request_host,
+                 std::string_view request_path,
+                 int64_t now,
+                 std::string* domain_buffer,
+                 Cookie* cookie,
+                 bool* remove) {
+  std::string_view domain = parsed.domain;
+  if (!domain.empty() && domain.front() == '.') {
+    domain.remove_prefix(1);
+  }
+  if (domain.empty()) {
+    cookie->domain = request_host;
+    cookie->host_only = true;
+  } else {
+    *domain_buffer = CanonicalHost(domain);
+    cookie->domain = *domain_buffer;
+    if (!DomainMatches(request_host, cookie->domain)) {
+      return false;
+    }
+    cookie->host_only = false;
+    // RFC 6265 5.3 step 5: no cookie for a whole public suffix, except as a
+    // host-only cookie of a host that is one.
+    if (!IsIpAddress(cookie->domain) && IsPublicSuffix(cookie->domain)) {
+      if (cookie->domain != request_host) {
+        return false;
+      }
+      cookie->domain = request_host;
+      cookie->host_only = true;
+    }
+  }
+
+  cookie->name = parsed.name;
+  cookie->value = parsed.value;
+  if (parsed.flags & kSetCookieHasPath) {
+    cookie->path = parsed.path;
+  } else {
+    cookie->path = DefaultPath(request_path);
+  }
+  cookie->secure = parsed.flags & kSetCookieSecure;
+  cookie->http_only = parsed.flags & kSetCookieHttpOnly;
+  cookie->same_site = parsed.same_site;
+
+  // Max-Age wins over Expires when both are present.
+  *remove = false;
+  if (parsed.flags & kSetCookieHasMaxAge) {
+    if (parsed.max_age <= 0) {
+      *remove = true;
+    } else {
+      cookie->expires = now + parsed.max_age;
+    }
+  } else if (parsed.flags & kSetCookieHasExpires) {
+    cookie->expires = parsed.expires;
+    *remove = cookie->expires <= now;
+  }
+  return true;
+}
+
+// The cookies of |buckets| that a request to |url|, whose canonical host is
+// |host|, carries, in the order of its Cookie header: longer paths first,
+// then older cookies first (RFC 6265 5.4).
+std::vector<const Cookie*> MatchingCookies(
+    const Url& url,
+    std::string_view host,
+    const std::vector<CookieBucketMatch>& buckets,
+    int64_t now) {
+  bool secure = url.is_secure();
+  // An IP address only matches itself, not the numbers it ends with.
+  bool ip_address = IsIpAddress(host);
+  std::vector<const Cookie*> matches;
+  for (const CookieBucketMatch& bucket : buckets) {
+    if (ip_address && !bucket.exact) {
+      continue;
+    }
+    for (const Cookie& cookie : *bucket.cookies) {
+      if ((cookie.host_only && !bucket.exact) || (cookie.secure && !secure) ||
+          (cookie.expires != kNoExpiry && cookie.expires <= now) ||
+          !PathMatches(cookie.path, url.path)) {
+        continue;
+      }
+      matches.push_back(&cookie);
+    }
+  }
+
+  std::stable_sort(matches.begin(), matches.end(),
+                   [](const Cookie* a, const Cookie* b) {
+                     if (a->path.size() != b->path.size()) {
+                       return a->path.size() > b->path.size();
+                     }
+                     return a->creation_index < b->creation_index;
+                   });
+  return matches;
+}
+
+}  // namespace
+
+Cookie Cookie::Copy() const {
+  Cookie copy;
+  copy.name = name;
+  copy.value = value;
+  copy.domain = domain;
+  copy.path = path;
+  copy.host_only = host_only;
+  copy.secure = secure;
+  copy.http_only = http_only;
+  copy.same_site = same_site;
+  copy.expires = expires;
+  copy.creation_index = creation_index;
+  copy.version = version;
+  copy.Own();
+  return copy;
+}
+
+void Cookie::Own() {
+  size_t total = name.size() + value.size() + domain.size() + path.size();
+  std::unique_ptr<char[]> buffer(new char[total > 0 ? total : 1]);
+  char* cursor = buffer.get();
+  for (std::string_view* field : {&name, &value, &domain, &path}) {
+    if (!field->empty()) {
+      std::memcpy(cursor, field->data(), field->size());
+    }
+    *field = std::string_view(cursor, field->size());
+    cursor += field->size();
+  }
+  storage = std::move(buffer);
+}
+
+bool IsIpAddress(std::string_view host) {
+  if (host.find(':') != std::string_view::npos) {
+    return true;
+  }
+  return !host.empty() &&
+         host.find_first_not_of("0123456789.") == std::string_view::npos;
+}
+
+bool PathMatches(std::string_view cookie_path, std::string_view request_path) {
+  if (request_path.compare(0, cookie_path.size(), cookie_path) != 0) {
+    return false;
+  }
+  return request_path.size() == cookie_path.size() ||
+         cookie_path.back() == '/' || request_path[cookie_path.size()] == '/';
+}
+
+std::string_view DefaultPath(std::string_view request_path) {
+  if (request_path.empty() || request_path.front() != '/') {
+    return "/";
+  }
+  size_t last_slash = request_path.rfind('/');
+  if (last_slash == 0) {
+    return "/";
+  }
+  return request_path.substr(0, last_slash);
+}
+
+CookieJar::CookieJar(CookieJarLimits limits)
+    : limits_(limits), expiry_(static_cast<int64_t>(std::time(nullptr))) {}
+
+size_t CookieJar::SetCookies(
+    std::string_view url, const std::vector<std::string>& set_cookie_headers) {
+  Url parsed;
+  if (!ParseUrl(url, &parsed)) {
+    return 0;
+  }
+  std::string host = CanonicalHost(parsed.host);
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  RemoveExpired(now);
+
+  size_t changed = 0;
+  std::string domain_buffer;
+  for (const std::string& header : set_cookie_headers) {
+    ParsedSetCookie set_cookie;
+    Cookie cookie;
+    bool remove = false;
+    if (!ParseSetCookie(header, &set_cookie) ||
+        !BuildCookie(set_cookie, host, parsed.path, now, &domain_buffer,
+                     &cookie, &remove)) {
+      continue;
+    }
+    // Only secure origins may set secure cookies.
+    if (cookie.secure && !parsed.is_secure()) {
+      continue;
+    }
+    cookie.Own();
+    if (Store(std::move(cookie), remove, true)) {
+      ++changed;
+    }
+  }
+  return changed;
+}
+
+size_t CookieJar::SyncCookies(
+    std::string_view url,
+    const std::vector<std::pair<std::string, std::string>>& cookies) {
+  Url parsed;
+  if (!ParseUrl(url, &parsed)) {
+    return 0;
+  }
+  std::string host = CanonicalHost(parsed.host);
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  RemoveExpired(now);
+
+  std::unordered_map<std::string_view, std::string_view> wanted;
+  wanted.reserve(cookies.size());
+  for (const auto& pair : cookies) {
+    wanted.emplace(pair.first, pair.second);
+  }
+
+  // The pairs come from a Cookie header for |url|, so a pair stands for the
+  // first cookie of its name that header lists, whatever its domain and
+  // path; it only takes the pair's value, and keeps its attributes.
+  std::vector<Cookie> writes;
+  std::unordered_set<std::string_view> matched;
+  std::vector<CookieBucketMatch> buckets;
+  domains_.ForEachSuffix(
+      host, [&buckets](const std::vector<Cookie>& bucket, bool exact) {
+        buckets.push_back({&bucket, exact});
+      });
+  for (const Cookie* cookie : MatchingCookies(parsed, host, buckets, now)) {
+    if (!matched.insert(cookie->name).second) {
+      continue;
+    }
+    auto pair = wanted.find(cookie->name);
+    if (pair != wanted.end() && pair->second != cookie->value) {
+      Cookie changed = cookie->Copy();
+      changed.value = pair->second;
+      changed.Own();
+      writes.push_back(std::move(changed));
+    }
+  }
+  // Only names no cookie for |url| has are new, and become host-only
+  // cookies with path "/".
+  for (const auto& pair : cookies) {
+    if (matched.count(pair.first) == 0) {
+      Cookie cookie;
+      cookie.name = pair.first;
+      cookie.value = pair.second;
+      cookie.domain = host;
+      cookie.path = "/";
+      cookie.Own();
+      writes.push_back(std::move(cookie));
+    }
+  }
+
+  // Of the cookies a sync can create, those the pairs no longer name are
+  // removed.
+  std::vector<Cookie> stale;
+  if (const std::vector<Cookie>* bucket = domains_.Find(host)) {
+    for (const Cookie& cookie : *bucket) {
+      if (cookie.host_only && cookie.path == "/" &&
+          wanted.count(cookie.name) == 0) {
+        Cookie key;
+        key.name = cookie.name;
+        key.domain = cookie.domain;
+        key.path = cookie.path;
+        key.Own();
+        stale.push_back(std::move(key));
+      }
+    }
+  }
+
+  // Nothing above may be stored while the buckets are being read.
+  size_t changed = 0;
+  for (Cookie& cookie : stale) {
+    if (Store(std::move(cookie), true, true)) {
+      ++changed;
+    }
+  }
+  for (Cookie& cookie : writes) {
+    if (Store(std::move(cookie), false, true)) {
+      ++changed;
+    }
+  }
+  return changed;
+}
+
+void CookieJar::Restore(Cookie cookie, bool removed) {
+  next_creation_index_ =
+      std::max(next_creation_index_, cookie.creation_index + 1);
+  Store(std::move(cookie), removed, false);
+}
+
+bool CookieJar::Store(Cookie cookie, bool remove, bool notify, bool moved) {
+  std::vector<Cookie>* found = domains_.Find(cookie.domain);
+  if (found == nullptr && remove) {
+    return false;
+  }
+  std::vector<Cookie>& bucket =
+      found != nullptr ? *found : domains_.FindOrInsert(cookie.domain);
+  auto existing = std::find_if(
+      bucket.begin(), bucket.end(), [&cookie](const Cookie& other) {
+        return other.name == cookie.name && other.path == cookie.path;
+      });
+
+  if (remove) {
+    if (existing == bucket.end()) {
+      return false;
+    }
+    Remove(&bucket, existing, notify);
+    return true;
+  }
+
+  if (existing != bucket.end()) {
+    if (!moved) {
+      // Replacing keeps the original creation time, as RFC 6265 5.3
+      // requires.
+      cookie.creation_index = existing->creation_index;
+    } else if (cookie.creation_index != existing->creation_index) {
+      domain_of_.erase(existing->creation_index);
+    }
+    cookie.version = ++version_;
+    *existing = std::move(cookie);
+    Track(*existing);
+    if (notify) {
+      for (CookieJarObserver* observer : observers_) {
+        observer->OnCookieChanged(*existing, false);
+      }
+    }
+    return true;
+  }
+
+  if (moved) {
+    next_creation_index_ =
+        std::max(next_creation_index_, cookie.creation_index + 1);
+  } else if (notify) {
+    cookie.creation_index = next_creation_index_++;
+  }
+  cookie.version = ++version_;
+  // Keep the bucket ordered by descending path length so that the header is
+  // built in the order RFC 6265 5.4 recommends.
+  auto position = std::find_if(
+      bucket.begin(), bucket.end(), [&cookie](const Cookie& other) {
+        return other.path.size() < cookie.path.size();
+      });
+  auto inserted = bucket.insert(position, std::move(cookie));
+  ++size_;
+  Track(*inserted);
+  if (notify) {
+    for (CookieJarObserver* observer : observers_) {
+      observer->OnCookieChanged(*inserted, false);
+    }
+  }
+  if (!moved) {
+    EnforceLimits(&bucket, notify);
+  }
+  return true;
+}
+
+size_t CookieJar::ReplaceDomain(std::string_view domain,
+                                const std::vector<Cookie>& cookies) {
+  size_t changed = 0;
+  auto same_identity = [](const Cookie& a, const Cookie& b) {
+    return a.name == b.name && a.path == b.path;
+  };
+  // Removals go first, so that the bucket never holds more cookies than
+  // either side.
+  if (std::vector<Cookie>* bucket = domains_.Find(domain)) {
+    for (size_t i = bucket->size(); i-- > 0;) {
+      const Cookie& stored = (*bucket)[i];
+      if (std::any_of(cookies.begin(), cookies.end(),
+                      [&](const Cookie& cookie) {
+                        return same_identity(cookie, stored);
+                      })) {
+        continue;
+      }
+      bool last = bucket->size() == 1;
+      Remove(bucket, bucket->begin() + i, true);
+      ++changed;
+      if (last) {
+        // Remove erased the bucket itself.
+        break;
+      }
+    }
+  }
+  for (const Cookie& cookie : cookies) {
+    if (const std::vector<Cookie>* bucket = domains_.Find(domain)) {
+      auto existing =
+          std::find_if(bucket->begin(), bucket->end(),
+                       [&](const Cookie& stored) {
+                         return same_identity(cookie, stored);
+                       });
+      if (existing != bucket->end() && SameContent(*existing, cookie)) {
+        continue;
+      }
+    }
+    Store(cookie.Copy(), false, true, true);
+    ++changed;
+  }
+  return changed;
+}
+
+void CookieJar::Remove(std::vector<Cookie>* bucket,
+                       std::vector<Cookie>::iterator position,
+                       bool notify) {
+  Cookie removed = std::move(*position);
+  removed.version = ++version_;
+  bucket->erase(position);
+  --size_;
+  domain_of_.erase(removed.creation_index);
+  if (bucket->empty()) {
+    domains_.Erase(removed.domain);
+  }
+  if (notify) {
+    for (CookieJarObserver* observer : observers_) {
+      observer->OnCookieChanged(removed, true);
+    }
+  }
+}
+
+Cookie* CookieJar::FindByCreation(uint64_t creation_index,
+                                  std::vector<Cookie>** bucket) {
+  auto domain = domain_of_.find(creation_index);
+  if (domain == domain_of_.end()) {
+    return nullptr;
+  }
+  *bucket = domains_.Find(domain->second);
+  if (*bucket == nullptr) {
+    return nullptr;
+  }
+  for (Cookie& cookie : **bucket) {
+    if (cookie.creation_index == creation_index) {
+      return &cookie;
+    }
+  }
+  return nullptr;
+}
+
+void CookieJar::Track(const Cookie& cookie) {
+  domain_of_[cookie.creation_index] = cookie.domain;
+  if (cookie.expires != kNoExpiry) {
+    expiry_.Schedule(cookie.creation_index, cookie.expires);
+  }
+  stored_order_.emplace_back(cookie.creation_index, cookie.version);
+
+  // Superseded timers and queue entries pile up when the same cookies are
+  // set over and over; start afresh from the stored cookies once they
+  // outnumber them. Each rebuild is paid for by as many stores.
+  if (stored_order_.size() > 2 * size_ + 64) {
+    std::vector<std::pair<uint64_t, uint64_t>> order;
+    order.reserve(size_);
+    ForEach([&order](const Cookie& stored) {
+      order.emplace_back(stored.version, stored.creation_index);
+    });
+    std::sort(order.begin(), order.end());
+    stored_order_.clear();
+    for (const auto& entry : order) {
+      stored_order_.emplace_back(entry.second, entry.first);
+    }
+  }
+  if (expiry_.size() > 2 * size_ + 64) {
+    expiry_.Clear();
+    ForEach([this](const Cookie& stored) {
+      if (stored.expires != kNoExpiry) {
+        expiry_.Schedule(stored.creation_index, stored.expires);
+      }
+    });
+  }
+}
+
+void CookieJar::EnforceLimits(std::vector<Cookie>* bucket, bool notify) {
+  while (bucket->size() > limits_.max_cookies_per_domain) {
+    auto oldest = std::min_element(
+        bucket->begin(), bucket->end(),
+        [](const Cookie& a, const Cookie& b) { return a.version < b.version; });
+    bool last = bucket->size() == 1;
+    Remove(bucket, oldest, notify);
+    ++stats_.evicted;
+    if (last) {
+      // Remove erased the bucket itself.
+      return;
+    }
+  }
+  while (size_ > limits_.max_cookies && !stored_order_.empty()) {
+    auto [creation_index, version] = stored_order_.front();
+    stored_order_.pop_front();
+    std::vector<Cookie>* owner = nullptr;
+    Cookie* cookie = FindByCreation(creation_index, &owner);
+    if (cookie == nullptr || cookie->version != version) {
+      continue;
+    }
+    Remove(owner, owner->begin() + (cookie - owner->data()), notify);
+    ++stats_.evicted;
+  }
+}
+
+size_t CookieJar::RemoveExpired(int64_t now) {
+  std::vector<TimerWheel::Timer> fired;
+  expiry_.Advance(now, &fired);
+  size_t removed = 0;
+  for (const TimerWheel::Timer& timer : fired) {
+    std::vector<Cookie>* bucket = nullptr;
+    Cookie* cookie = FindByCreation(timer.id, &bucket);
+    if (cookie == nullptr || cookie->expires != timer.deadline) {
+      // Removed, or replaced with another expiry that has its own timer.
+      continue;
+    }
+    if (cookie->expires > now) {
+      // The clock went back since the timer was scheduled.
+      expiry_.Schedule(timer.id, timer.deadline);
+      continue;
+    }
+    Remove(bucket, bucket->begin() + (cookie - bucket->data()), true);
+    ++stats_.expired;
+    ++removed;
+  }
+  return removed;
+}
+
+std::string CookieJar::GetCookieHeader(std::string_view url) const {
+  if (domains_.empty()) {
+    return std::string();
+  }
+  return BuildCookieHeader(
+      url, [this](std::string_view host,
+                  std::vector<CookieBucketMatch>* matches) {
+        domains_.ForEachSuffix(
+            host, [matches](const std::vector<Cookie>& bucket, bool exact) {
+              matches->push_back({&bucket, exact});
+            });
+      });
+}
+
+std::string BuildCookieHeader(std::string_view url,
+                              const CookieBucketLookup& find_buckets) {
+  Url parsed;
+  if (!ParseUrl(url, &parsed)) {
+    return std::string();
+  }
+  std::string host = CanonicalHost(parsed.host);
+  std::vector<CookieBucketMatch> buckets;
+  find_buckets(host, &buckets);
+  // Cookies that expired since the jar's last mutation are still stored.
+  std::vector<const Cookie*> matches = MatchingCookies(
+      parsed, host, buckets, static_cast<int64_t>(std::time(nullptr)));
+
+  std::string header;
+  for (const Cookie* cookie : matches) {
+    if (!header.empty()) {
+      header += "; ";
+    }
+    header += cookie->name;
+    header += '=';
+    header += cookie->value;
+  }
+  return header;
+}
+
+void CookieJar::Clear() {
+  domains_.Clear();
+  backings_.clear();
+  expiry_.Clear();
+  domain_of_.clear();
+  stored_order_.clear();
+  size_ = 0;
+  ++version_;
+  for (CookieJarObserver* observer : observers_) {
+    observer->OnCookiesCleared();
+  }
+}
+
+void CookieJar::ForEach(
+    const std::function<void(const Cookie&)>& visit) const {
+  domains_.ForEach([&visit](const std::vector<Cookie>& bucket) {
+    for (const Cookie& cookie : bucket) {
+      visit(cookie);
+    }
+  });
+}
+
+void CookieJar::ForEachInDomain(
+    const std::string& domain,
+    const std::function<void(const Cookie&)>& visit) const {
+  const std::vector<Cookie>* bucket = domains_.Find(domain);
+  if (bucket == nullptr) {
+    return;
+  }
+  for (const Cookie& cookie : *bucket) {
+    visit(cookie);
+  }
+}
+
+void CookieJar::AdoptBacking(std::shared_ptr<const void> backing) {
+  backings_.push_back(std::move(backing));
+}
+
+void CookieJar::AddObserver(CookieJarObserver* observer) {
+  observers_.push_back(observer);
+}
+
+void CookieJar::RemoveObserver(CookieJarObserver* observer) {
+  observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
+                   observers_.end());
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,245 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_COOKIE_JAR_H_
+#define FLUTTER_COOKIE_BRIDGE_COOKIE_JAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "domain_trie.h"
+#include "set_cookie_parser.h"
+#include "timer_wheel.h"
+
+namespace flutter_cookie_bridge {
+
+// A single stored cookie, following the storage model of RFC 6265 5.3.
+//
+// The string fields are views. A cookie received at runtime owns the bytes
+// they point at through |storage|; a cookie restored from disk points into a
+// buffer the jar keeps alive as a whole (see CookieJar::AdoptBacking), so
+// loading does not allocate per cookie.
+struct Cookie {
+  std::string_view name;
+  std::string_view value;
+  // Canonical (lowercase, no leading dot) domain the cookie is stored under.
+  std::string_view domain;
+  std::string_view path;
+  // True when the response did not carry a Domain attribute, in which case
+  // the cookie is only sent back to exactly |domain|.
+  bool host_only = true;
+  bool secure = false;
+  bool http_only = false;
+  SameSite same_site = SameSite::kUnspecified;
+  // Expiry in seconds since the epoch, or kNoExpiry for a session cookie.
+  int64_t expires = kNoExpiry;
+  // Insertion order, used to break ties when ordering the Cookie header.
+  uint64_t creation_index = 0;
+  // Jar version of the last mutation of this cookie, see CookieJar::version.
+  uint64_t version = 0;
+  // Backs the views when the cookie owns its bytes; null otherwise.
+  std::unique_ptr<char[]> storage;
+
+  // Copies the bytes of all views into |storage| and repoints the views.
+  void Own();
+
+  // Returns a copy that owns its bytes.
+  Cookie Copy() const;
+};
+
+// Receives every mutation of a CookieJar after it has been applied.
+class CookieJarObserver {
+ public:
+  virtual ~CookieJarObserver() = default;
+
+  // |cookie| was stored, or removed when |removed| is set.
+  virtual void OnCookieChanged(const Cookie& cookie, bool removed) = 0;
+
+  // Every cookie was removed.
+  virtual void OnCookiesCleared() = 0;
+};
+
+// Caps on the number of cookies a CookieJar keeps. The defaults are the
+// minimums RFC 6265 6.1 asks a user agent to support.
+struct CookieJarLimits {
+  size_t max_cookies_per_domain = 50;
+  size_t max_cookies = 3000;
+};
+
+// Cookies a CookieJar dropped on its own, since it was created.
+struct CookieJarStats {
+  // Removed because their expiry passed.
+  uint64_t expired = 0;
+  // Removed to stay within the CookieJarLimits.
+  uint64_t evicted = 0;
+};
+
+// In-memory cookie jar indexed by domain.
+//
+// Cookies are bucketed under their canonical domain in a DomainTrie and each
+// bucket is kept ordered by descending path length, so building a request
+// header is one walk of the trie, a step per label of the request host,
+// rather than a scan of the whole jar. Cookies scoped to a public suffix
+// are rejected.
+//
+// Persistent cookies are also scheduled on a TimerWheel at their expiry, and
+// every mutation first removes the cookies whose time has come, as if the
+// server had expired them. A bucket or jar over its CookieJarLimits loses
+// its least recently stored cookie. Recency is that of the last Set-Cookie
+// rather than of the last request, so that reading stays free of writes.
+// Expired cookies still waiting for a mutation are never sent.
+class CookieJar {
+ public:
+  explicit CookieJar(CookieJarLimits limits = CookieJarLimits());
+
+  CookieJar(const CookieJar&) = delete;
+  CookieJar& operator=(const CookieJar&) = delete;
+
+  // Stores the cookies carried by |set_cookie_headers|, the raw Set-Cookie
+  // header values of a response to |url|. Cookies that the response is not
+  // allowed to set are dropped. Returns the number of cookies stored or
+  // removed.
+  size_t SetCookies(std::string_view url,
+                    const std::vector<std::string>& set_cookie_headers);
+
+  // Brings the jar in line with |cookies|, the name/value pairs of a Cookie
+  // header for |url| as a WebView holds them. A pair updates the value of
+  // the cookie of its name that a request to |url| sends first, whatever
+  // its domain and path, keeping its attributes; a name no such cookie has
+  // becomes a host-only cookie with path "/" for the host of |url|, and any
+  // other host-only cookie with path "/" of that host is removed. This is
+  // the diff the WebView bridges apply in a single call. Returns the number
+  // of cookies stored or removed.
+  size_t SyncCookies(
+      std::string_view url,
+      const std::vector<std::pair<std::string, std::string>>& cookies);
+
+  // Returns the value of the Cookie request header for |url|, or an empty
+  // string when no stored cookie applies.
+  std::string GetCookieHeader(std::string_view url) const;
+
+  // Removes the cookies that expired at or before |now|, in seconds since
+  // the epoch, notifying observers. Returns how many were removed.
+  size_t RemoveExpired(int64_t now);
+
+  // Makes the cookies stored under the canonical |domain| exactly
+  // |cookies|, as another jar holds them: they keep their creation indexes
+  // and are not evicted. Observers see each cookie that changes. For moving
+  // the jar between partitions, see SharedCookieJar. Returns the number of
+  // cookies stored or removed.
+  size_t ReplaceDomain(std::string_view domain,
+                       const std::vector<Cookie>& cookies);
+
+  // Removes every cookie.
+  void Clear();
+
+  // The number of stored cookies.
+  size_t size() const { return size_; }
+
+  const CookieJarStats& stats() const { return stats_; }
+
+  // Increases with every mutation, restores from disk included. A stored or
+  // removed cookie carries the version of the mutation that produced it, so
+  // consumers can ask for everything after the last version they saw.
+  uint64_t version() const { return version_; }
+
+  // Calls |visit| for every stored cookie, in no particular order.
+  void ForEach(const std::function<void(const Cookie&)>& visit) const;
+
+  // Calls |visit| for every cookie stored under the canonical |domain|.
+  void ForEachInDomain(const std::string& domain,
+                       const std::function<void(const Cookie&)>& visit) const;
+
+  // Stores a cookie loaded from persistent storage without notifying
+  // observers. |cookie| keeps its creation index; with |removed| set any
+  // cookie with the same identity is deleted instead.
+  void Restore(Cookie cookie, bool removed);
+
+  // Keeps |backing| alive for as long as the jar may hold cookies whose
+  // views point into it. Released by Clear.
+  void AdoptBacking(std::shared_ptr<const void> backing);
+
+  // Registers |observer|, which must outlive the jar or be removed first.
+  void AddObserver(CookieJarObserver* observer);
+  void RemoveObserver(CookieJarObserver* observer);
+
+ private:
+  // Stores or replaces a single cookie. With |remove| set, deletes any
+  // existing cookie with the same identity instead. A |moved| cookie keeps
+  // its creation index and skips the limits. Returns true when the jar
+  // changed.
+  bool Store(Cookie cookie, bool remove, bool notify, bool moved = false);
+
+  // Removes the cookie at |position| in |bucket|.
+  void Remove(std::vector<Cookie>* bucket,
+              std::vector<Cookie>::iterator position,
+              bool notify);
+
+  // Returns the stored cookie with |creation_index|, or null, and sets
+  // |bucket| to the bucket holding it.
+  Cookie* FindByCreation(uint64_t creation_index,
+                         std::vector<Cookie>** bucket);
+
+  // Records that |cookie| was just stored, for expiry and eviction.
+  void Track(const Cookie& cookie);
+
+  // Evicts cookies until |bucket| and the jar are within limits_.
+  void EnforceLimits(std::vector<Cookie>* bucket, bool notify);
+
+  DomainTrie<std::vector<Cookie>> domains_;
+  std::vector<std::shared_ptr<const void>> backings_;
+  std::vector<CookieJarObserver*> observers_;
+  size_t size_ = 0;
+  uint64_t next_creation_index_ = 0;
+  uint64_t version_ = 0;
+
+  CookieJarLimits limits_;
+  CookieJarStats stats_;
+  // Timers by creation index. A cookie replaced with another expiry leaves
+  // its old timer behind; what fires is checked against the cookie.
+  TimerWheel expiry_;
+  // The domain of every stored cookie by creation index, so that a timer
+  // or eviction can find its bucket. Views into the cookies themselves.
+  std::unordered_map<uint64_t, std::string_view> domain_of_;
+  // Creation index and version of every store, oldest first. Entries whose
+  // cookie has since been replaced or removed are skipped on eviction and
+  // dropped when the queue is rebuilt.
+  std::deque<std::pair<uint64_t, uint64_t>> stored_order_;
+};
+
+// Cookies stored under a domain that a request host domain-matches.
+struct CookieBucketMatch {
+  const std::vector<Cookie>* cookies;
+  // Set when the domain is the request host itself.
+  bool exact;
+};
+
+// Appends to |matches| the buckets stored under the canonical |host| and
+// under every domain it is a subdomain of.
+using CookieBucketLookup = std::function<void(
+    std::string_view host, std::vector<CookieBucketMatch>* matches)>;
+
+// Builds the Cookie request header for |url| as RFC 6265 5.4 describes, from
+// buckets ordered like CookieJar's. Shared by CookieJar and the snapshots of
+// SharedCookieJar.
+std::string BuildCookieHeader(std::string_view url,
+                              const CookieBucketLookup& find_bucket);
+
+// Returns true when |host| is an IPv4 or IPv6 literal, for which cookies only
+// ever match exactly.
+bool IsIpAddress(std::string_view host);
+
+// Implements the path-match algorithm of RFC 6265 5.1.4.
+bool PathMatches(std::string_view cookie_path, std::string_view request_path);
+
+// Implements the default-path algorithm of RFC 6265 5.1.4.
+std::string_view DefaultPath(std::string_view request_path);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_COOKIE_JAR_H_
@@ -0,0 +1,467 @@
+#include "cookie_store.h"
+
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'C', 'B', 'L', 'O', 'G', '\0', '\1'};
+// Starts a log of sealed records.
+constexpr char kSealedMagic[8] = {'F', 'C', 'B', 'L', 'O', 'G', '\0', '\2'};
+static_assert(sizeof(kSealedMagic) == sizeof(kMagic), "");
+
+// Logs with fewer records are checked on the opening thread alone.
+constexpr size_t kParallelReplayRecords = 256;
+constexpr unsigned kMaxReplayThreads = 8;
+
+// Precedes every record. |length| counts the payload that follows and
+// |checksum| is its CRC-32, or 0 for a sealed record, which its tag
+// authenticates instead.
+struct RecordHeader {
+  uint32_t length;
+  uint32_t checksum;
+};
+
+// The fixed-size start of every record payload, followed by the name,
+// domain, path and value bytes.
+struct RecordFields {
+  uint8_t type;
+  uint8_t flags;
+  uint8_t same_site;
+  uint8_t reserved;
+  uint16_t name_length;
+  uint16_t domain_length;
+  uint16_t path_length;
+  uint16_t reserved2;
+  uint32_t value_length;
+  int64_t expires;
+  uint64_t creation_index;
+};
+static_assert(sizeof(RecordFields) == 32, "record layout must not change");
+
+enum RecordFlag : uint8_t {
+  kRecordHostOnly = 1 << 0,
+  kRecordSecure = 1 << 1,
+  kRecordHttpOnly = 1 << 2,
+};
+
+std::array<uint32_t, 256> MakeCrcTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+uint32_t Crc32(const char* data, size_t size) {
+  static const std::array<uint32_t, 256> table = MakeCrcTable();
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+}  // namespace
+
+CookieStore::CookieStore(std::string path,
+                         size_t compaction_threshold,
+                         std::unique_ptr<CookieKeyProvider> keys)
+    : path_(std::move(path)),
+      compaction_threshold_(compaction_threshold),
+      keys_(std::move(keys)) {}
+
+CookieStore::~CookieStore() {
+  WaitForCompaction();
+  if (jar_ != nullptr) {
+    jar_->RemoveObserver(this);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ >= 0) {
+    fdatasync(fd_);
+    close(fd_);
+  }
+}
+
+bool CookieStore::Open(CookieJar* jar) {
+  if (keys_ != nullptr) {
+    CookieKey key;
+    if (!keys_->GetKey(&key)) {
+      return false;
+    }
+    cipher_ =
+        std::make_unique<RecordCipher>(key, RecordCipher::PreferredAlgorithm());
+    OPENSSL_cleanse(key.data(), key.size());
+  }
+  const char* magic = cipher_ != nullptr ? kSealedMagic : kMagic;
+
+  int fd = open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  jar_ = jar;
+
+  struct stat info = {};
+  fstat(fd, &info);
+  size_t size = static_cast<size_t>(info.st_size);
+  size_t valid = 0;
+  bool migrate = false;
+  if (size >= sizeof(kMagic)) {
+    // Private and writable, so that sealed records decrypt in place without
+    // touching the file.
+    void* mapping =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      char* data = static_cast<char*>(mapping);
+      int64_t now = static_cast<int64_t>(std::time(nullptr));
+      if (std::memcmp(data, kMagic, sizeof(kMagic)) == 0) {
+        valid = Replay(data, size, now, false);
+        migrate = cipher_ != nullptr;
+      } else if (cipher_ != nullptr &&
+                 std::memcmp(data, kSealedMagic, sizeof(kMagic)) == 0) {
+        valid = Replay(data, size, now, true);
+      }
+      // Restored cookies point into the mapping, so the jar keeps it alive.
+      jar->AdoptBacking(std::shared_ptr<const void>(
+          mapping, [size](const void* address) {
+            munmap(const_cast<void*>(address), size);
+          }));
+    }
+  }
+
+  if (valid < sizeof(kMagic)) {
+    // Empty, foreign or unreadable: start a fresh log.
+    migrate = false;
+    if (ftruncate(fd, 0) != 0 || !WriteAll(fd, magic, sizeof(kMagic))) {
+      close(fd);
+      jar_ = nullptr;
+      return false;
+    }
+  } else if (valid < size) {
+    // Drop the torn tail left by a crash in the middle of an append.
+    if (ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+      close(fd);
+      jar_ = nullptr;
+      return false;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    compacting_ = migrate;
+  }
+  if (migrate) {
+    // Seal the plaintext log before anything is appended to it.
+    if (!Compact(EncodeLive(), jar->size())) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      close(fd_);
+      fd_ = -1;
+      jar_ = nullptr;
+      return false;
+    }
+  }
+  jar->AddObserver(this);
+  MaybeStartCompaction();
+  return true;
+}
+
+size_t CookieStore::Replay(char* data, size_t size, int64_t now, bool sealed) {
+  size_t overhead = sealed ? RecordCipher::kOverhead : 0;
+  size_t prefix = sealed ? RecordCipher::kPrefix : 0;
+
+  // Find the records by their framing alone. Checking, and for a sealed log
+  // decrypting, them is the expensive part, spread over several threads
+  // for a large log.
+  std::vector<size_t> offsets;
+  size_t offset = sizeof(kMagic);
+  while (offset + sizeof(RecordHeader) <= size) {
+    RecordHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+    if (header.length < sizeof(RecordFields) + overhead ||
+        header.length > size - offset - sizeof(header)) {
+      break;
+    }
+    offsets.push_back(offset);
+    offset += sizeof(header) + header.length;
+  }
+
+  std::vector<uint8_t> intact(offsets.size());
+  auto check = [this, data, sealed, &offsets, &intact](size_t begin,
+                                                       size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      RecordHeader header;
+      std::memcpy(&header, data + offsets[i], sizeof(header));
+      char* payload = data + offsets[i] + sizeof(header);
+      intact[i] = sealed ? cipher_->Open(payload, header.length)
+                         : Crc32(payload, header.length) == header.checksum;
+    }
+  };
+  size_t threads = 1;
+  if (offsets.size() >= kParallelReplayRecords) {
+    threads = std::min(std::max(std::thread::hardware_concurrency(), 1u),
+                       kMaxReplayThreads);
+  }
+  size_t chunk = (offsets.size() + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (size_t begin = chunk; begin < offsets.size(); begin += chunk) {
+    workers.emplace_back(check, begin, std::min(offsets.size(), begin + chunk));
+  }
+  check(0, std::min(offsets.size(), chunk));
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  size_t valid = sizeof(kMagic);
+  for (size_t i = 0; i < offsets.size() && intact[i]; ++i) {
+    RecordHeader header;
+    std::memcpy(&header, data + offsets[i], sizeof(header));
+    const char* payload = data + offsets[i] + sizeof(header) + prefix;
+    size_t length = header.length - overhead;
+    RecordFields fields;
+    std::memcpy(&fields, payload, sizeof(fields));
+    size_t strings_length = static_cast<size_t>(fields.name_length) +
+                            fields.domain_length + fields.path_length +
+                            fields.value_length;
+    if (strings_length != length - sizeof(RecordFields)) {
+      break;
+    }
+
+    if (fields.type == kRecordClear) {
+      jar_->Clear();
+    } else {
+      const char* cursor = payload + sizeof(RecordFields);
+      Cookie cookie;
+      cookie.name = std::string_view(cursor, fields.name_length);
+      cursor += fields.name_length;
+      cookie.domain = std::string_view(cursor, fields.domain_length);
+      cursor += fields.domain_length;
+      cookie.path = std::string_view(cursor, fields.path_length);
+      cursor += fields.path_length;
+      cookie.value = std::string_view(cursor, fields.value_length);
+      cookie.host_only = fields.flags & kRecordHostOnly;
+      cookie.secure = fields.flags & kRecordSecure;
+      cookie.http_only = fields.flags & kRecordHttpOnly;
+      cookie.same_site = static_cast<SameSite>(fields.same_site);
+      cookie.expires = fields.expires;
+      cookie.creation_index = fields.creation_index;
+
+      bool expired = cookie.expires != kNoExpiry && cookie.expires <= now;
+      if (expired) {
+        ++discarded_on_open_;
+      }
+      jar_->Restore(std::move(cookie),
+                    fields.type == kRecordDelete || expired);
+    }
+    ++records_;
+    valid = offsets[i] + sizeof(header) + header.length;
+  }
+  if (valid < size) {
+    ++discarded_on_open_;
+  }
+  return valid;
+}
+
+void CookieStore::EncodeRecord(RecordType type,
+                               const Cookie* cookie,
+                               std::vector<char>* out) const {
+  RecordFields fields = {};
+  fields.type = type;
+  if (cookie != nullptr) {
+    fields.flags = (cookie->host_only ? kRecordHostOnly : 0) |
+                   (cookie->secure ? kRecordSecure : 0) |
+                   (cookie->http_only ? kRecordHttpOnly : 0);
+    fields.same_site = static_cast<uint8_t>(cookie->same_site);
+    fields.name_length = static_cast<uint16_t>(cookie->name.size());
+    fields.domain_length = static_cast<uint16_t>(cookie->domain.size());
+    fields.path_length = static_cast<uint16_t>(cookie->path.size());
+    // Deletions only need the identity of the cookie.
+    fields.value_length = type == kRecordPut
+                              ? static_cast<uint32_t>(cookie->value.size())
+                              : 0;
+    fields.expires = cookie->expires;
+    fields.creation_index = cookie->creation_index;
+  }
+
+  size_t plain_length = sizeof(fields) + fields.name_length +
+                        fields.domain_length + fields.path_length +
+                        fields.value_length;
+  bool sealed = cipher_ != nullptr;
+  RecordHeader header;
+  header.length = static_cast<uint32_t>(
+      plain_length + (sealed ? RecordCipher::kOverhead : 0));
+  size_t start = out->size();
+  out->resize(start + sizeof(header) + header.length);
+  char* payload = out->data() + start + sizeof(header);
+  char* cursor = payload + (sealed ? RecordCipher::kPrefix : 0);
+  std::memcpy(cursor, &fields, sizeof(fields));
+  cursor += sizeof(fields);
+  if (cookie != nullptr) {
+    std::memcpy(cursor, cookie->name.data(), fields.name_length);
+    cursor += fields.name_length;
+    std::memcpy(cursor, cookie->domain.data(), fields.domain_length);
+    cursor += fields.domain_length;
+    std::memcpy(cursor, cookie->path.data(), fields.path_length);
+    cursor += fields.path_length;
+    std::memcpy(cursor, cookie->value.data(), fields.value_length);
+  }
+  if (sealed) {
+    header.checksum = 0;
+    if (!cipher_->Seal(payload, plain_length)) {
+      out->resize(start);
+      return;
+    }
+  } else {
+    header.checksum = Crc32(payload, header.length);
+  }
+  std::memcpy(out->data() + start, &header, sizeof(header));
+}
+
+bool CookieStore::AppendLocked(const std::vector<char>& bytes) {
+  if (fd_ < 0) {
+    return false;
+  }
+  if (compacting_) {
+    pending_.insert(pending_.end(), bytes.begin(), bytes.end());
+    ++pending_records_;
+  }
+  ++records_;
+  return WriteAll(fd_, bytes.data(), bytes.size());
+}
+
+void CookieStore::OnCookieChanged(const Cookie& cookie, bool removed) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scratch_.clear();
+    EncodeRecord(removed ? kRecordDelete : kRecordPut, &cookie, &scratch_);
+    if (!scratch_.empty()) {
+      AppendLocked(scratch_);
+    }
+  }
+  MaybeStartCompaction();
+}
+
+void CookieStore::OnCookiesCleared() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ < 0) {
+    return;
+  }
+  if (compacting_) {
+    // The compacted log is built from an older snapshot; make sure it ends
+    // up empty too.
+    pending_.clear();
+    EncodeRecord(kRecordClear, nullptr, &pending_);
+    pending_records_ = 1;
+  }
+  if (ftruncate(fd_, sizeof(kMagic)) == 0) {
+    records_ = 0;
+  }
+}
+
+size_t CookieStore::record_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+void CookieStore::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ >= 0) {
+    fdatasync(fd_);
+  }
+}
+
+void CookieStore::WaitForCompaction() {
+  if (compactor_.joinable()) {
+    compactor_.join();
+  }
+}
+
+void CookieStore::MaybeStartCompaction() {
+  size_t live = jar_->size();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (compacting_ || fd_ < 0 || records_ < live + compaction_threshold_ ||
+        records_ - live < live) {
+      return;
+    }
+    compacting_ = true;
+    pending_.clear();
+    pending_records_ = 0;
+  }
+
+  // Encoding the live cookies is a memory copy; the disk I/O and fsync
+  // happen on the compactor thread.
+  std::vector<char> snapshot = EncodeLive();
+  WaitForCompaction();
+  compactor_ = std::thread(&CookieStore::Compact, this, std::move(snapshot),
+                           live);
+}
+
+std::vector<char> CookieStore::EncodeLive() const {
+  const char* magic = cipher_ != nullptr ? kSealedMagic : kMagic;
+  std::vector<char> snapshot(magic, magic + sizeof(kMagic));
+  jar_->ForEach([this, &snapshot](const Cookie& cookie) {
+    EncodeRecord(kRecordPut, &cookie, &snapshot);
+  });
+  return snapshot;
+}
+
+bool CookieStore::Compact(std::vector<char> snapshot, size_t live_records) {
+  std::string temp_path = path_ + ".compact";
+  int fd = open(temp_path.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+  bool ok = fd >= 0 && WriteAll(fd, snapshot.data(), snapshot.size());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ok = ok && WriteAll(fd, pending_.data(), pending_.size()) &&
+       fdatasync(fd) == 0 && rename(temp_path.c_str(), path_.c_str()) == 0;
+  if (ok) {
+    close(fd_);
+    fd_ = fd;
+    records_ = live_records + pending_records_;
+  } else {
+    if (fd >= 0) {
+      close(fd);
+    }
+    unlink(temp_path.c_str());
+  }
+  compacting_ = false;
+  pending_.clear();
+  pending_records_ = 0;
+  return ok;
+}
+
+}  // namespace flutter_cookie_bridge
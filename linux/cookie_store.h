@@ -0,0 +1,117 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_COOKIE_STORE_H_
+#define FLUTTER_COOKIE_BRIDGE_COOKIE_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cookie_jar.h"
+#include "record_cipher.h"
+
+namespace flutter_cookie_bridge {
+
+// Persists a CookieJar in an append-only log.
+//
+// Every mutation of the jar appends one record, so a write costs O(changed
+// cookies) instead of rewriting the whole jar. On open the log is mapped
+// into memory and replayed; restored cookies point straight into the
+// mapping. A record that fails its length or checksum check marks a torn
+// write from a crash, and the log is truncated there. Once dead records (ones
+// superseded by later records) dominate the log, it is rewritten from the
+// live cookies on a background thread and atomically swapped in.
+//
+// Given a CookieKeyProvider, the store seals every record on its own with a
+// RecordCipher, so an append still costs one record and the log holds no
+// cookie in the clear. Records are then checked and decrypted on several
+// threads while loading. A plaintext log is rewritten sealed when it is
+// opened with a key; a sealed one that the key does not open is dropped.
+class CookieStore : public CookieJarObserver {
+ public:
+  // Minimum number of dead records before compaction is considered.
+  static constexpr size_t kDefaultCompactionThreshold = 256;
+
+  explicit CookieStore(
+      std::string path,
+      size_t compaction_threshold = kDefaultCompactionThreshold,
+      std::unique_ptr<CookieKeyProvider> keys = nullptr);
+  ~CookieStore() override;
+
+  CookieStore(const CookieStore&) = delete;
+  CookieStore& operator=(const CookieStore&) = delete;
+
+  // Opens the log, replays it into |jar| and starts recording |jar|'s
+  // mutations. |jar| must outlive the store. Returns false when the log
+  // cannot be opened or created, or no key is available for it; the jar
+  // then stays purely in memory.
+  bool Open(CookieJar* jar);
+
+  // Flushes appended records to stable storage.
+  void Flush();
+
+  // Blocks until any running compaction has finished.
+  void WaitForCompaction();
+
+  // The number of records in the log, live or dead.
+  size_t record_count() const;
+
+  // The number of records dropped on open because they were corrupt or
+  // expired.
+  size_t discarded_on_open() const { return discarded_on_open_; }
+
+  // CookieJarObserver:
+  void OnCookieChanged(const Cookie& cookie, bool removed) override;
+  void OnCookiesCleared() override;
+
+ private:
+  enum RecordType : uint8_t {
+    kRecordPut = 1,
+    kRecordDelete = 2,
+    kRecordClear = 3,
+  };
+
+  // Appends one encoded record to |out|, sealed when the store has a key.
+  void EncodeRecord(RecordType type,
+                    const Cookie* cookie,
+                    std::vector<char>* out) const;
+
+  // Replays the mapped log into the jar, decrypting sealed records in
+  // place. Returns the length of the valid prefix.
+  size_t Replay(char* data, size_t size, int64_t now, bool sealed);
+
+  // Writes |bytes| at the end of the log. Requires |mutex_|.
+  bool AppendLocked(const std::vector<char>& bytes);
+
+  // The log header followed by a record for every live cookie.
+  std::vector<char> EncodeLive() const;
+
+  void MaybeStartCompaction();
+  // Writes |snapshot| and the pending records to a new log and swaps it in.
+  // Returns false when the current log stays.
+  bool Compact(std::vector<char> snapshot, size_t live_records);
+
+  const std::string path_;
+  const size_t compaction_threshold_;
+  std::unique_ptr<CookieKeyProvider> keys_;
+  std::unique_ptr<RecordCipher> cipher_;
+  CookieJar* jar_ = nullptr;
+  size_t discarded_on_open_ = 0;
+
+  mutable std::mutex mutex_;
+  int fd_ = -1;
+  size_t records_ = 0;
+  bool compacting_ = false;
+  // Records appended while a compaction runs; replayed onto the compacted
+  // log before it replaces the current one.
+  std::vector<char> pending_;
+  size_t pending_records_ = 0;
+  std::thread compactor_;
+  std::vector<char> scratch_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_COOKIE_STORE_H_
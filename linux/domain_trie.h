@@ -0,0 +1,248 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_DOMAIN_TRIE_H_
+#define FLUTTER_COOKIE_BRIDGE_DOMAIN_TRIE_H_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+// Values keyed by canonical domain, stored in a trie of reversed labels:
+// "api.example.com" lives at com -> example -> api.
+//
+// Every domain a host is a subdomain of lies on the path from the root to
+// the host, so ForEachSuffix finds all of them in one walk of one step per
+// label of the host, whatever the number of domains stored.
+template <typename Value>
+class DomainTrie {
+ public:
+  DomainTrie() = default;
+  DomainTrie(const DomainTrie& other) { *this = other; }
+  DomainTrie& operator=(const DomainTrie& other) {
+    if (this != &other) {
+      root_ = Clone(other.root_);
+      size_ = other.size_;
+    }
+    return *this;
+  }
+  DomainTrie(DomainTrie&&) = default;
+  DomainTrie& operator=(DomainTrie&&) = default;
+
+  bool empty() const { return size_ == 0; }
+
+  // The number of domains with a value.
+  size_t size() const { return size_; }
+
+  // Returns the value stored under |domain|, or null when there is none.
+  Value* Find(std::string_view domain) {
+    Node* node = FindNode(domain);
+    return node != nullptr && node->value ? &*node->value : nullptr;
+  }
+  const Value* Find(std::string_view domain) const {
+    return const_cast<DomainTrie*>(this)->Find(domain);
+  }
+
+  // Returns the value stored under |domain|, storing a default-constructed
+  // one first when there is none.
+  Value& FindOrInsert(std::string_view domain) {
+    Node* node = &root_;
+    std::string key;
+    for (Labels labels(domain); labels.Next();) {
+      key.assign(labels.label());
+      std::unique_ptr<Node>& child = node->children[key];
+      if (child == nullptr) {
+        child = std::make_unique<Node>();
+      }
+      node = child.get();
+    }
+    if (!node->value) {
+      node->value.emplace();
+      ++size_;
+    }
+    return *node->value;
+  }
+
+  // Removes the value stored under |domain|, and the nodes that no longer
+  // lead to any value. Returns false when there was none.
+  bool Erase(std::string_view domain) {
+    std::vector<std::pair<Node*, std::string>> path;
+    Node* node = &root_;
+    for (Labels labels(domain); labels.Next();) {
+      std::string key(labels.label());
+      auto it = node->children.find(key);
+      if (it == node->children.end()) {
+        return false;
+      }
+      path.emplace_back(node, std::move(key));
+      node = it->second.get();
+    }
+    if (!node->value) {
+      return false;
+    }
+    node->value.reset();
+    --size_;
+    while (!path.empty() && !node->value && node->children.empty()) {
+      Node* parent = path.back().first;
+      parent->children.erase(path.back().second);
+      path.pop_back();
+      node = parent;
+    }
+    return true;
+  }
+
+  void Clear() {
+    root_ = Node();
+    size_ = 0;
+  }
+
+  // Calls |visit(value)| for every stored value, in no particular order.
+  template <typename Visit>
+  void ForEach(Visit&& visit) const {
+    ForEachIn(root_, visit);
+  }
+
+  // Calls |visit(value, other_value)| for every domain whose values in this
+  // trie and in |other| differ, with null for a missing one. Both tries are
+  // walked together, so no domain is looked up.
+  template <typename Visit>
+  void ForEachDifference(const DomainTrie& other, Visit&& visit) const {
+    DifferencesIn(&root_, &other.root_, visit);
+  }
+
+  // Calls |visit(value, exact)| for the values stored under |host| and
+  // under every domain |host| is a subdomain of, from the top-level domain
+  // down. |exact| is set for |host| itself.
+  template <typename Visit>
+  void ForEachSuffix(std::string_view host, Visit&& visit) const {
+    const Node* node = &root_;
+    std::string key;
+    for (Labels labels(host); labels.Next();) {
+      key.assign(labels.label());
+      auto it = node->children.find(key);
+      if (it == node->children.end()) {
+        return;
+      }
+      node = it->second.get();
+      if (node->value) {
+        visit(*node->value, labels.done());
+      }
+    }
+  }
+
+ private:
+  struct Node {
+    std::optional<Value> value;
+    std::unordered_map<std::string, std::unique_ptr<Node>> children;
+  };
+
+  // The labels of a domain, from the last to the first.
+  class Labels {
+   public:
+    explicit Labels(std::string_view domain)
+        : domain_(domain), end_(domain.size()) {}
+
+    bool Next() {
+      if (done_) {
+        return false;
+      }
+      size_t dot = end_ == 0 ? std::string_view::npos
+                             : domain_.rfind('.', end_ - 1);
+      size_t start = dot == std::string_view::npos ? 0 : dot + 1;
+      label_ = domain_.substr(start, end_ - start);
+      done_ = dot == std::string_view::npos;
+      end_ = done_ ? 0 : dot;
+      return true;
+    }
+
+    std::string_view label() const { return label_; }
+
+    // Whether label() is the first label of the domain.
+    bool done() const { return done_; }
+
+   private:
+    std::string_view domain_;
+    std::string_view label_;
+    size_t end_;
+    bool done_ = false;
+  };
+
+  Node* FindNode(std::string_view domain) {
+    Node* node = &root_;
+    std::string key;
+    for (Labels labels(domain); labels.Next();) {
+      key.assign(labels.label());
+      auto it = node->children.find(key);
+      if (it == node->children.end()) {
+        return nullptr;
+      }
+      node = it->second.get();
+    }
+    return node;
+  }
+
+  static Node Clone(const Node& node) {
+    Node copy;
+    copy.value = node.value;
+    copy.children.reserve(node.children.size());
+    for (const auto& child : node.children) {
+      copy.children.emplace(child.first,
+                            std::make_unique<Node>(Clone(*child.second)));
+    }
+    return copy;
+  }
+
+  template <typename Visit>
+  static void DifferencesIn(const Node* node, const Node* other,
+                            Visit& visit) {
+    const Value* value =
+        node != nullptr && node->value ? &*node->value : nullptr;
+    const Value* other_value =
+        other != nullptr && other->value ? &*other->value : nullptr;
+    if (value == nullptr || other_value == nullptr
+            ? value != other_value
+            : *value != *other_value) {
+      visit(value, other_value);
+    }
+    if (node != nullptr) {
+      for (const auto& child : node->children) {
+        const Node* other_child = nullptr;
+        if (other != nullptr) {
+          auto it = other->children.find(child.first);
+          if (it != other->children.end()) {
+            other_child = it->second.get();
+          }
+        }
+        DifferencesIn(child.second.get(), other_child, visit);
+      }
+    }
+    if (other != nullptr) {
+      for (const auto& child : other->children) {
+        if (node == nullptr || node->children.count(child.first) == 0) {
+          DifferencesIn(nullptr, child.second.get(), visit);
+        }
+      }
+    }
+  }
+
+  template <typename Visit>
+  static void ForEachIn(const Node& node, Visit& visit) {
+    if (node.value) {
+      visit(*node.value);
+    }
+    for (const auto& child : node.children) {
+      ForEachIn(*child.second, visit);
+    }
+  }
+
+  Node root_;
+  size_t size_ = 0;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_DOMAIN_TRIE_H_
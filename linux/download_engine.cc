@@ -0,0 +1,769 @@
+#include "download_engine.h"
+
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+// The journal is a StateHeader, the URL, the validator and then one
+// SegmentState per segment, all in host byte order: it never leaves the
+// machine that wrote it.
+constexpr uint32_t kStateMagic = 0x46434431;  // "FCD1"
+constexpr uint32_t kMaxSegments = 64;
+constexpr uint32_t kMaxStateString = 16 * 1024;
+constexpr size_t kHashReadSize = 256 * 1024;
+
+struct StateHeader {
+  uint32_t magic;
+  uint32_t segment_count;
+  uint32_t url_length;
+  uint32_t validator_length;
+  int64_t total;
+};
+
+struct SegmentState {
+  int64_t start;
+  int64_t end;
+  int64_t done;
+};
+
+bool IsRedirect(int status) {
+  return status == 301 || status == 302 || status == 303 || status == 307 ||
+         status == 308;
+}
+
+bool PwriteAll(int fd, const void* data, size_t size, int64_t offset) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = pwrite(fd, bytes, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+    offset += written;
+  }
+  return true;
+}
+
+bool PreadAll(int fd, void* data, size_t size, int64_t offset) {
+  char* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t read = pread(fd, bytes, size, offset);
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (read <= 0) {
+      return false;
+    }
+    bytes += read;
+    size -= static_cast<size_t>(read);
+    offset += read;
+  }
+  return true;
+}
+
+// Parses "bytes <first>-<last>/<total>". |total| is -1 when the server sent
+// "*".
+bool ParseContentRange(const std::string* value,
+                       int64_t* first,
+                       int64_t* total) {
+  if (value == nullptr || value->compare(0, 6, "bytes ") != 0) {
+    return false;
+  }
+  const char* cursor = value->c_str() + 6;
+  char* end = nullptr;
+  *first = std::strtoll(cursor, &end, 10);
+  if (end == cursor || *end != '-') {
+    return false;
+  }
+  const char* slash = std::strchr(end, '/');
+  if (slash == nullptr) {
+    return false;
+  }
+  if (slash[1] == '*') {
+    *total = -1;
+    return true;
+  }
+  *total = std::strtoll(slash + 1, &end, 10);
+  return end != slash + 1 && *total > *first;
+}
+
+// A strong ETag, or failing that Last-Modified: what If-Range accepts.
+std::string FindValidator(const HttpResponse& response) {
+  const std::string* etag = response.FindHeader("ETag");
+  if (etag != nullptr && etag->compare(0, 2, "W/") != 0) {
+    return *etag;
+  }
+  const std::string* last_modified = response.FindHeader("Last-Modified");
+  return last_modified != nullptr ? *last_modified : std::string();
+}
+
+}  // namespace
+
+struct Downloader::Segment {
+  int64_t start = 0;
+  // Exclusive; -1 while the length of the body is unknown.
+  int64_t end = -1;
+  // Bytes of the segment that are on disk.
+  std::atomic<int64_t> done{0};
+
+  bool complete() const { return end >= 0 && start + done >= end; }
+};
+
+// Buffers the body of one segment and writes it out a chunk at a time at the
+// segment's position in the file.
+class Downloader::SegmentWriter {
+ public:
+  SegmentWriter(Downloader* downloader, size_t index)
+      : downloader_(downloader),
+        index_(index),
+        segment_(downloader->segments_[index].get()) {
+    buffer_.reserve(downloader_->options_.chunk_size);
+  }
+
+  ~SegmentWriter() { Flush(); }
+
+  // Appends body bytes, dropping any beyond the end of the segment. Returns
+  // false once the segment is full, writing failed or the download was
+  // cancelled, which is when the response should no longer be read.
+  bool Append(const char* data, size_t size) {
+    if (segment_->end >= 0) {
+      int64_t room = segment_->end - segment_->start - segment_->done -
+                     static_cast<int64_t>(buffer_.size());
+      if (static_cast<int64_t>(size) > room) {
+        size = static_cast<size_t>(room);
+      }
+    }
+    size_t chunk_size = downloader_->options_.chunk_size;
+    while (size > 0) {
+      size_t count = chunk_size - buffer_.size();
+      if (count > size) {
+        count = size;
+      }
+      buffer_.append(data, count);
+      data += count;
+      size -= count;
+      if (buffer_.size() == chunk_size && !Flush()) {
+        return false;
+      }
+    }
+    return !full() && !downloader_->cancelled_;
+  }
+
+  // Writes out whatever is buffered and journals the progress.
+  bool Flush() {
+    if (buffer_.empty()) {
+      return true;
+    }
+    int64_t offset = segment_->start + segment_->done;
+    if (!PwriteAll(downloader_->fd_, buffer_.data(), buffer_.size(),
+                   offset)) {
+      downloader_->Fail(0, std::string("cannot write ") +
+                               downloader_->part_path_ + ": " +
+                               std::strerror(errno));
+      buffer_.clear();
+      return false;
+    }
+    segment_->done += static_cast<int64_t>(buffer_.size());
+    downloader_->SaveProgress(index_);
+    downloader_->AdvanceHash(buffer_.data(), offset, buffer_.size(), false);
+    downloader_->ReportProgress(false);
+    buffer_.clear();
+    return true;
+  }
+
+ private:
+  bool full() const {
+    return segment_->end >= 0 &&
+           segment_->start + segment_->done +
+                   static_cast<int64_t>(buffer_.size()) >=
+               segment_->end;
+  }
+
+  Downloader* downloader_;
+  size_t index_;
+  Segment* segment_;
+  std::string buffer_;
+};
+
+Downloader::Downloader(DownloadOptions options)
+    : options_(std::move(options)),
+      part_path_(options_.path + ".part"),
+      state_path_(part_path_ + ".state"),
+      url_(options_.url) {
+  if (options_.chunk_size == 0) {
+    options_.chunk_size = 256 * 1024;
+  }
+  if (options_.max_segments < 1) {
+    options_.max_segments = 1;
+  }
+  hash_ = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(hash_, EVP_sha256(), nullptr);
+}
+
+Downloader::~Downloader() {
+  for (std::thread& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  if (state_fd_ >= 0) {
+    close(state_fd_);
+  }
+  EVP_MD_CTX_free(hash_);
+}
+
+void Downloader::Cancel() {
+  cancelled_ = true;
+}
+
+void Downloader::Fail(int status, const std::string& error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_.empty()) {
+    error_ = error;
+    if (status != 0) {
+      status_ = status;
+    }
+  }
+}
+
+bool Downloader::failed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !error_.empty();
+}
+
+void Downloader::AdvanceHash(const char* data,
+                             int64_t offset,
+                             size_t size,
+                             bool wait) {
+  std::unique_lock<std::mutex> lock(hash_mutex_, std::defer_lock);
+  if (wait) {
+    lock.lock();
+  } else if (!lock.try_lock()) {
+    // The thread that holds it hashes on until it runs out of contiguous
+    // bytes, and Run catches up at the end.
+    return;
+  }
+  size_t index = 0;
+  while (index < segments_.size()) {
+    const Segment& segment = *segments_[index];
+    if (segment.end >= 0 && hashed_ >= segment.end) {
+      ++index;
+      continue;
+    }
+    int64_t available = segment.start + segment.done - hashed_;
+    if (available <= 0) {
+      return;
+    }
+    if (data != nullptr && hashed_ >= offset &&
+        hashed_ < offset + static_cast<int64_t>(size)) {
+      int64_t skip = hashed_ - offset;
+      int64_t count = static_cast<int64_t>(size) - skip;
+      if (count > available) {
+        count = available;
+      }
+      EVP_DigestUpdate(hash_, data + skip, static_cast<size_t>(count));
+      hashed_ += count;
+      continue;
+    }
+    // Written by another segment, or before a resume: read it back.
+    hash_buffer_.resize(kHashReadSize);
+    size_t count = available < static_cast<int64_t>(kHashReadSize)
+                       ? static_cast<size_t>(available)
+                       : kHashReadSize;
+    if (!PreadAll(fd_, &hash_buffer_[0], count, hashed_)) {
+      return;
+    }
+    EVP_DigestUpdate(hash_, hash_buffer_.data(), count);
+    hashed_ += static_cast<int64_t>(count);
+  }
+}
+
+void Downloader::ReportProgress(bool force) {
+  if (!options_.on_progress) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(progress_mutex_, std::defer_lock);
+  if (force) {
+    lock.lock();
+  } else if (!lock.try_lock()) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(now - reported_at_).count();
+  if (!force && seconds * 1000 < options_.progress_interval_ms) {
+    return;
+  }
+  DownloadProgress progress;
+  for (const auto& segment : segments_) {
+    progress.received += segment->done;
+  }
+  progress.total = total_;
+  progress.bytes_per_second =
+      seconds > 0 ? (progress.received - reported_bytes_) / seconds : 0;
+  reported_bytes_ = progress.received;
+  reported_at_ = now;
+  options_.on_progress(progress);
+}
+
+void Downloader::PlanSegments(int64_t total, int count) {
+  segments_.clear();
+  for (int i = 0; i < count; ++i) {
+    auto segment = std::make_unique<Segment>();
+    segment->start = total < 0 ? 0 : total * i / count;
+    segment->end = total < 0 ? -1 : total * (i + 1) / count;
+    segments_.push_back(std::move(segment));
+  }
+}
+
+bool Downloader::SaveState() {
+  StateHeader header = {};
+  header.magic = kStateMagic;
+  header.segment_count = static_cast<uint32_t>(segments_.size());
+  header.url_length = static_cast<uint32_t>(options_.url.size());
+  header.validator_length = static_cast<uint32_t>(validator_.size());
+  header.total = total_;
+  std::string state(reinterpret_cast<const char*>(&header), sizeof(header));
+  state += options_.url;
+  state += validator_;
+  for (const auto& segment : segments_) {
+    SegmentState entry = {segment->start, segment->end, segment->done};
+    state.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+  state_fd_ = open(state_path_.c_str(),
+                   O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (state_fd_ < 0 || !PwriteAll(state_fd_, state.data(), state.size(), 0)) {
+    // Without a journal the download still works, it just cannot resume.
+    if (state_fd_ >= 0) {
+      close(state_fd_);
+      state_fd_ = -1;
+    }
+    unlink(state_path_.c_str());
+    return false;
+  }
+  return true;
+}
+
+void Downloader::SaveProgress(size_t index) {
+  if (state_fd_ < 0) {
+    return;
+  }
+  int64_t done = segments_[index]->done;
+  int64_t offset = sizeof(StateHeader) + options_.url.size() +
+                   validator_.size() + index * sizeof(SegmentState) +
+                   offsetof(SegmentState, done);
+  PwriteAll(state_fd_, &done, sizeof(done), offset);
+}
+
+bool Downloader::LoadState() {
+  int fd = open(state_path_.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  StateHeader header;
+  bool valid = PreadAll(fd, &header, sizeof(header), 0) &&
+               header.magic == kStateMagic && header.segment_count >= 1 &&
+               header.segment_count <= kMaxSegments &&
+               header.url_length <= kMaxStateString &&
+               header.validator_length <= kMaxStateString &&
+               header.total >= 0;
+  std::string url(valid ? header.url_length : 0, '\0');
+  std::string validator(valid ? header.validator_length : 0, '\0');
+  std::vector<SegmentState> entries(valid ? header.segment_count : 0);
+  int64_t offset = sizeof(header);
+  valid = valid && PreadAll(fd, &url[0], url.size(), offset) &&
+          url == options_.url;
+  offset += url.size();
+  valid = valid && PreadAll(fd, &validator[0], validator.size(), offset);
+  offset += validator.size();
+  valid = valid && PreadAll(fd, entries.data(),
+                            entries.size() * sizeof(SegmentState), offset);
+  for (const SegmentState& entry : entries) {
+    valid = valid && entry.start >= 0 && entry.done >= 0 &&
+            entry.start + entry.done <= entry.end &&
+            entry.end <= header.total;
+  }
+  struct stat part;
+  valid = valid && stat(part_path_.c_str(), &part) == 0 &&
+          part.st_size == header.total;
+  if (valid) {
+    fd_ = open(part_path_.c_str(), O_RDWR | O_CLOEXEC);
+    valid = fd_ >= 0;
+  }
+  if (!valid) {
+    close(fd);
+    unlink(state_path_.c_str());
+    return false;
+  }
+  state_fd_ = fd;
+  total_ = header.total;
+  validator_ = std::move(validator);
+  ranges_ = true;
+  segments_.clear();
+  for (const SegmentState& entry : entries) {
+    auto segment = std::make_unique<Segment>();
+    segment->start = entry.start;
+    segment->end = entry.end;
+    segment->done = entry.done;
+    segments_.push_back(std::move(segment));
+  }
+  return true;
+}
+
+bool Downloader::Get(std::string* url,
+                     const std::vector<HttpHeader>& extra,
+                     CompressionPolicy* compression,
+                     HttpResponse* response,
+                     const HttpBodyCallback& on_body,
+                     std::string* error) {
+  for (int redirects = 0;; ++redirects) {
+    HttpRequest request;
+    request.url = *url;
+    request.headers = options_.headers;
+    request.headers.insert(request.headers.end(), extra.begin(), extra.end());
+    if (options_.jar != nullptr) {
+      std::string cookies = options_.jar->GetCookieHeader(*url);
+      if (!cookies.empty()) {
+        request.headers.push_back(HttpHeader{"Cookie", std::move(cookies)});
+      }
+    }
+    ConnectionPool* pool = options_.pool != nullptr
+                               ? options_.pool
+                               : ConnectionPool::Shared();
+    HttpOrigin origin;
+    CompressionPolicy* policy =
+        compression != nullptr && ParseHttpOrigin(*url, &origin) &&
+                compression->HasOptionsFor(origin.host)
+            ? compression
+            : nullptr;
+    bool ok = SendWithCompression(
+        pool, policy, request, options_.timeout_ms, response,
+        [&](const char* data, size_t size) {
+          // A redirect's body is of no interest.
+          return !IsRedirect(response->status) && !cancelled_ &&
+                 on_body(data, size);
+        },
+        error);
+    if (response->status != 0) {
+      status_ = response->status;
+    }
+    if (options_.jar != nullptr && response->status != 0) {
+      std::vector<std::string> set_cookies;
+      for (const HttpHeader& header : response->headers) {
+        if (EqualsIgnoreCase(header.name, "Set-Cookie")) {
+          set_cookies.push_back(header.value);
+        }
+      }
+      if (!set_cookies.empty()) {
+        options_.jar->SetCookies(*url, set_cookies);
+      }
+    }
+    if (!ok) {
+      return false;
+    }
+    const std::string* location = response->FindHeader("Location");
+    if (!IsRedirect(response->status) || location == nullptr) {
+      return true;
+    }
+    if (redirects == options_.max_redirects) {
+      *error = "too many redirects";
+      return false;
+    }
+    *url = ResolveUrl(*url, *location);
+  }
+}
+
+void Downloader::RunSegment(size_t index) {
+  Segment* segment = segments_[index].get();
+  std::string error;
+  int attempts = 0;
+  while (!segment->complete() && !cancelled_ && !restart_ && !failed()) {
+    if (attempts == options_.max_attempts) {
+      Fail(0, error.empty() ? "download interrupted" : error);
+      return;
+    }
+    if (attempts > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100 * attempts));
+    }
+    ++attempts;
+
+    int64_t offset = segment->start + segment->done;
+    std::vector<HttpHeader> extra;
+    extra.push_back(HttpHeader{"Range",
+                               "bytes=" + std::to_string(offset) + "-" +
+                                   std::to_string(segment->end - 1)});
+    if (!validator_.empty()) {
+      extra.push_back(HttpHeader{"If-Range", validator_});
+    }
+    std::string url = url_;
+    HttpResponse response;
+    bool accepted = false;
+    int64_t done_before = segment->done;
+    SegmentWriter writer(this, index);
+    bool ok = Get(
+        &url, extra, nullptr, &response,
+        [&](const char* data, size_t size) {
+          if (!accepted) {
+            int64_t first = 0;
+            int64_t total = 0;
+            if (response.status != 206 ||
+                !ParseContentRange(response.FindHeader("Content-Range"),
+                                   &first, &total) ||
+                first != offset || (total >= 0 && total != total_)) {
+              return false;
+            }
+            accepted = true;
+          }
+          return writer.Append(data, size);
+        },
+        &error);
+    writer.Flush();
+    if (segment->done > done_before) {
+      // Progress resets the budget: only failures in a row give up.
+      attempts = 0;
+    }
+    if (accepted || !ok || response.status >= 500) {
+      continue;
+    }
+    if (response.status == 200 || response.status == 206 ||
+        response.status == 416) {
+      // If-Range did not match, or the resource now has another length:
+      // what is on disk belongs to an older version.
+      restart_ = true;
+      return;
+    }
+    Fail(response.status, "HTTP " + std::to_string(response.status));
+    return;
+  }
+}
+
+bool Downloader::Start() {
+  {
+    std::lock_guard<std::mutex> lock(hash_mutex_);
+    hashed_ = 0;
+    EVP_DigestInit_ex(hash_, EVP_sha256(), nullptr);
+  }
+  unlink(state_path_.c_str());
+  fd_ = open(part_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+             0644);
+  if (fd_ < 0) {
+    Fail(0, std::string("cannot create ") + part_path_ + ": " +
+                std::strerror(errno));
+    return false;
+  }
+
+  // Asking for "bytes=0-" costs nothing when the server ignores it, and a
+  // 206 tells us both the length and that the rest can be fetched in
+  // parallel while this response streams.
+  HttpResponse response;
+  std::unique_ptr<SegmentWriter> writer;
+  bool decided = false;
+  auto accept = [&]() {
+    decided = true;
+    int64_t first = 0;
+    int64_t total = 0;
+    if (!response.decoded_from.empty() &&
+        (response.status == 200 || response.status == 206)) {
+      // The length and ranges are those of the encoded body.
+      ranges_ = false;
+      total_ = -1;
+    } else if (response.status == 206 &&
+               ParseContentRange(response.FindHeader("Content-Range"), &first,
+                                 &total) &&
+               first == 0 && total >= 0) {
+      ranges_ = true;
+      total_ = total;
+    } else if (response.status == 200) {
+      const std::string* accept_ranges = response.FindHeader("Accept-Ranges");
+      ranges_ = accept_ranges != nullptr &&
+                accept_ranges->find("bytes") != std::string::npos;
+      total_ = response.content_length;
+    } else {
+      Fail(response.status, "HTTP " + std::to_string(response.status));
+      return false;
+    }
+    validator_ = FindValidator(response);
+    int count = 1;
+    if (ranges_ && response.status == 206) {
+      int64_t fits = total_ / options_.min_segment_size;
+      count = fits < 1 ? 1
+                       : fits > options_.max_segments ? options_.max_segments
+                                                      : static_cast<int>(fits);
+    }
+    PlanSegments(total_, count);
+    if (total_ >= 0 && ftruncate(fd_, total_) != 0) {
+      Fail(0, std::string("cannot allocate ") + part_path_ + ": " +
+                  std::strerror(errno));
+      return false;
+    }
+    if (ranges_ && total_ >= 0 && !validator_.empty()) {
+      SaveState();
+    }
+    for (size_t i = 1; i < segments_.size(); ++i) {
+      workers_.emplace_back(&Downloader::RunSegment, this, i);
+    }
+    writer = std::make_unique<SegmentWriter>(this, 0);
+    return true;
+  };
+
+  std::string error;
+  bool ok = Get(
+      &url_, {HttpHeader{"Range", "bytes=0-"}}, options_.compression,
+      &response,
+      [&](const char* data, size_t size) {
+        if (!decided && !accept()) {
+          return false;
+        }
+        return writer->Append(data, size);
+      },
+      &error);
+  if (!decided) {
+    // Either nothing arrived or the body is empty.
+    if (!ok) {
+      Fail(0, error);
+      return false;
+    }
+    if (!accept()) {
+      return false;
+    }
+  }
+  if (writer == nullptr) {
+    return false;
+  }
+  writer->Flush();
+  writer.reset();
+
+  Segment* first = segments_[0].get();
+  if (first->end < 0) {
+    // No length to check against: the body is all there if it ended the
+    // way its framing said it would.
+    if (!ok || !response.complete) {
+      Fail(0, ok ? "download interrupted" : error);
+      return false;
+    }
+    first->end = first->done;
+    total_ = first->done;
+    return true;
+  }
+  if (!first->complete()) {
+    if (!ranges_) {
+      Fail(0, ok ? "download interrupted" : error);
+      return false;
+    }
+    RunSegment(0);
+  }
+  return true;
+}
+
+DownloadResult Downloader::Run() {
+  DownloadResult result;
+  reported_at_ = std::chrono::steady_clock::now();
+  result.resumed = LoadState();
+  if (result.resumed) {
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      workers_.emplace_back(&Downloader::RunSegment, this, i);
+    }
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    if (restart_) {
+      // The resource changed since the journal was written.
+      close(fd_);
+      fd_ = -1;
+      close(state_fd_);
+      state_fd_ = -1;
+      restart_ = false;
+      segments_.clear();
+      result.resumed = false;
+    }
+  }
+  if (!result.resumed && !failed() && !cancelled_) {
+    Start();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    if (restart_) {
+      Fail(0, "the resource changed during the download");
+    }
+  }
+  if (cancelled_) {
+    Fail(0, "cancelled");
+  }
+
+  bool complete = !failed() && !segments_.empty();
+  for (const auto& segment : segments_) {
+    complete = complete && segment->complete();
+  }
+  if (complete) {
+    AdvanceHash(nullptr, 0, 0, true);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (hashed_ == total_ && EVP_DigestFinal_ex(hash_, digest, &length)) {
+      static const char kHex[] = "0123456789abcdef";
+      for (unsigned int i = 0; i < length; ++i) {
+        result.sha256 += kHex[digest[i] >> 4];
+        result.sha256 += kHex[digest[i] & 0xf];
+      }
+    }
+  }
+  if (!segments_.empty()) {
+    ReportProgress(true);
+  }
+  if (complete && fdatasync(fd_) != 0) {
+    Fail(0, std::string("cannot write ") + part_path_ + ": " +
+                std::strerror(errno));
+    complete = false;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  bool journaled = state_fd_ >= 0;
+  if (state_fd_ >= 0) {
+    close(state_fd_);
+    state_fd_ = -1;
+  }
+  if (complete) {
+    if (rename(part_path_.c_str(), options_.path.c_str()) != 0) {
+      Fail(0, "cannot move the download to " + options_.path + ": " +
+                  std::strerror(errno));
+      complete = false;
+    } else {
+      unlink(state_path_.c_str());
+    }
+  } else if (!journaled || restart_) {
+    // Nothing to resume from.
+    unlink(part_path_.c_str());
+    unlink(state_path_.c_str());
+  }
+
+  result.ok = complete;
+  result.status = status_;
+  result.bytes = complete ? total_ : 0;
+  result.segments = static_cast<int>(segments_.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  result.error = error_;
+  return result;
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,204 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_DOWNLOAD_ENGINE_H_
+#define FLUTTER_COOKIE_BRIDGE_DOWNLOAD_ENGINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection_pool.h"
+#include "content_coding.h"
+#include "http_client.h"
+#include "shared_cookie_jar.h"
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+namespace flutter_cookie_bridge {
+
+struct DownloadProgress {
+  // Bytes of the file on disk so far.
+  int64_t received = 0;
+  // -1 while unknown.
+  int64_t total = -1;
+  // Over the time since the previous report.
+  double bytes_per_second = 0;
+};
+
+struct DownloadOptions {
+  std::string url;
+  // Where the finished file goes. Until then the body is written to
+  // |path| + ".part", and the progress needed to resume to
+  // |path| + ".part.state".
+  std::string path;
+  // Sent with every request, in addition to Range and Cookie.
+  std::vector<HttpHeader> headers;
+  // Supplies the Cookie header of every request, including redirects, and
+  // receives the cookies of every response. May be null.
+  SharedCookieJar* jar = nullptr;
+  // Carries every request; null means ConnectionPool::Shared().
+  ConnectionPool* pool = nullptr;
+  // Negotiates the content coding of the first request with the hosts it
+  // has options of its own for, and the response is then decoded on the
+  // way to disk. A decoded body is fetched in one piece, as ranges of it
+  // cannot be requested, so other hosts, and every host when this is null,
+  // are asked for no coding.
+  CompressionPolicy* compression = nullptr;
+  // Bytes buffered per segment before they are written out.
+  size_t chunk_size = 256 * 1024;
+  // Upper bound on parallel ranged requests for one file.
+  int max_segments = 4;
+  // Files are only split when every segment gets at least this much.
+  int64_t min_segment_size = 8 * 1024 * 1024;
+  // Requests made for a segment before the download fails.
+  int max_attempts = 3;
+  int timeout_ms = 30000;
+  int max_redirects = 5;
+  // Receives the progress at most once every |progress_interval_ms|, and a
+  // last time when the download ends. Called on the download's threads, one
+  // call at a time.
+  std::function<void(const DownloadProgress&)> on_progress;
+  int progress_interval_ms = 100;
+};
+
+struct DownloadResult {
+  bool ok = false;
+  // The status of the last response, 0 when none arrived.
+  int status = 0;
+  // The size of the finished file.
+  int64_t bytes = 0;
+  // How many ranged segments the body was fetched in.
+  int segments = 0;
+  // Whether an earlier interrupted download of the same file was continued.
+  bool resumed = false;
+  // Lower-case hex SHA-256 of the finished file.
+  std::string sha256;
+  std::string error;
+};
+
+// Streams one HTTP(S) resource to a file.
+//
+// The body goes to disk in |chunk_size| pieces, so memory use does not grow
+// with the file. When the server honours Range requests and the file is
+// large enough, the rest of the file is fetched in parallel segments while
+// the first response streams. Progress is journaled per chunk; a download
+// that is interrupted, by a dropped connection or by the process going
+// away, continues from where each segment stopped, guarded by If-Range so a
+// changed resource starts over.
+//
+// The SHA-256 of the file is computed as it is written: bytes are hashed as
+// soon as they extend the contiguous prefix on disk, straight from the write
+// buffer when they are next in line and otherwise read back while still in
+// the page cache, so there is no second pass over the finished file.
+class Downloader {
+ public:
+  explicit Downloader(DownloadOptions options);
+  ~Downloader();
+
+  Downloader(const Downloader&) = delete;
+  Downloader& operator=(const Downloader&) = delete;
+
+  // Performs the download on the calling thread.
+  DownloadResult Run();
+
+  // Makes Run give up as soon as possible, keeping what was downloaded so a
+  // later Run can resume. May be called from any thread.
+  void Cancel();
+
+ private:
+  struct Segment;
+  class SegmentWriter;
+
+  // Loads the journal of an interrupted download. Returns false when there
+  // is none or it does not match the partial file.
+  bool LoadState();
+
+  // Writes the journal for the current segments.
+  bool SaveState();
+
+  // Records the progress of segment |index| in the journal.
+  void SaveProgress(size_t index);
+
+  // Splits [0, total) into segments.
+  void PlanSegments(int64_t total, int count);
+
+  // Performs a GET of |url| with the configured and |extra| headers,
+  // following redirects, through SendWithCompression with |compression|
+  // for the hosts it has options of their own for.
+  // |on_body| receives the body of the final response, whose head is left
+  // in |response|. |url| is updated to the final URL.
+  bool Get(std::string* url,
+           const std::vector<HttpHeader>& extra,
+           CompressionPolicy* compression,
+           HttpResponse* response,
+           const HttpBodyCallback& on_body,
+           std::string* error);
+
+  // Downloads what is missing of segment |index| with ranged requests.
+  void RunSegment(size_t index);
+
+  // The first request of a fresh download, which also decides whether to
+  // split the file.
+  bool Start();
+
+  // Hashes what is on disk past the hashed prefix, as far as it is
+  // contiguous. |data| holds |size| bytes that were just written at
+  // |offset|, which are hashed from memory if they are next. Unless |wait|
+  // is set, returns at once when another thread is hashing.
+  void AdvanceHash(const char* data, int64_t offset, size_t size, bool wait);
+
+  // Reports progress if |progress_interval_ms| passed since the last
+  // report, or regardless when |force| is set.
+  void ReportProgress(bool force);
+
+  // Records |error| as the reason the download failed, unless there
+  // already is one.
+  void Fail(int status, const std::string& error);
+
+  bool failed() const;
+
+  DownloadOptions options_;
+  std::string part_path_;
+  std::string state_path_;
+  int fd_ = -1;
+  int state_fd_ = -1;
+  std::atomic<bool> cancelled_{false};
+  // Set when a resumed segment finds that the resource changed.
+  std::atomic<bool> restart_{false};
+
+  // The URL after redirects, used for every segment request.
+  std::string url_;
+  // ETag or Last-Modified of the resource, sent as If-Range.
+  std::string validator_;
+  // -1 until known.
+  int64_t total_ = -1;
+  bool ranges_ = false;
+  std::vector<std::unique_ptr<Segment>> segments_;
+  std::vector<std::thread> workers_;
+  // The status of the last response.
+  std::atomic<int> status_{0};
+
+  // Guards the hash state; the prefix of the file below |hashed_| is in
+  // |hash_|.
+  std::mutex hash_mutex_;
+  EVP_MD_CTX* hash_ = nullptr;
+  int64_t hashed_ = 0;
+  std::string hash_buffer_;
+
+  // Guards the progress reporting state.
+  std::mutex progress_mutex_;
+  int64_t reported_bytes_ = 0;
+  std::chrono::steady_clock::time_point reported_at_;
+
+  mutable std::mutex mutex_;
+  std::string error_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_DOWNLOAD_ENGINE_H_
@@ -0,0 +1,167 @@
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_ffi.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "set_cookie_parser.h"
+#include "shared_cookie_jar.h"
+#include "trace.h"
+#include "url_pattern_set.h"
+
+using flutter_cookie_bridge::ParsedSetCookie;
+using flutter_cookie_bridge::Tracer;
+using flutter_cookie_bridge::UrlPatternSet;
+
+namespace {
+
+FlutterCookieBridgeSpan ToSpan(std::string_view base, std::string_view part) {
+  if (part.empty()) {
+    return FlutterCookieBridgeSpan{0, 0};
+  }
+  return FlutterCookieBridgeSpan{
+      static_cast<uint32_t>(part.data() - base.data()),
+      static_cast<uint32_t>(part.size())};
+}
+
+}  // namespace
+
+int32_t flutter_cookie_bridge_parse_set_cookies(
+    const char* data,
+    const uint32_t* lengths,
+    int32_t count,
+    FlutterCookieBridgeSetCookie* out) {
+  int32_t parsed_count = 0;
+  size_t offset = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    std::string_view header(data + offset, lengths[i]);
+    offset += lengths[i];
+
+    ParsedSetCookie parsed;
+    FlutterCookieBridgeSetCookie* result = &out[i];
+    if (!flutter_cookie_bridge::ParseSetCookie(header, &parsed)) {
+      *result = FlutterCookieBridgeSetCookie{};
+      result->expires = flutter_cookie_bridge::kNoExpiry;
+      continue;
+    }
+    result->name = ToSpan(header, parsed.name);
+    result->value = ToSpan(header, parsed.value);
+    result->domain = ToSpan(header, parsed.domain);
+    result->path = ToSpan(header, parsed.path);
+    result->expires = parsed.expires;
+    result->max_age = parsed.max_age;
+    result->flags = parsed.flags;
+    result->same_site = static_cast<uint32_t>(parsed.same_site);
+    ++parsed_count;
+  }
+  return parsed_count;
+}
+
+int32_t flutter_cookie_bridge_parse_cookie_header(const char* data,
+                                                  uint32_t length,
+                                                  FlutterCookieBridgeSpan* out,
+                                                  int32_t capacity) {
+  std::string_view header(data, length);
+  int32_t count = 0;
+  flutter_cookie_bridge::ParseCookieHeader(
+      header, [&](std::string_view name, std::string_view value) {
+        if (count < capacity) {
+          out[count * 2] = ToSpan(header, name);
+          out[count * 2 + 1] = ToSpan(header, value);
+        }
+        ++count;
+      });
+  return count;
+}
+
+int32_t flutter_cookie_bridge_jar_set_cookies(const char* url,
+                                              uint32_t url_length,
+                                              const char* data,
+                                              const uint32_t* lengths,
+                                              int32_t count) {
+  std::vector<std::string> headers;
+  headers.reserve(count > 0 ? count : 0);
+  size_t offset = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    headers.emplace_back(data + offset, lengths[i]);
+    offset += lengths[i];
+  }
+  size_t changed = flutter_cookie_bridge::SharedCookieJar::Get()->SetCookies(
+      std::string_view(url, url_length), headers);
+  return static_cast<int32_t>(changed);
+}
+
+int32_t flutter_cookie_bridge_jar_get_cookie_header(const char* url,
+                                                    uint32_t url_length,
+                                                    char* out,
+                                                    int32_t capacity) {
+  std::string header =
+      flutter_cookie_bridge::SharedCookieJar::Get()->GetCookieHeader(
+          std::string_view(url, url_length));
+  if (capacity > 0) {
+    std::memcpy(out, header.data(),
+                std::min(header.size(), static_cast<size_t>(capacity)));
+  }
+  return static_cast<int32_t>(header.size());
+}
+
+void flutter_cookie_bridge_jar_stats(uint64_t* expired, uint64_t* evicted) {
+  flutter_cookie_bridge::CookieJarStats stats =
+      flutter_cookie_bridge::SharedCookieJar::Get()->stats();
+  *expired = stats.expired;
+  *evicted = stats.evicted;
+}
+
+void* flutter_cookie_bridge_patterns_create(const char* data,
+                                            const uint32_t* lengths,
+                                            const uint32_t* tags,
+                                            int32_t count) {
+  std::vector<UrlPatternSet::Pattern> patterns;
+  patterns.reserve(count > 0 ? count : 0);
+  size_t offset = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    patterns.emplace_back(std::string(data + offset, lengths[i]), tags[i]);
+    offset += lengths[i];
+  }
+  return new UrlPatternSet(patterns);
+}
+
+uint32_t flutter_cookie_bridge_patterns_match(const void* patterns,
+                                              const char* url,
+                                              uint32_t url_length) {
+  return static_cast<const UrlPatternSet*>(patterns)->Match(
+      std::string_view(url, url_length));
+}
+
+void flutter_cookie_bridge_patterns_free(void* patterns) {
+  delete static_cast<UrlPatternSet*>(patterns);
+}
+
+void flutter_cookie_bridge_trace_set_enabled(int32_t enabled) {
+  Tracer::Get()->SetEnabled(enabled != 0);
+}
+
+int32_t flutter_cookie_bridge_trace_enabled() {
+  return Tracer::Get()->enabled() ? 1 : 0;
+}
+
+int64_t flutter_cookie_bridge_trace_now() {
+  return Tracer::NowMicros();
+}
+
+void flutter_cookie_bridge_trace_record(const char* name,
+                                        int64_t start_us,
+                                        int64_t end_us) {
+  Tracer::Get()->Record(name, start_us, end_us);
+}
+
+int32_t flutter_cookie_bridge_trace_export(char* out, int32_t capacity) {
+  std::string json = Tracer::Get()->ExportJson();
+  if (capacity > 0) {
+    std::memcpy(out, json.data(),
+                std::min(json.size(), static_cast<size_t>(capacity)));
+  }
+  return static_cast<int32_t>(json.size());
+}
@@ -0,0 +1,1233 @@
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_plugin.h"
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+#include <sys/utsname.h>
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flutter_cookie_bridge_plugin_private.h"
+
+#define FLUTTER_COOKIE_BRIDGE_PLUGIN(obj)                                     \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), flutter_cookie_bridge_plugin_get_type(), \
+                              FlutterCookieBridgePlugin))
+
+struct _FlutterCookieBridgePlugin {
+  GObject parent_instance;
+
+  // The process-wide cookie jar, shared with FFI callers on other isolates.
+  flutter_cookie_bridge::SharedCookieJar* jar;
+
+  // Tracks what changed in |jar| for the cookie change event channel. The
+  // cookie store loader attaches it, and only then sets |feed_attached|, so
+  // the main thread never waits for the load; it is only accessed
+  // atomically.
+  flutter_cookie_bridge::CookieChangeFeed* feed;
+  gint feed_attached;
+
+  // The cookie change event channel, and whether Dart is listening to it.
+  FlEventChannel* changes_channel;
+  bool listening;
+
+  // The jar version the last event brought the listener up to, or, while
+  // |listen_from_now| is set, to be taken from the jar by the next event.
+  uint64_t sent_version;
+  bool listen_from_now;
+
+  // Set while an idle callback to send changes is pending. Jar writers on
+  // other threads schedule it, so it is only accessed atomically.
+  gint send_pending;
+
+  // The download progress event channel, and whether Dart is listening.
+  FlEventChannel* downloads_channel;
+  bool downloads_listening;
+
+  // Periodically closes pooled connections that sat idle too long.
+  guint reap_source;
+};
+
+G_DEFINE_TYPE(FlutterCookieBridgePlugin,
+              flutter_cookie_bridge_plugin,
+              g_object_get_type())
+
+// Returns the string stored under |key| in the |args| map, or nullptr.
+static const gchar* lookup_string(FlValue* args, const gchar* key) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return nullptr;
+  }
+  return fl_value_get_string(value);
+}
+
+static FlMethodResponse* bad_arguments(const gchar* message) {
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new("BAD_ARGUMENTS", message, nullptr));
+}
+
+static void start_download(FlutterCookieBridgePlugin* self,
+                           FlMethodCall* method_call);
+static void start_http_request(FlutterCookieBridgePlugin* self,
+                               FlMethodCall* method_call);
+static FlMethodResponse* configure_http_cache(FlValue* args);
+static FlMethodResponse* get_http_cache_stats();
+static FlMethodResponse* clear_http_cache();
+static FlMethodResponse* configure_compression(FlValue* args);
+static FlMethodResponse* get_compression_stats(FlValue* args);
+
+using MethodHandler = std::function<FlMethodResponse*(FlValue* args)>;
+
+// A method call being handled on a worker.
+struct MethodTask {
+  FlMethodCall* method_call;
+  FlValue* args;
+  MethodHandler handler;
+  FlMethodResponse* response;
+};
+
+static gboolean method_task_done_cb(gpointer user_data) {
+  MethodTask* task = static_cast<MethodTask*>(user_data);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(task->method_call, task->response, &error)) {
+    g_warning("Failed to send method response: %s", error->message);
+  }
+  g_object_unref(task->response);
+  g_object_unref(task->method_call);
+  delete task;
+  return G_SOURCE_REMOVE;
+}
+
+// Method calls that touch the cookie jar or the HTTP cache may block on the
+// disk, so they run on a worker rather than the main loop that produces
+// frames. They run one after another in the order they arrived, so a
+// getCookieHeader sent after a setCookies sees its cookies.
+static void respond_from_worker(FlMethodCall* method_call,
+                                MethodHandler handler) {
+  static auto* sequence = new flutter_cookie_bridge::TaskSequence(
+      flutter_cookie_bridge::WorkerPool::Shared());
+  FlValue* args = fl_method_call_get_args(method_call);
+  MethodTask* task = new MethodTask{
+      FL_METHOD_CALL(g_object_ref(method_call)),
+      args != nullptr ? fl_value_ref(args) : nullptr, std::move(handler),
+      nullptr};
+  sequence->Post([task] {
+    task->response = task->handler(task->args);
+    if (task->args != nullptr) {
+      fl_value_unref(task->args);
+    }
+    g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT,
+                               method_task_done_cb, task, nullptr);
+  });
+}
+
+// Called when a method call is received from Flutter.
+static void flutter_cookie_bridge_plugin_handle_method_call(
+    FlutterCookieBridgePlugin* self,
+    FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+
+  if (strcmp(method, "download") == 0) {
+    // Responds from the main loop once the file is complete.
+    start_download(self, method_call);
+    return;
+  }
+  if (strcmp(method, "httpRequest") == 0) {
+    start_http_request(self, method_call);
+    return;
+  }
+
+  // The jar is process-wide, so it outlives the plugin and any handler
+  // still queued.
+  flutter_cookie_bridge::SharedCookieJar* jar = self->jar;
+  MethodHandler handler;
+  if (strcmp(method, "setCookies") == 0) {
+    handler = [jar](FlValue* args) { return set_cookies(jar, args); };
+  } else if (strcmp(method, "syncCookies") == 0) {
+    handler = [jar](FlValue* args) { return sync_cookies(jar, args); };
+  } else if (strcmp(method, "getCookieHeader") == 0) {
+    handler = [jar](FlValue* args) { return get_cookie_header(jar, args); };
+  } else if (strcmp(method, "getCookies") == 0) {
+    handler = [jar](FlValue* args) { return get_cookies(jar); };
+  } else if (strcmp(method, "clear") == 0) {
+    handler = [jar](FlValue* args) { return clear_cookies(jar); };
+  } else if (strcmp(method, "switchCookiePartition") == 0) {
+    handler = [jar](FlValue* args) {
+      return switch_cookie_partition(jar, args);
+    };
+  } else if (strcmp(method, "deleteCookiePartition") == 0) {
+    handler = [jar](FlValue* args) {
+      return delete_cookie_partition(jar, args);
+    };
+  } else if (strcmp(method, "configureHttpCache") == 0) {
+    handler = configure_http_cache;
+  } else if (strcmp(method, "httpCacheStats") == 0) {
+    handler = [](FlValue* args) { return get_http_cache_stats(); };
+  } else if (strcmp(method, "clearHttpCache") == 0) {
+    handler = [](FlValue* args) { return clear_http_cache(); };
+  } else if (strcmp(method, "configureCompression") == 0) {
+    handler = configure_compression;
+  } else if (strcmp(method, "compressionStats") == 0) {
+    handler = get_compression_stats;
+  }
+  if (handler) {
+    respond_from_worker(method_call, std::move(handler));
+    return;
+  }
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "getPlatformVersion") == 0) {
+    response = get_platform_version();
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  fl_method_call_respond(method_call, response, nullptr);
+}
+
+FlMethodResponse* get_platform_version() {
+  struct utsname uname_data = {};
+  uname(&uname_data);
+  g_autofree gchar* version = g_strdup_printf("Linux %s", uname_data.version);
+  g_autoptr(FlValue) result = fl_value_new_string(version);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* set_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args) {
+  const gchar* url = lookup_string(args, "url");
+  FlValue* cookies = url == nullptr ? nullptr
+                                    : fl_value_lookup_string(args, "cookies");
+  if (cookies == nullptr || fl_value_get_type(cookies) != FL_VALUE_TYPE_LIST) {
+    return bad_arguments("Expected a url string and a cookies list");
+  }
+
+  std::vector<std::string> headers;
+  size_t length = fl_value_get_length(cookies);
+  headers.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    FlValue* cookie = fl_value_get_list_value(cookies, i);
+    if (fl_value_get_type(cookie) == FL_VALUE_TYPE_STRING) {
+      headers.emplace_back(fl_value_get_string(cookie));
+    }
+  }
+  g_autoptr(FlValue) result =
+      fl_value_new_int(static_cast<int64_t>(jar->SetCookies(url, headers)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* sync_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args) {
+  const gchar* url = lookup_string(args, "url");
+  FlValue* cookies = url == nullptr ? nullptr
+                                    : fl_value_lookup_string(args, "cookies");
+  if (cookies == nullptr || fl_value_get_type(cookies) != FL_VALUE_TYPE_MAP) {
+    return bad_arguments("Expected a url string and a cookies map");
+  }
+
+  std::vector<std::pair<std::string, std::string>> pairs;
+  size_t length = fl_value_get_length(cookies);
+  pairs.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    FlValue* name = fl_value_get_map_key(cookies, i);
+    FlValue* value = fl_value_get_map_value(cookies, i);
+    if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+        fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      pairs.emplace_back(fl_value_get_string(name), fl_value_get_string(value));
+    }
+  }
+  g_autoptr(FlValue) result =
+      fl_value_new_int(static_cast<int64_t>(jar->SyncCookies(url, pairs)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* get_cookie_header(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args) {
+  const gchar* url = lookup_string(args, "url");
+  if (url == nullptr) {
+    return bad_arguments("Expected a url string");
+  }
+
+  std::string header = jar->GetCookieHeader(url);
+  g_autoptr(FlValue) result = header.empty()
+                                  ? fl_value_new_null()
+                                  : fl_value_new_string(header.c_str());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* get_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar) {
+  g_autoptr(FlValue) result = fl_value_new_list();
+  std::string pair;
+  // The jar drops expired cookies lazily, so some may still be stored.
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  jar->Locked([&](flutter_cookie_bridge::CookieJar* cookies) {
+    cookies->ForEach([&](const flutter_cookie_bridge::Cookie& cookie) {
+      if (cookie.expires != flutter_cookie_bridge::kNoExpiry &&
+          cookie.expires <= now) {
+        return;
+      }
+      pair.assign(cookie.name);
+      pair += '=';
+      pair.append(cookie.value);
+      fl_value_append_take(result, fl_value_new_string(pair.c_str()));
+    });
+  });
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* clear_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar) {
+  jar->Clear();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* switch_cookie_partition(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args) {
+  const gchar* name = lookup_string(args, "name");
+  if (name == nullptr) {
+    return bad_arguments("Expected a name string");
+  }
+  const gchar* from = lookup_string(args, "from");
+  if (from != nullptr) {
+    // Fails when |name| already exists, which then keeps its cookies.
+    jar->ForkPartition(name, from);
+  }
+  jar->SwitchPartition(name);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* delete_cookie_partition(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args) {
+  const gchar* name = lookup_string(args, "name");
+  if (name == nullptr) {
+    return bad_arguments("Expected a name string");
+  }
+  g_autoptr(FlValue) result = fl_value_new_bool(jar->DropPartition(name));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlValue* encode_cookie_delta(const flutter_cookie_bridge::CookieDelta& delta) {
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(
+      result, "version", fl_value_new_int(static_cast<int64_t>(delta.version)));
+  fl_value_set_string_take(result, "reset", fl_value_new_bool(delta.reset));
+  FlValue* changes = fl_value_new_list();
+  for (const flutter_cookie_bridge::CookieChange& change : delta.changes) {
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "name",
+                             fl_value_new_string(change.name.c_str()));
+    fl_value_set_string_take(entry, "value",
+                             fl_value_new_string(change.value.c_str()));
+    fl_value_set_string_take(entry, "domain",
+                             fl_value_new_string(change.domain.c_str()));
+    fl_value_set_string_take(entry, "path",
+                             fl_value_new_string(change.path.c_str()));
+    fl_value_set_string_take(entry, "removed",
+                             fl_value_new_bool(change.removed));
+    fl_value_append_take(changes, entry);
+  }
+  fl_value_set_string_take(result, "changes", changes);
+  return result;
+}
+
+bool download_options_from_args(
+    FlValue* args,
+    flutter_cookie_bridge::DownloadOptions* options) {
+  const gchar* url = lookup_string(args, "url");
+  const gchar* path = lookup_string(args, "path");
+  if (url == nullptr || path == nullptr) {
+    return false;
+  }
+  options->url = url;
+  options->path = path;
+  FlValue* headers = fl_value_lookup_string(args, "headers");
+  if (headers != nullptr && fl_value_get_type(headers) == FL_VALUE_TYPE_MAP) {
+    for (size_t i = 0; i < fl_value_get_length(headers); ++i) {
+      FlValue* name = fl_value_get_map_key(headers, i);
+      FlValue* value = fl_value_get_map_value(headers, i);
+      if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+          fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+        options->headers.push_back(flutter_cookie_bridge::HttpHeader{
+            fl_value_get_string(name), fl_value_get_string(value)});
+      }
+    }
+  }
+  FlValue* segments = fl_value_lookup_string(args, "segments");
+  if (segments != nullptr && fl_value_get_type(segments) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(segments) > 0) {
+    options->max_segments = static_cast<int>(fl_value_get_int(segments));
+  }
+  FlValue* interval = fl_value_lookup_string(args, "progressIntervalMs");
+  if (interval != nullptr && fl_value_get_type(interval) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(interval) >= 0) {
+    options->progress_interval_ms =
+        static_cast<int>(fl_value_get_int(interval));
+  }
+  return true;
+}
+
+FlMethodResponse* download_response(
+    const flutter_cookie_bridge::DownloadOptions& options,
+    const flutter_cookie_bridge::DownloadResult& result) {
+  if (!result.ok) {
+    g_autoptr(FlValue) details = fl_value_new_map();
+    fl_value_set_string_take(details, "status",
+                             fl_value_new_int(result.status));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "DOWNLOAD_FAILED", result.error.c_str(), details));
+  }
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "path",
+                           fl_value_new_string(options.path.c_str()));
+  fl_value_set_string_take(value, "bytes", fl_value_new_int(result.bytes));
+  fl_value_set_string_take(value, "segments",
+                           fl_value_new_int(result.segments));
+  fl_value_set_string_take(value, "resumed",
+                           fl_value_new_bool(result.resumed));
+  fl_value_set_string_take(value, "sha256",
+                           fl_value_new_string(result.sha256.c_str()));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+}
+
+FlValue* encode_download_event(
+    const gchar* id,
+    const flutter_cookie_bridge::DownloadProgress& progress,
+    const flutter_cookie_bridge::DownloadOptions& options,
+    const flutter_cookie_bridge::DownloadResult* result) {
+  FlValue* event = fl_value_new_map();
+  fl_value_set_string_take(event, "id", fl_value_new_string(id));
+  fl_value_set_string_take(event, "received",
+                           fl_value_new_int(progress.received));
+  fl_value_set_string_take(event, "total", fl_value_new_int(progress.total));
+  fl_value_set_string_take(event, "bytesPerSecond",
+                           fl_value_new_float(progress.bytes_per_second));
+  fl_value_set_string_take(event, "done", fl_value_new_bool(result != nullptr));
+  if (result == nullptr) {
+    return event;
+  }
+  if (result->ok) {
+    fl_value_set_string_take(event, "path",
+                             fl_value_new_string(options.path.c_str()));
+    fl_value_set_string_take(event, "sha256",
+                             fl_value_new_string(result->sha256.c_str()));
+  } else {
+    fl_value_set_string_take(event, "error",
+                             fl_value_new_string(result->error.c_str()));
+    fl_value_set_string_take(event, "status",
+                             fl_value_new_int(result->status));
+  }
+  return event;
+}
+
+// A download running on a download worker.
+struct DownloadTask {
+  FlutterCookieBridgePlugin* plugin;
+  FlMethodCall* method_call;
+  std::string id;
+  flutter_cookie_bridge::DownloadOptions options;
+  flutter_cookie_bridge::DownloadProgress progress;
+  flutter_cookie_bridge::DownloadResult result;
+};
+
+// A progress report on its way from a download worker to the main loop.
+struct DownloadProgressEvent {
+  DownloadTask* task;
+  flutter_cookie_bridge::DownloadProgress progress;
+};
+
+// Sends the latest progress of |task|, and |result| once it is done.
+static void send_download_event(
+    DownloadTask* task,
+    const flutter_cookie_bridge::DownloadResult* result) {
+  FlutterCookieBridgePlugin* self = task->plugin;
+  if (!self->downloads_listening || self->downloads_channel == nullptr) {
+    return;
+  }
+  g_autoptr(FlValue) event = encode_download_event(
+      task->id.c_str(), task->progress, task->options, result);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(self->downloads_channel, event, nullptr,
+                             &error)) {
+    g_warning("Failed to send download progress: %s", error->message);
+  }
+}
+
+static gboolean download_progress_cb(gpointer user_data) {
+  DownloadProgressEvent* event = static_cast<DownloadProgressEvent*>(user_data);
+  // Reports of one download are queued in order, and the completion is
+  // queued after all of them, so the task is still alive.
+  event->task->progress = event->progress;
+  send_download_event(event->task, nullptr);
+  delete event;
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean download_done_cb(gpointer user_data) {
+  DownloadTask* task = static_cast<DownloadTask*>(user_data);
+  send_download_event(task, &task->result);
+  g_autoptr(FlMethodResponse) response =
+      download_response(task->options, task->result);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(task->method_call, response, &error)) {
+    g_warning("Failed to send download result: %s", error->message);
+  }
+  g_object_unref(task->method_call);
+  g_object_unref(task->plugin);
+  delete task;
+  return G_SOURCE_REMOVE;
+}
+
+// Downloads and API requests block on the network for as long as they take,
+// so they run on pools of their own rather than on the workers method calls
+// share, which would leave cookie calls waiting behind a slow server. Each
+// pool bounds the threads in flight; calls past that wait for a free worker.
+static flutter_cookie_bridge::WorkerPool* download_workers() {
+  // Each download fetches up to DownloadOptions::max_segments at once.
+  static auto* pool = new flutter_cookie_bridge::WorkerPool(4);
+  return pool;
+}
+
+static flutter_cookie_bridge::WorkerPool* request_workers() {
+  static auto* pool = new flutter_cookie_bridge::WorkerPool(8);
+  return pool;
+}
+
+// Downloads are long and blocking, so each runs on a download worker and
+// reports through the main loop. The engine already spaces the progress
+// reports, so each one becomes an event as is.
+static void start_download(FlutterCookieBridgePlugin* self,
+                           FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  DownloadTask* task = new DownloadTask();
+  if (!download_options_from_args(args, &task->options)) {
+    delete task;
+    g_autoptr(FlMethodResponse) response =
+        bad_arguments("Expected a url and a path");
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+  const gchar* id = lookup_string(args, "id");
+  task->id = id != nullptr ? id : task->options.path;
+  task->plugin = FLUTTER_COOKIE_BRIDGE_PLUGIN(g_object_ref(self));
+  task->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+  task->options.jar = self->jar;
+  // Only hosts configured with options of their own negotiate a coding;
+  // files from the others can still be fetched in parallel segments.
+  task->options.compression =
+      flutter_cookie_bridge::CompressionPolicy::Shared();
+  task->options.on_progress =
+      [task](const flutter_cookie_bridge::DownloadProgress& progress) {
+        g_idle_add_full(G_PRIORITY_DEFAULT, download_progress_cb,
+                        new DownloadProgressEvent{task, progress}, nullptr);
+      };
+  download_workers()->Post([task] {
+    task->result = flutter_cookie_bridge::Downloader(task->options).Run();
+    g_idle_add_full(G_PRIORITY_DEFAULT, download_done_cb, task, nullptr);
+  });
+}
+
+bool http_request_from_args(FlValue* args,
+                            flutter_cookie_bridge::HttpRequest* request,
+                            int* timeout_ms,
+                            bool* use_cache,
+                            bool* json) {
+  const gchar* method = lookup_string(args, "method");
+  const gchar* url = lookup_string(args, "url");
+  if (method == nullptr || url == nullptr) {
+    return false;
+  }
+  request->method = method;
+  request->url = url;
+  FlValue* headers = fl_value_lookup_string(args, "headers");
+  if (headers != nullptr && fl_value_get_type(headers) == FL_VALUE_TYPE_MAP) {
+    for (size_t i = 0; i < fl_value_get_length(headers); ++i) {
+      FlValue* name = fl_value_get_map_key(headers, i);
+      FlValue* value = fl_value_get_map_value(headers, i);
+      if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+          fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+        request->headers.push_back(flutter_cookie_bridge::HttpHeader{
+            fl_value_get_string(name), fl_value_get_string(value)});
+      }
+    }
+  }
+  FlValue* body = fl_value_lookup_string(args, "body");
+  if (body != nullptr && fl_value_get_type(body) == FL_VALUE_TYPE_UINT8_LIST) {
+    request->body.assign(
+        reinterpret_cast<const char*>(fl_value_get_uint8_list(body)),
+        fl_value_get_length(body));
+  }
+  FlValue* timeout = fl_value_lookup_string(args, "timeoutMs");
+  if (timeout != nullptr && fl_value_get_type(timeout) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(timeout) > 0) {
+    *timeout_ms = static_cast<int>(fl_value_get_int(timeout));
+  }
+  FlValue* cache = fl_value_lookup_string(args, "cache");
+  *use_cache = cache != nullptr &&
+               fl_value_get_type(cache) == FL_VALUE_TYPE_BOOL &&
+               fl_value_get_bool(cache);
+  FlValue* json_value = fl_value_lookup_string(args, "json");
+  *json = json_value != nullptr &&
+          fl_value_get_type(json_value) == FL_VALUE_TYPE_BOOL &&
+          fl_value_get_bool(json_value);
+  return true;
+}
+
+FlMethodResponse* http_response(
+    bool ok,
+    const flutter_cookie_bridge::HttpResponse& response,
+    const std::string& body,
+    const flutter_cookie_bridge::JsonDocument* document,
+    flutter_cookie_bridge::CacheOutcome outcome,
+    const std::string& error) {
+  if (!ok) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new("HTTP_FAILED", error.c_str(), nullptr));
+  }
+  g_autoptr(FlValue) headers = fl_value_new_map();
+  for (const flutter_cookie_bridge::HttpHeader& header : response.headers) {
+    std::string name = header.name;
+    for (char& c : name) {
+      c = g_ascii_tolower(c);
+    }
+    FlValue* values = fl_value_lookup_string(headers, name.c_str());
+    if (values == nullptr) {
+      fl_value_set_string_take(headers, name.c_str(), fl_value_new_list());
+      values = fl_value_lookup_string(headers, name.c_str());
+    }
+    fl_value_append_take(values, fl_value_new_string(header.value.c_str()));
+  }
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "status", fl_value_new_int(response.status));
+  fl_value_set_string(value, "headers", headers);
+  if (document != nullptr) {
+    const std::vector<uint64_t>& tape = document->tape();
+    const std::string& strings = document->strings();
+    g_autoptr(FlValue) json = fl_value_new_map();
+    fl_value_set_string_take(
+        json, "tape",
+        fl_value_new_int64_list(reinterpret_cast<const int64_t*>(tape.data()),
+                                tape.size()));
+    fl_value_set_string_take(
+        json, "strings",
+        fl_value_new_uint8_list(
+            reinterpret_cast<const uint8_t*>(strings.data()), strings.size()));
+    fl_value_set_string(value, "json", json);
+  } else {
+    fl_value_set_string_take(
+        value, "body",
+        fl_value_new_uint8_list(reinterpret_cast<const uint8_t*>(body.data()),
+                                body.size()));
+  }
+  const gchar* cache = nullptr;
+  switch (outcome) {
+    case flutter_cookie_bridge::CacheOutcome::kBypassed:
+      break;
+    case flutter_cookie_bridge::CacheOutcome::kHit:
+      cache = "hit";
+      break;
+    case flutter_cookie_bridge::CacheOutcome::kRevalidated:
+      cache = "revalidated";
+      break;
+    case flutter_cookie_bridge::CacheOutcome::kMiss:
+      cache = "miss";
+      break;
+  }
+  if (cache != nullptr) {
+    fl_value_set_string_take(value, "cache", fl_value_new_string(cache));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+}
+
+// The HTTP cache, while configureHttpCache has it turned on. Workers swap it
+// and the main loop reads it, through std::atomic_load and atomic_store;
+// requests hold a reference for as long as they run.
+static std::shared_ptr<flutter_cookie_bridge::HttpCache>& http_cache() {
+  static auto* cache = new std::shared_ptr<flutter_cookie_bridge::HttpCache>();
+  return *cache;
+}
+
+// Returns the directory of the HTTP cache. Lives where XDG puts caches, so
+// that it may be cleared like any other.
+static std::string http_cache_directory() {
+  GApplication* application = g_application_get_default();
+  const gchar* application_id =
+      application != nullptr ? g_application_get_application_id(application)
+                             : nullptr;
+  g_autofree gchar* directory = g_build_filename(
+      g_get_user_cache_dir(),
+      application_id != nullptr ? application_id : g_get_prgname(),
+      "flutter_cookie_bridge", "http", nullptr);
+  g_mkdir_with_parents(directory, 0700);
+  return directory;
+}
+
+bool http_cache_options_from_args(
+    FlValue* args,
+    flutter_cookie_bridge::HttpCacheOptions* options) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return false;
+  }
+  FlValue* enabled = fl_value_lookup_string(args, "enabled");
+  if (enabled == nullptr || fl_value_get_type(enabled) != FL_VALUE_TYPE_BOOL ||
+      !fl_value_get_bool(enabled)) {
+    return false;
+  }
+  FlValue* max_bytes = fl_value_lookup_string(args, "maxBytes");
+  if (max_bytes != nullptr &&
+      fl_value_get_type(max_bytes) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(max_bytes) > 0) {
+    options->max_bytes = fl_value_get_int(max_bytes);
+  }
+  return true;
+}
+
+FlValue* encode_http_cache_stats(
+    const flutter_cookie_bridge::HttpCacheStats& stats) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "lookups", fl_value_new_int(stats.lookups));
+  fl_value_set_string_take(value, "hits", fl_value_new_int(stats.hits));
+  fl_value_set_string_take(value, "revalidations",
+                           fl_value_new_int(stats.revalidations));
+  fl_value_set_string_take(value, "misses", fl_value_new_int(stats.misses));
+  fl_value_set_string_take(value, "bytesSaved",
+                           fl_value_new_int(stats.bytes_saved));
+  fl_value_set_string_take(value, "stores", fl_value_new_int(stats.stores));
+  fl_value_set_string_take(value, "evictions",
+                           fl_value_new_int(stats.evictions));
+  fl_value_set_string_take(value, "entries", fl_value_new_int(stats.entries));
+  fl_value_set_string_take(value, "sizeBytes",
+                           fl_value_new_int(stats.size_bytes));
+  return value;
+}
+
+static FlMethodResponse* configure_http_cache(FlValue* args) {
+  flutter_cookie_bridge::HttpCacheOptions options;
+  if (!http_cache_options_from_args(args, &options)) {
+    std::atomic_store(&http_cache(),
+                      std::shared_ptr<flutter_cookie_bridge::HttpCache>());
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  options.directory = http_cache_directory();
+  auto cache = std::make_shared<flutter_cookie_bridge::HttpCache>(options);
+  std::string error;
+  if (!cache->Open(&error)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "CACHE_FAILED", error.c_str(), nullptr));
+  }
+  std::atomic_store(&http_cache(), std::move(cache));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* get_http_cache_stats() {
+  std::shared_ptr<flutter_cookie_bridge::HttpCache> cache =
+      std::atomic_load(&http_cache());
+  g_autoptr(FlValue) result = encode_http_cache_stats(
+      cache != nullptr ? cache->stats()
+                       : flutter_cookie_bridge::HttpCacheStats());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* clear_http_cache() {
+  std::shared_ptr<flutter_cookie_bridge::HttpCache> cache =
+      std::atomic_load(&http_cache());
+  if (cache != nullptr) {
+    cache->Clear();
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+bool compression_options_from_args(
+    FlValue* args,
+    std::string* host,
+    bool* reset,
+    flutter_cookie_bridge::CompressionOptions* options) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return false;
+  }
+  const gchar* name = lookup_string(args, "host");
+  *host = name != nullptr ? name : "";
+  FlValue* reset_value = fl_value_lookup_string(args, "reset");
+  *reset = reset_value != nullptr &&
+           fl_value_get_type(reset_value) == FL_VALUE_TYPE_BOOL &&
+           fl_value_get_bool(reset_value);
+  FlValue* accept = fl_value_lookup_string(args, "accept");
+  if (accept != nullptr && fl_value_get_type(accept) == FL_VALUE_TYPE_LIST) {
+    options->accept.clear();
+    for (size_t i = 0; i < fl_value_get_length(accept); ++i) {
+      FlValue* item = fl_value_get_list_value(accept, i);
+      flutter_cookie_bridge::ContentCoding coding;
+      if (fl_value_get_type(item) != FL_VALUE_TYPE_STRING ||
+          !flutter_cookie_bridge::ParseContentCoding(
+              fl_value_get_string(item), &coding)) {
+        return false;
+      }
+      options->accept.push_back(coding);
+    }
+  }
+  const gchar* request_encoding = lookup_string(args, "requestEncoding");
+  if (request_encoding != nullptr &&
+      (!flutter_cookie_bridge::ParseContentCoding(request_encoding,
+                                                  &options->request_coding) ||
+       !flutter_cookie_bridge::IsContentCodingSupported(
+           options->request_coding))) {
+    return false;
+  }
+  FlValue* min_bytes = fl_value_lookup_string(args, "minRequestBytes");
+  if (min_bytes != nullptr &&
+      fl_value_get_type(min_bytes) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(min_bytes) >= 0) {
+    options->min_request_size =
+        static_cast<size_t>(fl_value_get_int(min_bytes));
+  }
+  FlValue* level = fl_value_lookup_string(args, "level");
+  if (level != nullptr && fl_value_get_type(level) == FL_VALUE_TYPE_INT) {
+    options->level = static_cast<int>(fl_value_get_int(level));
+  }
+  return true;
+}
+
+FlValue* encode_compression_stats(
+    const flutter_cookie_bridge::CompressionStats& stats) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "requests",
+                           fl_value_new_int(stats.requests));
+  fl_value_set_string_take(value, "requestBytes",
+                           fl_value_new_int(stats.request_bytes));
+  fl_value_set_string_take(value, "requestWireBytes",
+                           fl_value_new_int(stats.request_wire_bytes));
+  fl_value_set_string_take(value, "requestsCompressed",
+                           fl_value_new_int(stats.requests_compressed));
+  fl_value_set_string_take(value, "requestsRefused",
+                           fl_value_new_int(stats.requests_refused));
+  fl_value_set_string_take(value, "responses",
+                           fl_value_new_int(stats.responses));
+  fl_value_set_string_take(value, "responseWireBytes",
+                           fl_value_new_int(stats.response_wire_bytes));
+  fl_value_set_string_take(value, "responseBytes",
+                           fl_value_new_int(stats.response_bytes));
+  fl_value_set_string_take(value, "responsesDecoded",
+                           fl_value_new_int(stats.responses_decoded));
+  fl_value_set_string_take(value, "encodeCpuUs",
+                           fl_value_new_int(stats.encode_cpu_us));
+  fl_value_set_string_take(value, "decodeCpuUs",
+                           fl_value_new_int(stats.decode_cpu_us));
+  return value;
+}
+
+static FlMethodResponse* configure_compression(FlValue* args) {
+  std::string host;
+  bool reset = false;
+  flutter_cookie_bridge::CompressionOptions options;
+  if (!compression_options_from_args(args, &host, &reset, &options)) {
+    return bad_arguments("Unknown or unsupported content coding");
+  }
+  flutter_cookie_bridge::CompressionPolicy* policy =
+      flutter_cookie_bridge::CompressionPolicy::Shared();
+  if (reset) {
+    policy->Reset(host);
+  } else {
+    policy->Configure(host, std::move(options));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* get_compression_stats(FlValue* args) {
+  const gchar* host = lookup_string(args, "host");
+  g_autoptr(FlValue) result = encode_compression_stats(
+      flutter_cookie_bridge::CompressionPolicy::Shared()->Stats(
+          host != nullptr ? host : ""));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// An API request running on a request worker.
+struct HttpTask {
+  FlMethodCall* method_call;
+  flutter_cookie_bridge::HttpRequest request;
+  int timeout_ms = 30000;
+  // Null unless the request asked for the cache and it is on.
+  std::shared_ptr<flutter_cookie_bridge::HttpCache> cache;
+  bool ok = false;
+  flutter_cookie_bridge::HttpResponse response;
+  std::string body;
+  flutter_cookie_bridge::CacheOutcome outcome =
+      flutter_cookie_bridge::CacheOutcome::kBypassed;
+  std::string error;
+  // Set when the request asked for a JSON body as a parsed document, which
+  // then lands in |document| instead of |body|.
+  bool json = false;
+  std::unique_ptr<flutter_cookie_bridge::JsonDocument> document;
+};
+
+static gboolean http_request_done_cb(gpointer user_data) {
+  HttpTask* task = static_cast<HttpTask*>(user_data);
+  g_autoptr(FlMethodResponse) response =
+      http_response(task->ok, task->response, task->body,
+                    task->document.get(), task->outcome, task->error);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(task->method_call, response, &error)) {
+    g_warning("Failed to send HTTP response: %s", error->message);
+  }
+  g_object_unref(task->method_call);
+  delete task;
+  return G_SOURCE_REMOVE;
+}
+
+// Whether |response| says its body is JSON: application/json, or a type
+// with a +json suffix.
+static bool is_json_response(
+    const flutter_cookie_bridge::HttpResponse& response) {
+  const std::string* type = response.FindHeader("Content-Type");
+  if (type == nullptr) {
+    return false;
+  }
+  std::string lower = *type;
+  for (char& c : lower) {
+    c = g_ascii_tolower(c);
+  }
+  return lower.find("json") != std::string::npos;
+}
+
+// Ends |parser| into the task's document, or fails the task with the
+// parser's error.
+static bool finish_json(HttpTask* task,
+                        flutter_cookie_bridge::JsonParser* parser) {
+  auto document = std::make_unique<flutter_cookie_bridge::JsonDocument>();
+  if (!parser->Finish(document.get())) {
+    task->error = "invalid JSON: " + parser->error();
+    return false;
+  }
+  task->document = std::move(document);
+  return true;
+}
+
+// Sends a request that asked for its JSON body as a document. Past the
+// cache, the body is parsed as it arrives and never held in full; through
+// the cache, which stores bytes, it is parsed once it is complete. Bodies
+// that are empty or not JSON are returned as they are.
+static bool send_for_json(HttpTask* task) {
+  flutter_cookie_bridge::JsonParser parser;
+  if (task->cache != nullptr) {
+    if (!flutter_cookie_bridge::SendCached(
+            task->cache.get(), flutter_cookie_bridge::ConnectionPool::Shared(),
+            flutter_cookie_bridge::CompressionPolicy::Shared(), task->request,
+            task->timeout_ms, &task->response, &task->body, &task->outcome,
+            &task->error)) {
+      return false;
+    }
+    if (task->body.empty() || !is_json_response(task->response)) {
+      return true;
+    }
+    parser.Feed(task->body.data(), task->body.size());
+    std::string().swap(task->body);
+    return finish_json(task, &parser);
+  }
+
+  bool started = false;
+  bool parsing = false;
+  bool ok = flutter_cookie_bridge::SendWithCompression(
+      flutter_cookie_bridge::ConnectionPool::Shared(),
+      flutter_cookie_bridge::CompressionPolicy::Shared(), task->request,
+      task->timeout_ms, &task->response,
+      [task, &parser, &started, &parsing](const char* data, size_t size) {
+        if (!started) {
+          // The head has been read by the time the body starts.
+          started = true;
+          parsing = is_json_response(task->response);
+        }
+        if (!parsing) {
+          task->body.append(data, size);
+          return true;
+        }
+        return parser.Feed(data, size);
+      },
+      &task->error);
+  if (parsing && !parser.error().empty()) {
+    task->error = "invalid JSON: " + parser.error();
+    return false;
+  }
+  return ok && (!parsing || finish_json(task, &parser));
+}
+
+// Sends the request over the connection pool that downloads use too, so API
+// calls and downloads to one host share connections and TLS sessions.
+// Requests that ask for it go through the HTTP cache when it is on, and get
+// a JSON body parsed on this thread instead of on the UI isolate. Bodies
+// are compressed and decoded as configureCompression set for the host.
+static void start_http_request(FlutterCookieBridgePlugin* self,
+                               FlMethodCall* method_call) {
+  HttpTask* task = new HttpTask();
+  bool use_cache = false;
+  if (!http_request_from_args(fl_method_call_get_args(method_call),
+                              &task->request, &task->timeout_ms,
+                              &use_cache, &task->json)) {
+    delete task;
+    g_autoptr(FlMethodResponse) response =
+        bad_arguments("Expected a method and a url");
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+  task->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+  // Unsafe requests go past the cache either way, but drop what it holds
+  // for their URL.
+  const std::string& verb = task->request.method;
+  if (use_cache || (verb != "GET" && verb != "HEAD")) {
+    task->cache = std::atomic_load(&http_cache());
+  }
+  request_workers()->Post([task] {
+    if (task->json) {
+      task->ok = send_for_json(task);
+    } else {
+      task->ok = flutter_cookie_bridge::SendCached(
+          task->cache.get(), flutter_cookie_bridge::ConnectionPool::Shared(),
+          flutter_cookie_bridge::CompressionPolicy::Shared(), task->request,
+          task->timeout_ms, &task->response, &task->body, &task->outcome,
+          &task->error);
+    }
+    g_idle_add_full(G_PRIORITY_DEFAULT, http_request_done_cb, task, nullptr);
+  });
+}
+
+static gboolean reap_idle_connections_cb(gpointer user_data) {
+  flutter_cookie_bridge::ConnectionPool::Shared()->ReapIdle();
+  return G_SOURCE_CONTINUE;
+}
+
+static FlMethodErrorResponse* downloads_listen_cb(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data) {
+  FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data)->downloads_listening = true;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* downloads_cancel_cb(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data) {
+  FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data)->downloads_listening = false;
+  return nullptr;
+}
+
+// Sends the listener everything that changed since the last event.
+static void send_cookie_changes(FlutterCookieBridgePlugin* self) {
+  if (!self->listening || self->changes_channel == nullptr ||
+      !g_atomic_int_get(&self->feed_attached)) {
+    return;
+  }
+  flutter_cookie_bridge::CookieDelta delta;
+  self->jar->Locked([self, &delta](flutter_cookie_bridge::CookieJar* jar) {
+    if (self->listen_from_now) {
+      self->sent_version = jar->version();
+      self->listen_from_now = false;
+    }
+    delta = self->feed->ChangesSince(self->sent_version);
+  });
+  self->sent_version = delta.version;
+  if (!delta.reset && delta.changes.empty()) {
+    return;
+  }
+  g_autoptr(FlValue) event = encode_cookie_delta(delta);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(self->changes_channel, event, nullptr, &error)) {
+    g_warning("Failed to send cookie changes: %s", error->message);
+  }
+}
+
+static gboolean send_cookie_changes_cb(gpointer user_data) {
+  FlutterCookieBridgePlugin* self = FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data);
+  g_atomic_int_set(&self->send_pending, 0);
+  send_cookie_changes(self);
+  return G_SOURCE_REMOVE;
+}
+
+// Coalesces the changes of one main loop iteration, such as all the cookies
+// of one response, into a single event. Called on whichever thread wrote to
+// the jar.
+static void schedule_cookie_changes(FlutterCookieBridgePlugin* self) {
+  if (!g_atomic_int_compare_and_exchange(&self->send_pending, 0, 1)) {
+    return;
+  }
+  g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, send_cookie_changes_cb,
+                  g_object_ref(self), g_object_unref);
+}
+
+// The listen arguments are the version the listener already has, or null to
+// only receive changes from now on. Before the cookie store has loaded the
+// listener is caught up once the feed is attached.
+static FlMethodErrorResponse* changes_listen_cb(FlEventChannel* channel,
+                                                FlValue* args,
+                                                gpointer user_data) {
+  FlutterCookieBridgePlugin* self = FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data);
+  self->listening = true;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_INT) {
+    int64_t since = fl_value_get_int(args);
+    self->sent_version = since > 0 ? static_cast<uint64_t>(since) : 0;
+    self->listen_from_now = false;
+  } else {
+    self->listen_from_now = true;
+  }
+  send_cookie_changes(self);
+  return nullptr;
+}
+
+static FlMethodErrorResponse* changes_cancel_cb(FlEventChannel* channel,
+                                                FlValue* args,
+                                                gpointer user_data) {
+  FlutterCookieBridgePlugin* self = FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data);
+  self->listening = false;
+  return nullptr;
+}
+
+// Returns the path of |name| in the directory of the persistent cookie log,
+// creating the directory. Lives next to where path_provider keeps
+// application support files.
+static gchar* cookie_store_file(const gchar* name) {
+  GApplication* application = g_application_get_default();
+  const gchar* application_id =
+      application != nullptr ? g_application_get_application_id(application)
+                             : nullptr;
+  g_autofree gchar* directory = g_build_filename(
+      g_get_user_data_dir(),
+      application_id != nullptr ? application_id : g_get_prgname(),
+      "flutter_cookie_bridge", nullptr);
+  g_mkdir_with_parents(directory, 0700);
+  return g_build_filename(directory, name, nullptr);
+}
+
+// The key the cookie log is sealed with. Linux has no keyring every desktop
+// provides, so it is a file beside the log that only the user can read.
+static std::unique_ptr<flutter_cookie_bridge::CookieKeyProvider>
+cookie_store_keys() {
+  g_autofree gchar* path = cookie_store_file("cookies.key");
+  return std::make_unique<flutter_cookie_bridge::FileKeyProvider>(path);
+}
+
+gboolean flutter_cookie_bridge_plugin_trace_from_arguments(
+    const gchar* const* arguments) {
+  for (const gchar* const* argument = arguments;
+       argument != nullptr && *argument != nullptr; ++argument) {
+    if (g_strcmp0(*argument, "--trace-cookie-bridge") == 0) {
+      flutter_cookie_bridge::Tracer::Get()->SetEnabled(true);
+      break;
+    }
+  }
+  return flutter_cookie_bridge::Tracer::Get()->enabled();
+}
+
+void flutter_cookie_bridge_plugin_preload_cookies() {
+  g_autofree gchar* path = cookie_store_file("cookies.log");
+  flutter_cookie_bridge::SharedCookieJar::Get()->PersistInBackground(
+      path, cookie_store_keys());
+}
+
+static void flutter_cookie_bridge_plugin_dispose(GObject* object) {
+  FlutterCookieBridgePlugin* self = FLUTTER_COOKIE_BRIDGE_PLUGIN(object);
+  if (self->changes_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->changes_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_object_unref(self->changes_channel);
+    self->changes_channel = nullptr;
+  }
+  if (self->downloads_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->downloads_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_object_unref(self->downloads_channel);
+    self->downloads_channel = nullptr;
+  }
+  if (self->reap_source != 0) {
+    g_source_remove(self->reap_source);
+    self->reap_source = 0;
+  }
+  // The jar outlives the plugin, so stop observing it.
+  self->jar->Locked([self](flutter_cookie_bridge::CookieJar* jar) {
+    delete self->feed;
+    self->feed = nullptr;
+  });
+  self->jar->Flush();
+
+  G_OBJECT_CLASS(flutter_cookie_bridge_plugin_parent_class)->dispose(object);
+}
+
+static void flutter_cookie_bridge_plugin_class_init(
+    FlutterCookieBridgePluginClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = flutter_cookie_bridge_plugin_dispose;
+}
+
+static void flutter_cookie_bridge_plugin_init(FlutterCookieBridgePlugin* self) {
+  self->jar = flutter_cookie_bridge::SharedCookieJar::Get();
+
+  // Does nothing when flutter_cookie_bridge_plugin_preload_cookies already
+  // started the load. Either way the main thread goes on while the store is
+  // read; method calls wait for it on the workers they run on.
+  g_autofree gchar* path = cookie_store_file("cookies.log");
+  self->jar->PersistInBackground(path, cookie_store_keys());
+
+  // Dispose waits for the load, so |self| outlives this.
+  self->jar->WhenLoaded([self](flutter_cookie_bridge::CookieJar* jar,
+                               bool persisted) {
+    if (!persisted) {
+      g_warning("Failed to open the cookie store; cookies will not persist");
+    }
+    self->feed = new flutter_cookie_bridge::CookieChangeFeed(jar);
+    self->feed->SetListener([self] { schedule_cookie_changes(self); });
+    g_atomic_int_set(&self->feed_attached, 1);
+    // Catches up a listener that subscribed during the load.
+    schedule_cookie_changes(self);
+  });
+
+  // Requests reap the pool as they go; this closes what an app that went
+  // quiet left open.
+  self->reap_source =
+      g_timeout_add_seconds(30, reap_idle_connections_cb, nullptr);
+}
+
+static void method_call_cb(FlMethodChannel* channel,
+                           FlMethodCall* method_call,
+                           gpointer user_data) {
+  FlutterCookieBridgePlugin* plugin = FLUTTER_COOKIE_BRIDGE_PLUGIN(user_data);
+  flutter_cookie_bridge_plugin_handle_method_call(plugin, method_call);
+}
+
+void flutter_cookie_bridge_plugin_register_with_registrar(
+    FlPluginRegistrar* registrar) {
+  flutter_cookie_bridge::ScopedTrace trace("plugin.register");
+  FlutterCookieBridgePlugin* plugin = FLUTTER_COOKIE_BRIDGE_PLUGIN(
+      g_object_new(flutter_cookie_bridge_plugin_get_type(), nullptr));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_autoptr(FlMethodChannel) channel =
+      fl_method_channel_new(fl_plugin_registrar_get_messenger(registrar),
+                            "flutter_cookie_bridge", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      channel, method_call_cb, g_object_ref(plugin), g_object_unref);
+
+  plugin->changes_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "flutter_cookie_bridge/cookie_changes", FL_METHOD_CODEC(codec));
+  // The plugin owns this channel, so the handlers hold no reference to it;
+  // dispose detaches them.
+  fl_event_channel_set_stream_handlers(plugin->changes_channel,
+                                       changes_listen_cb, changes_cancel_cb,
+                                       plugin, nullptr);
+
+  plugin->downloads_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "flutter_cookie_bridge/downloads", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->downloads_channel,
+                                       downloads_listen_cb, downloads_cancel_cb,
+                                       plugin, nullptr);
+
+  g_object_unref(plugin);
+}
@@ -0,0 +1,159 @@
+#ifndef FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_PRIVATE_H_
+#define FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_PRIVATE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <string>
+
+#include "connection_pool.h"
+#include "content_coding.h"
+#include "cookie_change_feed.h"
+#include "download_engine.h"
+#include "http_cache.h"
+#include "json_document.h"
+#include "shared_cookie_jar.h"
+#include "trace.h"
+#include "worker_pool.h"
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_plugin.h"
+
+// This file exposes some plugin internals for unit testing. See
+// https://github.com/flutter/flutter/issues/88724 for current limitations
+// in the unit-testable API.
+
+// Handles the getPlatformVersion method call.
+FlMethodResponse* get_platform_version();
+
+// Handles the setCookies method call. |args| is a map with a "url" string and
+// a "cookies" list of raw Set-Cookie header values.
+FlMethodResponse* set_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args);
+
+// Handles the syncCookies method call. |args| is a map with a "url" string
+// and a "cookies" map of names to values. Applies the difference to the
+// host-only cookies of the url's host and responds with the number of
+// cookies stored or removed.
+FlMethodResponse* sync_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args);
+
+// Handles the getCookieHeader method call. |args| is a map with a "url"
+// string. Responds with the Cookie header value, or null when no cookie
+// applies.
+FlMethodResponse* get_cookie_header(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args);
+
+// Handles the getCookies method call. Responds with the name=value pair of
+// every stored cookie that has not expired.
+FlMethodResponse* get_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar);
+
+// Handles the clear method call.
+FlMethodResponse* clear_cookies(
+    flutter_cookie_bridge::SharedCookieJar* jar);
+
+// Handles the switchCookiePartition method call. |args| is a map with a
+// "name" string and optionally a "from" string naming the partition a new
+// one starts as a snapshot of. Responds with null once |name| is active.
+FlMethodResponse* switch_cookie_partition(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args);
+
+// Handles the deleteCookiePartition method call. |args| is a map with a
+// "name" string. Responds with whether a partition was dropped.
+FlMethodResponse* delete_cookie_partition(
+    flutter_cookie_bridge::SharedCookieJar* jar,
+    FlValue* args);
+
+// Reads the arguments of the download method call into |options|. |args| is
+// a map with "url" and "path" strings, and optionally a "headers" map of
+// strings, a "segments" int bounding the parallel requests and a
+// "progressIntervalMs" int spacing progress events. Returns false when the
+// url or path is missing.
+bool download_options_from_args(
+    FlValue* args,
+    flutter_cookie_bridge::DownloadOptions* options);
+
+// The response to the download method call once |result| is in: a map with
+// the final "path", "bytes", "segments", "resumed" and "sha256", or a
+// DOWNLOAD_FAILED error whose details hold the HTTP "status".
+FlMethodResponse* download_response(
+    const flutter_cookie_bridge::DownloadOptions& options,
+    const flutter_cookie_bridge::DownloadResult& result);
+
+// Encodes an event of the download event channel for the download called
+// |id|: a map with "id", "received", "total" (-1 while unknown),
+// "bytesPerSecond" and "done". Once |result| is given "done" is set, and the
+// map also holds "path" and "sha256", or the "error" and HTTP "status".
+FlValue* encode_download_event(
+    const gchar* id,
+    const flutter_cookie_bridge::DownloadProgress& progress,
+    const flutter_cookie_bridge::DownloadOptions& options,
+    const flutter_cookie_bridge::DownloadResult* result);
+
+// Reads the arguments of the httpRequest method call into |request|. |args|
+// is a map with "method" and "url" strings, and optionally a "headers" map
+// of strings, a "body" byte list, a "timeoutMs" int, stored in
+// |timeout_ms|, a "cache" bool, stored in |use_cache|, and a "json" bool,
+// stored in |json|. Returns false when the method or url is missing.
+bool http_request_from_args(FlValue* args,
+                            flutter_cookie_bridge::HttpRequest* request,
+                            int* timeout_ms,
+                            bool* use_cache,
+                            bool* json);
+
+// The response to the httpRequest method call: a map with the "status", the
+// "headers" as a map of lower-cased names to lists of values, the "body"
+// bytes and, unless the cache was bypassed, how the "cache" answered:
+// "hit", "revalidated" or "miss". When the body was parsed into |document|,
+// a "json" map with its "tape" as an int64 list and its "strings" bytes
+// takes the place of the body. An HTTP_FAILED error with |error| when |ok|
+// is false.
+FlMethodResponse* http_response(
+    bool ok,
+    const flutter_cookie_bridge::HttpResponse& response,
+    const std::string& body,
+    const flutter_cookie_bridge::JsonDocument* document,
+    flutter_cookie_bridge::CacheOutcome outcome,
+    const std::string& error);
+
+// Reads the arguments of the configureHttpCache method call into |options|.
+// |args| is a map with an "enabled" bool and optionally a "maxBytes" int.
+// Returns false when the cache is to be turned off.
+bool http_cache_options_from_args(
+    FlValue* args,
+    flutter_cookie_bridge::HttpCacheOptions* options);
+
+// Encodes |stats| as returned by the httpCacheStats method call: a map with
+// "lookups", "hits", "revalidations", "misses", "bytesSaved", "stores",
+// "evictions", "entries" and "sizeBytes".
+FlValue* encode_http_cache_stats(
+    const flutter_cookie_bridge::HttpCacheStats& stats);
+
+// Reads the arguments of the configureCompression method call. |args| is a
+// map with optionally a "host" string, stored in |host| and empty for the
+// default of every host, a "reset" bool, stored in |reset|, which drops the
+// host's own options, and the |options|: an "accept" list of coding names,
+// a "requestEncoding" name, a "minRequestBytes" int and a "level" int.
+// Returns false when a coding is unknown, or one to compress requests with
+// is not supported.
+bool compression_options_from_args(
+    FlValue* args,
+    std::string* host,
+    bool* reset,
+    flutter_cookie_bridge::CompressionOptions* options);
+
+// Encodes |stats| as returned by the compressionStats method call: a map
+// with "requests", "requestBytes", "requestWireBytes", "requestsCompressed",
+// "requestsRefused", "responses", "responseWireBytes", "responseBytes",
+// "responsesDecoded", "encodeCpuUs" and "decodeCpuUs".
+FlValue* encode_compression_stats(
+    const flutter_cookie_bridge::CompressionStats& stats);
+
+// Encodes |delta| as sent on the cookie change event channel: a map with the
+// "version" the listener is at afterwards, a "reset" flag and a "changes"
+// list of maps with "name", "value", "domain", "path" and "removed".
+FlValue* encode_cookie_delta(const flutter_cookie_bridge::CookieDelta& delta);
+
+#endif  // FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_PRIVATE_H_
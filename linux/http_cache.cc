@@ -0,0 +1,796 @@
+#include "http_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <openssl/sha.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include "set_cookie_parser.h"
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr uint32_t kIndexMagic = 0x46434349;  // "FCCI"
+constexpr uint32_t kEntryMagic = 0x46434345;  // "FCCE"
+constexpr char kIndexName[] = "index";
+// Hex digits of a key: the first 128 bits of a SHA-256.
+constexpr size_t kKeyLength = 32;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t count;
+};
+
+struct IndexRecord {
+  char key[kKeyLength];
+  int64_t size;
+  int64_t last_used;
+};
+
+// Precedes the headers, the Vary values and the body in an entry file.
+struct EntryHeader {
+  uint32_t magic;
+  int32_t status;
+  // When the response arrived, in seconds since the epoch.
+  int64_t response_time;
+  // Its age on arrival.
+  int64_t initial_age;
+  // How long it stays fresh, counted from its age.
+  int64_t lifetime;
+  uint32_t no_cache;
+  uint32_t headers_length;
+  uint32_t vary_length;
+  uint32_t reserved;
+  uint64_t body_length;
+};
+
+// Heuristically cacheable statuses, RFC 9110 15.1.
+bool IsCacheableStatus(int status) {
+  switch (status) {
+    case 200:
+    case 203:
+    case 204:
+    case 300:
+    case 301:
+    case 308:
+    case 404:
+    case 405:
+    case 410:
+    case 414:
+    case 501:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Headers a cache does not keep: hop-by-hop ones, and cookies, which are
+// for the response that set them and not for replays of it.
+bool IsUnstoredHeader(std::string_view name) {
+  for (const char* unstored :
+       {"Connection", "Keep-Alive", "Proxy-Authenticate", "Proxy-Connection",
+        "TE", "Trailer", "Transfer-Encoding", "Upgrade", "Set-Cookie",
+        "Set-Cookie2"}) {
+    if (EqualsIgnoreCase(name, unstored)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::string* FindRequestHeader(const HttpRequest& request,
+                                     std::string_view name) {
+  for (const HttpHeader& header : request.headers) {
+    if (EqualsIgnoreCase(header.name, name)) {
+      return &header.value;
+    }
+  }
+  return nullptr;
+}
+
+// The Cache-Control directives a private cache acts on.
+struct CacheControl {
+  bool no_store = false;
+  bool no_cache = false;
+  bool is_public = false;
+  bool must_revalidate = false;
+  bool has_s_maxage = false;
+  // -1 when absent.
+  int64_t max_age = -1;
+};
+
+CacheControl ParseCacheControl(const std::vector<HttpHeader>& headers) {
+  CacheControl control;
+  for (const HttpHeader& header : headers) {
+    bool pragma = EqualsIgnoreCase(header.name, "Pragma");
+    if (!pragma && !EqualsIgnoreCase(header.name, "Cache-Control")) {
+      continue;
+    }
+    std::string_view rest = header.value;
+    while (!rest.empty()) {
+      size_t comma = rest.find(',');
+      std::string_view directive = TrimWhitespace(rest.substr(0, comma));
+      rest = comma == std::string_view::npos ? std::string_view()
+                                             : rest.substr(comma + 1);
+      size_t equals = directive.find('=');
+      std::string_view name = TrimWhitespace(directive.substr(0, equals));
+      std::string_view value =
+          equals == std::string_view::npos
+              ? std::string_view()
+              : TrimWhitespace(directive.substr(equals + 1));
+      if (!value.empty() && value.front() == '"' && value.size() > 1) {
+        value = value.substr(1, value.size() - 2);
+      }
+      if (EqualsIgnoreCase(name, "no-cache")) {
+        control.no_cache = true;
+      } else if (pragma) {
+        continue;
+      } else if (EqualsIgnoreCase(name, "no-store")) {
+        control.no_store = true;
+      } else if (EqualsIgnoreCase(name, "public")) {
+        control.is_public = true;
+      } else if (EqualsIgnoreCase(name, "must-revalidate")) {
+        control.must_revalidate = true;
+      } else if (EqualsIgnoreCase(name, "s-maxage")) {
+        control.has_s_maxage = true;
+      } else if (EqualsIgnoreCase(name, "max-age") && !value.empty()) {
+        control.max_age = std::strtoll(std::string(value).c_str(), nullptr,
+                                       10);
+      }
+    }
+  }
+  return control;
+}
+
+const std::string* FindResponseHeader(const std::vector<HttpHeader>& headers,
+                                      std::string_view name) {
+  for (const HttpHeader& header : headers) {
+    if (EqualsIgnoreCase(header.name, name)) {
+      return &header.value;
+    }
+  }
+  return nullptr;
+}
+
+int64_t HeaderDate(const std::vector<HttpHeader>& headers,
+                   std::string_view name) {
+  const std::string* value = FindResponseHeader(headers, name);
+  return value == nullptr ? kNoExpiry : ParseCookieDate(*value);
+}
+
+// Fills in the age on arrival and the freshness lifetime, RFC 9111 4.2.
+void ComputeFreshness(const std::vector<HttpHeader>& headers,
+                      int status,
+                      int64_t request_time,
+                      int64_t response_time,
+                      EntryHeader* entry) {
+  CacheControl control = ParseCacheControl(headers);
+  int64_t date = HeaderDate(headers, "Date");
+  if (date == kNoExpiry) {
+    date = response_time;
+  }
+  const std::string* age_header = FindResponseHeader(headers, "Age");
+  int64_t age =
+      age_header == nullptr ? 0 : std::strtoll(age_header->c_str(), nullptr,
+                                               10);
+  int64_t apparent_age = std::max<int64_t>(0, response_time - date);
+  int64_t corrected_age = std::max<int64_t>(0, age) +
+                          std::max<int64_t>(0, response_time - request_time);
+  entry->initial_age = std::max(apparent_age, corrected_age);
+  entry->response_time = response_time;
+  entry->no_cache = control.no_cache ? 1 : 0;
+
+  if (control.max_age >= 0) {
+    entry->lifetime = control.max_age;
+    return;
+  }
+  if (FindResponseHeader(headers, "Expires") != nullptr) {
+    // An invalid date means already expired.
+    int64_t expires = HeaderDate(headers, "Expires");
+    entry->lifetime = expires == kNoExpiry ? 0 : expires - date;
+    return;
+  }
+  int64_t last_modified = HeaderDate(headers, "Last-Modified");
+  if (IsCacheableStatus(status) && last_modified != kNoExpiry &&
+      last_modified < date) {
+    // The customary heuristic: a tenth of the time since the last change,
+    // up to a day.
+    entry->lifetime = std::min<int64_t>((date - last_modified) / 10, 86400);
+    return;
+  }
+  entry->lifetime = 0;
+}
+
+std::string SerializeHeaders(const std::vector<HttpHeader>& headers) {
+  std::string lines;
+  for (const HttpHeader& header : headers) {
+    lines += header.name;
+    lines += ": ";
+    lines += header.value;
+    lines += "\r\n";
+  }
+  return lines;
+}
+
+std::vector<HttpHeader> ParseHeaders(std::string_view lines) {
+  std::vector<HttpHeader> headers;
+  while (!lines.empty()) {
+    size_t end = lines.find("\r\n");
+    std::string_view line = lines.substr(0, end);
+    lines = end == std::string_view::npos ? std::string_view()
+                                          : lines.substr(end + 2);
+    size_t colon = line.find(": ");
+    if (colon != std::string_view::npos) {
+      headers.push_back(HttpHeader{std::string(line.substr(0, colon)),
+                                   std::string(line.substr(colon + 2))});
+    }
+  }
+  return headers;
+}
+
+// The request's values of the headers the response varies on, one
+// "name: value" line each, or false for "Vary: *".
+bool VaryValues(const std::vector<HttpHeader>& response_headers,
+                const HttpRequest& request,
+                std::string* lines) {
+  for (const HttpHeader& header : response_headers) {
+    if (!EqualsIgnoreCase(header.name, "Vary")) {
+      continue;
+    }
+    std::string_view rest = header.value;
+    while (!rest.empty()) {
+      size_t comma = rest.find(',');
+      std::string_view name = TrimWhitespace(rest.substr(0, comma));
+      rest = comma == std::string_view::npos ? std::string_view()
+                                             : rest.substr(comma + 1);
+      if (name == "*") {
+        return false;
+      }
+      if (name.empty()) {
+        continue;
+      }
+      const std::string* value = FindRequestHeader(request, name);
+      *lines += name;
+      *lines += ": ";
+      *lines += value != nullptr ? *value : "";
+      *lines += "\r\n";
+    }
+  }
+  return true;
+}
+
+bool ReadFile(const std::string& path, std::string* contents) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  bool ok = fstat(fd, &info) == 0;
+  if (ok) {
+    contents->resize(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (ok && done < contents->size()) {
+      ssize_t count = read(fd, &(*contents)[done], contents->size() - done);
+      ok = count > 0;
+      done += ok ? static_cast<size_t>(count) : 0;
+    }
+  }
+  close(fd);
+  return ok;
+}
+
+// Writes |parts| to a temporary file that is then renamed over |path|, so
+// readers see either the old or the new contents.
+bool WriteFileAtomically(const std::string& path,
+                         std::initializer_list<std::string_view> parts) {
+  std::string temporary = path + ".XXXXXX";
+  int fd = mkostemp(&temporary[0], O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = true;
+  for (std::string_view part : parts) {
+    while (ok && !part.empty()) {
+      ssize_t count = write(fd, part.data(), part.size());
+      ok = count > 0;
+      if (ok) {
+        part.remove_prefix(static_cast<size_t>(count));
+      }
+    }
+  }
+  ok = close(fd) == 0 && ok;
+  if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+// A parsed entry file.
+struct StoredEntry {
+  EntryHeader header;
+  std::string_view headers;
+  std::string_view vary;
+  std::string_view body;
+};
+
+bool ParseEntry(const std::string& contents, StoredEntry* entry) {
+  if (contents.size() < sizeof(EntryHeader)) {
+    return false;
+  }
+  std::memcpy(&entry->header, contents.data(), sizeof(EntryHeader));
+  const EntryHeader& header = entry->header;
+  uint64_t expected = sizeof(EntryHeader) + uint64_t{header.headers_length} +
+                      header.vary_length + header.body_length;
+  if (header.magic != kEntryMagic || expected != contents.size()) {
+    return false;
+  }
+  std::string_view rest(contents);
+  rest.remove_prefix(sizeof(EntryHeader));
+  entry->headers = rest.substr(0, header.headers_length);
+  rest.remove_prefix(header.headers_length);
+  entry->vary = rest.substr(0, header.vary_length);
+  rest.remove_prefix(header.vary_length);
+  entry->body = rest;
+  return true;
+}
+
+// The Cache-Control directives of a request that keep a stored response
+// from being used without revalidation.
+bool RequiresRevalidation(const HttpRequest& request) {
+  CacheControl control = ParseCacheControl(request.headers);
+  return control.no_cache || control.max_age == 0;
+}
+
+}  // namespace
+
+HttpCache::HttpCache(HttpCacheOptions options) : options_(std::move(options)) {}
+
+HttpCache::~HttpCache() {
+  // Keeps the last use times for eviction order across runs.
+  std::lock_guard<std::mutex> lock(mutex_);
+  SaveIndexLocked();
+}
+
+int64_t HttpCache::Now() const {
+  return options_.clock ? options_.clock()
+                        : static_cast<int64_t>(std::time(nullptr));
+}
+
+bool HttpCache::Open(std::string* error) {
+  if (mkdir(options_.directory.c_str(), 0700) != 0 && errno != EEXIST) {
+    *error = "cannot create " + options_.directory + ": " +
+             std::strerror(errno);
+    return false;
+  }
+  std::string contents;
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  index_.clear();
+  size_ = 0;
+  IndexHeader header = {};
+  if (ReadFile(options_.directory + "/" + kIndexName, &contents) &&
+      contents.size() >= sizeof(header)) {
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != kIndexMagic ||
+        contents.size() != sizeof(header) + header.count * sizeof(IndexRecord)) {
+      header.count = 0;
+    }
+  }
+  for (uint32_t i = 0; i < header.count; ++i) {
+    IndexRecord record;
+    std::memcpy(&record, contents.data() + sizeof(header) + i * sizeof(record),
+                sizeof(record));
+    std::string key(record.key, kKeyLength);
+    struct stat info;
+    if (index_.count(key) != 0 || stat(PathFor(key).c_str(), &info) != 0 ||
+        info.st_size != record.size) {
+      continue;
+    }
+    lru_.push_back(IndexEntry{key, record.size, record.last_used});
+    index_[key] = std::prev(lru_.end());
+    size_ += record.size;
+  }
+  // Entries written after the index was last saved, and leftovers of
+  // interrupted writes, are not worth keeping.
+  if (DIR* directory = opendir(options_.directory.c_str())) {
+    while (dirent* file = readdir(directory)) {
+      std::string name = file->d_name;
+      if (name != "." && name != ".." && name != kIndexName &&
+          index_.count(name) == 0) {
+        unlink((options_.directory + "/" + name).c_str());
+      }
+    }
+    closedir(directory);
+  }
+  SaveIndexLocked();
+  return true;
+}
+
+std::string HttpCache::KeyFor(const HttpRequest& request) {
+  if (request.method != "GET") {
+    return "";
+  }
+  // Requests that are already conditional or partial are the caller's
+  // business, and no-store forbids even looking.
+  for (const char* name : {"Range", "If-None-Match", "If-Modified-Since",
+                           "If-Match", "If-Unmodified-Since", "If-Range"}) {
+    if (FindRequestHeader(request, name) != nullptr) {
+      return "";
+    }
+  }
+  if (ParseCacheControl(request.headers).no_store) {
+    return "";
+  }
+  const std::string* cookie = FindRequestHeader(request, "Cookie");
+  std::string identity = request.method + "\n" + request.url + "\n" +
+                         (cookie != nullptr ? *cookie : "");
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char*>(identity.data()),
+         identity.size(), digest);
+  static const char kHex[] = "0123456789abcdef";
+  std::string key(kKeyLength, '0');
+  for (size_t i = 0; i < kKeyLength / 2; ++i) {
+    key[2 * i] = kHex[digest[i] >> 4];
+    key[2 * i + 1] = kHex[digest[i] & 15];
+  }
+  return key;
+}
+
+std::string HttpCache::PathFor(const std::string& key) const {
+  return options_.directory + "/" + key;
+}
+
+bool HttpCache::Lookup(const HttpRequest& request, Entry* entry) {
+  std::string key = KeyFor(request);
+  if (key.empty()) {
+    return false;
+  }
+  int64_t now = Now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return false;
+    }
+    found->second->last_used = now;
+    lru_.splice(lru_.begin(), lru_, found->second);
+  }
+
+  std::string contents;
+  StoredEntry stored;
+  if (!ReadFile(PathFor(key), &contents) || !ParseEntry(contents, &stored)) {
+    return false;
+  }
+  std::string vary;
+  std::vector<HttpHeader> stored_vary = ParseHeaders(stored.vary);
+  for (const HttpHeader& header : stored_vary) {
+    const std::string* value = FindRequestHeader(request, header.name);
+    if ((value != nullptr ? *value : "") != header.value) {
+      return false;
+    }
+  }
+  const EntryHeader& header = stored.header;
+  int64_t age = header.initial_age + (now - header.response_time);
+  entry->status = header.status;
+  entry->headers = ParseHeaders(stored.headers);
+  entry->body.assign(stored.body);
+  entry->fresh = header.no_cache == 0 && age < header.lifetime &&
+                 !RequiresRevalidation(request);
+  const std::string* etag = FindResponseHeader(entry->headers, "ETag");
+  const std::string* last_modified =
+      FindResponseHeader(entry->headers, "Last-Modified");
+  entry->etag = etag != nullptr ? *etag : "";
+  entry->last_modified = last_modified != nullptr ? *last_modified : "";
+  return true;
+}
+
+void HttpCache::Store(const HttpRequest& request,
+                      const HttpResponse& response,
+                      const std::string& body,
+                      int64_t request_time) {
+  std::string key = KeyFor(request);
+  if (key.empty()) {
+    return;
+  }
+  CacheControl control = ParseCacheControl(response.headers);
+  std::string vary;
+  bool storable =
+      IsCacheableStatus(response.status) && !control.no_store &&
+      VaryValues(response.headers, request, &vary) &&
+      // Shared credentials only when the server says so, RFC 9111 3.5.
+      (FindRequestHeader(request, "Authorization") == nullptr ||
+       control.is_public || control.must_revalidate || control.has_s_maxage);
+
+  EntryHeader header = {};
+  std::vector<HttpHeader> kept;
+  if (storable) {
+    for (const HttpHeader& field : response.headers) {
+      if (!IsUnstoredHeader(field.name)) {
+        kept.push_back(field);
+      }
+    }
+    header.magic = kEntryMagic;
+    header.status = response.status;
+    ComputeFreshness(kept, response.status, request_time, Now(), &header);
+    // Without freshness or a validator the response is of no later use.
+    storable = header.lifetime > 0 ||
+               FindResponseHeader(kept, "ETag") != nullptr ||
+               FindResponseHeader(kept, "Last-Modified") != nullptr;
+  }
+  if (!storable ||
+      static_cast<int64_t>(body.size()) > options_.max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) != 0) {
+      RemoveLocked(key);
+      SaveIndexLocked();
+    }
+    return;
+  }
+
+  std::string lines = SerializeHeaders(kept);
+  header.headers_length = static_cast<uint32_t>(lines.size());
+  header.vary_length = static_cast<uint32_t>(vary.size());
+  header.body_length = body.size();
+  std::string meta(reinterpret_cast<const char*>(&header), sizeof(header));
+  meta += lines;
+  meta += vary;
+  int64_t size = WriteEntry(key, meta, body);
+  if (size < 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.stores;
+  IndexLocked(key, size);
+}
+
+bool HttpCache::Revalidated(const HttpRequest& request,
+                            const HttpResponse& response,
+                            int64_t request_time,
+                            Entry* entry) {
+  std::string key = KeyFor(request);
+  std::string contents;
+  StoredEntry stored;
+  if (key.empty() || !ReadFile(PathFor(key), &contents) ||
+      !ParseEntry(contents, &stored)) {
+    return false;
+  }
+  // The 304's headers replace the stored ones of the same name, RFC 9111
+  // 3.2, except for those that describe the 304 itself.
+  std::vector<HttpHeader> headers = ParseHeaders(stored.headers);
+  for (const HttpHeader& update : response.headers) {
+    if (IsUnstoredHeader(update.name) ||
+        EqualsIgnoreCase(update.name, "Content-Length")) {
+      continue;
+    }
+    headers.erase(std::remove_if(headers.begin(), headers.end(),
+                                 [&](const HttpHeader& header) {
+                                   return EqualsIgnoreCase(header.name,
+                                                           update.name);
+                                 }),
+                  headers.end());
+  }
+  for (const HttpHeader& update : response.headers) {
+    if (!IsUnstoredHeader(update.name) &&
+        !EqualsIgnoreCase(update.name, "Content-Length")) {
+      headers.push_back(update);
+    }
+  }
+
+  EntryHeader header = stored.header;
+  ComputeFreshness(headers, header.status, request_time, Now(), &header);
+  std::string lines = SerializeHeaders(headers);
+  header.headers_length = static_cast<uint32_t>(lines.size());
+  std::string meta(reinterpret_cast<const char*>(&header), sizeof(header));
+  meta += lines;
+  meta += stored.vary;
+
+  entry->status = header.status;
+  entry->headers = std::move(headers);
+  entry->body.assign(stored.body);
+  entry->fresh = true;
+  int64_t size = WriteEntry(key, meta, entry->body);
+  if (size >= 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    IndexLocked(key, size);
+  }
+  return true;
+}
+
+void HttpCache::Invalidate(const HttpRequest& request) {
+  HttpRequest get;
+  get.url = request.url;
+  const std::string* cookie = FindRequestHeader(request, "Cookie");
+  if (cookie != nullptr) {
+    get.headers.push_back(HttpHeader{"Cookie", *cookie});
+  }
+  std::string key = KeyFor(get);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index_.count(key) != 0) {
+    RemoveLocked(key);
+    SaveIndexLocked();
+  }
+}
+
+void HttpCache::Record(CacheOutcome outcome, size_t bytes_saved) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  switch (outcome) {
+    case CacheOutcome::kBypassed:
+      return;
+    case CacheOutcome::kHit:
+      ++stats_.hits;
+      break;
+    case CacheOutcome::kRevalidated:
+      ++stats_.revalidations;
+      break;
+    case CacheOutcome::kMiss:
+      ++stats_.misses;
+      break;
+  }
+  ++stats_.lookups;
+  stats_.bytes_saved += bytes_saved;
+}
+
+void HttpCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!lru_.empty()) {
+    RemoveLocked(lru_.front().key);
+  }
+  SaveIndexLocked();
+}
+
+HttpCacheStats HttpCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HttpCacheStats stats = stats_;
+  stats.entries = index_.size();
+  stats.size_bytes = static_cast<uint64_t>(size_);
+  return stats;
+}
+
+int64_t HttpCache::WriteEntry(const std::string& key,
+                              const std::string& meta,
+                              const std::string& body) {
+  if (!WriteFileAtomically(PathFor(key), {meta, body})) {
+    return -1;
+  }
+  return static_cast<int64_t>(meta.size() + body.size());
+}
+
+void HttpCache::IndexLocked(const std::string& key, int64_t size) {
+  auto found = index_.find(key);
+  if (found != index_.end()) {
+    size_ -= found->second->size;
+    lru_.erase(found->second);
+  }
+  lru_.push_front(IndexEntry{key, size, Now()});
+  index_[key] = lru_.begin();
+  size_ += size;
+  while (size_ > options_.max_bytes && lru_.size() > 1) {
+    RemoveLocked(lru_.back().key);
+    ++stats_.evictions;
+  }
+  SaveIndexLocked();
+}
+
+void HttpCache::RemoveLocked(const std::string& key) {
+  auto found = index_.find(key);
+  if (found == index_.end()) {
+    return;
+  }
+  unlink(PathFor(key).c_str());
+  size_ -= found->second->size;
+  lru_.erase(found->second);
+  index_.erase(found);
+}
+
+bool HttpCache::SaveIndexLocked() {
+  if (options_.directory.empty()) {
+    return false;
+  }
+  IndexHeader header = {kIndexMagic, static_cast<uint32_t>(lru_.size())};
+  std::string records;
+  records.reserve(lru_.size() * sizeof(IndexRecord));
+  for (const IndexEntry& entry : lru_) {
+    IndexRecord record = {};
+    std::memcpy(record.key, entry.key.data(), kKeyLength);
+    record.size = entry.size;
+    record.last_used = entry.last_used;
+    records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+  }
+  return WriteFileAtomically(
+      options_.directory + "/" + kIndexName,
+      {std::string_view(reinterpret_cast<const char*>(&header),
+                        sizeof(header)),
+       records});
+}
+
+bool SendCached(HttpCache* cache,
+                ConnectionPool* pool,
+                CompressionPolicy* compression,
+                const HttpRequest& request,
+                int timeout_ms,
+                HttpResponse* response,
+                std::string* body,
+                CacheOutcome* outcome,
+                std::string* error) {
+  *outcome = CacheOutcome::kBypassed;
+  body->clear();
+  HttpBodyCallback collect = [body](const char* data, size_t size) {
+    body->append(data, size);
+    return true;
+  };
+  if (cache == nullptr || HttpCache::KeyFor(request).empty()) {
+    bool ok = SendWithCompression(pool, compression, request, timeout_ms,
+                                  response, collect, error);
+    bool safe = request.method == "GET" || request.method == "HEAD" ||
+                request.method == "OPTIONS";
+    if (cache != nullptr && ok && !safe && response->status < 400) {
+      cache->Invalidate(request);
+    }
+    return ok;
+  }
+
+  HttpCache::Entry entry;
+  bool found = cache->Lookup(request, &entry);
+  auto answer = [&](CacheOutcome how) {
+    response->status = entry.status;
+    response->headers = std::move(entry.headers);
+    response->content_length = static_cast<int64_t>(entry.body.size());
+    response->complete = true;
+    *body = std::move(entry.body);
+    *outcome = how;
+    cache->Record(how, body->size());
+    return true;
+  };
+  if (found && entry.fresh) {
+    return answer(CacheOutcome::kHit);
+  }
+
+  HttpRequest conditional = request;
+  if (found && !entry.etag.empty()) {
+    conditional.headers.push_back(HttpHeader{"If-None-Match", entry.etag});
+  }
+  if (found && !entry.last_modified.empty()) {
+    conditional.headers.push_back(
+        HttpHeader{"If-Modified-Since", entry.last_modified});
+  }
+  int64_t request_time = cache->Now();
+  if (!SendWithCompression(pool, compression, conditional, timeout_ms,
+                           response, collect, error)) {
+    return false;
+  }
+  if (found && response->status == 304) {
+    // What the cache does not store, cookies above all, is the 304's own
+    // and still goes to the caller, so a session refreshed on revalidation
+    // reaches the jar.
+    std::vector<HttpHeader> unstored;
+    for (const HttpHeader& header : response->headers) {
+      if (IsUnstoredHeader(header.name)) {
+        unstored.push_back(header);
+      }
+    }
+    if (cache->Revalidated(request, *response, request_time, &entry)) {
+      answer(CacheOutcome::kRevalidated);
+      response->headers.insert(response->headers.end(), unstored.begin(),
+                               unstored.end());
+      return true;
+    }
+  }
+  if (response->complete) {
+    cache->Store(request, *response, *body, request_time);
+  }
+  *outcome = CacheOutcome::kMiss;
+  cache->Record(CacheOutcome::kMiss, 0);
+  return true;
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,170 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_HTTP_CACHE_H_
+#define FLUTTER_COOKIE_BRIDGE_HTTP_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "connection_pool.h"
+#include "content_coding.h"
+#include "http_client.h"
+
+namespace flutter_cookie_bridge {
+
+struct HttpCacheOptions {
+  // Holds the index and one file per response. Created when missing.
+  std::string directory;
+  // The least recently used responses are evicted beyond this size.
+  int64_t max_bytes = 50 * 1024 * 1024;
+  // Seconds since the epoch. Tests substitute their own.
+  std::function<int64_t()> clock;
+};
+
+struct HttpCacheStats {
+  // Lookups of cacheable requests, and how they were answered: from the
+  // cache without asking the server, after a 304 from the server, or by
+  // the network.
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+  uint64_t revalidations = 0;
+  uint64_t misses = 0;
+  // Body bytes served from the cache, whether fresh or revalidated.
+  uint64_t bytes_saved = 0;
+  uint64_t stores = 0;
+  uint64_t evictions = 0;
+  uint64_t entries = 0;
+  uint64_t size_bytes = 0;
+};
+
+// How a cached request was answered.
+enum class CacheOutcome {
+  // The request was not cacheable, or the cache is off.
+  kBypassed,
+  kHit,
+  kRevalidated,
+  kMiss,
+};
+
+// A private HTTP cache (RFC 9111) for GET responses, kept on disk.
+//
+// Entries are keyed by method, URL and the request's Cookie header, so two
+// sessions never share a response. The index of keys, sizes and last use
+// times lives in memory and in a compact binary file next to the entries;
+// the headers, validators and freshness of a response are kept in its
+// entry file in front of the body.
+class HttpCache {
+ public:
+  // A response found in the cache.
+  struct Entry {
+    int status = 0;
+    std::vector<HttpHeader> headers;
+    std::string body;
+    // Whether it may be used without asking the server.
+    bool fresh = false;
+    // Values for If-None-Match and If-Modified-Since; empty when absent.
+    std::string etag;
+    std::string last_modified;
+  };
+
+  explicit HttpCache(HttpCacheOptions options);
+  ~HttpCache();
+
+  HttpCache(const HttpCache&) = delete;
+  HttpCache& operator=(const HttpCache&) = delete;
+
+  // Loads the index, dropping entries whose file went missing. Returns
+  // false when the directory cannot be created.
+  bool Open(std::string* error);
+
+  // The key |request| is stored under, or an empty string when it is not
+  // cacheable at all.
+  static std::string KeyFor(const HttpRequest& request);
+
+  // Looks |request| up. Returns false when nothing usable is stored; a
+  // stored response whose Vary headers do not match counts as nothing.
+  bool Lookup(const HttpRequest& request, Entry* entry);
+
+  // Stores |response| with |body| for |request| when its status and
+  // Cache-Control allow it; otherwise drops any stored response for the
+  // request. |request_time| is when the request was sent, in seconds.
+  void Store(const HttpRequest& request,
+             const HttpResponse& response,
+             const std::string& body,
+             int64_t request_time);
+
+  // Applies a 304 |response| to the stored response for |request|,
+  // updating its headers and freshness, and returns the updated entry in
+  // |entry|. Returns false when nothing is stored any more.
+  bool Revalidated(const HttpRequest& request,
+                   const HttpResponse& response,
+                   int64_t request_time,
+                   Entry* entry);
+
+  // Drops what is stored for a GET of |request|'s URL with its cookies,
+  // after |request|, an unsafe method, succeeded (RFC 9111 4.4).
+  void Invalidate(const HttpRequest& request);
+
+  // Counts the outcome of one request, with the body bytes that did not
+  // have to be transferred.
+  void Record(CacheOutcome outcome, size_t bytes_saved);
+
+  void Clear();
+
+  HttpCacheStats stats() const;
+
+  int64_t Now() const;
+
+ private:
+  struct IndexEntry {
+    std::string key;
+    int64_t size = 0;
+    int64_t last_used = 0;
+  };
+  using Lru = std::list<IndexEntry>;
+
+  std::string PathFor(const std::string& key) const;
+
+  // Writes the entry file for |key|. Returns its size, or -1.
+  int64_t WriteEntry(const std::string& key,
+                     const std::string& meta,
+                     const std::string& body);
+
+  // Adds or replaces |key| in the index, then evicts down to max_bytes.
+  void IndexLocked(const std::string& key, int64_t size);
+  void RemoveLocked(const std::string& key);
+  bool SaveIndexLocked();
+
+  const HttpCacheOptions options_;
+  mutable std::mutex mutex_;
+  // Most recently used first.
+  Lru lru_;
+  std::unordered_map<std::string, Lru::iterator> index_;
+  int64_t size_ = 0;
+  HttpCacheStats stats_;
+};
+
+// Sends |request| through |pool|, answering from |cache| when it has a
+// fresh response and revalidating a stale one with its validators. A 304 is
+// turned into the stored response, and a successful unsafe request drops
+// what is stored for its URL. |body| receives the whole body, decoded as
+// |compression| negotiates, which is what gets stored, and |outcome| how the
+// request was answered. |cache| and |compression| may be null.
+bool SendCached(HttpCache* cache,
+                ConnectionPool* pool,
+                CompressionPolicy* compression,
+                const HttpRequest& request,
+                int timeout_ms,
+                HttpResponse* response,
+                std::string* body,
+                CacheOutcome* outcome,
+                std::string* error);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_HTTP_CACHE_H_
@@ -0,0 +1,321 @@
+#include "http_client.h"
+
+#include <cstdlib>
+
+#include "url.h"
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr size_t kBodyBufferSize = 64 * 1024;
+constexpr size_t kMaxHeaderLines = 256;
+
+char ToLower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string_view Trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+// Returns true when the comma-separated |list| contains |token|.
+bool HasToken(std::string_view list, std::string_view token) {
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    if (EqualsIgnoreCase(Trim(list.substr(0, comma)), token)) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+bool ReadHead(HttpConnection* connection,
+              HttpResponse* response,
+              bool* http_1_0,
+              std::string* error) {
+  std::string line;
+  if (!connection->ReadLine(&line)) {
+    *error = "connection closed before the response";
+    return false;
+  }
+  // "HTTP/1.1 200 OK"
+  if (line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+    *error = "malformed status line";
+    return false;
+  }
+  *http_1_0 = line.compare(5, 3, "1.0") == 0;
+  response->status = std::atoi(line.c_str() + 9);
+  response->headers.clear();
+  while (true) {
+    if (!connection->ReadLine(&line)) {
+      *error = "connection closed in the response head";
+      return false;
+    }
+    if (line.empty()) {
+      return true;
+    }
+    if (response->headers.size() == kMaxHeaderLines) {
+      *error = "too many response headers";
+      return false;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    std::string_view view(line);
+    response->headers.push_back(
+        HttpHeader{std::string(Trim(view.substr(0, colon))),
+                   std::string(Trim(view.substr(colon + 1)))});
+  }
+}
+
+bool ReadFixed(HttpConnection* connection,
+               int64_t length,
+               const HttpBodyCallback& on_body,
+               bool* stopped) {
+  char buffer[kBodyBufferSize];
+  while (length > 0) {
+    size_t want = length < static_cast<int64_t>(sizeof(buffer))
+                      ? static_cast<size_t>(length)
+                      : sizeof(buffer);
+    ssize_t read = connection->Read(buffer, want);
+    if (read <= 0) {
+      return false;
+    }
+    length -= read;
+    if (!on_body(buffer, static_cast<size_t>(read))) {
+      *stopped = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+bool ReadChunked(HttpConnection* connection,
+                 const HttpBodyCallback& on_body,
+                 bool* stopped) {
+  std::string line;
+  while (true) {
+    if (!connection->ReadLine(&line)) {
+      return false;
+    }
+    char* end = nullptr;
+    int64_t size = std::strtoll(line.c_str(), &end, 16);
+    if (end == line.c_str() || size < 0) {
+      return false;
+    }
+    if (size == 0) {
+      // Skip trailers up to the blank line.
+      while (connection->ReadLine(&line)) {
+        if (line.empty()) {
+          return true;
+        }
+      }
+      return false;
+    }
+    if (!ReadFixed(connection, size, on_body, stopped)) {
+      return false;
+    }
+    if (*stopped) {
+      return true;
+    }
+    if (!connection->ReadLine(&line) || !line.empty()) {
+      return false;
+    }
+  }
+}
+
+bool ReadUntilClose(HttpConnection* connection,
+                    const HttpBodyCallback& on_body,
+                    bool* stopped) {
+  char buffer[kBodyBufferSize];
+  while (true) {
+    ssize_t read = connection->Read(buffer, sizeof(buffer));
+    if (read < 0) {
+      return false;
+    }
+    if (read == 0) {
+      return true;
+    }
+    if (!on_body(buffer, static_cast<size_t>(read))) {
+      *stopped = true;
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (ToLower(a[i]) != ToLower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const std::string* HttpResponse::FindHeader(std::string_view name) const {
+  for (const HttpHeader& header : headers) {
+    if (EqualsIgnoreCase(header.name, name)) {
+      return &header.value;
+    }
+  }
+  return nullptr;
+}
+
+bool ParseHttpOrigin(std::string_view url, HttpOrigin* origin) {
+  Url parsed;
+  if (!ParseUrl(url, &parsed)) {
+    return false;
+  }
+  if (parsed.scheme == "https") {
+    origin->tls = true;
+  } else if (parsed.scheme == "http") {
+    origin->tls = false;
+  } else {
+    return false;
+  }
+  origin->host.assign(parsed.host);
+  origin->port.assign(parsed.port);
+  if (origin->port.empty()) {
+    origin->port = origin->tls ? "443" : "80";
+  }
+  origin->target.assign(parsed.path);
+  if (!parsed.query.empty()) {
+    origin->target += '?';
+    origin->target.append(parsed.query);
+  }
+  return true;
+}
+
+std::string ResolveUrl(std::string_view base, std::string_view location) {
+  if (location.find("://") != std::string_view::npos) {
+    return std::string(location);
+  }
+  Url parsed;
+  if (!ParseUrl(base, &parsed)) {
+    return std::string(location);
+  }
+  if (location.compare(0, 2, "//") == 0) {
+    return std::string(parsed.scheme) + ":" + std::string(location);
+  }
+  size_t authority_end = base.find_first_of("/?#", base.find("://") + 3);
+  std::string result(base.substr(0, authority_end));
+  if (location.empty() || location.front() != '/') {
+    // Relative to the directory of the base path.
+    result.append(parsed.path.substr(0, parsed.path.rfind('/')));
+    result += '/';
+  }
+  result.append(location);
+  return result;
+}
+
+bool SendHttpRequest(HttpConnection* connection,
+                     const HttpRequest& request,
+                     HttpResponse* response,
+                     const HttpBodyCallback& on_body,
+                     std::string* error) {
+  HttpOrigin origin;
+  if (!ParseHttpOrigin(request.url, &origin)) {
+    *error = "unsupported url";
+    return false;
+  }
+
+  std::string head;
+  head.reserve(256);
+  head += request.method;
+  head += ' ';
+  head += origin.target;
+  head += " HTTP/1.1\r\nHost: ";
+  head += origin.host;
+  if (origin.port != (origin.tls ? "443" : "80")) {
+    head += ':';
+    head += origin.port;
+  }
+  head += "\r\n";
+  for (const HttpHeader& header : request.headers) {
+    head += header.name;
+    head += ": ";
+    head += header.value;
+    head += "\r\n";
+  }
+  if (!request.body.empty() || request.method == "POST" ||
+      request.method == "PUT" || request.method == "PATCH") {
+    head += "Content-Length: ";
+    head += std::to_string(request.body.size());
+    head += "\r\n";
+  }
+  head += "\r\n";
+  head += request.body;
+  if (!connection->WriteAll(head)) {
+    *error = "cannot send the request";
+    return false;
+  }
+
+  bool http_1_0 = false;
+  do {
+    if (!ReadHead(connection, response, &http_1_0, error)) {
+      return false;
+    }
+    // Interim responses such as 100 Continue precede the real one.
+  } while (response->status >= 100 && response->status < 200);
+
+  const std::string* connection_header = response->FindHeader("Connection");
+  response->keep_alive =
+      http_1_0 ? connection_header != nullptr &&
+                     HasToken(*connection_header, "keep-alive")
+               : connection_header == nullptr ||
+                     !HasToken(*connection_header, "close");
+  response->content_length = -1;
+  response->complete = false;
+
+  if (request.method == "HEAD" || response->status == 204 ||
+      response->status == 304) {
+    response->complete = true;
+    return true;
+  }
+
+  bool stopped = false;
+  bool ok;
+  const std::string* transfer_encoding =
+      response->FindHeader("Transfer-Encoding");
+  const std::string* content_length = response->FindHeader("Content-Length");
+  if (transfer_encoding != nullptr &&
+      HasToken(*transfer_encoding, "chunked")) {
+    ok = ReadChunked(connection, on_body, &stopped);
+  } else if (content_length != nullptr) {
+    response->content_length = std::strtoll(content_length->c_str(), nullptr,
+                                            10);
+    ok = ReadFixed(connection, response->content_length, on_body, &stopped);
+  } else {
+    response->keep_alive = false;
+    ok = ReadUntilClose(connection, on_body, &stopped);
+  }
+  if (!ok) {
+    *error = "connection closed in the response body";
+    response->keep_alive = false;
+    return false;
+  }
+  response->complete = !stopped;
+  if (stopped) {
+    response->keep_alive = false;
+  }
+  return true;
+}
+
+}  // namespace flutter_cookie_bridge
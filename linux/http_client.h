@@ -0,0 +1,85 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_HTTP_CLIENT_H_
+#define FLUTTER_COOKIE_BRIDGE_HTTP_CLIENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_connection.h"
+
+namespace flutter_cookie_bridge {
+
+struct HttpHeader {
+  std::string name;
+  std::string value;
+};
+
+struct HttpRequest {
+  std::string method = "GET";
+  // Absolute http(s) URL.
+  std::string url;
+  std::vector<HttpHeader> headers;
+  std::string body;
+};
+
+struct HttpResponse {
+  int status = 0;
+  std::vector<HttpHeader> headers;
+  // From Content-Length, or -1 when the body is chunked or delimited by the
+  // end of the connection.
+  int64_t content_length = -1;
+  // Whether the whole body was read and the connection may carry another
+  // request.
+  bool keep_alive = false;
+  // Whether the whole body was read, as opposed to the body callback
+  // stopping early.
+  bool complete = false;
+  // The content coding the body was decoded from by SendWithCompression,
+  // or empty when it arrived as it is.
+  std::string decoded_from;
+
+  // Returns the value of the first header called |name|, compared
+  // case-insensitively, or null.
+  const std::string* FindHeader(std::string_view name) const;
+};
+
+// Receives the response body in pieces. Returning false stops reading; the
+// connection is then left in an undefined state and must be closed.
+using HttpBodyCallback = std::function<bool(const char* data, size_t size)>;
+
+// The URL components a request is routed by.
+struct HttpOrigin {
+  std::string host;
+  std::string port;
+  bool tls = false;
+  // The request target: path and query.
+  std::string target;
+};
+
+// Splits |url| into an origin and request target. Returns false for
+// anything but an absolute http or https URL.
+bool ParseHttpOrigin(std::string_view url, HttpOrigin* origin);
+
+// Resolves |location|, as found in a Location header, against |base|.
+std::string ResolveUrl(std::string_view base, std::string_view location);
+
+// Sends |request| over |connection|, which must already be connected to the
+// request's origin, and streams the response body to |on_body|. Handles
+// Content-Length, chunked and close-delimited bodies. Returns false and sets
+// |error| when no complete response head could be read or the body was cut
+// short.
+bool SendHttpRequest(HttpConnection* connection,
+                     const HttpRequest& request,
+                     HttpResponse* response,
+                     const HttpBodyCallback& on_body,
+                     std::string* error);
+
+// Returns true when |a| and |b| are equal ignoring ASCII case.
+bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_HTTP_CLIENT_H_
@@ -0,0 +1,305 @@
+#include "http_connection.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr size_t kReadBufferSize = 16 * 1024;
+
+// Hands a session ticket to the connection it arrived on, whose slot for it
+// is the SSL object's app data. Returning 1 keeps the reference.
+int OnNewSession(SSL* ssl, SSL_SESSION* session) {
+  SSL_SESSION** slot = static_cast<SSL_SESSION**>(SSL_get_app_data(ssl));
+  if (slot == nullptr) {
+    return 0;
+  }
+  if (*slot != nullptr) {
+    SSL_SESSION_free(*slot);
+  }
+  *slot = session;
+  return 1;
+}
+
+// One client context for the whole process; OpenSSL contexts are
+// thread-safe once configured. Sessions are not cached by OpenSSL itself:
+// the callers that pool connections keep them per origin.
+SSL_CTX* TlsContext() {
+  static SSL_CTX* context = [] {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    if (ctx != nullptr) {
+      SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+      SSL_CTX_set_default_verify_paths(ctx);
+      SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+      SSL_CTX_set_session_cache_mode(
+          ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(ctx, OnNewSession);
+    }
+    return ctx;
+  }();
+  return context;
+}
+
+std::string TlsError(const char* what) {
+  char detail[256];
+  ERR_error_string_n(ERR_get_error(), detail, sizeof(detail));
+  return std::string(what) + ": " + detail;
+}
+
+// Connects |fd| to |address| within |timeout_ms|.
+bool ConnectWithTimeout(int fd,
+                        const sockaddr* address,
+                        socklen_t length,
+                        int timeout_ms) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  int result = connect(fd, address, length);
+  if (result != 0 && errno == EINPROGRESS) {
+    pollfd poll_fd = {fd, POLLOUT, 0};
+    result = poll(&poll_fd, 1, timeout_ms);
+    if (result == 1) {
+      int error = 0;
+      socklen_t error_length = sizeof(error);
+      getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length);
+      result = error == 0 ? 0 : -1;
+    } else {
+      result = -1;
+    }
+  }
+  fcntl(fd, F_SETFL, flags);
+  return result == 0;
+}
+
+}  // namespace
+
+bool HttpConnection::AddTrustedCertificates(const std::string& pem) {
+  SSL_CTX* context = TlsContext();
+  BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+  if (context == nullptr || bio == nullptr) {
+    BIO_free(bio);
+    return false;
+  }
+  X509_STORE* store = SSL_CTX_get_cert_store(context);
+  int added = 0;
+  while (X509* certificate = PEM_read_bio_X509(bio, nullptr, nullptr,
+                                               nullptr)) {
+    added += X509_STORE_add_cert(store, certificate);
+    X509_free(certificate);
+  }
+  // Reading stops with an end-of-file error.
+  ERR_clear_error();
+  BIO_free(bio);
+  return added > 0;
+}
+
+HttpConnection::HttpConnection() = default;
+
+HttpConnection::~HttpConnection() {
+  Close();
+}
+
+bool HttpConnection::Connect(const std::string& host,
+                             const std::string& port,
+                             bool tls,
+                             int timeout_ms,
+                             std::string* error,
+                             SSL_SESSION* session) {
+  Close();
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  int resolved = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+  if (resolved != 0) {
+    *error = std::string("cannot resolve ") + host + ": " +
+             gai_strerror(resolved);
+    return false;
+  }
+  for (addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC,
+                    address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (ConnectWithTimeout(fd, address->ai_addr, address->ai_addrlen,
+                           timeout_ms)) {
+      fd_ = fd;
+      break;
+    }
+    close(fd);
+  }
+  freeaddrinfo(addresses);
+  if (fd_ < 0) {
+    *error = "cannot connect to " + host + ":" + port;
+    return false;
+  }
+
+  timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+  setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  int one = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (!tls) {
+    return true;
+  }
+  SSL_CTX* context = TlsContext();
+  if (context == nullptr || (ssl_ = SSL_new(context)) == nullptr) {
+    *error = TlsError("cannot create TLS session");
+    Close();
+    return false;
+  }
+  SSL_set_fd(ssl_, fd_);
+  SSL_set_app_data(ssl_, &session_);
+  SSL_set_tlsext_host_name(ssl_, host.c_str());
+  SSL_set1_host(ssl_, host.c_str());
+  if (session != nullptr) {
+    SSL_set_session(ssl_, session);
+  }
+  if (SSL_connect(ssl_) != 1) {
+    *error = TlsError(("TLS handshake with " + host + " failed").c_str());
+    Close();
+    return false;
+  }
+  tls_resumed_ = SSL_session_reused(ssl_) == 1;
+  return true;
+}
+
+bool HttpConnection::WriteAll(std::string_view data) {
+  while (!data.empty()) {
+    ssize_t written;
+    if (ssl_ != nullptr) {
+      written = SSL_write(ssl_, data.data(), static_cast<int>(data.size()));
+    } else {
+      written = send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+    }
+    if (written <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+ssize_t HttpConnection::ReadRaw(char* data, size_t size) {
+  if (ssl_ != nullptr) {
+    int read = SSL_read(ssl_, data, static_cast<int>(size));
+    if (read > 0) {
+      return read;
+    }
+    return SSL_get_error(ssl_, read) == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+  }
+  while (true) {
+    ssize_t read = recv(fd_, data, size, 0);
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+    return read;
+  }
+}
+
+ssize_t HttpConnection::Read(char* data, size_t size) {
+  if (buffer_offset_ < buffer_.size()) {
+    size_t available = buffer_.size() - buffer_offset_;
+    size_t count = available < size ? available : size;
+    std::memcpy(data, buffer_.data() + buffer_offset_, count);
+    buffer_offset_ += count;
+    return static_cast<ssize_t>(count);
+  }
+  return ReadRaw(data, size);
+}
+
+bool HttpConnection::ReadLine(std::string* line, size_t max_length) {
+  line->clear();
+  while (true) {
+    if (buffer_offset_ == buffer_.size()) {
+      buffer_.resize(kReadBufferSize);
+      ssize_t read = ReadRaw(&buffer_[0], buffer_.size());
+      if (read <= 0) {
+        buffer_.clear();
+        buffer_offset_ = 0;
+        return false;
+      }
+      buffer_.resize(static_cast<size_t>(read));
+      buffer_offset_ = 0;
+    }
+    const char* start = buffer_.data() + buffer_offset_;
+    size_t available = buffer_.size() - buffer_offset_;
+    const void* newline = std::memchr(start, '\n', available);
+    size_t count = newline != nullptr
+                       ? static_cast<const char*>(newline) - start
+                       : available;
+    line->append(start, count);
+    buffer_offset_ += count;
+    if (line->size() > max_length) {
+      return false;
+    }
+    if (newline != nullptr) {
+      ++buffer_offset_;
+      if (!line->empty() && line->back() == '\r') {
+        line->pop_back();
+      }
+      return true;
+    }
+  }
+}
+
+bool HttpConnection::IsIdleUsable() const {
+  if (fd_ < 0 || buffer_offset_ < buffer_.size() ||
+      (ssl_ != nullptr && SSL_pending(ssl_) > 0)) {
+    return false;
+  }
+  // Readable means end of stream, a reset, or bytes nobody asked for.
+  pollfd poll_fd = {fd_, POLLIN, 0};
+  return poll(&poll_fd, 1, 0) == 0;
+}
+
+SSL_SESSION* HttpConnection::TakeTlsSession() {
+  if (session_ == nullptr) {
+    return nullptr;
+  }
+  // A copy, because OpenSSL marks the session of a connection that is
+  // closed without a TLS shutdown as not resumable.
+  SSL_SESSION* session = SSL_SESSION_dup(session_);
+  SSL_SESSION_free(session_);
+  session_ = nullptr;
+  return session;
+}
+
+void HttpConnection::Close() {
+  if (ssl_ != nullptr) {
+    SSL_free(ssl_);
+    ssl_ = nullptr;
+  }
+  if (session_ != nullptr) {
+    SSL_SESSION_free(session_);
+    session_ = nullptr;
+  }
+  tls_resumed_ = false;
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  buffer_.clear();
+  buffer_offset_ = 0;
+}
+
+}  // namespace flutter_cookie_bridge
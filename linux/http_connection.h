@@ -0,0 +1,88 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_HTTP_CONNECTION_H_
+#define FLUTTER_COOKIE_BRIDGE_HTTP_CONNECTION_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_session_st SSL_SESSION;
+
+namespace flutter_cookie_bridge {
+
+// A blocking TCP connection to one origin, optionally over TLS, with a read
+// buffer for parsing HTTP/1.1 framing.
+//
+// TLS peers are verified against the system trust store and the host name.
+class HttpConnection {
+ public:
+  // Trusts the PEM certificates in |pem| in addition to the system store,
+  // for servers behind a private CA. Affects connections made afterwards.
+  static bool AddTrustedCertificates(const std::string& pem);
+
+  HttpConnection();
+  ~HttpConnection();
+
+  HttpConnection(const HttpConnection&) = delete;
+  HttpConnection& operator=(const HttpConnection&) = delete;
+
+  // Connects to |host|:|port|, trying every resolved address in turn, and
+  // performs the TLS handshake when |tls| is set. |timeout_ms| bounds the
+  // connect and every later read or write. When |session| is given, from
+  // TakeTlsSession on an earlier connection to the same origin, the
+  // handshake offers to resume it. On failure sets |error|.
+  bool Connect(const std::string& host,
+               const std::string& port,
+               bool tls,
+               int timeout_ms,
+               std::string* error,
+               SSL_SESSION* session = nullptr);
+
+  // Writes all of |data|. Returns false on error.
+  bool WriteAll(std::string_view data);
+
+  // Reads up to |size| bytes, serving buffered bytes first. Returns the
+  // number of bytes read, 0 at end of stream and -1 on error.
+  ssize_t Read(char* data, size_t size);
+
+  // Reads a line terminated by CRLF (or a bare LF) into |line|, without the
+  // terminator. Returns false on error or end of stream, or when the line
+  // exceeds |max_length|.
+  bool ReadLine(std::string* line, size_t max_length = 64 * 1024);
+
+  void Close();
+
+  // Whether an idle connection can carry another request: it is open,
+  // nothing unread is buffered, and the peer has neither closed it nor sent
+  // anything unasked.
+  bool IsIdleUsable() const;
+
+  // Returns the newest session ticket the server issued on this connection,
+  // which the caller then owns, or null. With TLS 1.3 tickets arrive after
+  // the handshake, so this is best called once a response has been read.
+  SSL_SESSION* TakeTlsSession();
+
+  bool is_open() const { return fd_ >= 0; }
+  bool is_tls() const { return ssl_ != nullptr; }
+  // Whether the TLS handshake resumed an earlier session instead of doing a
+  // full key exchange.
+  bool tls_resumed() const { return tls_resumed_; }
+
+ private:
+  // Reads from the socket, bypassing the buffer.
+  ssize_t ReadRaw(char* data, size_t size);
+
+  int fd_ = -1;
+  SSL* ssl_ = nullptr;
+  bool tls_resumed_ = false;
+  // Filled in by OpenSSL's new-session callback.
+  SSL_SESSION* session_ = nullptr;
+  std::string buffer_;
+  size_t buffer_offset_ = 0;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_HTTP_CONNECTION_H_
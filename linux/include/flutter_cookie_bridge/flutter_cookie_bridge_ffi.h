@@ -0,0 +1,145 @@
+#ifndef FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_FFI_H_
+#define FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_FFI_H_
+
+// C entry points of the plugin library that Dart calls through dart:ffi.
+//
+// These bypass the method channel entirely, so they can be called from any
+// isolate and return synchronously. Strings cross the boundary as UTF-8
+// buffers owned by the caller; results refer back into those buffers with
+// FlutterCookieBridgeSpan offsets instead of copying.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef FLUTTER_PLUGIN_IMPL
+#define FLUTTER_COOKIE_BRIDGE_FFI_EXPORT \
+  __attribute__((visibility("default")))
+#else
+#define FLUTTER_COOKIE_BRIDGE_FFI_EXPORT
+#endif
+
+// A byte range inside a caller-owned buffer.
+typedef struct {
+  uint32_t offset;
+  uint32_t length;
+} FlutterCookieBridgeSpan;
+
+// One parsed Set-Cookie header. Spans are relative to the start of the
+// header they came from. |flags| and |same_site| use the values of
+// SetCookieFlag and SameSite in set_cookie_parser.h.
+typedef struct {
+  FlutterCookieBridgeSpan name;
+  FlutterCookieBridgeSpan value;
+  FlutterCookieBridgeSpan domain;
+  FlutterCookieBridgeSpan path;
+  int64_t expires;
+  int64_t max_age;
+  uint32_t flags;
+  uint32_t same_site;
+} FlutterCookieBridgeSetCookie;
+
+// Parses |count| Set-Cookie header values laid out back to back in |data|,
+// where |lengths| holds the byte length of each. Writes one entry per header
+// to |out|; a header that carries no cookie gets an empty name. Returns the
+// number of headers that carried a cookie.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_parse_set_cookies(
+    const char* data,
+    const uint32_t* lengths,
+    int32_t count,
+    FlutterCookieBridgeSetCookie* out);
+
+// Splits a Cookie request header such as "a=1; b=2" into name/value pairs,
+// writing up to |capacity| pairs to |out| as consecutive name and value
+// spans. Returns the total number of pairs, which may exceed |capacity|.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_parse_cookie_header(
+    const char* data,
+    uint32_t length,
+    FlutterCookieBridgeSpan* out,
+    int32_t capacity);
+
+// Stores the cookies of |count| Set-Cookie header values, laid out as for
+// flutter_cookie_bridge_parse_set_cookies, received in a response to the
+// |url_length| bytes at |url|. Uses the process-wide jar that the plugin
+// persists and every isolate shares. Returns the number of cookies stored or
+// removed.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_jar_set_cookies(
+    const char* url,
+    uint32_t url_length,
+    const char* data,
+    const uint32_t* lengths,
+    int32_t count);
+
+// Writes up to |capacity| bytes of the Cookie header the process-wide jar
+// holds for |url| to |out|, without a terminating NUL. Returns the full
+// length of the header, which may exceed |capacity|; call again with a
+// larger buffer then. Never blocks on writers.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_jar_get_cookie_header(
+    const char* url,
+    uint32_t url_length,
+    char* out,
+    int32_t capacity);
+
+// Writes the number of cookies the process-wide jar removed because they
+// expired to |expired|, and the number it evicted to stay within its limits
+// to |evicted|.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT void flutter_cookie_bridge_jar_stats(
+    uint64_t* expired,
+    uint64_t* evicted);
+
+// Compiles |count| substring patterns, laid out back to back in |data| as
+// for flutter_cookie_bridge_parse_set_cookies, into a matcher; see
+// url_pattern_set.h. |tags| holds the mask bits each pattern reports. The
+// matcher is freed with flutter_cookie_bridge_patterns_free.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT void* flutter_cookie_bridge_patterns_create(
+    const char* data,
+    const uint32_t* lengths,
+    const uint32_t* tags,
+    int32_t count);
+
+// Returns the union of the tags of the patterns that occur in the
+// |url_length| bytes at |url|, in one pass over them.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT uint32_t
+flutter_cookie_bridge_patterns_match(const void* patterns,
+                                     const char* url,
+                                     uint32_t url_length);
+
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT void flutter_cookie_bridge_patterns_free(
+    void* patterns);
+
+// Tracing of the runner, the plugin and Dart into one buffer of the
+// process; see trace.h. Turns span recording on or off.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT void flutter_cookie_bridge_trace_set_enabled(
+    int32_t enabled);
+
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_trace_enabled(void);
+
+// Microseconds on the clock spans are measured with.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int64_t flutter_cookie_bridge_trace_now(void);
+
+// Records a span of the calling thread from |start_us| to |end_us|, if
+// tracing is on. |name| is NUL-terminated and must stay valid for the life
+// of the process.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT void flutter_cookie_bridge_trace_record(
+    const char* name,
+    int64_t start_us,
+    int64_t end_us);
+
+// Writes up to |capacity| bytes of the recorded spans, as Chrome trace-event
+// JSON, to |out| without a terminating NUL. Returns the full length, which
+// may exceed |capacity|; call again with a larger buffer then.
+FLUTTER_COOKIE_BRIDGE_FFI_EXPORT int32_t
+flutter_cookie_bridge_trace_export(char* out, int32_t capacity);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_FFI_H_
@@ -0,0 +1,39 @@
+#ifndef FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_H_
+#define FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+G_BEGIN_DECLS
+
+#ifdef FLUTTER_PLUGIN_IMPL
+#define FLUTTER_PLUGIN_EXPORT __attribute__((visibility("default")))
+#else
+#define FLUTTER_PLUGIN_EXPORT
+#endif
+
+typedef struct _FlutterCookieBridgePlugin FlutterCookieBridgePlugin;
+typedef struct {
+  GObjectClass parent_class;
+} FlutterCookieBridgePluginClass;
+
+FLUTTER_PLUGIN_EXPORT GType flutter_cookie_bridge_plugin_get_type();
+
+FLUTTER_PLUGIN_EXPORT void flutter_cookie_bridge_plugin_register_with_registrar(
+    FlPluginRegistrar* registrar);
+
+// Starts reading the persistent cookie store on a background thread. Call
+// it from the runner's local_command_line, before the engine starts, so the
+// jar is warm by the time the app makes its first request; registering the
+// plugin then picks up the load rather than reading the store again.
+FLUTTER_PLUGIN_EXPORT void flutter_cookie_bridge_plugin_preload_cookies();
+
+// Turns tracing on if |arguments|, the Dart entrypoint arguments, contain
+// --trace-cookie-bridge, and returns whether it is on. Spans are recorded
+// with flutter_cookie_bridge_trace_record from flutter_cookie_bridge_ffi.h.
+FLUTTER_PLUGIN_EXPORT gboolean
+flutter_cookie_bridge_plugin_trace_from_arguments(
+    const gchar* const* arguments);
+
+G_END_DECLS
+
+#endif  // FLUTTER_PLUGIN_FLUTTER_COOKIE_BRIDGE_PLUGIN_H_
@@ -0,0 +1,594 @@
+#include "json_document.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+uint64_t Word(char type, uint64_t payload = 0) {
+  return static_cast<uint64_t>(static_cast<unsigned char>(type))
+             << JsonDocument::kTypeShift |
+         payload;
+}
+
+bool IsSpecial(unsigned char c) {
+  return c == '"' || c == '\\' || c < 0x20;
+}
+
+// The first quote, backslash or control character of |data| at or after
+// |from|, or |size|.
+size_t FindStringSpecial(const char* data, size_t size, size_t from) {
+#if defined(__SSE2__)
+  const __m128i quotes = _mm_set1_epi8('"');
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  const __m128i controls = _mm_set1_epi8(0x1f);
+  while (from + 16 <= size) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+    // Bytes up to 0x1f are those the unsigned maximum leaves at 0x1f.
+    __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quotes),
+                     _mm_cmpeq_epi8(chunk, backslashes)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, controls), controls));
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return from + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    from += 16;
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t quotes = vdupq_n_u8('"');
+  const uint8x16_t backslashes = vdupq_n_u8('\\');
+  const uint8x16_t controls = vdupq_n_u8(0x1f);
+  while (from + 16 <= size) {
+    uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + from));
+    uint8x16_t hits = vorrq_u8(
+        vorrq_u8(vceqq_u8(chunk, quotes), vceqq_u8(chunk, backslashes)),
+        vcleq_u8(chunk, controls));
+    if (vmaxvq_u8(hits) != 0) {
+      break;  // The scalar loop below pinpoints the hit within this block.
+    }
+    from += 16;
+  }
+#endif
+  for (; from < size; ++from) {
+    if (IsSpecial(static_cast<unsigned char>(data[from]))) {
+      return from;
+    }
+  }
+  return size;
+}
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Reads the four hex digits at |data|. Returns -1 when they are not.
+int32_t ReadHex4(const char* data) {
+  int32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    int digit = HexValue(data[i]);
+    if (digit < 0) {
+      return -1;
+    }
+    value = value << 4 | digit;
+  }
+  return value;
+}
+
+void AppendUtf8(uint32_t code_point, std::string* out) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | code_point >> 6));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | code_point >> 12));
+    out->push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | code_point >> 18));
+    out->push_back(static_cast<char>(0x80 | (code_point >> 12 & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+// Appends the contents of a string, |data| between the quotes, with its
+// escapes resolved. Returns false on an invalid escape.
+bool Unescape(const char* data, size_t size, std::string* out) {
+  size_t pos = 0;
+  while (pos < size) {
+    const void* backslash = memchr(data + pos, '\\', size - pos);
+    size_t end = backslash == nullptr
+                     ? size
+                     : static_cast<const char*>(backslash) - data;
+    out->append(data + pos, end - pos);
+    if (end == size) {
+      return true;
+    }
+    // The scan that found the closing quote made sure every escape is
+    // complete.
+    char escape = data[end + 1];
+    pos = end + 2;
+    switch (escape) {
+      case '"':
+      case '\\':
+      case '/':
+        out->push_back(escape);
+        break;
+      case 'b':
+        out->push_back('\b');
+        break;
+      case 'f':
+        out->push_back('\f');
+        break;
+      case 'n':
+        out->push_back('\n');
+        break;
+      case 'r':
+        out->push_back('\r');
+        break;
+      case 't':
+        out->push_back('\t');
+        break;
+      case 'u': {
+        int32_t unit = ReadHex4(data + pos);
+        if (unit < 0) {
+          return false;
+        }
+        pos += 4;
+        uint32_t code_point = static_cast<uint32_t>(unit);
+        if (unit >= 0xd800 && unit < 0xdc00 && pos + 6 <= size &&
+            data[pos] == '\\' && data[pos + 1] == 'u') {
+          int32_t low = ReadHex4(data + pos + 2);
+          if (low >= 0xdc00 && low < 0xe000) {
+            code_point = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+            pos += 6;
+          }
+        }
+        if (code_point >= 0xd800 && code_point < 0xe000) {
+          // A lone surrogate has no UTF-8 form.
+          code_point = 0xfffd;
+        }
+        AppendUtf8(code_point, out);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+char JsonDocument::Value::type() const {
+  return static_cast<char>(word() >> kTypeShift);
+}
+
+int64_t JsonDocument::Value::AsInt() const {
+  switch (type()) {
+    case 'l':
+      return static_cast<int64_t>(word(1));
+    case 'd':
+      return static_cast<int64_t>(AsDouble());
+    default:
+      return 0;
+  }
+}
+
+double JsonDocument::Value::AsDouble() const {
+  switch (type()) {
+    case 'l':
+      return static_cast<double>(static_cast<int64_t>(word(1)));
+    case 'd': {
+      uint64_t bits = word(1);
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    default:
+      return 0;
+  }
+}
+
+std::string_view JsonDocument::Value::AsString() const {
+  if (type() != 's') {
+    return {};
+  }
+  return std::string_view(document_->strings_.data() + (word() & kPayloadMask),
+                          word(1));
+}
+
+size_t JsonDocument::Value::size() const {
+  char t = type();
+  return t == '{' || t == '[' ? word(1) : 0;
+}
+
+size_t JsonDocument::Value::Next() const {
+  switch (type()) {
+    case 'n':
+    case 't':
+    case 'f':
+      return index_ + 1;
+    case '{':
+    case '[':
+      return word() & kPayloadMask;
+    default:
+      return index_ + 2;
+  }
+}
+
+bool JsonDocument::Value::Find(std::string_view key, Value* value) const {
+  if (type() != '{') {
+    return false;
+  }
+  size_t index = index_ + 2;
+  for (size_t i = 0; i < size(); ++i) {
+    Value member(document_, index + 2);
+    if (Value(document_, index).AsString() == key) {
+      *value = member;
+      return true;
+    }
+    index = member.Next();
+  }
+  return false;
+}
+
+JsonDocument::Value JsonDocument::Value::At(size_t index, bool key) const {
+  bool object = type() == '{';
+  size_t at = index_ + 2;
+  for (size_t i = 0; i < index; ++i) {
+    at = Value(document_, object ? at + 2 : at).Next();
+  }
+  return Value(document_, object && !key ? at + 2 : at);
+}
+
+bool JsonParser::Feed(const char* data, size_t size) {
+  if (state_ == State::kFailed) {
+    return false;
+  }
+  base_ = offset_;
+  if (buffer_.empty()) {
+    // Parse in place, keeping only a value cut by the end of |data|.
+    size_t consumed = Parse(data, size, false);
+    offset_ += consumed;
+    buffer_.assign(data + consumed, size - consumed);
+  } else {
+    buffer_.append(data, size);
+    size_t consumed = Parse(buffer_.data(), buffer_.size(), false);
+    offset_ += consumed;
+    buffer_.erase(0, consumed);
+  }
+  return state_ != State::kFailed;
+}
+
+bool JsonParser::Finish(JsonDocument* document) {
+  if (state_ == State::kFailed) {
+    return false;
+  }
+  base_ = offset_;
+  size_t consumed = Parse(buffer_.data(), buffer_.size(), true);
+  if (state_ == State::kFailed) {
+    return false;
+  }
+  if (consumed != buffer_.size() || state_ != State::kDone) {
+    return Fail(buffer_.size(), "Unexpected end of the text");
+  }
+  offset_ += consumed;
+  buffer_.clear();
+  *document = JsonDocument(std::move(tape_), std::move(strings_));
+  return true;
+}
+
+size_t JsonParser::Parse(const char* data, size_t size, bool last) {
+  size_t pos = 0;
+  while (true) {
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\n' ||
+                          data[pos] == '\r' || data[pos] == '\t')) {
+      ++pos;
+    }
+    if (pos == size) {
+      return pos;
+    }
+    const char c = data[pos];
+    size_t start = pos;
+    Token token = Token::kDone;
+    switch (state_) {
+      case State::kFailed:
+        return pos;
+      case State::kDone:
+        Fail(pos, "Unexpected data after the value");
+        return pos;
+      case State::kColon:
+        if (c != ':') {
+          Fail(pos, "Expected ':'");
+          return pos;
+        }
+        ++pos;
+        state_ = State::kValue;
+        continue;
+      case State::kCommaOrEnd: {
+        bool object = (tape_[open_.back()] >> JsonDocument::kTypeShift) == '{';
+        if (c == ',') {
+          ++pos;
+          state_ = object ? State::kKey : State::kValue;
+          continue;
+        }
+        if (c != (object ? '}' : ']')) {
+          Fail(pos, object ? "Expected ',' or '}'" : "Expected ',' or ']'");
+          return pos;
+        }
+        break;
+      }
+      case State::kKeyOrEnd:
+        if (c == '}') {
+          break;
+        }
+        [[fallthrough]];
+      case State::kKey:
+        if (c != '"') {
+          Fail(pos, "Expected a string key");
+          return pos;
+        }
+        token = ParseString(data, size, &pos);
+        if (token == Token::kDone) {
+          state_ = State::kColon;
+          continue;
+        }
+        break;
+      case State::kValueOrEnd:
+        if (c == ']') {
+          break;
+        }
+        [[fallthrough]];
+      case State::kValue:
+        token = ParseValue(data, size, &pos, last);
+        if (token == Token::kDone) {
+          continue;
+        }
+        break;
+    }
+    if (token == Token::kIncomplete) {
+      return start;
+    }
+    if (token == Token::kInvalid) {
+      return pos;
+    }
+    // The end of the open container.
+    size_t open = open_.back();
+    open_.pop_back();
+    tape_[open] |= tape_.size();
+    ++pos;
+    EndValue();
+  }
+}
+
+JsonParser::Token JsonParser::ParseValue(const char* data,
+                                         size_t size,
+                                         size_t* pos,
+                                         bool last) {
+  const char c = data[*pos];
+  if (c == '{' || c == '[') {
+    if (open_.size() >= max_depth_) {
+      Fail(*pos, "Too deeply nested");
+      return Token::kInvalid;
+    }
+    open_.push_back(tape_.size());
+    tape_.push_back(Word(c));
+    tape_.push_back(0);
+    ++*pos;
+    state_ = c == '{' ? State::kKeyOrEnd : State::kValueOrEnd;
+    return Token::kDone;
+  }
+  Token token;
+  if (c == '"') {
+    token = ParseString(data, size, pos);
+  } else if (c == '-' || IsDigit(c)) {
+    token = ParseNumber(data, size, pos, last);
+  } else if (c == 't') {
+    token = ParseLiteral(data, size, pos, "true", 't');
+  } else if (c == 'f') {
+    token = ParseLiteral(data, size, pos, "false", 'f');
+  } else if (c == 'n') {
+    token = ParseLiteral(data, size, pos, "null", 'n');
+  } else {
+    Fail(*pos, "Expected a value");
+    return Token::kInvalid;
+  }
+  if (token == Token::kDone) {
+    EndValue();
+  }
+  return token;
+}
+
+JsonParser::Token JsonParser::ParseString(const char* data,
+                                          size_t size,
+                                          size_t* pos) {
+  const size_t start = *pos + 1;
+  size_t at = start + scanned_;
+  bool escaped = scanned_ != 0;
+  while (true) {
+    at = FindStringSpecial(data, size, at);
+    if (at == size) {
+      scanned_ = at - start;
+      return Token::kIncomplete;
+    }
+    if (data[at] == '"') {
+      break;
+    }
+    if (data[at] != '\\') {
+      Fail(at, "Control character in a string");
+      return Token::kInvalid;
+    }
+    size_t length = at + 1 < size && data[at + 1] == 'u' ? 6 : 2;
+    if (at + length > size) {
+      // Resume at the backslash once the escape is complete.
+      scanned_ = at - start;
+      return Token::kIncomplete;
+    }
+    escaped = true;
+    at += length;
+  }
+  scanned_ = 0;
+  size_t offset = strings_.size();
+  if (!escaped) {
+    strings_.append(data + start, at - start);
+  } else if (!Unescape(data + start, at - start, &strings_)) {
+    Fail(*pos, "Invalid escape in a string");
+    return Token::kInvalid;
+  }
+  tape_.push_back(Word('s', offset));
+  tape_.push_back(strings_.size() - offset);
+  *pos = at + 1;
+  return Token::kDone;
+}
+
+JsonParser::Token JsonParser::ParseNumber(const char* data,
+                                          size_t size,
+                                          size_t* pos,
+                                          bool last) {
+  const size_t start = *pos;
+  size_t end = start;
+  while (end < size && (IsDigit(data[end]) || data[end] == '-' ||
+                        data[end] == '+' || data[end] == '.' ||
+                        data[end] == 'e' || data[end] == 'E')) {
+    ++end;
+  }
+  if (end == size && !last) {
+    return Token::kIncomplete;
+  }
+
+  // -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?
+  size_t at = start;
+  bool negative = data[at] == '-';
+  if (negative) {
+    ++at;
+  }
+  uint64_t magnitude = 0;
+  bool overflow = false;
+  size_t digits = at;
+  while (at < end && IsDigit(data[at])) {
+    uint64_t digit = static_cast<uint64_t>(data[at] - '0');
+    overflow = overflow || magnitude > (UINT64_MAX - digit) / 10;
+    magnitude = magnitude * 10 + digit;
+    ++at;
+  }
+  bool valid = at > digits && (data[digits] != '0' || at == digits + 1);
+  bool integer = true;
+  if (valid && at < end && data[at] == '.') {
+    integer = false;
+    size_t fraction = ++at;
+    while (at < end && IsDigit(data[at])) {
+      ++at;
+    }
+    valid = at > fraction;
+  }
+  if (valid && at < end && (data[at] == 'e' || data[at] == 'E')) {
+    integer = false;
+    ++at;
+    if (at < end && (data[at] == '+' || data[at] == '-')) {
+      ++at;
+    }
+    size_t exponent = at;
+    while (at < end && IsDigit(data[at])) {
+      ++at;
+    }
+    valid = at > exponent;
+  }
+  if (!valid || at != end) {
+    Fail(start, "Invalid number");
+    return Token::kInvalid;
+  }
+
+  constexpr uint64_t kMaxInt = uint64_t{INT64_MAX};
+  if (integer && !overflow &&
+      (magnitude <= kMaxInt || (negative && magnitude == kMaxInt + 1))) {
+    tape_.push_back(Word('l'));
+    tape_.push_back(negative ? ~magnitude + 1 : magnitude);
+  } else {
+    double value = 0;
+    std::from_chars_result result = std::from_chars(data + start, data + end,
+                                                    value);
+    if (result.ec == std::errc::invalid_argument) {
+      Fail(start, "Invalid number");
+      return Token::kInvalid;
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+      // As in Dart: too small rounds to zero, too large to infinity.
+      const char* e = std::find_if(data + start, data + end, [](char c) {
+        return c == 'e' || c == 'E';
+      });
+      value = e + 1 < data + end && e[1] == '-' ? 0.0 : HUGE_VAL;
+      if (negative) {
+        value = -value;
+      }
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    tape_.push_back(Word('d'));
+    tape_.push_back(bits);
+  }
+  *pos = end;
+  return Token::kDone;
+}
+
+JsonParser::Token JsonParser::ParseLiteral(const char* data,
+                                           size_t size,
+                                           size_t* pos,
+                                           std::string_view literal,
+                                           char type) {
+  size_t available = std::min(size - *pos, literal.size());
+  if (std::string_view(data + *pos, available) !=
+      literal.substr(0, available)) {
+    Fail(*pos, "Expected a value");
+    return Token::kInvalid;
+  }
+  if (available < literal.size()) {
+    return Token::kIncomplete;
+  }
+  tape_.push_back(Word(type));
+  *pos += literal.size();
+  return Token::kDone;
+}
+
+void JsonParser::EndValue() {
+  if (open_.empty()) {
+    state_ = State::kDone;
+    return;
+  }
+  ++tape_[open_.back() + 1];
+  state_ = State::kCommaOrEnd;
+}
+
+bool JsonParser::Fail(size_t pos, const char* message) {
+  state_ = State::kFailed;
+  error_ = std::string(message) + " at byte " + std::to_string(base_ + pos);
+  return false;
+}
+
+}  // namespace flutter_cookie_bridge
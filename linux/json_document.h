@@ -0,0 +1,174 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_JSON_DOCUMENT_H_
+#define FLUTTER_COOKIE_BRIDGE_JSON_DOCUMENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+// A parsed JSON text as a tape: one flat array of 64-bit words that lists
+// the values in document order, with the bytes of every string in a second
+// array. Both are plain typed data, so a document crosses to Dart as two
+// buffers, and Dart reads the values it is asked for straight off the tape
+// instead of building the whole tree.
+//
+// The top byte of a word is the type of a value, the 56 bits below it the
+// payload:
+//   'n', 't', 'f'  null, true and false; one word.
+//   'l', 'd'       an int64 or a double; the value is in the next word.
+//   's'            a string; the payload is its offset in strings(), the
+//                  next word its length in bytes.
+//   '{', '['       an object or an array; the payload is the index of the
+//                  word after its last value, the next word its number of
+//                  members. The values follow, keys before values.
+// The root value starts at index 0.
+class JsonDocument {
+ public:
+  static constexpr int kTypeShift = 56;
+  static constexpr uint64_t kPayloadMask = (uint64_t{1} << kTypeShift) - 1;
+
+  // A value of the document. Cheap to copy; valid as long as the document.
+  class Value {
+   public:
+    Value(const JsonDocument* document, size_t index)
+        : document_(document), index_(index) {}
+
+    // One of the type bytes above.
+    char type() const;
+    bool is_null() const { return type() == 'n'; }
+    bool AsBool() const { return type() == 't'; }
+    int64_t AsInt() const;
+    // Ints convert.
+    double AsDouble() const;
+    std::string_view AsString() const;
+
+    // The number of members of an object or an array.
+    size_t size() const;
+
+    // Finds the value of member |key| of an object. Returns false when it
+    // has none.
+    bool Find(std::string_view key, Value* value) const;
+
+    // The |index|th value of an array, or the key of the |index|th member
+    // of an object when |key| is set and its value otherwise.
+    Value At(size_t index, bool key = false) const;
+
+   private:
+    uint64_t word(size_t offset = 0) const {
+      return document_->tape_[index_ + offset];
+    }
+    // The index of the value after this one.
+    size_t Next() const;
+
+    const JsonDocument* document_;
+    size_t index_;
+  };
+
+  JsonDocument() = default;
+  JsonDocument(std::vector<uint64_t> tape, std::string strings)
+      : tape_(std::move(tape)), strings_(std::move(strings)) {}
+
+  Value root() const { return Value(this, 0); }
+
+  const std::vector<uint64_t>& tape() const { return tape_; }
+  const std::string& strings() const { return strings_; }
+
+ private:
+  std::vector<uint64_t> tape_;
+  std::string strings_;
+};
+
+// Parses a JSON text (RFC 8259) into a JsonDocument as its bytes arrive, so
+// that a response body is parsed while the rest of it is still in flight
+// and never held in full.
+//
+// Only a value cut by the end of a piece is kept over to the next one; the
+// rest of each piece is consumed in place. String contents are scanned 16
+// bytes at a time with SSE2 or NEON for the quote, backslash or control
+// character that ends a run of plain bytes, which is copied as is. Bytes
+// above 0x7f are not checked to be valid UTF-8.
+class JsonParser {
+ public:
+  // Containers nested deeper than |max_depth| are refused.
+  explicit JsonParser(size_t max_depth = 1024) : max_depth_(max_depth) {}
+
+  JsonParser(const JsonParser&) = delete;
+  JsonParser& operator=(const JsonParser&) = delete;
+
+  // Parses the next |size| bytes of the text. Returns false once the text
+  // is known to be invalid; see error().
+  bool Feed(const char* data, size_t size);
+
+  // Ends the text and moves the document to |document|. Returns false when
+  // the text is invalid or incomplete.
+  bool Finish(JsonDocument* document);
+
+  // Bytes fed so far.
+  uint64_t size() const { return offset_ + buffer_.size(); }
+
+  const std::string& error() const { return error_; }
+
+ private:
+  enum class State : uint8_t {
+    kValue,
+    // After '[': a value or ']'.
+    kValueOrEnd,
+    // After '{': a key or '}'.
+    kKeyOrEnd,
+    kKey,
+    kColon,
+    kCommaOrEnd,
+    kDone,
+    kFailed,
+  };
+
+  // What a Parse* call made of the bytes at the cursor.
+  enum class Token : uint8_t { kDone, kIncomplete, kInvalid };
+
+  // Parses what it can of |data|, which holds the rest of the text from
+  // absolute offset base_ on, all of it when |last| is set. Returns the
+  // number of bytes consumed; the rest is an incomplete value, or the text
+  // is invalid.
+  size_t Parse(const char* data, size_t size, bool last);
+
+  Token ParseValue(const char* data, size_t size, size_t* pos, bool last);
+  Token ParseString(const char* data, size_t size, size_t* pos);
+  Token ParseNumber(const char* data, size_t size, size_t* pos, bool last);
+  Token ParseLiteral(const char* data,
+                     size_t size,
+                     size_t* pos,
+                     std::string_view literal,
+                     char type);
+
+  // Counts the value just written as a member of the open container, or
+  // ends the text when there is none.
+  void EndValue();
+
+  // Fails the text with |message| about the byte at |pos| of the data
+  // being parsed.
+  bool Fail(size_t pos, const char* message);
+
+  const size_t max_depth_;
+  State state_ = State::kValue;
+  // Tape indexes of the open containers.
+  std::vector<size_t> open_;
+  std::vector<uint64_t> tape_;
+  std::string strings_;
+  // The unconsumed end of the text, which starts at absolute offset_.
+  std::string buffer_;
+  uint64_t offset_ = 0;
+  // The absolute offset of the data being parsed.
+  uint64_t base_ = 0;
+  // Bytes of the string at the start of buffer_ already known to hold no
+  // closing quote, so that a long string is not rescanned per piece.
+  size_t scanned_ = 0;
+  std::string error_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_JSON_DOCUMENT_H_
@@ -0,0 +1,102 @@
+#include "public_suffix.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+enum RuleKind : uint8_t {
+  kRule = 1 << 0,
+  kWildcard = 1 << 1,
+  kException = 1 << 2,
+};
+
+struct DafsaState {
+  uint16_t first_edge;
+  uint8_t edge_count;
+  uint8_t kinds;
+};
+
+struct DafsaEdge {
+  char label;
+  uint16_t target;
+};
+
+// The automaton tools/make_public_suffix_dafsa.py builds from
+// public_suffix_list.dat when the library is built: kDafsaStates,
+// kDafsaEdges and kDafsaStart. Edges of a state are consecutive and in label
+// order.
+#include "public_suffix_dafsa.inc"
+
+constexpr uint16_t kNoState = UINT16_MAX;
+
+uint16_t Step(uint16_t from, char c) {
+  const DafsaState& state = kDafsaStates[from];
+  for (size_t i = state.first_edge; i < state.first_edge + state.edge_count;
+       ++i) {
+    if (kDafsaEdges[i].label == c) {
+      return kDafsaEdges[i].target;
+    }
+    if (kDafsaEdges[i].label > c) {
+      break;
+    }
+  }
+  return kNoState;
+}
+
+}  // namespace
+
+std::string_view PublicSuffix(std::string_view host) {
+  // The implicit "*" rule: the last label is a public suffix.
+  size_t last_dot = host.rfind('.');
+  size_t suffix = last_dot == std::string_view::npos ? 0 : last_dot + 1;
+
+  // Walk the host backwards, checking the rules that end at each label.
+  uint16_t state = kDafsaStart;
+  for (size_t i = host.size(); i-- > 0;) {
+    state = Step(state, host[i]);
+    if (state == kNoState) {
+      break;
+    }
+    if (i > 0 && host[i - 1] != '.') {
+      continue;
+    }
+    uint8_t kinds = kDafsaStates[state].kinds;
+    if (kinds & kException) {
+      // An exception wins over every other rule, and leaves its own first
+      // label out of the suffix.
+      return host.substr(host.find('.', i) + 1);
+    }
+    if ((kinds & kRule) && i < suffix) {
+      suffix = i;
+    }
+    if ((kinds & kWildcard) && i >= 2) {
+      size_t dot = host.rfind('.', i - 2);
+      size_t start = dot == std::string_view::npos ? 0 : dot + 1;
+      if (start < suffix) {
+        suffix = start;
+      }
+    }
+  }
+  return host.substr(suffix);
+}
+
+bool IsPublicSuffix(std::string_view domain) {
+  return !domain.empty() && PublicSuffix(domain).size() == domain.size();
+}
+
+std::string_view RegistrableDomain(std::string_view host) {
+  std::string_view suffix = PublicSuffix(host);
+  if (suffix.size() + 2 > host.size()) {
+    return std::string_view();
+  }
+  // The dot before the suffix.
+  size_t dot = host.size() - suffix.size() - 1;
+  size_t start = host.rfind('.', dot - 1);
+  start = start == std::string_view::npos ? 0 : start + 1;
+  return start == dot ? std::string_view() : host.substr(start);
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,33 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_PUBLIC_SUFFIX_H_
+#define FLUTTER_COOKIE_BRIDGE_PUBLIC_SUFFIX_H_
+
+#include <string_view>
+
+namespace flutter_cookie_bridge {
+
+// Public suffixes ("com", "co.uk", "github.io"): domains under which anyone
+// can register names, so that no cookie may be scoped to them.
+//
+// The rules are those of the Public Suffix List (publicsuffix.org) checked
+// in as public_suffix_list.dat, compiled into a minimal DAFSA by
+// tools/make_public_suffix_dafsa.py when the library is built. To update
+// them, replace that file with the current list. As in the list's
+// algorithm, a top-level domain that no rule names is a public suffix all
+// the same.
+//
+// |host| is a canonical domain name as CanonicalHost returns it, not an IP
+// address.
+
+// Returns the public suffix of |host|, which may be |host| itself.
+std::string_view PublicSuffix(std::string_view host);
+
+// Returns true when |domain| is a public suffix.
+bool IsPublicSuffix(std::string_view domain);
+
+// Returns the public suffix of |host| plus one label ("example.co.uk" for
+// "www.example.co.uk"), or an empty view when |host| is a public suffix.
+std::string_view RegistrableDomain(std::string_view host);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_PUBLIC_SUFFIX_H_
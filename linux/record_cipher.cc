@@ -0,0 +1,238 @@
+#include "record_cipher.h"
+
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+
+#if defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+struct CipherContextDeleter {
+  void operator()(EVP_CIPHER_CTX* context) const {
+    EVP_CIPHER_CTX_free(context);
+  }
+};
+
+std::atomic<uint64_t> g_next_cipher_id{1};
+
+// A context of the calling thread, keyed for one cipher's key, algorithm
+// and direction. Setting up a context fetches the algorithm and expands the
+// key, which costs more than sealing a cookie, so each thread keeps one
+// per algorithm and direction and later records only change the nonce.
+// Loading decrypts on several threads at once, each with its own.
+class ThreadContexts {
+ public:
+  // Returns the context for |cipher_id|, or null when it still needs the
+  // key and algorithm, in which case |*context| is the one to set up.
+  EVP_CIPHER_CTX* Find(uint64_t cipher_id,
+                       uint8_t algorithm,
+                       bool encrypt,
+                       EVP_CIPHER_CTX** context) {
+    Slot& slot = slots_[algorithm & 1][encrypt ? 1 : 0];
+    if (slot.context == nullptr) {
+      slot.context.reset(EVP_CIPHER_CTX_new());
+    }
+    *context = slot.context.get();
+    if (slot.cipher_id == cipher_id) {
+      return slot.context.get();
+    }
+    slot.cipher_id = cipher_id;
+    return nullptr;
+  }
+
+  // Forgets the key of the slot, after setting it up failed.
+  void Reset(uint8_t algorithm, bool encrypt) {
+    slots_[algorithm & 1][encrypt ? 1 : 0].cipher_id = 0;
+  }
+
+ private:
+  struct Slot {
+    std::unique_ptr<EVP_CIPHER_CTX, CipherContextDeleter> context;
+    uint64_t cipher_id = 0;
+  };
+  Slot slots_[2][2];
+};
+
+thread_local ThreadContexts t_contexts;
+
+const EVP_CIPHER* CipherFor(uint8_t algorithm) {
+  switch (static_cast<CipherAlgorithm>(algorithm)) {
+    case CipherAlgorithm::kAes256Gcm:
+      return EVP_aes_256_gcm();
+    case CipherAlgorithm::kChaCha20Poly1305:
+      return EVP_chacha20_poly1305();
+  }
+  return nullptr;
+}
+
+bool ReadKey(int fd, CookieKey* key) {
+  // One byte more than a key, to tell a longer file apart.
+  unsigned char buffer[sizeof(CookieKey) + 1];
+  size_t filled = 0;
+  while (filled < sizeof(buffer)) {
+    ssize_t count = read(fd, buffer + filled, sizeof(buffer) - filled);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    filled += static_cast<size_t>(count);
+  }
+  bool ok = filled == sizeof(CookieKey);
+  if (ok) {
+    std::copy(buffer, buffer + sizeof(CookieKey), key->begin());
+  }
+  OPENSSL_cleanse(buffer, sizeof(buffer));
+  return ok;
+}
+
+}  // namespace
+
+StaticKeyProvider::~StaticKeyProvider() {
+  OPENSSL_cleanse(key_.data(), key_.size());
+}
+
+bool StaticKeyProvider::GetKey(CookieKey* key) {
+  *key = key_;
+  return true;
+}
+
+bool FileKeyProvider::GetKey(CookieKey* key) {
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    bool ok = ReadKey(fd, key);
+    close(fd);
+    return ok;
+  }
+  if (errno != ENOENT) {
+    return false;
+  }
+
+  // Written aside and linked into place, so that two processes starting at
+  // once agree on one key and a crash never leaves half a key behind.
+  CookieKey fresh;
+  if (RAND_bytes(fresh.data(), static_cast<int>(fresh.size())) != 1) {
+    return false;
+  }
+  std::string temp_path = path_ + ".XXXXXX";
+  fd = mkostemp(temp_path.data(), O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = write(fd, fresh.data(), fresh.size()) ==
+                static_cast<ssize_t>(fresh.size()) &&
+            fsync(fd) == 0;
+  close(fd);
+  bool linked = ok && link(temp_path.c_str(), path_.c_str()) == 0;
+  bool lost_race = ok && !linked && errno == EEXIST;
+  unlink(temp_path.c_str());
+  if (linked) {
+    *key = fresh;
+  }
+  OPENSSL_cleanse(fresh.data(), fresh.size());
+  if (lost_race) {
+    fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    linked = fd >= 0 && ReadKey(fd, key);
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  return linked;
+}
+
+CipherAlgorithm RecordCipher::PreferredAlgorithm() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  bool hardware_aes =
+      __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul");
+#elif defined(__aarch64__)
+  bool hardware_aes = (getauxval(AT_HWCAP) & HWCAP_AES) != 0 &&
+                      (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#else
+  bool hardware_aes = false;
+#endif
+  return hardware_aes ? CipherAlgorithm::kAes256Gcm
+                      : CipherAlgorithm::kChaCha20Poly1305;
+}
+
+RecordCipher::RecordCipher(const CookieKey& key, CipherAlgorithm algorithm)
+    : key_(key), algorithm_(algorithm), id_(g_next_cipher_id++) {}
+
+RecordCipher::~RecordCipher() {
+  OPENSSL_cleanse(key_.data(), key_.size());
+}
+
+EVP_CIPHER_CTX* RecordCipher::Context(uint8_t algorithm, bool encrypt) const {
+  EVP_CIPHER_CTX* context = nullptr;
+  if (t_contexts.Find(id_, algorithm, encrypt, &context) != nullptr) {
+    return context;
+  }
+  const EVP_CIPHER* cipher = CipherFor(algorithm);
+  if (cipher == nullptr || context == nullptr ||
+      EVP_CipherInit_ex(context, cipher, nullptr, key_.data(), nullptr,
+                        encrypt ? 1 : 0) != 1) {
+    t_contexts.Reset(algorithm, encrypt);
+    return nullptr;
+  }
+  return context;
+}
+
+bool RecordCipher::Seal(char* record, size_t size) const {
+  auto* bytes = reinterpret_cast<unsigned char*>(record);
+  bytes[0] = static_cast<uint8_t>(algorithm_);
+  unsigned char* nonce = bytes + 1;
+  unsigned char* data = bytes + kPrefix;
+  EVP_CIPHER_CTX* context = Context(bytes[0], true);
+  if (context == nullptr || RAND_bytes(nonce, kNonceSize) != 1) {
+    return false;
+  }
+  int length = 0;
+  int final_length = 0;
+  // The algorithm byte is authenticated along with the data.
+  return EVP_EncryptInit_ex(context, nullptr, nullptr, nullptr, nonce) == 1 &&
+         EVP_EncryptUpdate(context, nullptr, &length, bytes, 1) == 1 &&
+         EVP_EncryptUpdate(context, data, &length, data,
+                           static_cast<int>(size)) == 1 &&
+         EVP_EncryptFinal_ex(context, data + length, &final_length) == 1 &&
+         EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_GET_TAG, kTagSize,
+                             data + size) == 1;
+}
+
+bool RecordCipher::Open(char* record, size_t size) const {
+  if (size < kOverhead) {
+    return false;
+  }
+  auto* bytes = reinterpret_cast<unsigned char*>(record);
+  EVP_CIPHER_CTX* context = Context(bytes[0], false);
+  if (context == nullptr) {
+    return false;
+  }
+  unsigned char* nonce = bytes + 1;
+  unsigned char* data = bytes + kPrefix;
+  size_t data_size = size - kOverhead;
+  int length = 0;
+  int final_length = 0;
+  return EVP_DecryptInit_ex(context, nullptr, nullptr, nullptr, nonce) == 1 &&
+         EVP_DecryptUpdate(context, nullptr, &length, bytes, 1) == 1 &&
+         EVP_DecryptUpdate(context, data, &length, data,
+                           static_cast<int>(data_size)) == 1 &&
+         EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_SET_TAG, kTagSize,
+                             data + data_size) == 1 &&
+         EVP_DecryptFinal_ex(context, data + length, &final_length) == 1;
+}
+
+}  // namespace flutter_cookie_bridge
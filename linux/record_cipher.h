@@ -0,0 +1,111 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_RECORD_CIPHER_H_
+#define FLUTTER_COOKIE_BRIDGE_RECORD_CIPHER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace flutter_cookie_bridge {
+
+using CookieKey = std::array<uint8_t, 32>;
+
+// Supplies the key a CookieStore encrypts its records with. Embedders with
+// a platform keyring implement this on top of it.
+class CookieKeyProvider {
+ public:
+  virtual ~CookieKeyProvider() = default;
+
+  // Writes the key to |key|. Returns false when no key is available.
+  virtual bool GetKey(CookieKey* key) = 0;
+};
+
+// A key the embedder already holds.
+class StaticKeyProvider : public CookieKeyProvider {
+ public:
+  explicit StaticKeyProvider(const CookieKey& key) : key_(key) {}
+  ~StaticKeyProvider() override;
+
+  bool GetKey(CookieKey* key) override;
+
+ private:
+  CookieKey key_;
+};
+
+// Keeps the key in a file only the user can read, created with a random key
+// on first use. The stand-in for a keyring on Linux: it keeps cookies out
+// of backups and copies that take the log without the key, not out of reach
+// of the user's own processes.
+class FileKeyProvider : public CookieKeyProvider {
+ public:
+  explicit FileKeyProvider(std::string path) : path_(std::move(path)) {}
+
+  bool GetKey(CookieKey* key) override;
+
+ private:
+  const std::string path_;
+};
+
+enum class CipherAlgorithm : uint8_t {
+  kAes256Gcm = 1,
+  kChaCha20Poly1305 = 2,
+};
+
+// Authenticated encryption of single log records, so that a record can be
+// appended without touching the others.
+//
+// A sealed record is the algorithm byte and a random nonce, then the
+// ciphertext in place of the plaintext, then the tag. Each record names its
+// algorithm, so a log written on one machine opens on any other. OpenSSL
+// picks the AES-NI, VAES or ARMv8 code for AES-GCM at runtime; without
+// AES instructions ChaCha20-Poly1305 is the faster and constant-time
+// choice.
+//
+// Seal and Open may be called from several threads at once.
+class RecordCipher {
+ public:
+  static constexpr size_t kNonceSize = 12;
+  static constexpr size_t kTagSize = 16;
+  // Bytes before the ciphertext.
+  static constexpr size_t kPrefix = 1 + kNonceSize;
+  static constexpr size_t kOverhead = kPrefix + kTagSize;
+
+  // The algorithm this machine runs fastest.
+  static CipherAlgorithm PreferredAlgorithm();
+
+  RecordCipher(const CookieKey& key, CipherAlgorithm algorithm);
+  ~RecordCipher();
+
+  RecordCipher(const RecordCipher&) = delete;
+  RecordCipher& operator=(const RecordCipher&) = delete;
+
+  // Encrypts the |size| bytes at |record| + kPrefix in place, writing the
+  // algorithm and nonce before them and the tag after them, so |record|
+  // must have room for |size| + kOverhead bytes.
+  bool Seal(char* record, size_t size) const;
+
+  // Authenticates and decrypts a record of |size| bytes, overhead included,
+  // that Seal produced. On success the |size| - kOverhead bytes of
+  // plaintext are at |record| + kPrefix.
+  bool Open(char* record, size_t size) const;
+
+  CipherAlgorithm algorithm() const { return algorithm_; }
+
+ private:
+  // The calling thread's context for |algorithm| in one direction, keyed
+  // for this cipher, or null when |algorithm| is unknown.
+  EVP_CIPHER_CTX* Context(uint8_t algorithm, bool encrypt) const;
+
+  CookieKey key_;
+  const CipherAlgorithm algorithm_;
+  // Tells the thread contexts keyed for this cipher from those of earlier
+  // ciphers, which may have lived at the same address.
+  const uint64_t id_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_RECORD_CIPHER_H_
@@ -0,0 +1,318 @@
+#include "set_cookie_parser.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Compares |s| against the lowercase literal |lower| ignoring ASCII case.
+bool EqualsLowercase(std::string_view s, std::string_view lower) {
+  if (s.size() != lower.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (ToLower(s[i]) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Parses the Max-Age attribute value of RFC 6265 5.2.2.
+bool ParseMaxAge(std::string_view value, int64_t* out) {
+  if (value.empty()) {
+    return false;
+  }
+  bool negative = value.front() == '-';
+  if (negative) {
+    value.remove_prefix(1);
+  }
+  if (value.empty()) {
+    return false;
+  }
+  int64_t result = 0;
+  for (char c : value) {
+    if (!IsDigit(c)) {
+      return false;
+    }
+    // Saturate rather than overflow on absurdly long values.
+    if (result < INT64_MAX / 10) {
+      result = result * 10 + (c - '0');
+    }
+  }
+  *out = negative ? -result : result;
+  return true;
+}
+
+void ApplyAttribute(std::string_view key,
+                    std::string_view value,
+                    ParsedSetCookie* out) {
+  switch (key.size()) {
+    case 4:
+      if (EqualsLowercase(key, "path") && !value.empty() &&
+          value.front() == '/') {
+        out->path = value;
+        out->flags |= kSetCookieHasPath;
+      }
+      break;
+    case 6:
+      if (EqualsLowercase(key, "domain")) {
+        if (!value.empty()) {
+          out->domain = value;
+          out->flags |= kSetCookieHasDomain;
+        }
+      } else if (EqualsLowercase(key, "secure")) {
+        out->flags |= kSetCookieSecure;
+      }
+      break;
+    case 7:
+      if (EqualsLowercase(key, "expires")) {
+        int64_t expires = ParseCookieDate(value);
+        if (expires != kNoExpiry) {
+          out->expires = expires;
+          out->flags |= kSetCookieHasExpires;
+        }
+      } else if (EqualsLowercase(key, "max-age")) {
+        if (ParseMaxAge(value, &out->max_age)) {
+          out->flags |= kSetCookieHasMaxAge;
+        }
+      }
+      break;
+    case 8:
+      if (EqualsLowercase(key, "httponly")) {
+        out->flags |= kSetCookieHttpOnly;
+      } else if (EqualsLowercase(key, "samesite")) {
+        if (EqualsLowercase(value, "none")) {
+          out->same_site = SameSite::kNone;
+        } else if (EqualsLowercase(value, "lax")) {
+          out->same_site = SameSite::kLax;
+        } else if (EqualsLowercase(value, "strict")) {
+          out->same_site = SameSite::kStrict;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// The delimiter set of the cookie-date grammar in RFC 6265 5.1.1.
+bool IsDateDelimiter(unsigned char c) {
+  return c == 0x09 || (c >= 0x20 && c <= 0x2F) || (c >= 0x3B && c <= 0x40) ||
+         (c >= 0x5B && c <= 0x60) || (c >= 0x7B && c <= 0x7E);
+}
+
+// Reads between |min_digits| and |max_digits| leading digits of |token|. The
+// digits may only be followed by a non-digit.
+bool ReadDigits(std::string_view* token,
+                size_t min_digits,
+                size_t max_digits,
+                int* out) {
+  size_t count = 0;
+  int value = 0;
+  while (count < token->size() && IsDigit((*token)[count])) {
+    if (count == max_digits) {
+      return false;
+    }
+    value = value * 10 + ((*token)[count] - '0');
+    ++count;
+  }
+  if (count < min_digits) {
+    return false;
+  }
+  token->remove_prefix(count);
+  *out = value;
+  return true;
+}
+
+bool ParseTime(std::string_view token, int* hour, int* minute, int* second) {
+  if (!ReadDigits(&token, 1, 2, hour) || token.empty() ||
+      token.front() != ':') {
+    return false;
+  }
+  token.remove_prefix(1);
+  if (!ReadDigits(&token, 1, 2, minute) || token.empty() ||
+      token.front() != ':') {
+    return false;
+  }
+  token.remove_prefix(1);
+  return ReadDigits(&token, 1, 2, second);
+}
+
+int ParseMonth(std::string_view token) {
+  static const char kMonths[] = "janfebmaraprmayjunjulaugsepoctnovdec";
+  if (token.size() < 3) {
+    return 0;
+  }
+  char prefix[3] = {ToLower(token[0]), ToLower(token[1]), ToLower(token[2])};
+  for (int month = 0; month < 12; ++month) {
+    const char* name = kMonths + month * 3;
+    if (prefix[0] == name[0] && prefix[1] == name[1] && prefix[2] == name[2]) {
+      return month + 1;
+    }
+  }
+  return 0;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date.
+int64_t DaysFromCivil(int64_t year, int month, int day) {
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const int64_t year_of_era = year - era * 400;
+  const int64_t day_of_year =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int64_t day_of_era =
+      year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+}  // namespace
+
+std::string_view TrimWhitespace(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+size_t FindDelimiter(const char* data,
+                     size_t size,
+                     size_t from,
+                     bool stop_at_equals) {
+  const char second = stop_at_equals ? '=' : ';';
+#if defined(__SSE2__)
+  const __m128i semicolons = _mm_set1_epi8(';');
+  const __m128i seconds = _mm_set1_epi8(second);
+  while (from + 16 <= size) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+    int mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(chunk, semicolons), _mm_cmpeq_epi8(chunk, seconds)));
+    if (mask != 0) {
+      return from + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    from += 16;
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t semicolons = vdupq_n_u8(';');
+  const uint8x16_t seconds = vdupq_n_u8(static_cast<uint8_t>(second));
+  while (from + 16 <= size) {
+    uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + from));
+    uint8x16_t hits =
+        vorrq_u8(vceqq_u8(chunk, semicolons), vceqq_u8(chunk, seconds));
+    if (vmaxvq_u8(hits) != 0) {
+      break;  // The scalar loop below pinpoints the hit within this block.
+    }
+    from += 16;
+  }
+#endif
+  for (; from < size; ++from) {
+    if (data[from] == ';' || data[from] == second) {
+      return from;
+    }
+  }
+  return size;
+}
+
+bool ParseSetCookie(std::string_view header, ParsedSetCookie* out) {
+  *out = ParsedSetCookie();
+  const char* data = header.data();
+  const size_t size = header.size();
+
+  size_t equals = FindDelimiter(data, size, 0, true);
+  if (equals == size || data[equals] != '=') {
+    return false;
+  }
+  size_t pair_end = FindDelimiter(data, size, equals + 1, false);
+  out->name = TrimWhitespace(header.substr(0, equals));
+  if (out->name.empty()) {
+    return false;
+  }
+  out->value =
+      TrimWhitespace(header.substr(equals + 1, pair_end - equals - 1));
+
+  size_t pos = pair_end + 1;
+  while (pos < size) {
+    size_t delimiter = FindDelimiter(data, size, pos, true);
+    std::string_view key = TrimWhitespace(header.substr(pos, delimiter - pos));
+    std::string_view value;
+    size_t end = delimiter;
+    if (delimiter < size && data[delimiter] == '=') {
+      end = FindDelimiter(data, size, delimiter + 1, false);
+      value =
+          TrimWhitespace(header.substr(delimiter + 1, end - delimiter - 1));
+    }
+    ApplyAttribute(key, value, out);
+    pos = end + 1;
+  }
+  return true;
+}
+
+int64_t ParseCookieDate(std::string_view date) {
+  bool found_time = false;
+  bool found_day = false;
+  bool found_month = false;
+  bool found_year = false;
+  int hour = 0, minute = 0, second = 0, day = 0, month = 0, year = 0;
+
+  size_t pos = 0;
+  while (pos < date.size()) {
+    while (pos < date.size() &&
+           IsDateDelimiter(static_cast<unsigned char>(date[pos]))) {
+      ++pos;
+    }
+    size_t start = pos;
+    while (pos < date.size() &&
+           !IsDateDelimiter(static_cast<unsigned char>(date[pos]))) {
+      ++pos;
+    }
+    std::string_view token = date.substr(start, pos - start);
+    if (token.empty()) {
+      continue;
+    }
+
+    std::string_view digits = token;
+    int value = 0;
+    if (!found_time && ParseTime(token, &hour, &minute, &second)) {
+      found_time = true;
+    } else if (!found_day && ReadDigits(&digits, 1, 2, &value)) {
+      found_day = true;
+      day = value;
+    } else if (!found_month && (month = ParseMonth(token)) != 0) {
+      found_month = true;
+    } else if (!found_year && ReadDigits(&(digits = token), 2, 4, &value)) {
+      found_year = true;
+      year = value;
+    }
+  }
+
+  if (found_year && year >= 70 && year <= 99) {
+    year += 1900;
+  } else if (found_year && year >= 0 && year <= 69) {
+    year += 2000;
+  }
+  if (!found_time || !found_day || !found_month || !found_year || day < 1 ||
+      day > 31 || year < 1601 || hour > 23 || minute > 59 || second > 59) {
+    return kNoExpiry;
+  }
+  return DaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 +
+         second;
+}
+
+}  // namespace flutter_cookie_bridge
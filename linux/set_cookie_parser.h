@@ -0,0 +1,98 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_SET_COOKIE_PARSER_H_
+#define FLUTTER_COOKIE_BRIDGE_SET_COOKIE_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace flutter_cookie_bridge {
+
+enum class SameSite : uint8_t {
+  kUnspecified = 0,
+  kNone = 1,
+  kLax = 2,
+  kStrict = 3,
+};
+
+// Bits of ParsedSetCookie::flags.
+enum SetCookieFlag : uint32_t {
+  kSetCookieSecure = 1u << 0,
+  kSetCookieHttpOnly = 1u << 1,
+  kSetCookieHasDomain = 1u << 2,
+  kSetCookieHasPath = 1u << 3,
+  kSetCookieHasExpires = 1u << 4,
+  kSetCookieHasMaxAge = 1u << 5,
+};
+
+// Sentinel for ParsedSetCookie::expires when the Expires attribute is absent
+// or cannot be parsed.
+constexpr int64_t kNoExpiry = INT64_MIN;
+
+// The result of parsing one Set-Cookie header value.
+//
+// Every view points into the header that was parsed; nothing is copied. The
+// views are trimmed of surrounding whitespace but otherwise untouched, so the
+// domain keeps any leading dot and keeps its case.
+struct ParsedSetCookie {
+  std::string_view name;
+  std::string_view value;
+  std::string_view domain;
+  std::string_view path;
+  // Seconds since the epoch, or kNoExpiry.
+  int64_t expires = kNoExpiry;
+  // Only meaningful when kSetCookieHasMaxAge is set.
+  int64_t max_age = 0;
+  uint32_t flags = 0;
+  SameSite same_site = SameSite::kUnspecified;
+};
+
+// Parses a Set-Cookie header value following RFC 6265 5.2. Returns false when
+// the header carries no cookie (no '=' in the name-value pair, or an empty
+// name).
+bool ParseSetCookie(std::string_view header, ParsedSetCookie* out);
+
+// Calls |visit(name, value)| for every pair of a Cookie request header such
+// as "a=1; b=2". Pairs without '=' or with an empty name are skipped. Returns
+// the number of pairs visited.
+template <typename Visitor>
+size_t ParseCookieHeader(std::string_view header, Visitor visit);
+
+// Parses an RFC 6265 5.1.1 cookie-date. Returns kNoExpiry on failure.
+int64_t ParseCookieDate(std::string_view date);
+
+// Returns the offset of the first ';' in |data| at or after |from|, or of the
+// first '=' too when |stop_at_equals| is set. Returns |size| when there is
+// none. Scans 16 bytes at a time where the target supports it.
+size_t FindDelimiter(const char* data,
+                     size_t size,
+                     size_t from,
+                     bool stop_at_equals);
+
+// Removes leading and trailing spaces and tabs.
+std::string_view TrimWhitespace(std::string_view s);
+
+template <typename Visitor>
+size_t ParseCookieHeader(std::string_view header, Visitor visit) {
+  size_t count = 0;
+  size_t pos = 0;
+  while (pos < header.size()) {
+    size_t delimiter = FindDelimiter(header.data(), header.size(), pos, true);
+    size_t end = delimiter;
+    if (delimiter < header.size() && header[delimiter] == '=') {
+      end = FindDelimiter(header.data(), header.size(), delimiter + 1, false);
+      std::string_view name =
+          TrimWhitespace(header.substr(pos, delimiter - pos));
+      if (!name.empty()) {
+        visit(name, TrimWhitespace(
+                        header.substr(delimiter + 1, end - delimiter - 1)));
+        ++count;
+      }
+    }
+    pos = end + 1;
+  }
+  return count;
+}
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_SET_COOKIE_PARSER_H_
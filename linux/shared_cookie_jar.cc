@@ -0,0 +1,398 @@
+#include "shared_cookie_jar.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "trace.h"
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+// Threads beyond this many read under the writer mutex instead.
+constexpr size_t kReaderSlots = 128;
+
+struct alignas(64) ReaderSlot {
+  // The epoch the owning thread entered its current read in, or 0 while it
+  // is not reading.
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<bool> claimed{false};
+};
+
+ReaderSlot g_reader_slots[kReaderSlots];
+std::atomic<uint64_t> g_epoch{1};
+
+// Claims a reader slot for a thread and gives it back when the thread exits.
+class ReaderRegistration {
+ public:
+  ReaderRegistration() {
+    for (ReaderSlot& slot : g_reader_slots) {
+      bool expected = false;
+      if (!slot.claimed.load(std::memory_order_relaxed) &&
+          slot.claimed.compare_exchange_strong(expected, true)) {
+        slot_ = &slot;
+        return;
+      }
+    }
+  }
+
+  ~ReaderRegistration() {
+    if (slot_ != nullptr) {
+      slot_->claimed.store(false, std::memory_order_release);
+    }
+  }
+
+  ReaderSlot* slot() const { return slot_; }
+
+ private:
+  ReaderSlot* slot_ = nullptr;
+};
+
+ReaderSlot* CurrentReaderSlot() {
+  thread_local ReaderRegistration registration;
+  return registration.slot();
+}
+
+}  // namespace
+
+struct SharedCookieJar::Snapshot {
+  DomainTrie<std::shared_ptr<const std::vector<Cookie>>> domains;
+};
+
+// Records which domains changed since the last published snapshot.
+class SharedCookieJar::DirtyTracker : public CookieJarObserver {
+ public:
+  void OnCookieChanged(const Cookie& cookie, bool removed) override {
+    domains.emplace(cookie.domain);
+  }
+
+  void OnCookiesCleared() override {
+    everything = true;
+    domains.clear();
+  }
+
+  std::unordered_set<std::string> domains;
+  bool everything = false;
+};
+
+SharedCookieJar* SharedCookieJar::Get() {
+  static SharedCookieJar* jar = new SharedCookieJar();
+  return jar;
+}
+
+SharedCookieJar::SharedCookieJar(CookieJarLimits limits)
+    : jar_(limits),
+      tracker_(std::make_unique<DirtyTracker>()),
+      snapshot_(new Snapshot()) {
+  jar_.AddObserver(tracker_.get());
+}
+
+SharedCookieJar::~SharedCookieJar() {
+  if (loader_.joinable()) {
+    loader_.join();
+  }
+  store_.reset();
+  jar_.RemoveObserver(tracker_.get());
+  delete snapshot_.load();
+  for (const auto& retired : retired_) {
+    delete retired.first;
+  }
+}
+
+size_t SharedCookieJar::SetCookies(
+    std::string_view url, const std::vector<std::string>& set_cookie_headers) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t changed = jar_.SetCookies(url, set_cookie_headers);
+  PublishLocked();
+  return changed;
+}
+
+size_t SharedCookieJar::SyncCookies(
+    std::string_view url,
+    const std::vector<std::pair<std::string, std::string>>& cookies) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t changed = jar_.SyncCookies(url, cookies);
+  PublishLocked();
+  return changed;
+}
+
+void SharedCookieJar::Clear() {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  jar_.Clear();
+  PublishLocked();
+}
+
+CookieJarStats SharedCookieJar::stats() const {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jar_.stats();
+}
+
+std::string SharedCookieJar::GetCookieHeader(std::string_view url) const {
+  AwaitLoad();
+  ReaderSlot* slot = CurrentReaderSlot();
+  if (slot == nullptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jar_.GetCookieHeader(url);
+  }
+
+  // Announcing the epoch before loading the snapshot is what lets writers
+  // tell whether this read may still see a snapshot they retired.
+  slot->epoch.store(g_epoch.load());
+  const Snapshot* snapshot = snapshot_.load();
+  std::string header;
+  if (!snapshot->domains.empty()) {
+    header = BuildCookieHeader(
+        url, [snapshot](std::string_view host,
+                        std::vector<CookieBucketMatch>* matches) {
+          snapshot->domains.ForEachSuffix(
+              host, [matches](const auto& bucket, bool exact) {
+                matches->push_back({bucket.get(), exact});
+              });
+        });
+  }
+  slot->epoch.store(0, std::memory_order_release);
+  return header;
+}
+
+void SharedCookieJar::SwitchPartition(const std::string& name) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (name == active_partition_) {
+    return;
+  }
+  ScopedTrace trace("cookie_jar.switch_partition");
+  std::unique_ptr<const Snapshot> next;
+  auto found = partitions_.find(name);
+  if (found == partitions_.end()) {
+    next = std::make_unique<Snapshot>();
+  } else {
+    next = std::move(found->second);
+    partitions_.erase(found);
+  }
+  // Every mutation is published, so the snapshot holds what the jar holds.
+  const Snapshot* current = snapshot_.load(std::memory_order_relaxed);
+
+  // Only the default partition goes to the log.
+  if (store_ != nullptr && active_partition_ == kDefaultPartition) {
+    store_->Flush();
+    jar_.RemoveObserver(store_.get());
+  } else if (store_ != nullptr && name == kDefaultPartition) {
+    jar_.AddObserver(store_.get());
+  }
+
+  // The buckets of a domain are the same when neither partition changed it
+  // since one was forked from the other, and then it is skipped.
+  current->domains.ForEachDifference(
+      next->domains, [this](const auto* outgoing, const auto* incoming) {
+        if (incoming == nullptr) {
+          jar_.ReplaceDomain((*outgoing)->front().domain, {});
+        } else {
+          jar_.ReplaceDomain((*incoming)->front().domain, **incoming);
+        }
+      });
+
+  // The jar now holds the cookies of |next|. Readers get |next| itself
+  // rather than copies of the buckets it changed, so that its buckets stay
+  // shared with the partitions it was forked from or into. Snapshots are
+  // immutable, so the outgoing one is kept as the saved partition, however
+  // long readers still use it.
+  tracker_->domains.clear();
+  tracker_->everything = false;
+  partitions_[active_partition_].reset(snapshot_.exchange(next.release()));
+  active_partition_ = name;
+}
+
+bool SharedCookieJar::ForkPartition(const std::string& name,
+                                    const std::string& from) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (name == active_partition_ || partitions_.count(name) != 0) {
+    return false;
+  }
+  const Snapshot* source = nullptr;
+  if (from == active_partition_) {
+    source = snapshot_.load(std::memory_order_relaxed);
+  } else {
+    auto found = partitions_.find(from);
+    if (found == partitions_.end()) {
+      return false;
+    }
+    source = found->second.get();
+  }
+  partitions_[name] = std::make_unique<Snapshot>(*source);
+  return true;
+}
+
+bool SharedCookieJar::DropPartition(const std::string& name) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (name == active_partition_ || name == kDefaultPartition) {
+    return false;
+  }
+  auto found = partitions_.find(name);
+  if (found == partitions_.end()) {
+    return false;
+  }
+  // Readers may still hold it, from before it was switched away from.
+  retired_.emplace_back(found->second.release(), g_epoch.fetch_add(1));
+  partitions_.erase(found);
+  ReclaimLocked();
+  return true;
+}
+
+std::string SharedCookieJar::active_partition() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return active_partition_;
+}
+
+bool SharedCookieJar::Persist(const std::string& path,
+                              std::unique_ptr<CookieKeyProvider> keys) {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  return PersistLocked(path, std::move(keys));
+}
+
+void SharedCookieJar::PersistInBackground(
+    const std::string& path, std::unique_ptr<CookieKeyProvider> keys) {
+  std::call_once(load_started_, [this, &path, &keys] {
+    std::promise<void> done;
+    loaded_ = done.get_future().share();
+    loading_.store(true, std::memory_order_release);
+    // Calls made meanwhile wait on |loaded_| instead of the mutex, so the
+    // loader cannot lose the race for it to one of them.
+    loader_ = std::thread([this, path, keys = std::move(keys),
+                           done = std::move(done)]() mutable {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool persisted = PersistLocked(path, std::move(keys));
+        std::vector<std::function<void(CookieJar*, bool)>> waiting;
+        {
+          std::lock_guard<std::mutex> waiting_lock(when_loaded_mutex_);
+          waiting.swap(when_loaded_);
+          load_finished_ = true;
+        }
+        for (auto& function : waiting) {
+          function(&jar_, persisted);
+        }
+        PublishLocked();
+      }
+      done.set_value();
+      loading_.store(false, std::memory_order_release);
+    });
+  });
+}
+
+void SharedCookieJar::WhenLoaded(
+    std::function<void(CookieJar*, bool persisted)> function) {
+  {
+    std::lock_guard<std::mutex> lock(when_loaded_mutex_);
+    if (loading_.load(std::memory_order_acquire) && !load_finished_) {
+      when_loaded_.push_back(std::move(function));
+      return;
+    }
+  }
+  Locked([this, &function](CookieJar* jar) {
+    function(jar, store_ != nullptr && persist_result_);
+  });
+}
+
+void SharedCookieJar::AwaitLoad() const {
+  if (loading_.load(std::memory_order_acquire)) {
+    loaded_.wait();
+  }
+}
+
+bool SharedCookieJar::PersistLocked(const std::string& path,
+                                    std::unique_ptr<CookieKeyProvider> keys) {
+  if (store_ != nullptr) {
+    return persist_result_;
+  }
+  ScopedTrace trace("cookie_store.load");
+  store_ = std::make_unique<CookieStore>(
+      path, CookieStore::kDefaultCompactionThreshold, std::move(keys));
+  persist_result_ = store_->Open(&jar_);
+  // Restored cookies do not notify observers.
+  tracker_->everything = true;
+  PublishLocked();
+  return persist_result_;
+}
+
+void SharedCookieJar::Flush() {
+  AwaitLoad();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (store_ != nullptr) {
+    store_->Flush();
+  }
+}
+
+void SharedCookieJar::PublishLocked() {
+  if (!tracker_->everything && tracker_->domains.empty()) {
+    return;
+  }
+
+  auto next = std::make_unique<Snapshot>();
+  if (tracker_->everything) {
+    std::unordered_map<std::string, std::shared_ptr<std::vector<Cookie>>>
+        buckets;
+    jar_.ForEach([&buckets](const Cookie& cookie) {
+      std::shared_ptr<std::vector<Cookie>>& bucket =
+          buckets[std::string(cookie.domain)];
+      if (bucket == nullptr) {
+        bucket = std::make_shared<std::vector<Cookie>>();
+      }
+      bucket->push_back(cookie.Copy());
+    });
+    for (auto& entry : buckets) {
+      next->domains.FindOrInsert(entry.first) = std::move(entry.second);
+    }
+  } else {
+    next->domains = snapshot_.load(std::memory_order_relaxed)->domains;
+    for (const std::string& domain : tracker_->domains) {
+      auto bucket = std::make_shared<std::vector<Cookie>>();
+      jar_.ForEachInDomain(domain, [&bucket](const Cookie& cookie) {
+        bucket->push_back(cookie.Copy());
+      });
+      if (bucket->empty()) {
+        next->domains.Erase(domain);
+      } else {
+        next->domains.FindOrInsert(domain) = std::move(bucket);
+      }
+    }
+  }
+  tracker_->domains.clear();
+  tracker_->everything = false;
+
+  const Snapshot* previous = snapshot_.exchange(next.release());
+  // Readers that announced this epoch or an earlier one may hold |previous|;
+  // later ones load the pointer after the exchange above.
+  retired_.emplace_back(previous, g_epoch.fetch_add(1));
+  ReclaimLocked();
+}
+
+void SharedCookieJar::ReclaimLocked() {
+  uint64_t oldest_reader = std::numeric_limits<uint64_t>::max();
+  for (const ReaderSlot& slot : g_reader_slots) {
+    uint64_t epoch = slot.epoch.load();
+    if (epoch != 0) {
+      oldest_reader = std::min(oldest_reader, epoch);
+    }
+  }
+  retired_.erase(
+      std::remove_if(retired_.begin(), retired_.end(),
+                     [oldest_reader](const auto& retired) {
+                       if (retired.second >= oldest_reader) {
+                         return false;
+                       }
+                       delete retired.first;
+                       return true;
+                     }),
+      retired_.end());
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,165 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_SHARED_COOKIE_JAR_H_
+#define FLUTTER_COOKIE_BRIDGE_SHARED_COOKIE_JAR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cookie_jar.h"
+#include "cookie_store.h"
+
+namespace flutter_cookie_bridge {
+
+// A CookieJar that any thread, and so any Dart isolate calling in through
+// dart:ffi, can use concurrently.
+//
+// Writers are serialized by a mutex. After each write the jar publishes an
+// immutable snapshot of its buckets; buckets that did not change are shared
+// with the previous snapshot, so publishing costs O(domains) pointer copies
+// plus a copy of the changed buckets. Readers build Cookie headers from the
+// current snapshot without taking any lock or retrying: they announce the
+// epoch they read in, load the snapshot pointer, and writers only free a
+// retired snapshot once no reader announced an epoch that could have seen
+// it.
+//
+// The jar is split into named partitions, such as one per user profile or
+// one for a partner flow, of which one is active at a time; every method
+// other than the partition ones reads and writes the active partition. An
+// inactive partition is kept as the snapshot it last published, so forking
+// a partition copies the trie of domains but no cookie, and the two share
+// every bucket until one of them changes it.
+class SharedCookieJar {
+ public:
+  // The partition a jar starts in, and the only one persisted.
+  static constexpr char kDefaultPartition[] = "default";
+
+  // The jar shared by every engine and isolate of the process.
+  static SharedCookieJar* Get();
+
+  explicit SharedCookieJar(CookieJarLimits limits = CookieJarLimits());
+  ~SharedCookieJar();
+
+  SharedCookieJar(const SharedCookieJar&) = delete;
+  SharedCookieJar& operator=(const SharedCookieJar&) = delete;
+
+  // See CookieJar.
+  size_t SetCookies(std::string_view url,
+                    const std::vector<std::string>& set_cookie_headers);
+  size_t SyncCookies(
+      std::string_view url,
+      const std::vector<std::pair<std::string, std::string>>& cookies);
+  void Clear();
+
+  // See CookieJar.
+  CookieJarStats stats() const;
+
+  // Same as CookieJar::GetCookieHeader, but wait-free.
+  std::string GetCookieHeader(std::string_view url) const;
+
+  // Makes |name| the active partition, creating it empty if there is none
+  // of that name. Readers move to it with one pointer swap. The underlying
+  // jar, and so its observers such as a CookieChangeFeed, only sees the
+  // cookies that differ between the two partitions; buckets they still
+  // share are skipped without being looked at.
+  void SwitchPartition(const std::string& name);
+
+  // Creates partition |name| as a snapshot of partition |from|. Returns
+  // false when |name| exists or |from| does not.
+  bool ForkPartition(const std::string& name, const std::string& from);
+
+  // Drops partition |name|. Returns false when it is the active or the
+  // default partition, or does not exist.
+  bool DropPartition(const std::string& name);
+
+  std::string active_partition() const;
+
+  // Persists the default partition in the log at |path|, sealed with the
+  // key of |keys| when given; see CookieStore. Call it before switching
+  // partitions. Only the first call opens a store; later ones return
+  // whether that succeeded.
+  bool Persist(const std::string& path,
+               std::unique_ptr<CookieKeyProvider> keys = nullptr);
+
+  // Starts Persist(|path|, |keys|) on a background thread, so the store is
+  // read while the embedder starts up. Every other call waits for the load
+  // to finish rather than see the jar without the stored cookies. Only the
+  // first call starts a load.
+  void PersistInBackground(const std::string& path,
+                           std::unique_ptr<CookieKeyProvider> keys = nullptr);
+
+  // Flushes the store, if any, to stable storage.
+  void Flush();
+
+  // Runs |function| with exclusive access to the underlying jar, for reads
+  // that need a consistent view and for registering observers. Mutations
+  // made by |function| are published when it returns.
+  template <typename Function>
+  void Locked(Function&& function) {
+    AwaitLoad();
+    std::lock_guard<std::mutex> lock(mutex_);
+    function(&jar_);
+    PublishLocked();
+  }
+
+  // Runs |function| as Locked would, with whether the store opened, once a
+  // load started by PersistInBackground has finished. It runs on the loader
+  // thread when the load is still running and right away otherwise, so the
+  // main thread can register observers without waiting for the load.
+  void WhenLoaded(std::function<void(CookieJar*, bool persisted)> function);
+
+ private:
+  struct Snapshot;
+  class DirtyTracker;
+
+  // Blocks until a load started by PersistInBackground has finished.
+  void AwaitLoad() const;
+
+  bool PersistLocked(const std::string& path,
+                     std::unique_ptr<CookieKeyProvider> keys);
+
+  // Publishes the buckets changed since the last snapshot.
+  void PublishLocked();
+
+  // Frees retired snapshots that no reader can still be using.
+  void ReclaimLocked();
+
+  mutable std::mutex mutex_;
+  CookieJar jar_;
+  std::unique_ptr<DirtyTracker> tracker_;
+  std::unique_ptr<CookieStore> store_;
+  bool persist_result_ = false;
+
+  std::once_flag load_started_;
+  // Set while a background load may still be running; |loaded_| becomes
+  // ready when it is done.
+  std::atomic<bool> loading_{false};
+  std::shared_future<void> loaded_;
+  std::thread loader_;
+  // What WhenLoaded left for the loader to run, until it has run them.
+  std::mutex when_loaded_mutex_;
+  std::vector<std::function<void(CookieJar*, bool)>> when_loaded_;
+  bool load_finished_ = false;
+
+  std::string active_partition_ = kDefaultPartition;
+  // The inactive partitions, as they were last published or forked.
+  std::unordered_map<std::string, std::unique_ptr<const Snapshot>>
+      partitions_;
+
+  std::atomic<const Snapshot*> snapshot_;
+  // Snapshots replaced by a later one, with the epoch they were retired in.
+  std::vector<std::pair<const Snapshot*, uint64_t>> retired_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_SHARED_COOKIE_JAR_H_
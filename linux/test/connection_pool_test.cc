@@ -0,0 +1,130 @@
+#include "connection_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test/test_http_server.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+// GETs |url| through |pool|, returning the body size or -1 on failure.
+int64_t Fetch(ConnectionPool* pool, const std::string& url) {
+  HttpRequest request;
+  request.url = url;
+  HttpResponse response;
+  std::string error;
+  int64_t size = 0;
+  bool ok = pool->Send(request, 5000, &response,
+                       [&](const char*, size_t count) {
+                         size += static_cast<int64_t>(count);
+                         return true;
+                       },
+                       &error);
+  EXPECT_TRUE(ok) << error;
+  return ok && response.status == 200 ? size : -1;
+}
+
+}  // namespace
+
+TEST(ConnectionPool, ReusesKeepAliveConnections) {
+  TestHttpServer server;
+  server.Add("/a", TestResource{1024});
+  ConnectionPool pool;
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Fetch(&pool, server.Url("/a")), 1024);
+  }
+  EXPECT_EQ(server.connections(), 1);
+  EXPECT_EQ(pool.stats().connects, 1u);
+  EXPECT_EQ(pool.stats().reuses, 9u);
+  EXPECT_EQ(pool.idle_count(), 1u);
+}
+
+TEST(ConnectionPool, ReplacesConnectionsTheServerClosed) {
+  TestHttpServer server;
+  server.Add("/a", TestResource{1024});
+  server.set_max_requests_per_connection(1);
+  ConnectionPool pool;
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Fetch(&pool, server.Url("/a")), 1024);
+  }
+  EXPECT_EQ(server.connections(), 5);
+  EXPECT_EQ(server.requests().size(), 5u);
+}
+
+TEST(ConnectionPool, ReapsIdleConnections) {
+  TestHttpServer server;
+  server.Add("/a", TestResource{16});
+  ConnectionPoolOptions options;
+  options.idle_timeout_ms = 50;
+  ConnectionPool pool(options);
+  EXPECT_EQ(Fetch(&pool, server.Url("/a")), 16);
+  EXPECT_EQ(pool.idle_count(), 1u);
+  EXPECT_EQ(pool.ReapIdle(), 0u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(pool.ReapIdle(), 1u);
+  EXPECT_EQ(pool.idle_count(), 0u);
+  EXPECT_EQ(pool.stats().reaped, 1u);
+}
+
+TEST(ConnectionPool, SendsRequestBodies) {
+  TestHttpServer server;
+  server.Add("/form", TestResource{0});
+  ConnectionPool pool;
+  for (const char* body : {"a=1&b=2", ""}) {
+    HttpRequest request;
+    request.method = "POST";
+    request.url = server.Url("/form");
+    request.body = body;
+    HttpResponse response;
+    std::string error;
+    ASSERT_TRUE(pool.Send(request, 5000, &response,
+                          [](const char*, size_t) { return true; }, &error))
+        << error;
+  }
+  std::vector<TestRequest> requests = server.requests();
+  ASSERT_EQ(requests.size(), 2u);
+  EXPECT_EQ(requests[0].method, "POST");
+  EXPECT_EQ(requests[0].body, "a=1&b=2");
+  EXPECT_EQ(requests[1].headers["content-length"], "0");
+  EXPECT_EQ(server.connections(), 1);
+}
+
+TEST(ConnectionPool, ResumesTlsSessions) {
+  TestHttpServer server(/*tls=*/true);
+  ASSERT_TRUE(HttpConnection::AddTrustedCertificates(server.certificate_pem()));
+  server.Add("/a", TestResource{1024});
+  // Without idle connections every request needs a handshake.
+  ConnectionPoolOptions options;
+  options.max_idle_per_origin = 0;
+  ConnectionPool pool(options);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Fetch(&pool, server.Url("/a")), 1024);
+  }
+  EXPECT_EQ(server.connections(), 5);
+  EXPECT_EQ(server.resumed_handshakes(), 4);
+  EXPECT_EQ(pool.stats().tls_handshakes, 5u);
+  EXPECT_EQ(pool.stats().tls_resumptions, 4u);
+}
+
+TEST(ConnectionPool, KeepsTlsConnectionsAlive) {
+  TestHttpServer server(/*tls=*/true);
+  ASSERT_TRUE(HttpConnection::AddTrustedCertificates(server.certificate_pem()));
+  server.Add("/api", TestResource{2048});
+  ConnectionPool pool;
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(Fetch(&pool, server.Url("/api")), 2048);
+  }
+  EXPECT_EQ(server.connections(), 1);
+  EXPECT_EQ(pool.stats().tls_handshakes, 1u);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,315 @@
+#include "content_coding.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test/test_http_server.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+// About 200 KiB of JSON, which compresses well, as API bodies do.
+std::string Payload() {
+  std::string text = "[";
+  for (int i = 0; text.size() < 200 * 1024; ++i) {
+    text += (i == 0 ? "{\"id\":" : ",{\"id\":") + std::to_string(i) +
+            ",\"amount\":" + std::to_string(i % 977) +
+            ",\"memo\":\"UPI/" + std::to_string(i * 7919) + "\"}";
+  }
+  return text + "]";
+}
+
+std::vector<ContentCoding> SupportedCodings() {
+  std::vector<ContentCoding> codings;
+  for (ContentCoding coding : {ContentCoding::kGzip, ContentCoding::kBrotli,
+                               ContentCoding::kZstd}) {
+    if (IsContentCodingSupported(coding)) {
+      codings.push_back(coding);
+    }
+  }
+  return codings;
+}
+
+// Decodes |encoded| fed in pieces of |piece| bytes.
+bool Decode(ContentCoding coding,
+            const std::string& encoded,
+            size_t piece,
+            std::string* decoded,
+            std::string* error) {
+  std::unique_ptr<ContentDecoder> decoder = ContentDecoder::Create(coding);
+  if (decoder == nullptr) {
+    *error = "no decoder";
+    return false;
+  }
+  for (size_t offset = 0; offset < encoded.size(); offset += piece) {
+    size_t size = std::min(piece, encoded.size() - offset);
+    if (!decoder->Update(encoded.data() + offset, size,
+                         [&](const char* data, size_t size) {
+                           decoded->append(data, size);
+                           return true;
+                         })) {
+      *error = decoder->error();
+      return false;
+    }
+  }
+  if (!decoder->finished()) {
+    *error = "unfinished";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(ContentCoding, ParsesCodingNames) {
+  ContentCoding coding = ContentCoding::kIdentity;
+  EXPECT_TRUE(ParseContentCoding(" GZIP ", &coding));
+  EXPECT_EQ(coding, ContentCoding::kGzip);
+  EXPECT_TRUE(ParseContentCoding("x-gzip", &coding));
+  EXPECT_EQ(coding, ContentCoding::kGzip);
+  EXPECT_TRUE(ParseContentCoding("br", &coding));
+  EXPECT_EQ(coding, ContentCoding::kBrotli);
+  EXPECT_TRUE(ParseContentCoding("zstd", &coding));
+  EXPECT_EQ(coding, ContentCoding::kZstd);
+  EXPECT_FALSE(ParseContentCoding("deflate, gzip", &coding));
+  EXPECT_STREQ(ContentCodingName(ContentCoding::kBrotli), "br");
+  EXPECT_TRUE(IsContentCodingSupported(ContentCoding::kGzip));
+  EXPECT_EQ(ContentDecoder::Create(ContentCoding::kIdentity), nullptr);
+}
+
+TEST(ContentCoding, RoundTripsInAnyPieces) {
+  std::string payload = Payload();
+  for (ContentCoding coding : SupportedCodings()) {
+    SCOPED_TRACE(ContentCodingName(coding));
+    std::string encoded;
+    ASSERT_TRUE(EncodeContent(coding, payload, 0, &encoded));
+    EXPECT_LT(encoded.size(), payload.size() / 4);
+    for (size_t piece : {size_t{1}, size_t{1000}, encoded.size()}) {
+      std::string decoded;
+      std::string error;
+      ASSERT_TRUE(Decode(coding, encoded, piece, &decoded, &error)) << error;
+      EXPECT_EQ(decoded, payload);
+    }
+    std::string empty;
+    ASSERT_TRUE(EncodeContent(coding, "", 0, &encoded));
+    std::string error;
+    ASSERT_TRUE(Decode(coding, encoded, 7, &empty, &error)) << error;
+    EXPECT_EQ(empty, "");
+  }
+}
+
+TEST(ContentCoding, DecodesConcatenatedGzipMembers) {
+  std::string first;
+  std::string second;
+  ASSERT_TRUE(EncodeContent(ContentCoding::kGzip, "hello, ", 0, &first));
+  ASSERT_TRUE(EncodeContent(ContentCoding::kGzip, "world", 0, &second));
+  std::string decoded;
+  std::string error;
+  ASSERT_TRUE(Decode(ContentCoding::kGzip, first + second + '\0', 3,
+                     &decoded, &error))
+      << error;
+  EXPECT_EQ(decoded, "hello, world");
+}
+
+TEST(ContentCoding, RejectsCorruptAndTruncatedBodies) {
+  std::string payload = Payload();
+  for (ContentCoding coding : SupportedCodings()) {
+    SCOPED_TRACE(ContentCodingName(coding));
+    std::string encoded;
+    ASSERT_TRUE(EncodeContent(coding, payload, 0, &encoded));
+    std::string decoded;
+    std::string error;
+    EXPECT_FALSE(Decode(coding, encoded.substr(0, encoded.size() / 2), 512,
+                        &decoded, &error));
+    EXPECT_EQ(error, "unfinished");
+
+    std::string corrupt = encoded;
+    for (size_t i = 0; i < 64; ++i) {
+      corrupt[i] = static_cast<char>(~corrupt[i]);
+    }
+    decoded.clear();
+    error.clear();
+    EXPECT_FALSE(Decode(coding, corrupt, 512, &decoded, &error));
+    EXPECT_FALSE(error.empty());
+  }
+}
+
+TEST(CompressionPolicy, KeepsOptionsAndStatsPerHost) {
+  CompressionPolicy policy;
+  CompressionOptions options;
+  options.request_coding = ContentCoding::kGzip;
+  options.min_request_size = 10;
+  policy.Configure("api.example.com", options);
+  EXPECT_EQ(policy.OptionsFor("api.example.com").request_coding,
+            ContentCoding::kGzip);
+  EXPECT_EQ(policy.OptionsFor("cdn.example.com").request_coding,
+            ContentCoding::kIdentity);
+  EXPECT_TRUE(policy.HasOptionsFor("api.example.com"));
+  EXPECT_FALSE(policy.HasOptionsFor("cdn.example.com"));
+
+  options.accept = {ContentCoding::kGzip};
+  policy.Configure("", options);
+  EXPECT_EQ(policy.OptionsFor("cdn.example.com").accept.size(), 1u);
+  EXPECT_FALSE(policy.HasOptionsFor(""));
+  policy.Reset("api.example.com");
+  EXPECT_EQ(policy.OptionsFor("api.example.com").accept.size(), 1u);
+  EXPECT_FALSE(policy.HasOptionsFor("api.example.com"));
+
+  CompressionStats stats;
+  stats.requests = 1;
+  stats.response_wire_bytes = 100;
+  policy.Record("api.example.com", stats);
+  policy.Record("cdn.example.com", stats);
+  policy.Record("cdn.example.com", stats);
+  EXPECT_EQ(policy.Stats("api.example.com").requests, 1u);
+  EXPECT_EQ(policy.Stats("cdn.example.com").response_wire_bytes, 200u);
+  EXPECT_EQ(policy.Stats("").requests, 3u);
+  EXPECT_EQ(policy.Stats("other.example.com").requests, 0u);
+}
+
+class SendWithCompressionTest : public ::testing::Test {
+ protected:
+  bool Send(const HttpRequest& request,
+            HttpResponse* response,
+            std::string* body,
+            std::string* error) {
+    return SendWithCompression(
+        &pool_, &policy_, request, 5000, response,
+        [body](const char* data, size_t size) {
+          body->append(data, size);
+          return true;
+        },
+        error);
+  }
+
+  TestHttpServer server_;
+  ConnectionPool pool_;
+  CompressionPolicy policy_;
+};
+
+TEST_F(SendWithCompressionTest, DecodesResponsesAsTheyArrive) {
+  std::string payload = Payload();
+  std::string encoded;
+  ASSERT_TRUE(EncodeContent(ContentCoding::kGzip, payload, 0, &encoded));
+  TestResource resource;
+  resource.body = encoded;
+  resource.chunked = true;
+  resource.headers = {"Content-Encoding: gzip"};
+  server_.Add("/gzip", resource);
+
+  HttpRequest request;
+  request.url = server_.Url("/gzip");
+  HttpResponse response;
+  std::string body;
+  std::string error;
+  ASSERT_TRUE(Send(request, &response, &body, &error)) << error;
+  EXPECT_EQ(response.status, 200);
+  EXPECT_EQ(body, payload);
+  EXPECT_EQ(response.decoded_from, "gzip");
+  EXPECT_EQ(response.content_length, -1);
+  EXPECT_EQ(response.FindHeader("Content-Encoding"), nullptr);
+  std::string accept = server_.requests()[0].headers["accept-encoding"];
+  EXPECT_NE(accept.find("gzip"), std::string::npos);
+
+  CompressionStats stats = policy_.Stats("127.0.0.1");
+  EXPECT_EQ(stats.responses, 1u);
+  EXPECT_EQ(stats.responses_decoded, 1u);
+  EXPECT_EQ(stats.response_wire_bytes, encoded.size());
+  EXPECT_EQ(stats.response_bytes, payload.size());
+
+  // A request naming its own Accept-Encoding gets the body as it came.
+  request.headers = {{"Accept-Encoding", "gzip"}};
+  body.clear();
+  ASSERT_TRUE(Send(request, &response, &body, &error)) << error;
+  EXPECT_EQ(body, encoded);
+  EXPECT_EQ(response.decoded_from, "");
+  ASSERT_NE(response.FindHeader("Content-Encoding"), nullptr);
+}
+
+TEST_F(SendWithCompressionTest, FailsOnCorruptResponses) {
+  TestResource resource;
+  resource.body = "this is not gzip at all";
+  resource.headers = {"Content-Encoding: gzip"};
+  server_.Add("/corrupt", resource);
+  HttpRequest request;
+  request.url = server_.Url("/corrupt");
+  HttpResponse response;
+  std::string body;
+  std::string error;
+  EXPECT_FALSE(Send(request, &response, &body, &error));
+  EXPECT_EQ(error.compare(0, 18, "invalid gzip body:"), 0) << error;
+}
+
+TEST_F(SendWithCompressionTest, CompressesLargeRequestBodies) {
+  TestResource resource;
+  resource.size = 10;
+  server_.Add("/upload", resource);
+  CompressionOptions options;
+  options.request_coding = ContentCoding::kGzip;
+  policy_.Configure("127.0.0.1", options);
+
+  HttpRequest request;
+  request.method = "POST";
+  request.url = server_.Url("/upload");
+  request.body = Payload();
+  HttpResponse response;
+  std::string body;
+  std::string error;
+  ASSERT_TRUE(Send(request, &response, &body, &error)) << error;
+  request.body = "{\"small\":true}";
+  ASSERT_TRUE(Send(request, &response, &body, &error)) << error;
+
+  std::vector<TestRequest> seen = server_.requests();
+  ASSERT_EQ(seen.size(), 2u);
+  EXPECT_EQ(seen[0].headers["content-encoding"], "gzip");
+  std::string decoded;
+  ASSERT_TRUE(Decode(ContentCoding::kGzip, seen[0].body, seen[0].body.size(),
+                     &decoded, &error))
+      << error;
+  EXPECT_EQ(decoded, Payload());
+  EXPECT_EQ(seen[1].headers.count("content-encoding"), 0u);
+  EXPECT_EQ(seen[1].body, request.body);
+
+  CompressionStats stats = policy_.Stats("127.0.0.1");
+  EXPECT_EQ(stats.requests, 2u);
+  EXPECT_EQ(stats.requests_compressed, 1u);
+  EXPECT_EQ(stats.request_bytes, Payload().size() + request.body.size());
+  EXPECT_EQ(stats.request_wire_bytes,
+            seen[0].body.size() + seen[1].body.size());
+}
+
+TEST_F(SendWithCompressionTest, SendsRefusedBodiesAgainAsTheyAre) {
+  TestResource resource;
+  resource.size = 10;
+  resource.refuses_encoded_bodies = true;
+  server_.Add("/upload", resource);
+  CompressionOptions options;
+  options.request_coding = ContentCoding::kGzip;
+  policy_.Configure("", options);
+
+  HttpRequest request;
+  request.method = "PUT";
+  request.url = server_.Url("/upload");
+  request.body = Payload();
+  HttpResponse response;
+  std::string body;
+  std::string error;
+  ASSERT_TRUE(Send(request, &response, &body, &error)) << error;
+  EXPECT_EQ(response.status, 200);
+  std::vector<TestRequest> seen = server_.requests();
+  ASSERT_EQ(seen.size(), 2u);
+  EXPECT_EQ(seen[1].body, request.body);
+
+  CompressionStats stats = policy_.Stats("");
+  EXPECT_EQ(stats.requests, 1u);
+  EXPECT_EQ(stats.requests_refused, 1u);
+  EXPECT_EQ(stats.requests_compressed, 0u);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
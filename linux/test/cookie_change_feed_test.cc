@@ -0,0 +1,83 @@
+#include "cookie_change_feed.h"
+
+#include <gtest/gtest.h>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(CookieChangeFeed, ReportsOnlyChangesSinceVersion) {
+  CookieJar jar;
+  CookieChangeFeed feed(&jar);
+  jar.SetCookies("https://example.com/", {"a=1; Path=/", "b=2; Path=/"});
+  uint64_t seen = feed.ChangesSince(0).version;
+
+  jar.SetCookies("https://example.com/", {"a=3; Path=/"});
+  jar.SetCookies("https://example.com/", {"b=; Path=/; Max-Age=0"});
+
+  CookieDelta delta = feed.ChangesSince(seen);
+  EXPECT_FALSE(delta.reset);
+  EXPECT_EQ(delta.version, jar.version());
+  ASSERT_EQ(delta.changes.size(), 2u);
+  EXPECT_EQ(delta.changes[0].name, "a");
+  EXPECT_EQ(delta.changes[0].value, "3");
+  EXPECT_FALSE(delta.changes[0].removed);
+  EXPECT_EQ(delta.changes[1].name, "b");
+  EXPECT_TRUE(delta.changes[1].removed);
+
+  EXPECT_TRUE(feed.ChangesSince(delta.version).changes.empty());
+}
+
+TEST(CookieChangeFeed, UnchangedSyncProducesNoDelta) {
+  CookieJar jar;
+  CookieChangeFeed feed(&jar);
+  jar.SyncCookies("https://example.com/", {{"a", "1"}});
+  uint64_t seen = jar.version();
+  jar.SyncCookies("https://example.com/", {{"a", "1"}});
+  EXPECT_TRUE(feed.ChangesSince(seen).changes.empty());
+}
+
+TEST(CookieChangeFeed, ClearForcesReset) {
+  CookieJar jar;
+  CookieChangeFeed feed(&jar);
+  jar.SetCookies("https://example.com/", {"a=1"});
+  uint64_t seen = jar.version();
+  jar.Clear();
+  jar.SetCookies("https://example.com/", {"b=2"});
+
+  CookieDelta delta = feed.ChangesSince(seen);
+  EXPECT_TRUE(delta.reset);
+  ASSERT_EQ(delta.changes.size(), 1u);
+  EXPECT_EQ(delta.changes[0].name, "b");
+}
+
+TEST(CookieChangeFeed, ForgottenTombstonesForceReset) {
+  CookieJar jar;
+  CookieChangeFeed feed(&jar, 2);
+  jar.SetCookies("https://example.com/", {"a=1", "b=2", "c=3", "d=4"});
+  uint64_t seen = jar.version();
+  jar.SetCookies("https://example.com/",
+                 {"a=; Max-Age=0", "b=; Max-Age=0", "c=; Max-Age=0"});
+
+  CookieDelta delta = feed.ChangesSince(seen);
+  EXPECT_TRUE(delta.reset);
+  ASSERT_EQ(delta.changes.size(), 1u);
+  EXPECT_EQ(delta.changes[0].name, "d");
+
+  // A consumer that saw the first removal can still catch up.
+  EXPECT_FALSE(feed.ChangesSince(seen + 1).reset);
+  // A version ahead of the jar, left over from a previous run, cannot.
+  EXPECT_TRUE(feed.ChangesSince(jar.version() + 10).reset);
+}
+
+TEST(CookieChangeFeed, NotifiesListener) {
+  CookieJar jar;
+  CookieChangeFeed feed(&jar);
+  int calls = 0;
+  feed.SetListener([&calls] { ++calls; });
+  jar.SetCookies("https://example.com/", {"a=1", "b=2"});
+  jar.Clear();
+  EXPECT_EQ(calls, 3);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,245 @@
+#include "cookie_jar.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(CookieJar, HostOnlyCookieIsNotSentToSubdomains) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/", {"sid=1"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/a"), "sid=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/a"), "");
+}
+
+TEST(CookieJar, DomainCookieIsSentToSubdomains) {
+  CookieJar jar;
+  jar.SetCookies("https://www.example.com/", {"sid=1; Domain=.Example.com"});
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/"), "sid=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "sid=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://notexample.com/"), "");
+}
+
+TEST(CookieJar, RejectsForeignDomain) {
+  CookieJar jar;
+  EXPECT_EQ(jar.SetCookies("https://example.com/", {"a=1; Domain=other.com"}),
+            0u);
+  EXPECT_EQ(jar.size(), 0u);
+}
+
+TEST(CookieJar, PathMatchingAndOrdering) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/",
+                 {"a=1; Path=/", "b=2; Path=/api", "c=3; Path=/apix"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/api/users"), "b=2; a=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/other"), "a=1");
+}
+
+TEST(CookieJar, DefaultPathComesFromRequestUrl) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/api/login", {"sid=1"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/api/me"), "sid=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "");
+}
+
+TEST(CookieJar, ReplacesAndRemoves) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/", {"sid=1; Path=/", "x=9; Path=/"});
+  jar.SetCookies("https://example.com/", {"sid=2; Path=/"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "sid=2; x=9");
+  jar.SetCookies("https://example.com/", {"sid=; Path=/; Max-Age=0"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "x=9");
+  EXPECT_EQ(jar.size(), 1u);
+}
+
+TEST(CookieJar, PastExpiresRemovesCookie) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/", {"sid=1; Path=/"});
+  jar.SetCookies("https://example.com/",
+                 {"sid=1; Path=/; Expires=Thu, 01 Jan 1970 00:00:00 GMT"});
+  EXPECT_EQ(jar.size(), 0u);
+}
+
+TEST(CookieJar, SecureCookiesNeedSecureScheme) {
+  CookieJar jar;
+  EXPECT_EQ(jar.SetCookies("http://example.com/", {"a=1; Secure"}), 0u);
+  jar.SetCookies("https://example.com/", {"a=1; Secure"});
+  EXPECT_EQ(jar.GetCookieHeader("http://example.com/"), "");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1");
+}
+
+TEST(CookieJar, IpHostsOnlyMatchExactly) {
+  CookieJar jar;
+  jar.SetCookies("http://10.0.0.1:8080/", {"a=1"});
+  EXPECT_EQ(jar.GetCookieHeader("http://10.0.0.1:8080/x"), "a=1");
+  EXPECT_EQ(jar.GetCookieHeader("http://0.0.1/"), "");
+}
+
+TEST(CookieJar, RejectsCookiesForPublicSuffixes) {
+  CookieJar jar;
+  EXPECT_EQ(jar.SetCookies("https://shop.example.co.uk/",
+                           {"a=1; Domain=co.uk", "b=2; Domain=uk",
+                            "c=3; Domain=example.co.uk"}),
+            1u);
+  EXPECT_EQ(jar.SetCookies("https://alice.github.io/",
+                           {"d=4; Domain=github.io"}),
+            0u);
+  EXPECT_EQ(jar.GetCookieHeader("https://other.co.uk/"), "");
+  EXPECT_EQ(jar.GetCookieHeader("https://www.example.co.uk/"), "c=3");
+  EXPECT_EQ(jar.GetCookieHeader("https://bob.github.io/"), "");
+}
+
+TEST(CookieJar, PublicSuffixHostKeepsItsOwnCookiesHostOnly) {
+  CookieJar jar;
+  EXPECT_EQ(jar.SetCookies("https://github.io/", {"a=1; Domain=github.io"}),
+            1u);
+  EXPECT_EQ(jar.GetCookieHeader("https://github.io/"), "a=1");
+  EXPECT_EQ(jar.GetCookieHeader("https://alice.github.io/"), "");
+}
+
+TEST(CookieJar, MatchesEveryDomainOfTheHost) {
+  CookieJar jar;
+  jar.SetCookies("https://a.b.example.com/",
+                 {"host=1", "b=2; Domain=b.example.com",
+                  "root=3; Domain=example.com"});
+  jar.SetCookies("https://example.org/", {"other=4"});
+  EXPECT_EQ(jar.GetCookieHeader("https://a.b.example.com/"),
+            "host=1; b=2; root=3");
+  EXPECT_EQ(jar.GetCookieHeader("https://c.b.example.com/"), "b=2; root=3");
+  EXPECT_EQ(jar.GetCookieHeader("https://b.example.com/"), "b=2; root=3");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "root=3");
+  EXPECT_EQ(jar.GetCookieHeader("https://com/"), "");
+}
+
+TEST(CookieJar, SyncCookiesAppliesOnlyTheDiff) {
+  CookieJar jar;
+  jar.SetCookies("https://example.com/",
+                 {"a=1; Path=/", "b=2; Path=/", "c=3; Path=/",
+                  "d=4; Path=/api", "e=5; Domain=example.com; Path=/"});
+
+  // b is unchanged, a changes, c goes away and f is new. Cookies outside
+  // the host-only "/" set are left alone.
+  EXPECT_EQ(jar.SyncCookies("https://example.com/x",
+                            {{"a", "10"}, {"b", "2"}, {"f", "6"}}),
+            3u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/api"),
+            "d=4; a=10; b=2; e=5; f=6");
+
+  EXPECT_EQ(jar.SyncCookies("https://example.com/",
+                            {{"a", "10"}, {"b", "2"}, {"f", "6"}}),
+            0u);
+  EXPECT_EQ(jar.SyncCookies("not a url", {{"a", "1"}}), 0u);
+}
+
+TEST(CookieJar, SyncCookiesKeepsTheAttributesOfWhatItUpdates) {
+  CookieJar jar;
+  jar.SetCookies("https://www.example.com/app/",
+                 {"parent=1; Domain=example.com; Path=/; Max-Age=3600",
+                  "narrow=2; Path=/app; Secure; HttpOnly",
+                  "root=3; Path=/"});
+
+  // The pairs of the Cookie header for the URL, two of them changed.
+  EXPECT_EQ(jar.SyncCookies("https://www.example.com/app/page",
+                            {{"narrow", "20"}, {"root", "3"},
+                             {"parent", "10"}}),
+            2u);
+  std::vector<std::string> cookies;
+  jar.ForEach([&cookies](const Cookie& cookie) {
+    cookies.push_back(std::string(cookie.name) + "=" +
+                      std::string(cookie.value) + " " +
+                      std::string(cookie.domain) + std::string(cookie.path) +
+                      (cookie.host_only ? " host-only" : "") +
+                      (cookie.secure ? " secure" : "") +
+                      (cookie.expires != kNoExpiry ? " expires" : ""));
+  });
+  std::sort(cookies.begin(), cookies.end());
+  EXPECT_EQ(cookies, (std::vector<std::string>{
+                         "narrow=20 www.example.com/app host-only secure",
+                         "parent=10 example.com/ expires",
+                         "root=3 www.example.com/ host-only",
+                     }));
+  // The parent domain cookie still reaches the other hosts.
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/"), "parent=10");
+}
+
+TEST(CookieJar, RemovesCookiesOnceTheyExpire) {
+  CookieJar jar;
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  jar.SetCookies("https://example.com/",
+                 {"short=1; Max-Age=60", "long=2; Max-Age=3600", "session=3"});
+  EXPECT_EQ(jar.RemoveExpired(now + 30), 0u);
+  EXPECT_EQ(jar.RemoveExpired(now + 120), 1u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "long=2; session=3");
+
+  // Renewing a cookie supersedes its timer.
+  jar.SetCookies("https://example.com/", {"long=4; Max-Age=86400"});
+  EXPECT_EQ(jar.RemoveExpired(now + 7200), 0u);
+  EXPECT_EQ(jar.RemoveExpired(now + 90000), 1u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "session=3");
+  EXPECT_EQ(jar.stats().expired, 2u);
+  EXPECT_EQ(jar.stats().evicted, 0u);
+}
+
+TEST(CookieJar, NeverSendsExpiredCookies) {
+  CookieJar jar;
+  Cookie stale;
+  stale.name = "stale";
+  stale.value = "1";
+  stale.domain = "example.com";
+  stale.path = "/";
+  stale.expires = static_cast<int64_t>(std::time(nullptr)) - 10;
+  stale.Own();
+  jar.Restore(std::move(stale), false);
+  jar.SetCookies("https://example.com/", {"fresh=2"});
+  EXPECT_EQ(jar.size(), 1u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "fresh=2");
+  EXPECT_EQ(jar.stats().expired, 1u);
+}
+
+TEST(CookieJar, EvictsTheLeastRecentlyStoredCookies) {
+  CookieJar jar(CookieJarLimits{2, 3});
+  jar.SetCookies("https://example.com/", {"a=1", "b=2"});
+  // Storing a again makes b the oldest of the domain.
+  jar.SetCookies("https://example.com/", {"a=3", "c=4"});
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=3; c=4");
+  EXPECT_EQ(jar.stats().evicted, 1u);
+
+  jar.SetCookies("https://example.org/", {"d=5", "e=6"});
+  EXPECT_EQ(jar.size(), 3u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "c=4");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.org/"), "d=5; e=6");
+  EXPECT_EQ(jar.stats().evicted, 2u);
+}
+
+TEST(CookieJar, ReplaceDomainAppliesOnlyTheDiff) {
+  CookieJar other;
+  other.SetCookies("https://example.com/", {"a=1", "b=2", "c=3"});
+  other.SetCookies("https://example.com/", {"b=20", "d=4"});
+  std::vector<Cookie> cookies;
+  other.ForEachInDomain("example.com", [&cookies](const Cookie& cookie) {
+    cookies.push_back(cookie.Copy());
+  });
+
+  CookieJar jar(CookieJarLimits{4, 4});
+  jar.SetCookies("https://example.com/", {"x=0", "b=2", "c=3"});
+  jar.SetCookies("https://example.org/", {"y=5"});
+  // x goes, a and d are new, b changes and c is left alone.
+  EXPECT_EQ(jar.ReplaceDomain("example.com", cookies), 4u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1; b=20; c=3; d=4");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.org/"), "y=5");
+  // Five cookies are over the limit, but the moved ones are not evicted.
+  EXPECT_EQ(jar.size(), 5u);
+  EXPECT_EQ(jar.stats().evicted, 0u);
+
+  EXPECT_EQ(jar.ReplaceDomain("example.com", cookies), 0u);
+  EXPECT_EQ(jar.ReplaceDomain("example.com", {}), 4u);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "");
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
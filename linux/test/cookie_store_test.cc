@@ -0,0 +1,237 @@
+#include "cookie_store.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+class CookieStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/cookie_store_test_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+    path_ = directory_ + "/cookies.log";
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    rmdir(directory_.c_str());
+  }
+
+  off_t FileSize() {
+    struct stat info = {};
+    stat(path_.c_str(), &info);
+    return info.st_size;
+  }
+
+  std::string FileContents() {
+    std::ifstream file(path_, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+  }
+
+  static std::unique_ptr<CookieKeyProvider> Keys(uint8_t fill) {
+    CookieKey key;
+    key.fill(fill);
+    return std::make_unique<StaticKeyProvider>(key);
+  }
+
+  std::string directory_;
+  std::string path_;
+};
+
+}  // namespace
+
+TEST_F(CookieStoreTest, RoundTripsCookies) {
+  {
+    CookieJar jar;
+    CookieStore store(path_);
+    ASSERT_TRUE(store.Open(&jar));
+    jar.SetCookies("https://example.com/",
+                   {"a=1; Path=/", "b=2; Path=/; Domain=example.com; Secure"});
+    jar.SetCookies("https://example.com/", {"a=3; Path=/"});
+  }
+  CookieJar jar;
+  CookieStore store(path_);
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.size(), 2u);
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/"), "b=2");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=3; b=2");
+}
+
+TEST_F(CookieStoreTest, WritesAreProportionalToChanges) {
+  CookieJar jar;
+  CookieStore store(path_);
+  ASSERT_TRUE(store.Open(&jar));
+  for (int i = 0; i < 50; ++i) {
+    jar.SetCookies("https://example.com/",
+                   {"c" + std::to_string(i) + "=v; Path=/"});
+  }
+  off_t before = FileSize();
+  jar.SetCookies("https://example.com/", {"c0=w; Path=/"});
+  EXPECT_LT(FileSize() - before, 64);
+}
+
+TEST_F(CookieStoreTest, DeletionsAndClearPersist) {
+  {
+    CookieJar jar;
+    CookieStore store(path_);
+    ASSERT_TRUE(store.Open(&jar));
+    jar.SetCookies("https://example.com/", {"a=1; Path=/", "b=2; Path=/"});
+    jar.SetCookies("https://example.com/", {"a=; Path=/; Max-Age=0"});
+  }
+  {
+    CookieJar jar;
+    CookieStore store(path_);
+    ASSERT_TRUE(store.Open(&jar));
+    EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "b=2");
+    jar.Clear();
+  }
+  CookieJar jar;
+  CookieStore store(path_);
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.size(), 0u);
+}
+
+TEST_F(CookieStoreTest, TruncatesTornTail) {
+  {
+    CookieJar jar;
+    CookieStore store(path_);
+    ASSERT_TRUE(store.Open(&jar));
+    jar.SetCookies("https://example.com/", {"a=1; Path=/", "b=2; Path=/"});
+  }
+  // Simulate a crash halfway through writing the last record.
+  off_t full = FileSize();
+  ASSERT_EQ(truncate(path_.c_str(), full - 3), 0);
+
+  CookieJar jar;
+  CookieStore store(path_);
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1");
+  EXPECT_EQ(store.discarded_on_open(), 1u);
+  EXPECT_LT(FileSize(), full - 3);
+
+  // Appends after recovery are readable again.
+  jar.SetCookies("https://example.com/", {"c=3; Path=/"});
+  CookieJar reopened;
+  CookieStore reopened_store(path_);
+  ASSERT_TRUE(reopened_store.Open(&reopened));
+  EXPECT_EQ(reopened.GetCookieHeader("https://example.com/"), "a=1; c=3");
+}
+
+TEST_F(CookieStoreTest, CompactsOnceDeadRecordsDominate) {
+  CookieJar jar;
+  CookieStore store(path_, /*compaction_threshold=*/16);
+  ASSERT_TRUE(store.Open(&jar));
+  for (int i = 0; i < 40; ++i) {
+    jar.SetCookies("https://example.com/",
+                   {"sid=" + std::to_string(i) + "; Path=/"});
+  }
+  store.WaitForCompaction();
+  // Forty appends for one live cookie; without compaction all would remain.
+  EXPECT_LT(store.record_count(), 40u);
+
+  CookieJar reopened;
+  CookieStore reopened_store(path_);
+  ASSERT_TRUE(reopened_store.Open(&reopened));
+  EXPECT_EQ(reopened.GetCookieHeader("https://example.com/"), "sid=39");
+}
+
+TEST_F(CookieStoreTest, ReplacesForeignFile) {
+  FILE* file = fopen(path_.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  fputs("sid=legacy; other=1", file);
+  fclose(file);
+
+  CookieJar jar;
+  CookieStore store(path_);
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.size(), 0u);
+  jar.SetCookies("https://example.com/", {"a=1"});
+  EXPECT_EQ(store.record_count(), 1u);
+}
+
+TEST_F(CookieStoreTest, SealsRecords) {
+  {
+    CookieJar jar;
+    CookieStore store(path_, CookieStore::kDefaultCompactionThreshold,
+                      Keys(1));
+    ASSERT_TRUE(store.Open(&jar));
+    jar.SetCookies("https://example.com/",
+                   {"sid=hunter2; Path=/", "theme=dark; Path=/"});
+    jar.SetCookies("https://example.com/", {"theme=; Path=/; Max-Age=0"});
+  }
+  std::string contents = FileContents();
+  EXPECT_EQ(contents.find("hunter2"), std::string::npos);
+  EXPECT_EQ(contents.find("example.com"), std::string::npos);
+
+  {
+    CookieJar jar;
+    CookieStore store(path_, CookieStore::kDefaultCompactionThreshold,
+                      Keys(1));
+    ASSERT_TRUE(store.Open(&jar));
+    EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "sid=hunter2");
+  }
+  // Without the key the log is unreadable, and starts over.
+  CookieJar jar;
+  CookieStore store(path_, CookieStore::kDefaultCompactionThreshold, Keys(2));
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.size(), 0u);
+}
+
+TEST_F(CookieStoreTest, SealsAPlaintextLogWhenOpenedWithAKey) {
+  {
+    CookieJar jar;
+    CookieStore store(path_);
+    ASSERT_TRUE(store.Open(&jar));
+    jar.SetCookies("https://example.com/", {"sid=hunter2; Path=/"});
+  }
+  {
+    CookieJar jar;
+    CookieStore store(path_, CookieStore::kDefaultCompactionThreshold,
+                      Keys(1));
+    ASSERT_TRUE(store.Open(&jar));
+    EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "sid=hunter2");
+    EXPECT_EQ(FileContents().find("hunter2"), std::string::npos);
+    jar.SetCookies("https://example.com/", {"lang=en; Path=/"});
+  }
+  CookieJar jar;
+  CookieStore store(path_, CookieStore::kDefaultCompactionThreshold, Keys(1));
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"),
+            "sid=hunter2; lang=en");
+}
+
+TEST_F(CookieStoreTest, LoadsLargeSealedLogs) {
+  constexpr int kCookies = 4000;
+  {
+    CookieJar jar(CookieJarLimits{kCookies, kCookies});
+    CookieStore store(path_, CookieStore::kDefaultCompactionThreshold,
+                      Keys(1));
+    ASSERT_TRUE(store.Open(&jar));
+    for (int i = 0; i < kCookies; ++i) {
+      jar.SetCookies("https://example.com/",
+                     {"c" + std::to_string(i) + "=" + std::to_string(i)});
+    }
+  }
+  // A torn last record costs that record alone.
+  ASSERT_EQ(truncate(path_.c_str(), FileSize() - 1), 0);
+  CookieJar jar(CookieJarLimits{kCookies, kCookies});
+  CookieStore store(path_, CookieStore::kDefaultCompactionThreshold, Keys(1));
+  ASSERT_TRUE(store.Open(&jar));
+  EXPECT_EQ(jar.size(), static_cast<size_t>(kCookies - 1));
+  EXPECT_EQ(store.discarded_on_open(), 1u);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,108 @@
+#include "domain_trie.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+std::vector<std::pair<int, bool>> Suffixes(const DomainTrie<int>& trie,
+                                           std::string_view host) {
+  std::vector<std::pair<int, bool>> found;
+  trie.ForEachSuffix(host, [&found](int value, bool exact) {
+    found.emplace_back(value, exact);
+  });
+  return found;
+}
+
+}  // namespace
+
+TEST(DomainTrie, FindsStoredDomains) {
+  DomainTrie<int> trie;
+  trie.FindOrInsert("example.com") = 1;
+  trie.FindOrInsert("api.example.com") = 2;
+  EXPECT_EQ(trie.size(), 2u);
+  ASSERT_NE(trie.Find("example.com"), nullptr);
+  EXPECT_EQ(*trie.Find("example.com"), 1);
+  EXPECT_EQ(*trie.Find("api.example.com"), 2);
+  // Nodes on the way to a value hold none themselves.
+  EXPECT_EQ(trie.Find("com"), nullptr);
+  EXPECT_EQ(trie.Find("www.example.com"), nullptr);
+  EXPECT_EQ(trie.Find("example.org"), nullptr);
+  // Labels match whole, not as string suffixes.
+  EXPECT_EQ(trie.Find("xample.com"), nullptr);
+}
+
+TEST(DomainTrie, WalksFromTheTopLevelDomainDown) {
+  DomainTrie<int> trie;
+  trie.FindOrInsert("com") = 0;
+  trie.FindOrInsert("example.com") = 1;
+  trie.FindOrInsert("a.b.example.com") = 3;
+  trie.FindOrInsert("notexample.com") = 9;
+  using Found = std::vector<std::pair<int, bool>>;
+  EXPECT_EQ(Suffixes(trie, "a.b.example.com"),
+            (Found{{0, false}, {1, false}, {3, true}}));
+  EXPECT_EQ(Suffixes(trie, "b.example.com"), (Found{{0, false}, {1, false}}));
+  EXPECT_EQ(Suffixes(trie, "example.com"), (Found{{0, false}, {1, true}}));
+  EXPECT_EQ(Suffixes(trie, "x.a.b.example.com"),
+            (Found{{0, false}, {1, false}, {3, false}}));
+  EXPECT_EQ(Suffixes(trie, "example.org"), Found());
+}
+
+TEST(DomainTrie, EraseRemovesEmptyBranches) {
+  DomainTrie<int> trie;
+  trie.FindOrInsert("a.b.example.com") = 1;
+  trie.FindOrInsert("example.com") = 2;
+  EXPECT_FALSE(trie.Erase("b.example.com"));
+  EXPECT_TRUE(trie.Erase("a.b.example.com"));
+  EXPECT_FALSE(trie.Erase("a.b.example.com"));
+  EXPECT_EQ(trie.size(), 1u);
+  EXPECT_EQ(*trie.Find("example.com"), 2);
+  EXPECT_TRUE(trie.Erase("example.com"));
+  EXPECT_TRUE(trie.empty());
+
+  int visited = 0;
+  trie.ForEach([&visited](int) { ++visited; });
+  EXPECT_EQ(visited, 0);
+}
+
+TEST(DomainTrie, CopiesAreIndependent) {
+  DomainTrie<std::string> trie;
+  trie.FindOrInsert("example.com") = "a";
+  DomainTrie<std::string> copy = trie;
+  copy.FindOrInsert("example.com") = "b";
+  copy.FindOrInsert("example.org") = "c";
+  EXPECT_EQ(*trie.Find("example.com"), "a");
+  EXPECT_EQ(trie.Find("example.org"), nullptr);
+  EXPECT_EQ(copy.size(), 2u);
+}
+
+TEST(DomainTrie, ForEachDifferenceVisitsOnlyChangedDomains) {
+  DomainTrie<int> trie;
+  trie.FindOrInsert("example.com") = 1;
+  trie.FindOrInsert("api.example.com") = 2;
+  trie.FindOrInsert("example.org") = 3;
+  DomainTrie<int> other = trie;
+  other.FindOrInsert("api.example.com") = 20;
+  other.Erase("example.org");
+  other.FindOrInsert("a.b.example.net") = 4;
+
+  std::vector<std::string> differences;
+  trie.ForEachDifference(other, [&](const int* mine, const int* theirs) {
+    differences.push_back((mine != nullptr ? std::to_string(*mine) : "-") +
+                          ":" +
+                          (theirs != nullptr ? std::to_string(*theirs) : "-"));
+  });
+  std::sort(differences.begin(), differences.end());
+  EXPECT_EQ(differences, (std::vector<std::string>{"-:4", "2:20", "3:-"}));
+  trie.ForEachDifference(trie, [](const int*, const int*) { FAIL(); });
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
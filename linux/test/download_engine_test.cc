@@ -0,0 +1,354 @@
+#include "download_engine.h"
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "test/test_http_server.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+class DownloaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/download_engine_test_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+    path_ = directory_ + "/file.bin";
+  }
+
+  void TearDown() override {
+    for (const char* suffix : {"", ".part", ".part.state"}) {
+      unlink((path_ + suffix).c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  DownloadOptions Options(const std::string& url) {
+    DownloadOptions options;
+    options.url = url;
+    options.path = path_;
+    options.min_segment_size = 1024 * 1024;
+    return options;
+  }
+
+  bool Exists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+  }
+
+  // Checks that the finished file holds the server's body of |size| bytes.
+  void ExpectBody(int64_t size) {
+    FILE* file = fopen(path_.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    std::vector<char> buffer(1024 * 1024);
+    int64_t offset = 0;
+    size_t read;
+    while ((read = fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+      for (size_t i = 0; i < read; ++i, ++offset) {
+        if (buffer[i] != TestHttpServer::ByteAt(offset)) {
+          fclose(file);
+          FAIL() << "content differs at offset " << offset;
+        }
+      }
+    }
+    fclose(file);
+    EXPECT_EQ(offset, size);
+    EXPECT_FALSE(Exists(path_ + ".part"));
+    EXPECT_FALSE(Exists(path_ + ".part.state"));
+  }
+
+  // The hex SHA-256 of the server's body of |size| bytes.
+  static std::string ExpectedSha256(int64_t size) {
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(context, EVP_sha256(), nullptr);
+    std::vector<char> buffer(64 * 1024);
+    for (int64_t offset = 0; offset < size;) {
+      size_t count = static_cast<size_t>(
+          std::min<int64_t>(size - offset, buffer.size()));
+      for (size_t i = 0; i < count; ++i) {
+        buffer[i] = TestHttpServer::ByteAt(offset + i);
+      }
+      EVP_DigestUpdate(context, buffer.data(), count);
+      offset += count;
+    }
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(context, digest, &length);
+    EVP_MD_CTX_free(context);
+    std::string hex;
+    for (unsigned int i = 0; i < length; ++i) {
+      char pair[3];
+      snprintf(pair, sizeof(pair), "%02x", digest[i]);
+      hex += pair;
+    }
+    return hex;
+  }
+
+  TestHttpServer server_;
+  std::string directory_;
+  std::string path_;
+};
+
+TEST_F(DownloaderTest, StreamsWholeFileWithoutRanges) {
+  TestResource resource;
+  resource.size = 3 * 1024 * 1024 + 17;
+  resource.ranges = false;
+  server_.Add("/file", resource);
+
+  DownloadResult result = Downloader(Options(server_.Url("/file"))).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.status, 200);
+  EXPECT_EQ(result.bytes, resource.size);
+  EXPECT_EQ(result.segments, 1);
+  EXPECT_FALSE(result.resumed);
+  EXPECT_EQ(result.sha256, ExpectedSha256(resource.size));
+  ExpectBody(resource.size);
+}
+
+TEST_F(DownloaderTest, StreamsChunkedBodyOfUnknownLength) {
+  TestResource resource;
+  resource.size = 700 * 1024 + 3;
+  resource.ranges = false;
+  resource.chunked = true;
+  server_.Add("/file", resource);
+
+  DownloadResult result = Downloader(Options(server_.Url("/file"))).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.bytes, resource.size);
+  ExpectBody(resource.size);
+}
+
+TEST_F(DownloaderTest, SplitsLargeFilesIntoParallelSegments) {
+  TestResource resource;
+  resource.size = 10 * 1024 * 1024 + 5;
+  server_.Add("/file", resource);
+
+  DownloadResult result = Downloader(Options(server_.Url("/file"))).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.segments, 4);
+  ExpectBody(resource.size);
+
+  std::vector<TestRequest> requests = server_.requests();
+  ASSERT_EQ(requests.size(), 4u);
+  EXPECT_EQ(requests[0].headers["range"], "bytes=0-");
+  for (size_t i = 1; i < requests.size(); ++i) {
+    EXPECT_EQ(requests[i].headers["if-range"], "\"v1\"");
+  }
+}
+
+TEST_F(DownloaderTest, DecodesCompressedFilesInOnePiece) {
+  int64_t size = 3 * 1024 * 1024 + 1;
+  std::string plain(static_cast<size_t>(size), '\0');
+  for (int64_t i = 0; i < size; ++i) {
+    plain[static_cast<size_t>(i)] = TestHttpServer::ByteAt(i);
+  }
+  TestResource resource;
+  ASSERT_TRUE(EncodeContent(ContentCoding::kGzip, plain, 0, &resource.body));
+  resource.headers = {"Content-Encoding: gzip"};
+  server_.Add("/file", resource);
+
+  CompressionPolicy policy;
+  policy.Configure("127.0.0.1", CompressionOptions());
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.compression = &policy;
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.bytes, size);
+  EXPECT_EQ(result.segments, 1);
+  EXPECT_EQ(result.sha256, ExpectedSha256(size));
+  ExpectBody(size);
+  EXPECT_EQ(server_.requests().size(), 1u);
+  EXPECT_EQ(policy.Stats("").responses_decoded, 1u);
+}
+
+TEST_F(DownloaderTest, AsksHostsWithoutOptionsForNoCoding) {
+  TestResource resource;
+  resource.size = 10 * 1024 * 1024 + 5;
+  server_.Add("/file", resource);
+
+  // The default options are for API requests.
+  CompressionPolicy policy;
+  policy.Configure("", CompressionOptions());
+  policy.Configure("cdn.example.com", CompressionOptions());
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.compression = &policy;
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.segments, 4);
+  ExpectBody(resource.size);
+  for (const TestRequest& request : server_.requests()) {
+    EXPECT_EQ(request.headers.count("accept-encoding"), 0u);
+  }
+}
+
+TEST_F(DownloaderTest, RetriesFromWhereTheConnectionDropped) {
+  TestResource resource;
+  resource.size = 3 * 1024 * 1024;
+  resource.fail_at = 1536 * 1024 + 100;
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.min_segment_size = resource.size;
+
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  ExpectBody(resource.size);
+
+  std::vector<TestRequest> requests = server_.requests();
+  ASSERT_EQ(requests.size(), 2u);
+  EXPECT_EQ(requests[1].headers["range"],
+            "bytes=" + std::to_string(resource.fail_at) + "-" +
+                std::to_string(resource.size - 1));
+}
+
+TEST_F(DownloaderTest, ResumesAnInterruptedDownload) {
+  TestResource resource;
+  resource.size = 4 * 1024 * 1024;
+  resource.fail_at = 3 * 1024 * 1024 + 7;
+  resource.gone_after_failure = true;
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.min_segment_size = resource.size;
+
+  DownloadResult first = Downloader(options).Run();
+  EXPECT_FALSE(first.ok);
+  EXPECT_EQ(first.status, 404);
+  EXPECT_TRUE(Exists(path_ + ".part"));
+  EXPECT_TRUE(Exists(path_ + ".part.state"));
+
+  int64_t cut = resource.fail_at;
+  resource.fail_at = -1;
+  server_.Add("/file", resource);
+  size_t requests_before = server_.requests().size();
+  DownloadResult second = Downloader(options).Run();
+  ASSERT_TRUE(second.ok) << second.error;
+  EXPECT_TRUE(second.resumed);
+  EXPECT_EQ(second.sha256, ExpectedSha256(resource.size));
+  ExpectBody(resource.size);
+
+  // Only the missing tail is fetched again.
+  std::vector<TestRequest> requests = server_.requests();
+  ASSERT_EQ(requests.size(), requests_before + 1);
+  EXPECT_EQ(requests.back().headers["range"],
+            "bytes=" + std::to_string(cut) + "-" +
+                std::to_string(resource.size - 1));
+}
+
+TEST_F(DownloaderTest, StartsOverWhenTheResourceChanged) {
+  TestResource resource;
+  resource.size = 2 * 1024 * 1024;
+  resource.fail_at = 1024 * 1024;
+  resource.gone_after_failure = true;
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.min_segment_size = resource.size;
+
+  EXPECT_FALSE(Downloader(options).Run().ok);
+  EXPECT_TRUE(Exists(path_ + ".part.state"));
+
+  resource.fail_at = -1;
+  resource.etag = "\"v2\"";
+  server_.Add("/file", resource);
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_FALSE(result.resumed);
+  ExpectBody(resource.size);
+}
+
+TEST_F(DownloaderTest, ReportsThrottledProgressAndHashesWhileWriting) {
+  TestResource resource;
+  resource.size = 10 * 1024 * 1024 + 5;
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.chunk_size = 64 * 1024;
+  options.progress_interval_ms = 20;
+  std::vector<DownloadProgress> reports;
+  std::vector<std::chrono::steady_clock::time_point> times;
+  options.on_progress = [&](const DownloadProgress& progress) {
+    reports.push_back(progress);
+    times.push_back(std::chrono::steady_clock::now());
+  };
+
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.segments, 4);
+  EXPECT_EQ(result.sha256, ExpectedSha256(resource.size));
+  ExpectBody(resource.size);
+
+  ASSERT_FALSE(reports.empty());
+  EXPECT_EQ(reports.back().received, resource.size);
+  EXPECT_EQ(reports.back().total, resource.size);
+  // Every report but the last waited out the interval.
+  for (size_t i = 1; i + 1 < times.size(); ++i) {
+    EXPECT_GE(times[i] - times[i - 1], std::chrono::milliseconds(19));
+    EXPECT_GE(reports[i].received, reports[i - 1].received);
+  }
+}
+
+TEST_F(DownloaderTest, FollowsRedirectsCarryingJarCookies) {
+  SharedCookieJar jar;
+  jar.SetCookies(server_.Url("/"), {"session=abc; Path=/"});
+  TestResource redirect;
+  redirect.redirect_to = "/file";
+  redirect.set_cookies = {"hop=1; Path=/"};
+  server_.Add("/start", redirect);
+  TestResource resource;
+  resource.size = 1000;
+  resource.set_cookies = {"served=yes; Path=/"};
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/start"));
+  options.jar = &jar;
+
+  DownloadResult result = Downloader(options).Run();
+  ASSERT_TRUE(result.ok) << result.error;
+  ExpectBody(resource.size);
+
+  std::vector<TestRequest> requests = server_.requests();
+  ASSERT_EQ(requests.size(), 2u);
+  EXPECT_EQ(requests[0].headers["cookie"], "session=abc");
+  EXPECT_EQ(requests[1].path, "/file");
+  EXPECT_EQ(requests[1].headers["cookie"], "session=abc; hop=1");
+  EXPECT_EQ(jar.GetCookieHeader(server_.Url("/")),
+            "session=abc; hop=1; served=yes");
+}
+
+TEST_F(DownloaderTest, FailsOnErrorStatusWithoutLeavingFiles) {
+  DownloadResult result = Downloader(Options(server_.Url("/missing"))).Run();
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.status, 404);
+  EXPECT_FALSE(result.error.empty());
+  EXPECT_FALSE(Exists(path_));
+  EXPECT_FALSE(Exists(path_ + ".part"));
+  EXPECT_FALSE(Exists(path_ + ".part.state"));
+}
+
+// Memory stays flat however large the file: a 128 MiB download must not
+// raise the peak RSS by more than the buffers it streams through.
+TEST_F(DownloaderTest, LargeDownloadKeepsMemoryFlat) {
+  TestResource resource;
+  resource.size = 128ll * 1024 * 1024;
+  server_.Add("/file", resource);
+  DownloadOptions options = Options(server_.Url("/file"));
+  options.min_segment_size = 8 * 1024 * 1024;
+
+  rusage before;
+  getrusage(RUSAGE_SELF, &before);
+  DownloadResult result = Downloader(options).Run();
+  rusage after;
+  getrusage(RUSAGE_SELF, &after);
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(result.segments, 4);
+  EXPECT_LT(after.ru_maxrss - before.ru_maxrss, 32 * 1024);
+  ExpectBody(resource.size);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
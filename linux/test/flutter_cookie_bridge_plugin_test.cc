@@ -0,0 +1,376 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <ctime>
+#include <utility>
+
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_plugin.h"
+#include "flutter_cookie_bridge_plugin_private.h"
+
+// This demonstrates a simple unit test of the C portion of this plugin's
+// implementation.
+//
+// Once you have built the plugin's example app, you can run these tests
+// from the command line. For instance, for a plugin called my_plugin
+// built for x64 debug, run:
+// $ build/linux/x64/debug/plugins/my_plugin/my_plugin_test
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(FlutterCookieBridgePlugin, GetPlatformVersion) {
+  g_autoptr(FlMethodResponse) response = get_platform_version();
+  ASSERT_NE(response, nullptr);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response));
+  ASSERT_EQ(fl_value_get_type(result), FL_VALUE_TYPE_STRING);
+  // The full string varies, so just validate that it has the right format.
+  EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
+}
+
+TEST(FlutterCookieBridgePlugin, SetThenGetCookieHeader) {
+  SharedCookieJar jar;
+
+  g_autoptr(FlValue) set_args = fl_value_new_map();
+  fl_value_set_string_take(set_args, "url",
+                           fl_value_new_string("https://api.example.com/v1"));
+  g_autoptr(FlValue) cookies = fl_value_new_list();
+  fl_value_append_take(cookies, fl_value_new_string("sid=abc; Path=/"));
+  fl_value_set_string(set_args, "cookies", cookies);
+  g_autoptr(FlMethodResponse) set_response = set_cookies(&jar, set_args);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(set_response));
+
+  g_autoptr(FlValue) get_args = fl_value_new_map();
+  fl_value_set_string_take(get_args, "url",
+                           fl_value_new_string("https://api.example.com/x"));
+  g_autoptr(FlMethodResponse) get_response = get_cookie_header(&jar, get_args);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(get_response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(get_response));
+  ASSERT_EQ(fl_value_get_type(result), FL_VALUE_TYPE_STRING);
+  EXPECT_STREQ(fl_value_get_string(result), "sid=abc");
+
+  g_autoptr(FlMethodResponse) clear_response = clear_cookies(&jar);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(clear_response));
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/x"), "");
+}
+
+TEST(FlutterCookieBridgePlugin, SetCookiesRejectsMissingUrl) {
+  SharedCookieJar jar;
+  g_autoptr(FlValue) args = fl_value_new_map();
+  g_autoptr(FlMethodResponse) response = set_cookies(&jar, args);
+  EXPECT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response));
+}
+
+TEST(FlutterCookieBridgePlugin, SyncCookiesAppliesDiff) {
+  SharedCookieJar jar;
+  jar.SetCookies("https://example.com/", {"a=1; Path=/", "stale=1; Path=/"});
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "url",
+                           fl_value_new_string("https://example.com/"));
+  g_autoptr(FlValue) cookies = fl_value_new_map();
+  fl_value_set_string_take(cookies, "a", fl_value_new_string("1"));
+  fl_value_set_string_take(cookies, "b", fl_value_new_string("2"));
+  fl_value_set_string(args, "cookies", cookies);
+  g_autoptr(FlMethodResponse) response = sync_cookies(&jar, args);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response));
+  ASSERT_EQ(fl_value_get_type(result), FL_VALUE_TYPE_INT);
+  EXPECT_EQ(fl_value_get_int(result), 2);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1; b=2");
+}
+
+TEST(FlutterCookieBridgePlugin, GetCookiesSkipsExpiredCookies) {
+  SharedCookieJar jar;
+  jar.SetCookies("https://example.com/", {"fresh=1"});
+  jar.Locked([](CookieJar* cookies) {
+    Cookie stale;
+    stale.name = "stale";
+    stale.value = "2";
+    stale.domain = "example.com";
+    stale.path = "/";
+    stale.expires = static_cast<int64_t>(std::time(nullptr)) - 10;
+    stale.Own();
+    cookies->Restore(std::move(stale), false);
+  });
+
+  g_autoptr(FlMethodResponse) response = get_cookies(&jar);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response));
+  ASSERT_EQ(fl_value_get_type(result), FL_VALUE_TYPE_LIST);
+  ASSERT_EQ(fl_value_get_length(result), 1u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_get_list_value(result, 0)),
+               "fresh=1");
+}
+
+TEST(FlutterCookieBridgePlugin, SwitchAndDeleteCookiePartitions) {
+  SharedCookieJar jar;
+  jar.SetCookies("https://example.com/", {"a=1"});
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "name", fl_value_new_string("partner"));
+  fl_value_set_string_take(args, "from", fl_value_new_string("default"));
+  g_autoptr(FlMethodResponse) fork = switch_cookie_partition(&jar, args);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(fork));
+  EXPECT_EQ(jar.active_partition(), "partner");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1");
+
+  g_autoptr(FlValue) back = fl_value_new_map();
+  fl_value_set_string_take(back, "name", fl_value_new_string("default"));
+  g_autoptr(FlMethodResponse) response = switch_cookie_partition(&jar, back);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  EXPECT_EQ(jar.active_partition(), "default");
+
+  g_autoptr(FlMethodResponse) deleted = delete_cookie_partition(&jar, args);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(deleted));
+  EXPECT_TRUE(fl_value_get_bool(fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(deleted))));
+
+  g_autoptr(FlValue) empty = fl_value_new_map();
+  g_autoptr(FlMethodResponse) missing = switch_cookie_partition(&jar, empty);
+  EXPECT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(missing));
+}
+
+TEST(FlutterCookieBridgePlugin, EncodeCookieDelta) {
+  CookieDelta delta;
+  delta.version = 7;
+  CookieChange change;
+  change.name = "sid";
+  change.domain = "example.com";
+  change.path = "/";
+  change.removed = true;
+  delta.changes.push_back(change);
+
+  g_autoptr(FlValue) event = encode_cookie_delta(delta);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(event, "version")), 7);
+  EXPECT_FALSE(fl_value_get_bool(fl_value_lookup_string(event, "reset")));
+  FlValue* changes = fl_value_lookup_string(event, "changes");
+  ASSERT_EQ(fl_value_get_length(changes), 1u);
+  FlValue* entry = fl_value_get_list_value(changes, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(entry, "name")),
+               "sid");
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(entry, "removed")));
+}
+
+TEST(FlutterCookieBridgePlugin, DownloadArgumentsAndResponse) {
+  DownloadOptions options;
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "url",
+                           fl_value_new_string("https://example.com/a.zip"));
+  EXPECT_FALSE(download_options_from_args(args, &options));
+
+  fl_value_set_string_take(args, "path", fl_value_new_string("/tmp/a.zip"));
+  g_autoptr(FlValue) headers = fl_value_new_map();
+  fl_value_set_string_take(headers, "User-Agent", fl_value_new_string("x"));
+  fl_value_set_string(args, "headers", headers);
+  fl_value_set_string_take(args, "segments", fl_value_new_int(2));
+  ASSERT_TRUE(download_options_from_args(args, &options));
+  EXPECT_EQ(options.path, "/tmp/a.zip");
+  EXPECT_EQ(options.max_segments, 2);
+  ASSERT_EQ(options.headers.size(), 1u);
+  EXPECT_EQ(options.headers[0].value, "x");
+
+  DownloadResult result;
+  result.ok = true;
+  result.bytes = 42;
+  result.segments = 1;
+  g_autoptr(FlMethodResponse) success = download_response(options, result);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(success));
+  FlValue* value = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(success));
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "bytes")), 42);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(value, "path")),
+               "/tmp/a.zip");
+
+  result.ok = false;
+  result.status = 403;
+  result.error = "HTTP 403";
+  g_autoptr(FlMethodResponse) failure = download_response(options, result);
+  EXPECT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(failure));
+}
+
+TEST(FlutterCookieBridgePlugin, EncodeDownloadEvent) {
+  DownloadOptions options;
+  options.path = "/tmp/a.zip";
+  DownloadProgress progress;
+  progress.received = 512;
+  progress.total = 1024;
+  progress.bytes_per_second = 2048;
+
+  g_autoptr(FlValue) update =
+      encode_download_event("7", progress, options, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(update, "id")), "7");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(update, "received")), 512);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(update, "total")), 1024);
+  EXPECT_FALSE(fl_value_get_bool(fl_value_lookup_string(update, "done")));
+  EXPECT_EQ(fl_value_lookup_string(update, "sha256"), nullptr);
+
+  DownloadResult result;
+  result.ok = true;
+  result.sha256 = "ab";
+  g_autoptr(FlValue) done =
+      encode_download_event("7", progress, options, &result);
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(done, "done")));
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(done, "sha256")),
+               "ab");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(done, "path")),
+               "/tmp/a.zip");
+}
+
+TEST(FlutterCookieBridgePlugin, HttpRequestArgumentsAndResponse) {
+  HttpRequest request;
+  int timeout_ms = 30000;
+  bool use_cache = true;
+  bool json = true;
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "url",
+                           fl_value_new_string("https://example.com/api"));
+  EXPECT_FALSE(
+      http_request_from_args(args, &request, &timeout_ms, &use_cache, &json));
+
+  fl_value_set_string_take(args, "method", fl_value_new_string("POST"));
+  const uint8_t body[] = {'{', '}'};
+  fl_value_set_string_take(args, "body", fl_value_new_uint8_list(body, 2));
+  fl_value_set_string_take(args, "timeoutMs", fl_value_new_int(5000));
+  ASSERT_TRUE(
+      http_request_from_args(args, &request, &timeout_ms, &use_cache, &json));
+  EXPECT_EQ(request.method, "POST");
+  EXPECT_EQ(request.body, "{}");
+  EXPECT_EQ(timeout_ms, 5000);
+  EXPECT_FALSE(use_cache);
+  EXPECT_FALSE(json);
+
+  HttpResponse response;
+  response.status = 200;
+  response.headers = {{"Set-Cookie", "a=1"}, {"set-cookie", "b=2"}};
+  g_autoptr(FlMethodResponse) success =
+      http_response(true, response, "ok", nullptr, CacheOutcome::kBypassed, "");
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(success));
+  FlValue* value = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(success));
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "status")), 200);
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(value, "body")), 2u);
+  FlValue* cookies = fl_value_lookup_string(
+      fl_value_lookup_string(value, "headers"), "set-cookie");
+  ASSERT_NE(cookies, nullptr);
+  EXPECT_EQ(fl_value_get_length(cookies), 2u);
+  EXPECT_EQ(fl_value_lookup_string(value, "cache"), nullptr);
+
+  g_autoptr(FlMethodResponse) cached =
+      http_response(true, response, "ok", nullptr, CacheOutcome::kRevalidated,
+                    "");
+  FlValue* cached_value = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(cached));
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(cached_value, "cache")),
+      "revalidated");
+
+  g_autoptr(FlMethodResponse) failure = http_response(
+      false, response, "", nullptr, CacheOutcome::kBypassed, "cannot connect");
+  EXPECT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(failure));
+}
+
+TEST(FlutterCookieBridgePlugin, HttpResponseCarriesAJsonDocument) {
+  HttpRequest request;
+  int timeout_ms = 30000;
+  bool use_cache = false;
+  bool json = false;
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "method", fl_value_new_string("GET"));
+  fl_value_set_string_take(args, "url",
+                           fl_value_new_string("https://example.com/api"));
+  fl_value_set_string_take(args, "json", fl_value_new_bool(true));
+  ASSERT_TRUE(
+      http_request_from_args(args, &request, &timeout_ms, &use_cache, &json));
+  EXPECT_TRUE(json);
+
+  JsonDocument document;
+  JsonParser parser;
+  std::string text = "{\"a\": [1, \"b\"]}";
+  ASSERT_TRUE(parser.Feed(text.data(), text.size()));
+  ASSERT_TRUE(parser.Finish(&document));
+  HttpResponse response;
+  response.status = 200;
+  g_autoptr(FlMethodResponse) success = http_response(
+      true, response, "", &document, CacheOutcome::kBypassed, "");
+  FlValue* value = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(success));
+  EXPECT_EQ(fl_value_lookup_string(value, "body"), nullptr);
+  FlValue* result = fl_value_lookup_string(value, "json");
+  ASSERT_NE(result, nullptr);
+  FlValue* tape = fl_value_lookup_string(result, "tape");
+  ASSERT_EQ(fl_value_get_type(tape), FL_VALUE_TYPE_INT64_LIST);
+  ASSERT_EQ(fl_value_get_length(tape), document.tape().size());
+  EXPECT_EQ(static_cast<uint64_t>(fl_value_get_int64_list(tape)[0]),
+            document.tape()[0]);
+  FlValue* strings = fl_value_lookup_string(result, "strings");
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(
+                            fl_value_get_uint8_list(strings)),
+                        fl_value_get_length(strings)),
+            "ab");
+}
+
+TEST(FlutterCookieBridgePlugin, HttpCacheArgumentsAndStats) {
+  HttpCacheOptions options;
+  EXPECT_FALSE(http_cache_options_from_args(nullptr, &options));
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "enabled", fl_value_new_bool(true));
+  fl_value_set_string_take(args, "maxBytes", fl_value_new_int(4096));
+  ASSERT_TRUE(http_cache_options_from_args(args, &options));
+  EXPECT_EQ(options.max_bytes, 4096);
+
+  HttpCacheStats stats;
+  stats.lookups = 4;
+  stats.hits = 3;
+  stats.bytes_saved = 1000;
+  g_autoptr(FlValue) value = encode_http_cache_stats(stats);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "hits")), 3);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "bytesSaved")),
+            1000);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "misses")), 0);
+}
+
+TEST(FlutterCookieBridgePlugin, CompressionArgumentsAndStats) {
+  std::string host;
+  bool reset = false;
+  CompressionOptions options;
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "host", fl_value_new_string("example.com"));
+  FlValue* accept = fl_value_new_list();
+  fl_value_append_take(accept, fl_value_new_string("gzip"));
+  fl_value_set_string_take(args, "accept", accept);
+  fl_value_set_string_take(args, "requestEncoding",
+                           fl_value_new_string("gzip"));
+  fl_value_set_string_take(args, "minRequestBytes", fl_value_new_int(512));
+  ASSERT_TRUE(compression_options_from_args(args, &host, &reset, &options));
+  EXPECT_EQ(host, "example.com");
+  EXPECT_FALSE(reset);
+  ASSERT_EQ(options.accept.size(), 1u);
+  EXPECT_EQ(options.accept[0], ContentCoding::kGzip);
+  EXPECT_EQ(options.request_coding, ContentCoding::kGzip);
+  EXPECT_EQ(options.min_request_size, 512u);
+
+  fl_value_set_string_take(args, "requestEncoding",
+                           fl_value_new_string("deflate"));
+  EXPECT_FALSE(compression_options_from_args(args, &host, &reset, &options));
+
+  CompressionStats stats;
+  stats.responses = 2;
+  stats.response_wire_bytes = 300;
+  stats.response_bytes = 1200;
+  g_autoptr(FlValue) value = encode_compression_stats(stats);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "responses")), 2);
+  EXPECT_EQ(
+      fl_value_get_int(fl_value_lookup_string(value, "responseWireBytes")),
+      300);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "requests")), 0);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,290 @@
+#include "http_cache.h"
+
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test/test_http_server.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+class HttpCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/http_cache_test_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+    Reopen();
+  }
+
+  void TearDown() override {
+    cache_.reset();
+    if (DIR* directory = opendir(directory_.c_str())) {
+      while (dirent* file = readdir(directory)) {
+        unlink((directory_ + "/" + file->d_name).c_str());
+      }
+      closedir(directory);
+    }
+    rmdir(directory_.c_str());
+  }
+
+  // Replaces the cache with a new one on the same directory.
+  void Reopen(int64_t max_bytes = 1024 * 1024) {
+    cache_.reset();
+    HttpCacheOptions options;
+    options.directory = directory_;
+    options.max_bytes = max_bytes;
+    options.clock = [this] { return now_; };
+    cache_ = std::make_unique<HttpCache>(options);
+    std::string error;
+    ASSERT_TRUE(cache_->Open(&error)) << error;
+  }
+
+  // GETs |path| through the cache, checking the body, and returns how the
+  // request was answered.
+  CacheOutcome Get(const std::string& path,
+                   std::vector<HttpHeader> headers = {}) {
+    HttpRequest request;
+    request.url = server_.Url(path);
+    request.headers = std::move(headers);
+    return Send(request);
+  }
+
+  CacheOutcome Send(const HttpRequest& request) {
+    HttpResponse response;
+    std::string body;
+    CacheOutcome outcome = CacheOutcome::kBypassed;
+    std::string error;
+    EXPECT_TRUE(SendCached(cache_.get(), &pool_, nullptr, request, 5000,
+                           &response, &body, &outcome, &error))
+        << error;
+    EXPECT_EQ(response.status, 200);
+    EXPECT_EQ(body.size(), static_cast<size_t>(response.content_length));
+    for (size_t i = 0; i < body.size(); ++i) {
+      if (body[i] != TestHttpServer::ByteAt(static_cast<int64_t>(i))) {
+        ADD_FAILURE() << "content differs at offset " << i;
+        break;
+      }
+    }
+    return outcome;
+  }
+
+  size_t NetworkRequests() { return server_.requests().size(); }
+
+  TestHttpServer server_;
+  ConnectionPool pool_;
+  std::string directory_;
+  int64_t now_ = 1700000000;
+  std::unique_ptr<HttpCache> cache_;
+};
+
+TEST_F(HttpCacheTest, ServesFreshResponsesWithoutTheNetwork) {
+  TestResource resource{4096};
+  resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  now_ += 59;
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  EXPECT_EQ(NetworkRequests(), 1u);
+
+  HttpCacheStats stats = cache_->stats();
+  EXPECT_EQ(stats.lookups, 3u);
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.bytes_saved, 2u * 4096);
+  EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST_F(HttpCacheTest, RevalidatesStaleResponses) {
+  TestResource resource{1024};
+  resource.headers = {"Cache-Control: max-age=10",
+                      "Last-Modified: Tue, 14 Nov 2023 00:00:00 GMT"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  now_ += 11;
+  EXPECT_EQ(Get("/a"), CacheOutcome::kRevalidated);
+  std::vector<TestRequest> requests = server_.requests();
+  ASSERT_EQ(requests.size(), 2u);
+  EXPECT_EQ(requests[1].headers["if-none-match"], "\"v1\"");
+  EXPECT_EQ(requests[1].headers["if-modified-since"],
+            "Tue, 14 Nov 2023 00:00:00 GMT");
+  // The 304 made it fresh again.
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  EXPECT_EQ(NetworkRequests(), 2u);
+
+  // A changed resource replaces the stored one.
+  resource.etag = "\"v2\"";
+  server_.Add("/a", resource);
+  now_ += 11;
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(cache_->stats().revalidations, 1u);
+  EXPECT_EQ(cache_->stats().bytes_saved, 2u * 1024);
+}
+
+TEST_F(HttpCacheTest, PassesOnTheCookiesOfA304) {
+  TestResource resource{100};
+  resource.headers = {"Cache-Control: no-cache"};
+  resource.set_cookies = {"sid=1; Path=/"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  resource.set_cookies = {"sid=2; Path=/"};
+  server_.Add("/a", resource);
+
+  HttpRequest request;
+  request.url = server_.Url("/a");
+  HttpResponse response;
+  std::string body;
+  CacheOutcome outcome = CacheOutcome::kBypassed;
+  std::string error;
+  ASSERT_TRUE(SendCached(cache_.get(), &pool_, nullptr, request, 5000,
+                         &response, &body, &outcome, &error))
+      << error;
+  EXPECT_EQ(outcome, CacheOutcome::kRevalidated);
+  EXPECT_EQ(response.status, 200);
+  EXPECT_EQ(body.size(), 100u);
+  std::vector<std::string> cookies;
+  for (const HttpHeader& header : response.headers) {
+    if (header.name == "Set-Cookie") {
+      cookies.push_back(header.value);
+    }
+  }
+  EXPECT_EQ(cookies, std::vector<std::string>{"sid=2; Path=/"});
+}
+
+TEST_F(HttpCacheTest, RevalidatesNoCacheResponsesEveryTime) {
+  TestResource resource{100};
+  resource.headers = {"Cache-Control: no-cache"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kRevalidated);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kRevalidated);
+  EXPECT_EQ(NetworkRequests(), 3u);
+}
+
+TEST_F(HttpCacheTest, HonorsRequestCacheControl) {
+  TestResource resource{100};
+  resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/a", {{"Cache-Control", "no-cache"}}),
+            CacheOutcome::kRevalidated);
+  EXPECT_EQ(Get("/a", {{"Cache-Control", "no-store"}}),
+            CacheOutcome::kBypassed);
+  EXPECT_EQ(NetworkRequests(), 3u);
+}
+
+TEST_F(HttpCacheTest, DoesNotStoreWhatItMayNot) {
+  TestResource no_store{100};
+  no_store.headers = {"Cache-Control: no-store"};
+  server_.Add("/no-store", no_store);
+  TestResource vary_all{100};
+  vary_all.headers = {"Cache-Control: max-age=60", "Vary: *"};
+  server_.Add("/vary-all", vary_all);
+  TestResource private_resource{100};
+  private_resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/private", private_resource);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(Get("/no-store"), CacheOutcome::kMiss);
+    EXPECT_EQ(Get("/vary-all"), CacheOutcome::kMiss);
+    EXPECT_EQ(Get("/private", {{"Authorization", "Bearer x"}}),
+              CacheOutcome::kMiss);
+  }
+  EXPECT_EQ(cache_->stats().entries, 0u);
+}
+
+TEST_F(HttpCacheTest, KeepsSessionsApart) {
+  TestResource resource{512};
+  resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/me", resource);
+  EXPECT_EQ(Get("/me", {{"Cookie", "sid=alice"}}), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/me", {{"Cookie", "sid=bob"}}), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/me"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/me", {{"Cookie", "sid=alice"}}), CacheOutcome::kHit);
+  EXPECT_EQ(Get("/me", {{"Cookie", "sid=bob"}}), CacheOutcome::kHit);
+  EXPECT_EQ(NetworkRequests(), 3u);
+  EXPECT_NE(HttpCache::KeyFor(HttpRequest{"GET", "http://a/", {}, ""}),
+            HttpCache::KeyFor(
+                HttpRequest{"GET", "http://a/", {{"Cookie", "x=1"}}, ""}));
+}
+
+TEST_F(HttpCacheTest, MatchesVaryHeaders) {
+  TestResource resource{256};
+  resource.headers = {"Cache-Control: max-age=60", "Vary: Accept-Language"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a", {{"Accept-Language", "en"}}), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/a", {{"Accept-Language", "en"}}), CacheOutcome::kHit);
+  EXPECT_EQ(Get("/a", {{"Accept-Language", "de"}}), CacheOutcome::kMiss);
+}
+
+TEST_F(HttpCacheTest, DropsStoredResponsesAfterUnsafeRequests) {
+  TestResource resource{256};
+  resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/a", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  HttpRequest post;
+  post.method = "POST";
+  post.url = server_.Url("/a");
+  post.body = "x";
+  HttpResponse response;
+  std::string body;
+  CacheOutcome outcome;
+  std::string error;
+  ASSERT_TRUE(SendCached(cache_.get(), &pool_, nullptr, post, 5000,
+                         &response, &body, &outcome, &error));
+  EXPECT_EQ(outcome, CacheOutcome::kBypassed);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+}
+
+TEST_F(HttpCacheTest, EvictsLeastRecentlyUsed) {
+  TestResource resource{1000};
+  resource.headers = {"Cache-Control: max-age=60"};
+  for (const char* path : {"/a", "/b", "/c"}) {
+    server_.Add(path, resource);
+  }
+  // Room for two entries with their headers.
+  Reopen(2500);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/b"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  EXPECT_EQ(Get("/c"), CacheOutcome::kMiss);
+  EXPECT_EQ(cache_->stats().evictions, 1u);
+  EXPECT_EQ(cache_->stats().entries, 2u);
+  EXPECT_LE(cache_->stats().size_bytes, 2500u);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  EXPECT_EQ(Get("/b"), CacheOutcome::kMiss);
+}
+
+TEST_F(HttpCacheTest, ReloadsItsIndex) {
+  TestResource resource{2048};
+  resource.headers = {"Cache-Control: max-age=60"};
+  server_.Add("/a", resource);
+  server_.Add("/b", resource);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+  EXPECT_EQ(Get("/b"), CacheOutcome::kMiss);
+  // A file without an index record is left over from a crash.
+  FILE* stray = fopen((directory_ + "/stray").c_str(), "w");
+  ASSERT_NE(stray, nullptr);
+  fclose(stray);
+
+  Reopen();
+  EXPECT_EQ(cache_->stats().entries, 2u);
+  EXPECT_EQ(access((directory_ + "/stray").c_str(), F_OK), -1);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kHit);
+  EXPECT_EQ(Get("/b"), CacheOutcome::kHit);
+  EXPECT_EQ(NetworkRequests(), 2u);
+
+  cache_->Clear();
+  EXPECT_EQ(cache_->stats().entries, 0u);
+  EXPECT_EQ(cache_->stats().size_bytes, 0u);
+  EXPECT_EQ(Get("/a"), CacheOutcome::kMiss);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,165 @@
+#include "json_document.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+bool Parse(const std::string& text, JsonDocument* document) {
+  JsonParser parser;
+  return parser.Feed(text.data(), text.size()) && parser.Finish(document);
+}
+
+const char kTransactions[] =
+    "{\"account\": \"XX1234\", \"balance\": -1520.75, \"count\": 2,\n"
+    " \"open\": true, \"closed\": false, \"note\": null,\n"
+    " \"items\": [\n"
+    "  {\"id\": 9007199254740993, \"memo\": \"Caf\\u00e9 \\\"Q\\\"\\n\","
+    "   \"tags\": []},\n"
+    "  {\"id\": 2, \"memo\": \"\\ud83d\\ude00 \\/ \\\\\", \"tags\": [\"a\"]}\n"
+    " ]}";
+
+}  // namespace
+
+TEST(JsonDocument, ReadsEveryKindOfValue) {
+  JsonDocument document;
+  ASSERT_TRUE(Parse(kTransactions, &document));
+  JsonDocument::Value root = document.root();
+  ASSERT_EQ(root.type(), '{');
+  EXPECT_EQ(root.size(), 7u);
+  EXPECT_EQ(root.At(6, true).AsString(), "items");
+
+  JsonDocument::Value value = root;
+  ASSERT_TRUE(root.Find("account", &value));
+  EXPECT_EQ(value.AsString(), "XX1234");
+  ASSERT_TRUE(root.Find("balance", &value));
+  EXPECT_EQ(value.type(), 'd');
+  EXPECT_EQ(value.AsDouble(), -1520.75);
+  ASSERT_TRUE(root.Find("count", &value));
+  EXPECT_EQ(value.type(), 'l');
+  EXPECT_EQ(value.AsInt(), 2);
+  ASSERT_TRUE(root.Find("open", &value));
+  EXPECT_TRUE(value.AsBool());
+  ASSERT_TRUE(root.Find("closed", &value));
+  EXPECT_EQ(value.type(), 'f');
+  ASSERT_TRUE(root.Find("note", &value));
+  EXPECT_TRUE(value.is_null());
+  EXPECT_FALSE(root.Find("missing", &value));
+
+  JsonDocument::Value items = root;
+  ASSERT_TRUE(root.Find("items", &items));
+  ASSERT_EQ(items.size(), 2u);
+  JsonDocument::Value first = items.At(0);
+  ASSERT_TRUE(first.Find("id", &value));
+  // Beyond the doubles' integers, so kept exact.
+  EXPECT_EQ(value.AsInt(), 9007199254740993);
+  ASSERT_TRUE(first.Find("memo", &value));
+  EXPECT_EQ(value.AsString(), "Caf\xc3\xa9 \"Q\"\n");
+  ASSERT_TRUE(first.Find("tags", &value));
+  EXPECT_EQ(value.size(), 0u);
+  ASSERT_TRUE(items.At(1).Find("memo", &value));
+  EXPECT_EQ(value.AsString(), "\xf0\x9f\x98\x80 / \\");
+  ASSERT_TRUE(items.At(1).Find("tags", &value));
+  EXPECT_EQ(value.At(0).AsString(), "a");
+}
+
+TEST(JsonDocument, ParsesTheSameTextInAnyPieces) {
+  const std::string text = kTransactions;
+  JsonDocument whole;
+  ASSERT_TRUE(Parse(text, &whole));
+  for (size_t split = 0; split <= text.size(); ++split) {
+    JsonParser parser;
+    ASSERT_TRUE(parser.Feed(text.data(), split)) << split;
+    ASSERT_TRUE(parser.Feed(text.data() + split, text.size() - split));
+    JsonDocument document;
+    ASSERT_TRUE(parser.Finish(&document)) << split;
+    EXPECT_EQ(document.tape(), whole.tape()) << split;
+    EXPECT_EQ(document.strings(), whole.strings()) << split;
+  }
+
+  JsonParser parser;
+  for (char c : text) {
+    ASSERT_TRUE(parser.Feed(&c, 1));
+  }
+  JsonDocument document;
+  ASSERT_TRUE(parser.Finish(&document));
+  EXPECT_EQ(document.tape(), whole.tape());
+  EXPECT_EQ(parser.size(), text.size());
+}
+
+TEST(JsonDocument, KeepsLongStringsAcrossPieces) {
+  std::string long_value(1 << 20, 'x');
+  long_value[12345] = '\\';
+  long_value[12346] = 't';
+  std::string text = "[\"" + long_value + "\", 1]";
+  JsonParser parser;
+  for (size_t at = 0; at < text.size(); at += 1000) {
+    ASSERT_TRUE(parser.Feed(text.data() + at,
+                            std::min<size_t>(1000, text.size() - at)));
+  }
+  JsonDocument document;
+  ASSERT_TRUE(parser.Finish(&document));
+  std::string_view value = document.root().At(0).AsString();
+  ASSERT_EQ(value.size(), long_value.size() - 1);
+  EXPECT_EQ(value[12345], '\t');
+  EXPECT_EQ(document.root().At(1).AsInt(), 1);
+}
+
+TEST(JsonDocument, ReadsNumbersAsJsonDefinesThem) {
+  JsonDocument document;
+  ASSERT_TRUE(Parse("[0, -0, 9223372036854775807, -9223372036854775808, "
+                    "9223372036854775808, 1.5e-3, 2E+2, 1e400, -1e400, "
+                    "1e-400]",
+                    &document));
+  JsonDocument::Value root = document.root();
+  EXPECT_EQ(root.At(0).AsInt(), 0);
+  EXPECT_EQ(root.At(1).type(), 'l');
+  EXPECT_EQ(root.At(2).AsInt(), INT64_MAX);
+  EXPECT_EQ(root.At(3).AsInt(), INT64_MIN);
+  EXPECT_EQ(root.At(4).type(), 'd');
+  EXPECT_EQ(root.At(4).AsDouble(), 9223372036854775808.0);
+  EXPECT_EQ(root.At(5).AsDouble(), 0.0015);
+  EXPECT_EQ(root.At(6).AsDouble(), 200);
+  EXPECT_EQ(root.At(7).AsDouble(), HUGE_VAL);
+  EXPECT_EQ(root.At(8).AsDouble(), -HUGE_VAL);
+  EXPECT_EQ(root.At(9).AsDouble(), 0);
+}
+
+TEST(JsonDocument, RejectsInvalidTexts) {
+  const std::vector<std::string> invalid = {
+      "",         " ",         "[1,]",      "[1 2]",       "{\"a\" 1}",
+      "{a: 1}",   "{\"a\":1,}", "{\"a\":1",  "01",          "1.",
+      "-",        "1e",        ".5",        "+1",          "\"\\x\"",
+      "\"\\u12\"", "\"a\nb\"", "\"open",    "[1] 2",       "tru",
+      "nul",      "[true false]", "}",      "[\"a\":1]",
+  };
+  for (const std::string& text : invalid) {
+    JsonDocument document;
+    JsonParser parser;
+    EXPECT_FALSE(parser.Feed(text.data(), text.size()) &&
+                 parser.Finish(&document))
+        << text;
+    EXPECT_FALSE(parser.error().empty()) << text;
+  }
+
+  JsonParser parser;
+  std::string text = "{\"a\": [1, x]}";
+  EXPECT_FALSE(parser.Feed(text.data(), text.size()));
+  EXPECT_EQ(parser.error(), "Expected a value at byte 10");
+
+  std::string deep(2000, '[');
+  JsonParser shallow;
+  EXPECT_FALSE(shallow.Feed(deep.data(), deep.size()));
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
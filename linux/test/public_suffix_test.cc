@@ -0,0 +1,59 @@
+#include "public_suffix.h"
+
+#include <gtest/gtest.h>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(PublicSuffix, UnlistedTopLevelDomainsArePublicSuffixes) {
+  EXPECT_EQ(PublicSuffix("www.example.com"), "com");
+  EXPECT_EQ(PublicSuffix("example.example"), "example");
+  EXPECT_EQ(PublicSuffix("localhost"), "localhost");
+  EXPECT_TRUE(IsPublicSuffix("com"));
+  EXPECT_FALSE(IsPublicSuffix("example.com"));
+  EXPECT_FALSE(IsPublicSuffix(""));
+}
+
+TEST(PublicSuffix, LongestRuleWins) {
+  EXPECT_EQ(PublicSuffix("www.example.co.uk"), "co.uk");
+  EXPECT_EQ(PublicSuffix("co.uk"), "co.uk");
+  EXPECT_EQ(PublicSuffix("example.uk"), "uk");
+  EXPECT_EQ(PublicSuffix("a.blogspot.co.uk"), "blogspot.co.uk");
+  EXPECT_EQ(PublicSuffix("alice.github.io"), "github.io");
+  EXPECT_EQ(PublicSuffix("github.io"), "github.io");
+  // Not a rule, only a string suffix of one.
+  EXPECT_EQ(PublicSuffix("www.ithub.io"), "io");
+  EXPECT_EQ(PublicSuffix("www.xco.uk"), "uk");
+}
+
+TEST(PublicSuffix, WildcardsAndExceptions) {
+  EXPECT_EQ(PublicSuffix("foo.bar.ck"), "bar.ck");
+  EXPECT_EQ(PublicSuffix("bar.ck"), "bar.ck");
+  EXPECT_EQ(PublicSuffix("ck"), "ck");
+  EXPECT_EQ(PublicSuffix("www.ck"), "ck");
+  EXPECT_EQ(PublicSuffix("a.www.ck"), "ck");
+  EXPECT_EQ(PublicSuffix("a.b.kawasaki.jp"), "b.kawasaki.jp");
+  EXPECT_EQ(PublicSuffix("www.city.kawasaki.jp"), "kawasaki.jp");
+  EXPECT_TRUE(IsPublicSuffix("ec2.compute.amazonaws.com"));
+  EXPECT_FALSE(IsPublicSuffix("city.kawasaki.jp"));
+}
+
+TEST(PublicSuffix, CoversTheWholeList) {
+  EXPECT_EQ(PublicSuffix("school.pvt.k12.ma.us"), "pvt.k12.ma.us");
+  EXPECT_EQ(PublicSuffix("a.school.sch.uk"), "school.sch.uk");
+  EXPECT_EQ(PublicSuffix("app.azurestaticapps.net"), "azurestaticapps.net");
+  // Internationalized rules are matched in punycode.
+  EXPECT_EQ(PublicSuffix("example.xn--55qx5d.cn"), "xn--55qx5d.cn");
+}
+
+TEST(PublicSuffix, RegistrableDomain) {
+  EXPECT_EQ(RegistrableDomain("www.example.co.uk"), "example.co.uk");
+  EXPECT_EQ(RegistrableDomain("example.com"), "example.com");
+  EXPECT_EQ(RegistrableDomain("a.b.c.example.com"), "example.com");
+  EXPECT_EQ(RegistrableDomain("www.city.kawasaki.jp"), "city.kawasaki.jp");
+  EXPECT_EQ(RegistrableDomain("co.uk"), "");
+  EXPECT_EQ(RegistrableDomain("com"), "");
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,96 @@
+#include "record_cipher.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+std::vector<char> Sealed(const RecordCipher& cipher,
+                         const std::string& plaintext) {
+  std::vector<char> record(RecordCipher::kOverhead + plaintext.size());
+  std::copy(plaintext.begin(), plaintext.end(),
+            record.begin() + RecordCipher::kPrefix);
+  EXPECT_TRUE(cipher.Seal(record.data(), plaintext.size()));
+  return record;
+}
+
+std::string Opened(const RecordCipher& cipher, std::vector<char> record) {
+  if (!cipher.Open(record.data(), record.size())) {
+    return "<rejected>";
+  }
+  return std::string(record.begin() + RecordCipher::kPrefix,
+                     record.end() - RecordCipher::kTagSize);
+}
+
+}  // namespace
+
+TEST(RecordCipher, RoundTripsWithEitherAlgorithm) {
+  CookieKey key;
+  key.fill(3);
+  for (CipherAlgorithm algorithm :
+       {CipherAlgorithm::kAes256Gcm, CipherAlgorithm::kChaCha20Poly1305}) {
+    RecordCipher cipher(key, algorithm);
+    std::vector<char> record = Sealed(cipher, "sid=hunter2");
+    EXPECT_EQ(std::string(record.begin(), record.end()).find("hunter2"),
+              std::string::npos);
+    EXPECT_EQ(Opened(cipher, record), "sid=hunter2");
+    EXPECT_EQ(Opened(cipher, Sealed(cipher, "")), "");
+  }
+
+  // Records name their algorithm, so either cipher opens both.
+  RecordCipher aes(key, CipherAlgorithm::kAes256Gcm);
+  RecordCipher chacha(key, CipherAlgorithm::kChaCha20Poly1305);
+  EXPECT_EQ(Opened(chacha, Sealed(aes, "a=1")), "a=1");
+}
+
+TEST(RecordCipher, RejectsTamperingAndOtherKeys) {
+  CookieKey key;
+  key.fill(3);
+  RecordCipher cipher(key, RecordCipher::PreferredAlgorithm());
+  std::vector<char> record = Sealed(cipher, "sid=hunter2");
+  for (size_t i = 0; i < record.size(); ++i) {
+    std::vector<char> tampered = record;
+    tampered[i] ^= 1;
+    EXPECT_EQ(Opened(cipher, tampered), "<rejected>") << "byte " << i;
+  }
+  key.fill(4);
+  RecordCipher other(key, RecordCipher::PreferredAlgorithm());
+  EXPECT_EQ(Opened(other, record), "<rejected>");
+  EXPECT_EQ(Opened(cipher, std::vector<char>(RecordCipher::kOverhead - 1)),
+            "<rejected>");
+}
+
+TEST(FileKeyProvider, CreatesThePrivateKeyOnce) {
+  char directory[] = "/tmp/record_cipher_test_XXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+  std::string path = std::string(directory) + "/cookies.key";
+
+  CookieKey first;
+  CookieKey second;
+  ASSERT_TRUE(FileKeyProvider(path).GetKey(&first));
+  ASSERT_TRUE(FileKeyProvider(path).GetKey(&second));
+  EXPECT_EQ(first, second);
+  struct stat info = {};
+  ASSERT_EQ(stat(path.c_str(), &info), 0);
+  EXPECT_EQ(info.st_mode & 0777, 0600u);
+  EXPECT_EQ(info.st_size, static_cast<off_t>(sizeof(CookieKey)));
+
+  // A key file that is not a key is refused rather than replaced.
+  ASSERT_EQ(truncate(path.c_str(), 5), 0);
+  EXPECT_FALSE(FileKeyProvider(path).GetKey(&second));
+
+  unlink(path.c_str());
+  rmdir(directory);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
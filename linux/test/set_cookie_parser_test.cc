@@ -0,0 +1,102 @@
+#include "set_cookie_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_ffi.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(SetCookieParser, ParsesAllAttributes) {
+  std::string header =
+      "sid=abc=def; Domain=.Example.com; Path=/api; "
+      "Expires=Wed, 21 Oct 2015 07:28:00 GMT; Max-Age=3600; Secure; "
+      "HttpOnly; SameSite=Lax";
+  ParsedSetCookie parsed;
+  ASSERT_TRUE(ParseSetCookie(header, &parsed));
+  EXPECT_EQ(parsed.name, "sid");
+  EXPECT_EQ(parsed.value, "abc=def");
+  EXPECT_EQ(parsed.domain, ".Example.com");
+  EXPECT_EQ(parsed.path, "/api");
+  EXPECT_EQ(parsed.expires, 1445412480);
+  EXPECT_EQ(parsed.max_age, 3600);
+  EXPECT_EQ(parsed.flags, kSetCookieSecure | kSetCookieHttpOnly |
+                              kSetCookieHasDomain | kSetCookieHasPath |
+                              kSetCookieHasExpires | kSetCookieHasMaxAge);
+  EXPECT_EQ(parsed.same_site, SameSite::kLax);
+  // The views point into the original header.
+  EXPECT_EQ(parsed.name.data(), header.data());
+}
+
+TEST(SetCookieParser, RejectsHeadersWithoutCookie) {
+  ParsedSetCookie parsed;
+  EXPECT_FALSE(ParseSetCookie("novalue; Path=/", &parsed));
+  EXPECT_FALSE(ParseSetCookie(" =value", &parsed));
+  EXPECT_FALSE(ParseSetCookie("", &parsed));
+}
+
+TEST(SetCookieParser, IgnoresInvalidAttributeValues) {
+  ParsedSetCookie parsed;
+  ASSERT_TRUE(ParseSetCookie(
+      "a=1; Path=relative; Domain=; Max-Age=soon; Expires=never", &parsed));
+  EXPECT_EQ(parsed.flags, 0u);
+  EXPECT_EQ(parsed.expires, kNoExpiry);
+}
+
+TEST(SetCookieParser, LongHeadersCrossVectorBlocks) {
+  std::string value(100, 'v');
+  std::string header = "name=" + value + ";" + std::string(40, ' ') +
+                       "path=/deep/path/for/the/scanner";
+  ParsedSetCookie parsed;
+  ASSERT_TRUE(ParseSetCookie(header, &parsed));
+  EXPECT_EQ(parsed.value, value);
+  EXPECT_EQ(parsed.path, "/deep/path/for/the/scanner");
+}
+
+TEST(SetCookieParser, CookieDates) {
+  EXPECT_EQ(ParseCookieDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseCookieDate("Sunday, 06-Nov-94 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseCookieDate("Sun Nov  6 08:49:37 1994"), 784111777);
+  EXPECT_EQ(ParseCookieDate("Thu, 01 Jan 1970 00:00:00 GMT"), 0);
+  EXPECT_EQ(ParseCookieDate("Sun, 32 Nov 1994 08:49:37 GMT"), kNoExpiry);
+  EXPECT_EQ(ParseCookieDate("garbage"), kNoExpiry);
+}
+
+TEST(SetCookieParser, CookieHeaderPairs) {
+  std::vector<std::pair<std::string, std::string>> pairs;
+  size_t count = ParseCookieHeader(
+      "a=1; b = two ;novalue; c=x=y;",
+      [&](std::string_view name, std::string_view value) {
+        pairs.emplace_back(std::string(name), std::string(value));
+      });
+  EXPECT_EQ(count, 3u);
+  ASSERT_EQ(pairs.size(), 3u);
+  EXPECT_EQ(pairs[1], std::make_pair(std::string("b"), std::string("two")));
+  EXPECT_EQ(pairs[2], std::make_pair(std::string("c"), std::string("x=y")));
+}
+
+TEST(SetCookieParser, FfiBatchReportsSpansPerHeader) {
+  std::string first = "a=1; Path=/";
+  std::string second = "broken";
+  std::string third = "b=22; Secure";
+  std::string data = first + second + third;
+  uint32_t lengths[] = {static_cast<uint32_t>(first.size()),
+                        static_cast<uint32_t>(second.size()),
+                        static_cast<uint32_t>(third.size())};
+  FlutterCookieBridgeSetCookie out[3];
+  EXPECT_EQ(
+      flutter_cookie_bridge_parse_set_cookies(data.data(), lengths, 3, out),
+      2);
+  EXPECT_EQ(out[0].path.offset, 10u);
+  EXPECT_EQ(out[1].name.length, 0u);
+  EXPECT_EQ(out[2].value.offset, 2u);
+  EXPECT_EQ(out[2].value.length, 2u);
+  EXPECT_EQ(out[2].flags, static_cast<uint32_t>(kSetCookieSecure));
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,263 @@
+#include "shared_cookie_jar.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cookie_change_feed.h"
+#include "include/flutter_cookie_bridge/flutter_cookie_bridge_ffi.h"
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(SharedCookieJar, ReadsSeeEveryPublishedWrite) {
+  SharedCookieJar jar;
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "");
+
+  jar.SetCookies("https://www.example.com/",
+                 {"a=1; Path=/", "b=2; Domain=example.com; Path=/"});
+  jar.SetCookies("https://other.com/", {"c=3"});
+  EXPECT_EQ(jar.GetCookieHeader("https://www.example.com/"), "a=1; b=2");
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/"), "b=2");
+
+  jar.SetCookies("https://www.example.com/", {"a=; Path=/; Max-Age=0"});
+  EXPECT_EQ(jar.GetCookieHeader("https://www.example.com/"), "b=2");
+  EXPECT_EQ(jar.GetCookieHeader("https://other.com/"), "c=3");
+
+  jar.SyncCookies("https://other.com/", {{"d", "4"}});
+  EXPECT_EQ(jar.GetCookieHeader("https://other.com/"), "d=4");
+
+  jar.Clear();
+  EXPECT_EQ(jar.GetCookieHeader("https://api.example.com/"), "");
+}
+
+TEST(SharedCookieJar, LockedMutationsArePublished) {
+  SharedCookieJar jar;
+  jar.Locked([](CookieJar* inner) {
+    inner->SetCookies("https://example.com/", {"a=1"});
+  });
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "a=1");
+}
+
+TEST(SharedCookieJar, ConcurrentReadersNeverSeeTornState) {
+  SharedCookieJar jar;
+  jar.SetCookies("https://example.com/", {"a=0; Path=/", "b=0; Path=/"});
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> reads{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        std::string header = jar.GetCookieHeader("https://example.com/x");
+        // Both cookies are always written together.
+        size_t a = header.find("a=");
+        size_t b = header.find("; b=");
+        ASSERT_NE(a, std::string::npos);
+        ASSERT_NE(b, std::string::npos);
+        EXPECT_EQ(header.substr(a + 2, b - a - 2), header.substr(b + 4));
+        reads.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  // Keeps writing until the readers got going, however fast the writes are.
+  std::string value;
+  for (int i = 1; i <= 2000 || reads.load() < 1000; ++i) {
+    value = std::to_string(i);
+    jar.SetCookies("https://example.com/",
+                   {"a=" + value + "; Path=/", "b=" + value + "; Path=/"});
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"),
+            "a=" + value + "; b=" + value);
+}
+
+TEST(SharedCookieJar, FfiUsesTheProcessWideJar) {
+  const std::string url = "https://ffi.example.com/";
+  const std::string data = "a=1; Path=/b=2; Path=/";
+  const uint32_t lengths[] = {11, 11};
+  EXPECT_EQ(flutter_cookie_bridge_jar_set_cookies(url.data(), url.size(),
+                                                  data.data(), lengths, 2),
+            2);
+  EXPECT_EQ(SharedCookieJar::Get()->GetCookieHeader(url), "a=1; b=2");
+
+  char small[4];
+  EXPECT_EQ(flutter_cookie_bridge_jar_get_cookie_header(url.data(), url.size(),
+                                                        small, sizeof(small)),
+            8);
+  EXPECT_EQ(std::string(small, sizeof(small)), "a=1;");
+
+  SharedCookieJar::Get()->Clear();
+}
+
+TEST(SharedCookieJar, PartitionsKeepTheirOwnCookies) {
+  SharedCookieJar jar;
+  EXPECT_EQ(jar.active_partition(), SharedCookieJar::kDefaultPartition);
+  jar.SetCookies("https://example.com/", {"user=alice"});
+
+  jar.SwitchPartition("partner");
+  EXPECT_EQ(jar.active_partition(), "partner");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "");
+  jar.SetCookies("https://example.com/", {"user=karza"});
+  jar.SetCookies("https://partner.test/", {"token=1"});
+
+  jar.SwitchPartition(SharedCookieJar::kDefaultPartition);
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "user=alice");
+  EXPECT_EQ(jar.GetCookieHeader("https://partner.test/"), "");
+  jar.Locked([](CookieJar* inner) { EXPECT_EQ(inner->size(), 1u); });
+
+  jar.SwitchPartition("partner");
+  EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "user=karza");
+  EXPECT_EQ(jar.GetCookieHeader("https://partner.test/"), "token=1");
+
+  EXPECT_FALSE(jar.DropPartition("partner"));
+  EXPECT_FALSE(jar.DropPartition(SharedCookieJar::kDefaultPartition));
+  jar.SwitchPartition(SharedCookieJar::kDefaultPartition);
+  EXPECT_TRUE(jar.DropPartition("partner"));
+  EXPECT_FALSE(jar.DropPartition("partner"));
+  jar.SwitchPartition("partner");
+  EXPECT_EQ(jar.GetCookieHeader("https://partner.test/"), "");
+}
+
+TEST(SharedCookieJar, SwitchingReportsOnlyTheDifference) {
+  SharedCookieJar jar;
+  for (int i = 0; i < 100; ++i) {
+    jar.SetCookies("https://site" + std::to_string(i) + ".test/", {"a=1"});
+  }
+  EXPECT_FALSE(jar.ForkPartition("work", "missing"));
+  EXPECT_TRUE(jar.ForkPartition("work", SharedCookieJar::kDefaultPartition));
+  EXPECT_FALSE(jar.ForkPartition("work", SharedCookieJar::kDefaultPartition));
+
+  std::unique_ptr<CookieChangeFeed> feed;
+  jar.Locked([&feed](CookieJar* inner) {
+    feed = std::make_unique<CookieChangeFeed>(inner);
+  });
+  uint64_t seen = feed->ChangesSince(0).version;
+
+  // The fork shares every domain, so switching to it changes nothing.
+  jar.SwitchPartition("work");
+  EXPECT_TRUE(feed->ChangesSince(seen).changes.empty());
+  EXPECT_EQ(jar.GetCookieHeader("https://site7.test/"), "a=1");
+
+  jar.SetCookies("https://site7.test/", {"a=2"});
+  jar.SetCookies("https://new.test/", {"b=1"});
+  seen = feed->ChangesSince(0).version;
+
+  jar.SwitchPartition(SharedCookieJar::kDefaultPartition);
+  CookieDelta delta = feed->ChangesSince(seen);
+  EXPECT_FALSE(delta.reset);
+  ASSERT_EQ(delta.changes.size(), 2u);
+  if (delta.changes[0].domain != "new.test") {
+    std::swap(delta.changes[0], delta.changes[1]);
+  }
+  EXPECT_EQ(delta.changes[0].domain, "new.test");
+  EXPECT_TRUE(delta.changes[0].removed);
+  EXPECT_EQ(delta.changes[1].domain, "site7.test");
+  EXPECT_EQ(delta.changes[1].value, "1");
+  EXPECT_EQ(jar.GetCookieHeader("https://site7.test/"), "a=1");
+
+  jar.Locked([&feed](CookieJar*) { feed.reset(); });
+}
+
+TEST(SharedCookieJar, PersistsOnlyTheDefaultPartition) {
+  char directory[] = "/tmp/shared_cookie_jar_test_XXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+  std::string path = std::string(directory) + "/cookies.log";
+  {
+    SharedCookieJar jar;
+    ASSERT_TRUE(jar.Persist(path));
+    jar.SetCookies("https://example.com/", {"main=1; Max-Age=3600"});
+    jar.SwitchPartition("partner");
+    jar.SetCookies("https://example.com/", {"partner=2; Max-Age=3600"});
+    jar.SwitchPartition(SharedCookieJar::kDefaultPartition);
+    jar.SetCookies("https://example.com/", {"later=3; Max-Age=3600"});
+  }
+  {
+    SharedCookieJar jar;
+    ASSERT_TRUE(jar.Persist(path));
+    EXPECT_EQ(jar.GetCookieHeader("https://example.com/"), "main=1; later=3");
+  }
+  unlink(path.c_str());
+  rmdir(directory);
+}
+
+TEST(SharedCookieJar, WritesDuringABackgroundLoadKeepStoredCookies) {
+  char directory[] = "/tmp/shared_cookie_jar_test_XXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+  std::string path = std::string(directory) + "/cookies.log";
+  {
+    SharedCookieJar jar;
+    ASSERT_TRUE(jar.Persist(path));
+    jar.SetCookies("https://example.com/", {"stored=1; Max-Age=3600"});
+  }
+  {
+    SharedCookieJar jar;
+    jar.PersistInBackground(path);
+    jar.SetCookies("https://example.com/", {"fresh=2; Max-Age=3600"});
+    EXPECT_EQ(jar.GetCookieHeader("https://example.com/"),
+              "stored=1; fresh=2");
+    EXPECT_TRUE(jar.Persist(path));
+  }
+  unlink(path.c_str());
+  rmdir(directory);
+}
+
+TEST(SharedCookieJar, WhenLoadedRunsAfterTheStoredCookies) {
+  char directory[] = "/tmp/shared_cookie_jar_test_XXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+  std::string path = std::string(directory) + "/cookies.log";
+  {
+    SharedCookieJar jar;
+    ASSERT_TRUE(jar.Persist(path));
+    jar.SetCookies("https://example.com/", {"stored=1; Max-Age=3600"});
+  }
+  {
+    SharedCookieJar jar;
+    jar.PersistInBackground(path);
+    std::atomic<int> runs{0};
+    std::unique_ptr<CookieChangeFeed> feed;
+    uint64_t seen = 0;
+    jar.WhenLoaded([&](CookieJar* inner, bool persisted) {
+      EXPECT_TRUE(persisted);
+      EXPECT_EQ(inner->GetCookieHeader("https://example.com/"), "stored=1");
+      feed = std::make_unique<CookieChangeFeed>(inner);
+      seen = feed->ChangesSince(0).version;
+      ++runs;
+    });
+    // Waits for the load, which ran the function before it finished.
+    jar.SetCookies("https://example.com/", {"fresh=2; Max-Age=3600"});
+    EXPECT_EQ(runs.load(), 1);
+    ASSERT_EQ(feed->ChangesSince(seen).changes.size(), 1u);
+
+    // Once loaded, the function runs right away.
+    jar.WhenLoaded([&](CookieJar*, bool persisted) {
+      EXPECT_TRUE(persisted);
+      ++runs;
+    });
+    EXPECT_EQ(runs.load(), 2);
+    jar.Locked([&feed](CookieJar*) { feed.reset(); });
+  }
+  {
+    SharedCookieJar jar;
+    bool persisted = true;
+    jar.WhenLoaded([&persisted](CookieJar*, bool result) {
+      persisted = result;
+    });
+    EXPECT_FALSE(persisted);
+  }
+  unlink(path.c_str());
+  rmdir(directory);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
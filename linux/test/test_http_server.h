@@ -0,0 +1,495 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_TEST_TEST_HTTP_SERVER_H_
+#define FLUTTER_COOKIE_BRIDGE_TEST_TEST_HTTP_SERVER_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+// What the server answers for one path.
+struct TestResource {
+  // The body is generated, see TestHttpServer::ByteAt, so large files cost
+  // no memory.
+  int64_t size = 0;
+  // Sent instead of the generated bytes when set, and then |size| is
+  // ignored.
+  std::string body;
+  std::string etag = "\"v1\"";
+  bool ranges = true;
+  // Sends the body chunked and without Content-Length.
+  bool chunked = false;
+  // When set, the first response to reach this many body bytes, counted
+  // from the start of the file, is cut off there.
+  int64_t fail_at = -1;
+  // After that cut, the path answers 404 until it is added again.
+  bool gone_after_failure = false;
+  // Answers with a 302 to this path instead.
+  std::string redirect_to;
+  std::vector<std::string> set_cookies;
+  // Further "Name: value" response header lines, such as Cache-Control.
+  std::vector<std::string> headers;
+  // Answers If-None-Match with this ETag with a 304.
+  bool conditional = true;
+  // Answers requests whose body has a Content-Encoding with a 415.
+  bool refuses_encoded_bodies = false;
+};
+
+struct TestRequest {
+  std::string method;
+  std::string path;
+  // Names are lower-cased.
+  std::map<std::string, std::string> headers;
+  std::string body;
+};
+
+// A minimal HTTP/1.1 server on 127.0.0.1 for exercising the native client:
+// keep-alive connections, optionally over TLS, Range, If-Range and
+// If-None-Match support, and a record of every request it saw.
+class TestHttpServer {
+ public:
+  // With |tls| the server speaks HTTPS with a certificate for 127.0.0.1
+  // made up on the spot; clients have to trust certificate_pem().
+  explicit TestHttpServer(bool tls = false) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    if (tls) {
+      tls_context_ = NewTlsContext(port_, &certificate_pem_);
+    }
+    listen(listen_fd_, 64);
+    acceptor_ = std::thread([this] { AcceptLoop(); });
+  }
+
+  ~TestHttpServer() {
+    stopping_ = true;
+    acceptor_.join();
+    {
+      // Wakes handlers waiting for the next request on an idle connection.
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (int fd : open_fds_) {
+        shutdown(fd, SHUT_RDWR);
+      }
+    }
+    for (std::thread& handler : handlers_) {
+      handler.join();
+    }
+    close(listen_fd_);
+    SSL_CTX_free(tls_context_);
+  }
+
+  static char ByteAt(int64_t offset) {
+    uint64_t mixed = static_cast<uint64_t>(offset) * 0x9E3779B97F4A7C15ull;
+    return static_cast<char>(mixed >> 56);
+  }
+
+  void Add(const std::string& path, TestResource resource) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resources_[path] = std::move(resource);
+  }
+
+  std::string Url(const std::string& path) const {
+    return (tls_context_ != nullptr ? "https" : "http") +
+           std::string("://127.0.0.1:") + std::to_string(port_) + path;
+  }
+
+  std::vector<TestRequest> requests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+
+  const std::string& certificate_pem() const { return certificate_pem_; }
+
+  // Closes every connection after |count| responses without announcing it,
+  // like a server whose keep-alive timeout ran out.
+  void set_max_requests_per_connection(int count) {
+    max_requests_per_connection_ = count;
+  }
+
+  // Connections accepted so far.
+  int connections() const { return connections_; }
+
+  // TLS handshakes that resumed a session rather than doing a full one.
+  int resumed_handshakes() const { return resumed_handshakes_; }
+
+ private:
+  void AcceptLoop() {
+    while (!stopping_) {
+      pollfd poll_fd = {listen_fd_, POLLIN, 0};
+      if (poll(&poll_fd, 1, 20) != 1) {
+        continue;
+      }
+      int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd >= 0) {
+        // Heads and bodies are sent separately.
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ++connections_;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          open_fds_.insert(fd);
+        }
+        handlers_.emplace_back([this, fd] {
+          Serve(fd);
+          std::lock_guard<std::mutex> lock(mutex_);
+          open_fds_.erase(fd);
+          close(fd);
+        });
+      }
+    }
+  }
+
+  // One accepted connection.
+  struct Peer {
+    int fd = -1;
+    SSL* ssl = nullptr;
+    // Read past the end of the last request.
+    std::string pending;
+
+    ssize_t Receive(char* data, size_t size) {
+      if (ssl != nullptr) {
+        int read = SSL_read(ssl, data, static_cast<int>(size));
+        return read > 0 ? read : -1;
+      }
+      return recv(fd, data, size, 0);
+    }
+  };
+
+  static bool SendAll(Peer* peer, const char* data, size_t size) {
+    while (size > 0) {
+      ssize_t sent =
+          peer->ssl != nullptr
+              ? SSL_write(peer->ssl, data, static_cast<int>(size))
+              : send(peer->fd, data, size, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        return false;
+      }
+      data += sent;
+      size -= static_cast<size_t>(sent);
+    }
+    return true;
+  }
+
+  static bool SendAll(Peer* peer, const std::string& data) {
+    return SendAll(peer, data.data(), data.size());
+  }
+
+  // The certificate's subject names the port, so that clients trusting the
+  // certificates of several servers can tell them apart.
+  static SSL_CTX* NewTlsContext(uint16_t port, std::string* certificate_pem) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* certificate = X509_new();
+    X509_set_version(certificate, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+    X509_gmtime_adj(X509_getm_notBefore(certificate), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 3600);
+    X509_set_pubkey(certificate, key);
+    X509_NAME* name = X509_get_subject_name(certificate);
+    std::string common_name = "127.0.0.1:" + std::to_string(port);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>(common_name.c_str()), -1, -1,
+        0);
+    X509_set_issuer_name(certificate, name);
+    X509V3_CTX extension_context;
+    X509V3_set_ctx_nodb(&extension_context);
+    X509V3_set_ctx(&extension_context, certificate, certificate, nullptr,
+                   nullptr, 0);
+    X509_EXTENSION* names =
+        X509V3_EXT_conf_nid(nullptr, &extension_context,
+                            NID_subject_alt_name, "IP:127.0.0.1");
+    X509_add_ext(certificate, names, -1);
+    X509_EXTENSION_free(names);
+    X509_sign(certificate, key, EVP_sha256());
+
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, certificate);
+    char* pem = nullptr;
+    long length = BIO_get_mem_data(bio, &pem);
+    certificate_pem->assign(pem, static_cast<size_t>(length));
+    BIO_free(bio);
+
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_use_certificate(context, certificate);
+    SSL_CTX_use_PrivateKey(context, key);
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    return context;
+  }
+
+  bool ReadRequest(Peer* peer, TestRequest* request) {
+    size_t head_end;
+    while ((head_end = peer->pending.find("\r\n\r\n")) ==
+           std::string::npos) {
+      char buffer[4096];
+      ssize_t read = peer->Receive(buffer, sizeof(buffer));
+      if (read <= 0 || peer->pending.size() > 64 * 1024) {
+        return false;
+      }
+      peer->pending.append(buffer, static_cast<size_t>(read));
+    }
+    std::string head = peer->pending.substr(0, head_end + 4);
+    peer->pending.erase(0, head_end + 4);
+    size_t line_end = head.find("\r\n");
+    size_t first_space = head.find(' ');
+    size_t second_space = head.find(' ', first_space + 1);
+    if (first_space == std::string::npos || second_space > line_end) {
+      return false;
+    }
+    request->method = head.substr(0, first_space);
+    request->path = head.substr(first_space + 1,
+                                second_space - first_space - 1);
+    size_t position = line_end + 2;
+    while (position < head.size()) {
+      size_t end = head.find("\r\n", position);
+      std::string line = head.substr(position, end - position);
+      position = end + 2;
+      size_t colon = line.find(':');
+      if (colon == std::string::npos) {
+        continue;
+      }
+      std::string name = line.substr(0, colon);
+      for (char& c : name) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      }
+      size_t value = line.find_first_not_of(' ', colon + 1);
+      request->headers[name] =
+          value == std::string::npos ? "" : line.substr(value);
+    }
+    auto content_length = request->headers.find("content-length");
+    size_t body_size = content_length == request->headers.end()
+                           ? 0
+                           : std::strtoul(content_length->second.c_str(),
+                                          nullptr, 10);
+    while (peer->pending.size() < body_size) {
+      char buffer[4096];
+      ssize_t read = peer->Receive(buffer, sizeof(buffer));
+      if (read <= 0) {
+        return false;
+      }
+      peer->pending.append(buffer, static_cast<size_t>(read));
+    }
+    request->body = peer->pending.substr(0, body_size);
+    peer->pending.erase(0, body_size);
+    return true;
+  }
+
+  void Serve(int fd) {
+    Peer peer;
+    peer.fd = fd;
+    if (tls_context_ != nullptr) {
+      peer.ssl = SSL_new(tls_context_);
+      SSL_set_fd(peer.ssl, fd);
+      if (SSL_accept(peer.ssl) != 1) {
+        SSL_free(peer.ssl);
+        return;
+      }
+      if (SSL_session_reused(peer.ssl)) {
+        ++resumed_handshakes_;
+      }
+    }
+    for (int served = 1; !stopping_; ++served) {
+      TestRequest request;
+      if (!ReadRequest(&peer, &request)) {
+        break;
+      }
+      auto connection = request.headers.find("connection");
+      bool last = connection != request.headers.end() &&
+                  connection->second == "close";
+      if (!Handle(&peer, request, last) || last ||
+          served == max_requests_per_connection_) {
+        break;
+      }
+    }
+    SSL_free(peer.ssl);
+  }
+
+  // Answers |request|. Returns false when the connection has to be closed.
+  // |closing| tells the client so; a cut response does not.
+  bool Handle(Peer* peer, const TestRequest& request, bool closing) {
+    const char* connection = closing ? "Connection: close\r\n" : "";
+    TestResource resource;
+    bool found;
+    bool fail = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(request);
+      auto it = resources_.find(request.path);
+      found = it != resources_.end();
+      if (found) {
+        resource = it->second;
+      }
+    }
+    if (!resource.body.empty()) {
+      resource.size = static_cast<int64_t>(resource.body.size());
+    }
+    if (!found) {
+      return SendAll(peer, std::string("HTTP/1.1 404 Not Found\r\n"
+                                       "Content-Length: 0\r\n") +
+                               connection + "\r\n");
+    }
+    if (resource.refuses_encoded_bodies &&
+        request.headers.count("content-encoding") != 0) {
+      return SendAll(peer, std::string("HTTP/1.1 415 Unsupported Media "
+                                       "Type\r\nContent-Length: 0\r\n") +
+                               connection + "\r\n");
+    }
+    std::string head;
+    for (const std::string& cookie : resource.set_cookies) {
+      head += "Set-Cookie: " + cookie + "\r\n";
+    }
+    for (const std::string& line : resource.headers) {
+      head += line + "\r\n";
+    }
+    auto if_none_match = request.headers.find("if-none-match");
+    if (resource.conditional && if_none_match != request.headers.end() &&
+        if_none_match->second == resource.etag) {
+      return SendAll(peer, "HTTP/1.1 304 Not Modified\r\n" + head +
+                               "ETag: " + resource.etag + "\r\n" +
+                               connection + "\r\n");
+    }
+    if (!resource.redirect_to.empty()) {
+      return SendAll(peer, "HTTP/1.1 302 Found\r\nLocation: " +
+                               resource.redirect_to + "\r\n" + head +
+                               "Content-Length: 0\r\n" + connection +
+                               "\r\n");
+    }
+
+    int64_t first = 0;
+    int64_t last = resource.size - 1;
+    bool partial = false;
+    auto range = request.headers.find("range");
+    auto if_range = request.headers.find("if-range");
+    if (resource.ranges && range != request.headers.end() &&
+        range->second.compare(0, 6, "bytes=") == 0 &&
+        (if_range == request.headers.end() ||
+         if_range->second == resource.etag)) {
+      char* end = nullptr;
+      first = std::strtoll(range->second.c_str() + 6, &end, 10);
+      if (*end == '-' && end[1] != '\0') {
+        last = std::strtoll(end + 1, nullptr, 10);
+      }
+      if (last >= resource.size) {
+        last = resource.size - 1;
+      }
+      if (first > last) {
+        return SendAll(peer, std::string("HTTP/1.1 416 Range Not "
+                                         "Satisfiable\r\nContent-Length: "
+                                         "0\r\n") +
+                                 connection + "\r\n");
+      }
+      partial = true;
+    }
+    int64_t stop = last + 1;
+    if (resource.fail_at >= 0 && resource.fail_at > first &&
+        resource.fail_at < stop) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      TestResource& stored = resources_[request.path];
+      if (stored.fail_at >= 0) {
+        stored.fail_at = -1;
+        fail = true;
+        stop = resource.fail_at;
+        if (stored.gone_after_failure) {
+          resources_.erase(request.path);
+        }
+      }
+    }
+
+    head = std::string(partial ? "HTTP/1.1 206 Partial Content\r\n"
+                               : "HTTP/1.1 200 OK\r\n") +
+           head + "ETag: " + resource.etag + "\r\n" + connection;
+    if (resource.ranges) {
+      head += "Accept-Ranges: bytes\r\n";
+    }
+    if (partial) {
+      head += "Content-Range: bytes " + std::to_string(first) + "-" +
+              std::to_string(last) + "/" + std::to_string(resource.size) +
+              "\r\n";
+    }
+    if (resource.chunked) {
+      head += "Transfer-Encoding: chunked\r\n\r\n";
+    } else {
+      head += "Content-Length: " + std::to_string(last + 1 - first) +
+              "\r\n\r\n";
+    }
+    if (!SendAll(peer, head)) {
+      return false;
+    }
+    char buffer[64 * 1024];
+    for (int64_t offset = first; offset < stop;) {
+      size_t count = sizeof(buffer);
+      if (stop - offset < static_cast<int64_t>(count)) {
+        count = static_cast<size_t>(stop - offset);
+      }
+      for (size_t i = 0; i < count; ++i) {
+        int64_t at = offset + static_cast<int64_t>(i);
+        buffer[i] = resource.body.empty()
+                        ? ByteAt(at)
+                        : resource.body[static_cast<size_t>(at)];
+      }
+      if (resource.chunked) {
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", count);
+        SendAll(peer, size_line);
+      }
+      if (!SendAll(peer, buffer, count) ||
+          (resource.chunked && !SendAll(peer, "\r\n"))) {
+        return false;
+      }
+      offset += static_cast<int64_t>(count);
+    }
+    if (fail) {
+      // Every response is framed, so closing here is seen as a cut.
+      return false;
+    }
+    return !resource.chunked || SendAll(peer, "0\r\n\r\n");
+  }
+
+  SSL_CTX* tls_context_ = nullptr;
+  std::string certificate_pem_;
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::atomic<int> max_requests_per_connection_{0};
+  std::atomic<int> connections_{0};
+  std::atomic<int> resumed_handshakes_{0};
+  std::thread acceptor_;
+  // Only touched by the acceptor thread until it is joined.
+  std::vector<std::thread> handlers_;
+  mutable std::mutex mutex_;
+  std::set<int> open_fds_;
+  std::map<std::string, TestResource> resources_;
+  std::vector<TestRequest> requests_;
+};
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_TEST_TEST_HTTP_SERVER_H_
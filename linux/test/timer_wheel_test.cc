@@ -0,0 +1,112 @@
+#include "timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+std::vector<uint64_t> Ids(const std::vector<TimerWheel::Timer>& timers) {
+  std::vector<uint64_t> ids;
+  for (const TimerWheel::Timer& timer : timers) {
+    ids.push_back(timer.id);
+  }
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+}  // namespace
+
+TEST(TimerWheel, FiresTimersWhenTheirDeadlinePasses) {
+  TimerWheel wheel(1000);
+  wheel.Schedule(1, 1010);
+  wheel.Schedule(2, 1010);
+  wheel.Schedule(3, 5000);
+  EXPECT_EQ(wheel.size(), 3u);
+
+  std::vector<TimerWheel::Timer> fired;
+  wheel.Advance(1009, &fired);
+  EXPECT_TRUE(fired.empty());
+  wheel.Advance(1010, &fired);
+  EXPECT_EQ(Ids(fired), (std::vector<uint64_t>{1, 2}));
+  fired.clear();
+  wheel.Advance(4999, &fired);
+  EXPECT_TRUE(fired.empty());
+  wheel.Advance(6000, &fired);
+  ASSERT_EQ(fired.size(), 1u);
+  EXPECT_EQ(fired[0].id, 3u);
+  EXPECT_EQ(fired[0].deadline, 5000);
+  EXPECT_EQ(wheel.size(), 0u);
+  EXPECT_EQ(wheel.now(), 6000);
+}
+
+TEST(TimerWheel, FiresPastDeadlinesOnTheNextAdvance) {
+  TimerWheel wheel(1000);
+  wheel.Schedule(1, 1000);
+  wheel.Schedule(2, 10);
+  std::vector<TimerWheel::Timer> fired;
+  wheel.Advance(999, &fired);
+  EXPECT_EQ(Ids(fired), (std::vector<uint64_t>{1, 2}));
+}
+
+TEST(TimerWheel, HoldsDeadlinesBeyondItsSpan) {
+  TimerWheel wheel(0);
+  int64_t far = int64_t{1} << 40;
+  wheel.Schedule(1, far);
+  std::vector<TimerWheel::Timer> fired;
+  wheel.Advance(far - 1, &fired);
+  EXPECT_TRUE(fired.empty());
+  wheel.Advance(far, &fired);
+  EXPECT_EQ(Ids(fired), (std::vector<uint64_t>{1}));
+}
+
+TEST(TimerWheel, NeverFiresEarlyOrLate) {
+  std::mt19937_64 random(7);
+  int64_t start = 1700000000;
+  TimerWheel wheel(start);
+  std::vector<int64_t> deadlines;
+  for (uint64_t id = 0; id < 2000; ++id) {
+    // Spread over every level of the wheel.
+    int64_t delay = static_cast<int64_t>(random() % (int64_t{1} << 30));
+    delay >>= random() % 30;
+    delay += 1;
+    deadlines.push_back(start + delay);
+    wheel.Schedule(id, start + delay);
+  }
+
+  int64_t now = start;
+  size_t fired_total = 0;
+  while (wheel.size() > 0) {
+    int64_t previous = now;
+    now += 1 + static_cast<int64_t>(random() % 100000);
+    std::vector<TimerWheel::Timer> fired;
+    wheel.Advance(now, &fired);
+    for (const TimerWheel::Timer& timer : fired) {
+      EXPECT_EQ(timer.deadline, deadlines[timer.id]);
+      EXPECT_GT(timer.deadline, previous);
+      EXPECT_LE(timer.deadline, now);
+    }
+    fired_total += fired.size();
+  }
+  EXPECT_EQ(fired_total, deadlines.size());
+}
+
+TEST(TimerWheel, ClearDropsEveryTimer) {
+  TimerWheel wheel(0);
+  wheel.Schedule(1, 5);
+  wheel.Schedule(2, 100000);
+  wheel.Clear();
+  EXPECT_EQ(wheel.size(), 0u);
+  std::vector<TimerWheel::Timer> fired;
+  wheel.Advance(200000, &fired);
+  EXPECT_TRUE(fired.empty());
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
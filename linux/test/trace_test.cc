@@ -0,0 +1,100 @@
+#include "trace.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+namespace {
+
+size_t CountOf(const std::string& text, const std::string& needle) {
+  size_t count = 0;
+  for (size_t at = text.find(needle); at != std::string::npos;
+       at = text.find(needle, at + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(Tracer, RecordsNothingWhileDisabled) {
+  Tracer* tracer = Tracer::Get();
+  tracer->Clear();
+  tracer->SetEnabled(false);
+  { ScopedTrace trace("disabled.span"); }
+  tracer->Record("disabled.span", 1, 2);
+  EXPECT_EQ(tracer->ExportJson(),
+            "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+}
+
+TEST(Tracer, ExportsSpansOfEveryThread) {
+  Tracer* tracer = Tracer::Get();
+  tracer->Clear();
+  tracer->SetEnabled(true);
+  tracer->Record("main.span", 100, 250);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] { ScopedTrace trace("worker.\"span\""); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  tracer->SetEnabled(false);
+
+  std::string json = tracer->ExportJson();
+  EXPECT_NE(json.find("{\"name\":\"main.span\","
+                      "\"cat\":\"flutter_cookie_bridge\",\"ph\":\"X\","
+                      "\"ts\":100,\"dur\":150,"),
+            std::string::npos)
+      << json;
+  // Spans of threads that exited survive them.
+  EXPECT_EQ(CountOf(json, "\"name\":\"worker.\\\"span\\\"\""), 4u) << json;
+
+  tracer->Clear();
+  EXPECT_EQ(CountOf(tracer->ExportJson(), "\"name\""), 0u);
+}
+
+TEST(Tracer, KeepsTheMostRecentSpansPerThread) {
+  Tracer* tracer = Tracer::Get();
+  tracer->Clear();
+  tracer->SetEnabled(true);
+  std::thread([tracer] {
+    for (size_t i = 0; i < Tracer::kEventsPerThread + 10; ++i) {
+      tracer->Record(i < 10 ? "old" : "new", i, i + 1);
+    }
+  }).join();
+  tracer->SetEnabled(false);
+  std::string json = tracer->ExportJson();
+  EXPECT_EQ(CountOf(json, "\"name\":\"old\""), 0u);
+  EXPECT_EQ(CountOf(json, "\"name\":\"new\""), Tracer::kEventsPerThread);
+  tracer->Clear();
+}
+
+TEST(Tracer, ExportWhileRecordingSeesOnlyWholeSpans) {
+  Tracer* tracer = Tracer::Get();
+  tracer->Clear();
+  tracer->SetEnabled(true);
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (int64_t i = 0; !stop; ++i) {
+      tracer->Record("spin", i, i + 7);
+    }
+  });
+  for (int i = 0; i < 50; ++i) {
+    std::string json = tracer->ExportJson();
+    EXPECT_EQ(CountOf(json, "\"name\":\"spin\""), CountOf(json, "\"dur\":7,"));
+  }
+  stop = true;
+  writer.join();
+  tracer->SetEnabled(false);
+  tracer->Clear();
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,90 @@
+#include "url_pattern_set.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(UrlPatternSet, ReportsTheTagsOfEveryPatternInTheUrl) {
+  UrlPatternSet patterns({{"/redirect?status=", 1},
+                          {"/api/user/redirect", 2},
+                          {".pdf", 4},
+                          {"/statements/", 4},
+                          {"bank.example", 8}});
+  EXPECT_EQ(patterns.Match("https://bank.example/home"), 8u);
+  EXPECT_EQ(patterns.Match("https://bank.example/statements/may.pdf"), 12u);
+  EXPECT_EQ(patterns.Match("https://x.test/redirect?status=ok"), 1u);
+  EXPECT_EQ(patterns.Match("https://x.test/api/user/redirect"), 2u);
+  EXPECT_EQ(patterns.Match("https://x.test/"), 0u);
+  EXPECT_EQ(patterns.Match(""), 0u);
+}
+
+TEST(UrlPatternSet, FindsPatternsInsideOtherPatterns) {
+  // "/redirect" ends inside "/api/user/redirect", and "he" inside "she".
+  UrlPatternSet patterns(
+      {{"/api/user/redirect", 1}, {"/redirect", 2}, {"she", 4}, {"he", 8}});
+  EXPECT_EQ(patterns.Match("https://x.test/api/user/redirect"), 3u);
+  EXPECT_EQ(patterns.Match("ushers"), 12u);
+  EXPECT_EQ(patterns.Match("/api/user/redirec"), 0u);
+}
+
+TEST(UrlPatternSet, IsCaseSensitive) {
+  UrlPatternSet patterns({{".PDF", 1}});
+  EXPECT_EQ(patterns.Match("https://x.test/a.PDF"), 1u);
+  EXPECT_EQ(patterns.Match("https://x.test/a.pdf"), 0u);
+}
+
+TEST(UrlPatternSet, EmptyPatternsMatchEveryUrl) {
+  UrlPatternSet patterns({{"", 1}, {"x", 2}});
+  EXPECT_EQ(patterns.Match(""), 1u);
+  EXPECT_EQ(patterns.Match("https://y.test/"), 1u);
+  EXPECT_EQ(patterns.Match("https://x.test/"), 3u);
+  EXPECT_EQ(UrlPatternSet({}).Match("https://x.test/"), 0u);
+}
+
+TEST(UrlPatternSet, HandlesEveryByteValue) {
+  std::string all;
+  for (int c = 0; c < 256; ++c) {
+    all.push_back(static_cast<char>(c));
+  }
+  UrlPatternSet patterns({{all, 1}, {std::string("\xff\x00", 2), 2}});
+  EXPECT_EQ(patterns.Match("a" + all + "b"), 1u);
+  EXPECT_EQ(patterns.Match(std::string("\xfe\xff\x00", 3)), 2u);
+}
+
+TEST(UrlPatternSet, AgreesWithSubstringSearch) {
+  std::mt19937 random(11);
+  // A small alphabet, so that patterns overlap often.
+  auto text = [&](size_t max_length) {
+    std::string result(random() % (max_length + 1), 'a');
+    for (char& c : result) {
+      c = "ab/."[random() % 4];
+    }
+    return result;
+  };
+  for (int round = 0; round < 50; ++round) {
+    std::vector<UrlPatternSet::Pattern> list;
+    for (uint32_t i = 0; i < 20; ++i) {
+      list.emplace_back(text(6), uint32_t{1} << (i % 32));
+    }
+    UrlPatternSet patterns(list);
+    for (int i = 0; i < 50; ++i) {
+      std::string url = text(40);
+      uint32_t expected = 0;
+      for (const UrlPatternSet::Pattern& pattern : list) {
+        if (url.find(pattern.first) != std::string::npos) {
+          expected |= pattern.second;
+        }
+      }
+      EXPECT_EQ(patterns.Match(url), expected) << url;
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
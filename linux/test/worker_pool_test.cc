@@ -0,0 +1,77 @@
+#include "worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+namespace test {
+
+TEST(WorkerPool, RunsEveryTaskBeforeJoining) {
+  std::atomic<int> done{0};
+  {
+    WorkerPool pool(4);
+    for (int i = 0; i < 1000; ++i) {
+      pool.Post([&done] { ++done; });
+    }
+  }
+  EXPECT_EQ(done, 1000);
+}
+
+TEST(WorkerPool, SequencesRunInOrderOneAtATime) {
+  WorkerPool pool(4);
+  TaskSequence first(&pool);
+  TaskSequence second(&pool);
+  // Neither vector is locked: a sequence never runs two tasks at once.
+  std::vector<int> first_order;
+  std::vector<int> second_order;
+  std::atomic<int> done{0};
+  for (int i = 0; i < 500; ++i) {
+    first.Post([&, i] {
+      first_order.push_back(i);
+      ++done;
+    });
+    second.Post([&, i] {
+      second_order.push_back(i);
+      ++done;
+    });
+  }
+  while (done < 1000) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(first_order.size(), 500u);
+  ASSERT_EQ(second_order.size(), 500u);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(first_order[i], i);
+    EXPECT_EQ(second_order[i], i);
+  }
+  EXPECT_EQ(pool.stats().queued, 0u);
+}
+
+// The plugin posts method calls from the main loop, which must not wait for
+// them: a burst of posts returns while every task is still blocked.
+TEST(WorkerPool, PostingNeverWaitsForTasks) {
+  WorkerPool pool(2);
+  TaskSequence sequence(&pool);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<int> done{0};
+  for (int i = 0; i < 1000; ++i) {
+    sequence.Post([&] {
+      released.wait();
+      ++done;
+    });
+  }
+  EXPECT_EQ(done, 0);
+  release.set_value();
+  while (done < 1000) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(pool.stats().queued, 0u);
+}
+
+}  // namespace test
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,106 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr int kWheelBits = TimerWheel::kLevelBits * TimerWheel::kLevels;
+
+}  // namespace
+
+TimerWheel::TimerWheel(int64_t now) : now_(now) {}
+
+void TimerWheel::Schedule(uint64_t id, int64_t deadline) {
+  ++size_;
+  Place({id, deadline}, &due_);
+}
+
+void TimerWheel::Place(const Timer& timer, std::vector<Timer>* fired) {
+  if (timer.deadline <= now_) {
+    fired->push_back(timer);
+    return;
+  }
+  // A deadline beyond the span of the whole wheel waits in the top level
+  // and is placed again when its slot comes round.
+  int64_t at =
+      std::min(timer.deadline, now_ + (int64_t{1} << kWheelBits) - 1);
+  int level = 0;
+  while (level < kLevels - 1 &&
+         (at >> (kLevelBits * (level + 1))) !=
+             (now_ >> (kLevelBits * (level + 1)))) {
+    ++level;
+  }
+  size_t slot = (at >> (kLevelBits * level)) & (kSlots - 1);
+  slots_[level][slot].push_back(timer);
+  ++level_sizes_[level];
+}
+
+void TimerWheel::Advance(int64_t now, std::vector<Timer>* fired) {
+  while (now_ < now) {
+    int empty = 0;
+    while (empty < kLevels && level_sizes_[empty] == 0) {
+      ++empty;
+    }
+    if (empty == kLevels) {
+      now_ = now;
+      break;
+    }
+    // Nothing happens before the next slot boundary of the lowest level
+    // holding timers, as every level below it is empty.
+    int64_t next = ((now_ >> (kLevelBits * empty)) + 1)
+                   << (kLevelBits * empty);
+    if (next > now) {
+      now_ = now;
+      break;
+    }
+    now_ = next;
+    Tick(&due_);
+  }
+  size_ -= due_.size();
+  if (fired->empty()) {
+    fired->swap(due_);
+  } else {
+    fired->insert(fired->end(), due_.begin(), due_.end());
+  }
+  due_.clear();
+}
+
+void TimerWheel::Tick(std::vector<Timer>* fired) {
+  for (int level = kLevels - 1; level > 0; --level) {
+    int64_t mask = (int64_t{1} << (kLevelBits * level)) - 1;
+    if ((now_ & mask) != 0) {
+      continue;
+    }
+    std::vector<Timer>& slot =
+        slots_[level][(now_ >> (kLevelBits * level)) & (kSlots - 1)];
+    if (slot.empty()) {
+      continue;
+    }
+    std::vector<Timer> timers;
+    timers.swap(slot);
+    level_sizes_[level] -= timers.size();
+    for (const Timer& timer : timers) {
+      Place(timer, fired);
+    }
+  }
+  std::vector<Timer>& slot = slots_[0][now_ & (kSlots - 1)];
+  level_sizes_[0] -= slot.size();
+  fired->insert(fired->end(), slot.begin(), slot.end());
+  slot.clear();
+}
+
+void TimerWheel::Clear() {
+  for (auto& level : slots_) {
+    for (std::vector<Timer>& slot : level) {
+      slot.clear();
+    }
+  }
+  std::fill(std::begin(level_sizes_), std::end(level_sizes_), 0);
+  due_.clear();
+  size_ = 0;
+}
+
+}  // namespace flutter_cookie_bridge
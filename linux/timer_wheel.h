@@ -0,0 +1,73 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_TIMER_WHEEL_H_
+#define FLUTTER_COOKIE_BRIDGE_TIMER_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+// A hierarchical timer wheel over whole seconds, for deadlines that are
+// mostly never cancelled but often superseded, like cookie expiry.
+//
+// Level L has kSlots slots of kSlots^L seconds each. A timer goes in the
+// lowest level whose span reaches its deadline and moves down a level
+// each time the wheel turns past the start of its slot, so scheduling is
+// O(1) and each timer is touched at most kLevels times before it fires.
+// Advance skips stretches of empty slots instead of ticking through every
+// second of them.
+//
+// Timers cannot be cancelled. The owner checks what fired against its own
+// state and ignores timers it superseded.
+class TimerWheel {
+ public:
+  struct Timer {
+    uint64_t id;
+    int64_t deadline;
+  };
+
+  static constexpr int kLevelBits = 6;
+  static constexpr size_t kSlots = size_t{1} << kLevelBits;
+  static constexpr int kLevels = 5;
+
+  // |now| is the current time, in seconds.
+  explicit TimerWheel(int64_t now);
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Schedules timer |id| for |deadline|. A deadline that is not after the
+  // wheel's current time fires on the next Advance.
+  void Schedule(uint64_t id, int64_t deadline);
+
+  // Moves the wheel to |now| and appends the timers whose deadline is not
+  // after it to |fired|. Going back in time does nothing.
+  void Advance(int64_t now, std::vector<Timer>* fired);
+
+  // Drops every timer.
+  void Clear();
+
+  // Timers scheduled and not yet fired.
+  size_t size() const { return size_; }
+
+  int64_t now() const { return now_; }
+
+ private:
+  // Places |timer| relative to now_, or into |fired| if it is due.
+  void Place(const Timer& timer, std::vector<Timer>* fired);
+
+  // Cascades the slots starting at now_ down a level, then fires the
+  // level-0 slot of now_.
+  void Tick(std::vector<Timer>* fired);
+
+  int64_t now_;
+  std::vector<Timer> slots_[kLevels][kSlots];
+  size_t level_sizes_[kLevels] = {};
+  // Due timers waiting for the next Advance.
+  std::vector<Timer> due_;
+  size_t size_ = 0;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_TIMER_WHEEL_H_
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Compiles the Public Suffix List into the automaton public_suffix.cc walks.
+
+Usage: make_public_suffix_dafsa.py LIST OUTPUT
+
+Reads the list from LIST, a copy of
+https://publicsuffix.org/list/public_suffix_list.dat, and writes OUTPUT.
+
+Every rule of the list, ICANN and private sections alike, goes into a trie
+read backwards, since hosts are matched from their last character; nodes
+that accept the same remainders are then merged, which turns the trie into a
+minimal DAFSA. Labels are converted to punycode, the form hosts are matched
+in. The output defines kDafsaStates, kDafsaEdges and kDafsaStart for
+public_suffix.cc to include; see DafsaState and DafsaEdge there.
+
+Uses the standard library only, so that any Python 3 can run it at build
+time.
+"""
+
+import sys
+
+# The kinds of rule that end at a node, as RuleKind in public_suffix.cc.
+RULE = 1 << 0
+WILDCARD = 1 << 1
+EXCEPTION = 1 << 2
+
+# States and edges are numbered with 16 bits.
+MAX_INDEX = (1 << 16) - 1
+
+
+class Node:
+    __slots__ = ('kinds', 'children')
+
+    def __init__(self):
+        self.kinds = 0
+        self.children = {}
+
+
+def read_rules(path):
+    """Yields the rules of the list at |path|, as (body, kind) pairs."""
+    with open(path, encoding='utf-8') as list_file:
+        for line in list_file:
+            # A rule is the first word of its line.
+            words = line.split()
+            if not words or words[0].startswith('//'):
+                continue
+            rule = words[0]
+            if rule.startswith('*.'):
+                body, kind = rule[2:], WILDCARD
+            elif rule.startswith('!'):
+                body, kind = rule[1:], EXCEPTION
+            else:
+                body, kind = rule, RULE
+            yield '.'.join(label.encode('idna').decode('ascii')
+                           for label in body.split('.')), kind
+
+
+def build_trie(rules):
+    root = Node()
+    for body, kind in rules:
+        node = root
+        for c in reversed(body):
+            node = node.children.setdefault(c, Node())
+        node.kinds |= kind
+    return root
+
+
+def minimize(root):
+    """Returns the states of the DAFSA, as (kinds, [(label, target)]) in
+    index order, and the index of the start state."""
+    states = []
+    index_of = {}
+
+    # Children come before their parents, so a state's targets are known by
+    # the time it is looked up. Hosts are short, so recursion is shallow.
+    def visit(node):
+        edges = tuple((c, visit(node.children[c]))
+                      for c in sorted(node.children))
+        signature = (node.kinds, edges)
+        index = index_of.get(signature)
+        if index is None:
+            index = index_of[signature] = len(states)
+            states.append(signature)
+        return index
+
+    start = visit(root)
+    return states, start
+
+
+def write_dafsa(states, start, path):
+    edge_count = sum(len(edges) for _, edges in states)
+    if len(states) > MAX_INDEX or edge_count > MAX_INDEX:
+        sys.exit('too many rules for 16-bit states: %d states, %d edges' %
+                 (len(states), edge_count))
+    lines = [
+        '// Generated by tools/make_public_suffix_dafsa.py from',
+        '// public_suffix_list.dat; do not edit.',
+        '',
+        'constexpr DafsaState kDafsaStates[] = {',
+    ]
+    first_edge = 0
+    for kinds, edges in states:
+        lines.append('    {%d, %d, %d},' % (first_edge, len(edges), kinds))
+        first_edge += len(edges)
+    lines.append('};')
+    lines.append('')
+    lines.append('constexpr DafsaEdge kDafsaEdges[] = {')
+    for _, edges in states:
+        for label, target in edges:
+            lines.append("    {'%s', %d}," % (label, target))
+    lines.append('};')
+    lines.append('')
+    lines.append('constexpr uint16_t kDafsaStart = %d;' % start)
+    with open(path, 'w', encoding='ascii') as output:
+        output.write('\n'.join(lines) + '\n')
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.exit('usage: make_public_suffix_dafsa.py LIST OUTPUT')
+    states, start = minimize(build_trie(read_rules(argv[1])))
+    write_dafsa(states, start, argv[2])
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,182 @@
+#include "trace.h"
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace flutter_cookie_bridge {
+
+struct Tracer::Ring {
+  // A slot holding the n-th span of its ring has sequence 2n + 2 once
+  // written, and an odd sequence while being written.
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start_us{0};
+    std::atomic<int64_t> duration_us{0};
+    std::atomic<int32_t> tid{0};
+  };
+
+  std::atomic<bool> claimed{false};
+  int32_t tid = 0;
+  // Spans ever written, and how many of those Clear dropped.
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> cleared{0};
+  Slot slots[kEventsPerThread];
+};
+
+namespace {
+
+struct Span {
+  const char* name;
+  int64_t start_us;
+  int64_t duration_us;
+  int32_t tid;
+};
+
+void AppendEscaped(std::string* out, const char* text) {
+  for (const char* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      out->push_back('\\');
+      out->push_back(*c);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+      out->append(escaped);
+    } else {
+      out->push_back(*c);
+    }
+  }
+}
+
+}  // namespace
+
+Tracer* Tracer::Get() {
+  static Tracer* tracer = new Tracer();
+  return tracer;
+}
+
+int64_t Tracer::NowMicros() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void Tracer::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::Record(const char* name, int64_t start_us, int64_t end_us) {
+  if (!enabled()) {
+    return;
+  }
+  Ring* ring = CurrentRing();
+  uint64_t n = ring->head.load(std::memory_order_relaxed);
+  Ring::Slot& slot = ring->slots[n % kEventsPerThread];
+  // Release stores keep a reader that sees any new field from missing the
+  // odd sequence before it.
+  slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+  slot.name.store(name, std::memory_order_release);
+  slot.start_us.store(start_us, std::memory_order_release);
+  slot.duration_us.store(std::max<int64_t>(end_us - start_us, 0),
+                         std::memory_order_release);
+  slot.tid.store(ring->tid, std::memory_order_release);
+  slot.sequence.store(2 * n + 2, std::memory_order_release);
+  ring->head.store(n + 1, std::memory_order_release);
+}
+
+Tracer::Ring* Tracer::CurrentRing() {
+  // Gives the thread's ring back when the thread exits.
+  struct Registration {
+    ~Registration() {
+      if (ring != nullptr) {
+        ring->claimed.store(false, std::memory_order_release);
+      }
+    }
+
+    Ring* ring = nullptr;
+  };
+  thread_local Registration registration;
+  if (registration.ring != nullptr) {
+    return registration.ring;
+  }
+
+  Ring* ring = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (const std::unique_ptr<Ring>& candidate : rings_) {
+      bool expected = false;
+      if (candidate->claimed.compare_exchange_strong(expected, true)) {
+        ring = candidate.get();
+        break;
+      }
+    }
+    if (ring == nullptr) {
+      rings_.push_back(std::make_unique<Ring>());
+      ring = rings_.back().get();
+      ring->claimed.store(true);
+    }
+  }
+  ring->tid = static_cast<int32_t>(syscall(SYS_gettid));
+  registration.ring = ring;
+  return ring;
+}
+
+std::string Tracer::ExportJson() const {
+  std::vector<Span> spans;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (const std::unique_ptr<Ring>& ring : rings_) {
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      uint64_t first = std::max(
+          ring->cleared.load(std::memory_order_relaxed),
+          head > kEventsPerThread ? head - kEventsPerThread : 0);
+      for (uint64_t n = first; n < head; ++n) {
+        const Ring::Slot& slot = ring->slots[n % kEventsPerThread];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * n + 2) {
+          continue;
+        }
+        Span span{slot.name.load(std::memory_order_acquire),
+                  slot.start_us.load(std::memory_order_acquire),
+                  slot.duration_us.load(std::memory_order_acquire),
+                  slot.tid.load(std::memory_order_acquire)};
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+          spans.push_back(span);
+        }
+      }
+    }
+  }
+  std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+    return a.start_us < b.start_us;
+  });
+
+  std::string json = "{\"traceEvents\":[";
+  const int pid = getpid();
+  char fields[128];
+  for (size_t i = 0; i < spans.size(); ++i) {
+    json.append(i == 0 ? "{\"name\":\"" : ",{\"name\":\"");
+    AppendEscaped(&json, spans[i].name);
+    snprintf(fields, sizeof(fields),
+             "\",\"cat\":\"flutter_cookie_bridge\",\"ph\":\"X\",\"ts\":%lld,"
+             "\"dur\":%lld,\"pid\":%d,\"tid\":%d}",
+             static_cast<long long>(spans[i].start_us),
+             static_cast<long long>(spans[i].duration_us), pid, spans[i].tid);
+    json.append(fields);
+  }
+  json.append("],\"displayTimeUnit\":\"ms\"}");
+  return json;
+}
+
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (const std::unique_ptr<Ring>& ring : rings_) {
+    ring->cleared.store(ring->head.load(std::memory_order_acquire),
+                        std::memory_order_relaxed);
+  }
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,90 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_TRACE_H_
+#define FLUTTER_COOKIE_BRIDGE_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+// Records spans into a ring buffer per thread, for export as Chrome
+// trace-event JSON that chrome://tracing and Perfetto open.
+//
+// A thread only ever writes its own ring, so recording takes no lock and
+// never waits for the exporter; the exporter skips a slot that a sequence
+// number shows was overwritten while it read it. Each ring keeps the most
+// recent kEventsPerThread spans. While tracing is disabled, recording costs
+// one relaxed load.
+class Tracer {
+ public:
+  static constexpr size_t kEventsPerThread = 1024;
+
+  // The tracer of the process, shared by the runner, the plugin and Dart.
+  static Tracer* Get();
+
+  Tracer() = default;
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  // Microseconds on the monotonic clock, the time base of every span. Dart's
+  // Timeline.now reads the same clock.
+  static int64_t NowMicros();
+
+  void SetEnabled(bool enabled);
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Records a span of the calling thread, if tracing is enabled. |name| is
+  // not copied and must stay valid for the life of the process, like a
+  // string literal.
+  void Record(const char* name, int64_t start_us, int64_t end_us);
+
+  // {"traceEvents":[...]} with a complete ("X") event per span still in the
+  // rings, in order of start time.
+  std::string ExportJson() const;
+
+  // Drops every recorded span.
+  void Clear();
+
+ private:
+  struct Ring;
+
+  // The calling thread's ring, claimed on its first span.
+  Ring* CurrentRing();
+
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex rings_mutex_;
+  // Rings are never freed: a thread that exits gives its ring back for the
+  // next one to reuse, and the spans it recorded stay exportable until then.
+  std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+// Records a span from construction to destruction on Tracer::Get(), if
+// tracing was enabled at construction. |name| must outlive the process, as
+// for Tracer::Record.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name)
+      : name_(name),
+        start_us_(Tracer::Get()->enabled() ? Tracer::NowMicros() : -1) {}
+
+  ~ScopedTrace() {
+    if (start_us_ >= 0) {
+      Tracer::Get()->Record(name_, start_us_, Tracer::NowMicros());
+    }
+  }
+
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+ private:
+  const char* const name_;
+  const int64_t start_us_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_TRACE_H_
@@ -0,0 +1,71 @@
+#include "url.h"
+
+namespace flutter_cookie_bridge {
+
+bool ParseUrl(std::string_view url, Url* out) {
+  size_t scheme_end = url.find("://");
+  if (scheme_end == std::string_view::npos || scheme_end == 0) {
+    return false;
+  }
+  *out = Url();
+  out->scheme = url.substr(0, scheme_end);
+
+  std::string_view rest = url.substr(scheme_end + 3);
+  size_t authority_end = rest.find_first_of("/?#");
+  std::string_view authority = rest.substr(0, authority_end);
+  rest = authority_end == std::string_view::npos ? std::string_view()
+                                                 : rest.substr(authority_end);
+
+  // Drop any userinfo.
+  size_t at = authority.rfind('@');
+  if (at != std::string_view::npos) {
+    authority = authority.substr(at + 1);
+  }
+  if (!authority.empty() && authority.front() == '[') {
+    // IPv6 literal; keep the brackets out of the host.
+    size_t close = authority.find(']');
+    if (close == std::string_view::npos) {
+      return false;
+    }
+    out->host = authority.substr(1, close - 1);
+    if (close + 1 < authority.size() && authority[close + 1] == ':') {
+      out->port = authority.substr(close + 2);
+    }
+  } else {
+    size_t colon = authority.rfind(':');
+    out->host = authority.substr(0, colon);
+    if (colon != std::string_view::npos) {
+      out->port = authority.substr(colon + 1);
+    }
+  }
+  if (out->host.empty()) {
+    return false;
+  }
+
+  size_t fragment = rest.find('#');
+  if (fragment != std::string_view::npos) {
+    rest = rest.substr(0, fragment);
+  }
+  size_t query = rest.find('?');
+  if (query != std::string_view::npos) {
+    out->query = rest.substr(query + 1);
+    rest = rest.substr(0, query);
+  }
+  out->path = rest.empty() ? std::string_view("/") : rest;
+  return true;
+}
+
+std::string CanonicalHost(std::string_view host) {
+  if (!host.empty() && host.back() == '.') {
+    host.remove_suffix(1);
+  }
+  std::string result(host);
+  for (char& c : result) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+  return result;
+}
+
+}  // namespace flutter_cookie_bridge
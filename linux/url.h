@@ -0,0 +1,34 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_URL_H_
+#define FLUTTER_COOKIE_BRIDGE_URL_H_
+
+#include <string>
+#include <string_view>
+
+namespace flutter_cookie_bridge {
+
+// The parts of an absolute http(s) URL that cookie matching cares about.
+//
+// All views point into the string passed to ParseUrl, so a Url must not
+// outlive it. The host is not lowercased; use CanonicalHost for that.
+struct Url {
+  std::string_view scheme;
+  std::string_view host;
+  std::string_view port;
+  // The path without query or fragment. "/" when the URL has no path.
+  std::string_view path;
+  // The query without the leading '?', empty when absent.
+  std::string_view query;
+
+  bool is_secure() const { return scheme == "https" || scheme == "wss"; }
+};
+
+// Splits |url| into its components. Returns false when |url| is not an
+// absolute URL with a non-empty host.
+bool ParseUrl(std::string_view url, Url* out);
+
+// Returns the lowercased host with any trailing dot removed.
+std::string CanonicalHost(std::string_view host);
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_URL_H_
@@ -0,0 +1,80 @@
+#include "url_pattern_set.h"
+
+#include <deque>
+
+namespace flutter_cookie_bridge {
+
+namespace {
+
+constexpr uint32_t kNoState = UINT32_MAX;
+
+}  // namespace
+
+UrlPatternSet::UrlPatternSet(const std::vector<Pattern>& patterns) {
+  for (const Pattern& pattern : patterns) {
+    for (unsigned char c : pattern.first) {
+      if (classes_[c] == 0) {
+        classes_[c] = static_cast<uint16_t>(class_count_++);
+      }
+    }
+  }
+
+  // The trie of the patterns, with kNoState for missing edges.
+  next_.assign(class_count_, kNoState);
+  tags_.assign(1, 0);
+  for (const Pattern& pattern : patterns) {
+    uint32_t state = 0;
+    for (unsigned char c : pattern.first) {
+      uint32_t& edge = next_[state * class_count_ + classes_[c]];
+      if (edge == kNoState) {
+        edge = static_cast<uint32_t>(tags_.size());
+        tags_.push_back(0);
+        next_.resize(next_.size() + class_count_, kNoState);
+      }
+      state = next_[state * class_count_ + classes_[c]];
+    }
+    tags_[state] |= pattern.second;
+  }
+
+  // Breadth first, so that the failure state of each state, which is
+  // shallower, is complete before the state borrows its missing edges and
+  // its tags from it.
+  std::vector<uint32_t> failure(tags_.size(), 0);
+  std::deque<uint32_t> queue;
+  for (size_t c = 0; c < class_count_; ++c) {
+    uint32_t& edge = next_[c];
+    if (edge == kNoState) {
+      edge = 0;
+    } else {
+      tags_[edge] |= tags_[0];
+      queue.push_back(edge);
+    }
+  }
+  while (!queue.empty()) {
+    uint32_t state = queue.front();
+    queue.pop_front();
+    const uint32_t* fallback = &next_[failure[state] * class_count_];
+    for (size_t c = 0; c < class_count_; ++c) {
+      uint32_t& edge = next_[state * class_count_ + c];
+      if (edge == kNoState) {
+        edge = fallback[c];
+      } else {
+        failure[edge] = fallback[c];
+        tags_[edge] |= tags_[failure[edge]];
+        queue.push_back(edge);
+      }
+    }
+  }
+}
+
+uint32_t UrlPatternSet::Match(std::string_view url) const {
+  uint32_t state = 0;
+  uint32_t tags = tags_[0];
+  for (unsigned char c : url) {
+    state = next_[state * class_count_ + classes_[c]];
+    tags |= tags_[state];
+  }
+  return tags;
+}
+
+}  // namespace flutter_cookie_bridge
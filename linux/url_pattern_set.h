@@ -0,0 +1,51 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_URL_PATTERN_SET_H_
+#define FLUTTER_COOKIE_BRIDGE_URL_PATTERN_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+// A set of substring patterns, each tagged with bits of a mask, compiled
+// into one automaton that finds every pattern in a URL in a single pass.
+//
+// This is an Aho-Corasick automaton turned into a full transition table:
+// each byte of the URL is one table lookup, however many patterns there
+// are, and each state carries the tags of every pattern ending there. Bytes
+// that no pattern uses share one column of the table, which keeps it small
+// for the ASCII patterns navigation rules are made of.
+//
+// Matching is case-sensitive, like String.contains. A set is immutable once
+// built, so Match may be called from several threads at once.
+class UrlPatternSet {
+ public:
+  using Pattern = std::pair<std::string, uint32_t>;
+
+  explicit UrlPatternSet(const std::vector<Pattern>& patterns);
+
+  UrlPatternSet(const UrlPatternSet&) = delete;
+  UrlPatternSet& operator=(const UrlPatternSet&) = delete;
+
+  // The union of the tags of the patterns that occur in |url|. An empty
+  // pattern occurs in every URL.
+  uint32_t Match(std::string_view url) const;
+
+  size_t state_count() const { return tags_.size(); }
+
+ private:
+  // Column of the table for each byte value. Column 0 is shared by the
+  // bytes no pattern uses.
+  uint16_t classes_[256] = {};
+  size_t class_count_ = 1;
+  // class_count_ entries per state.
+  std::vector<uint32_t> next_;
+  std::vector<uint32_t> tags_;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_URL_PATTERN_SET_H_
@@ -0,0 +1,95 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace flutter_cookie_bridge {
+
+WorkerPool* WorkerPool::Shared() {
+  // Handlers are short; a few workers keep one slow disk from holding up
+  // the rest without competing with the engine for cores.
+  static WorkerPool* pool = new WorkerPool(
+      std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 2, 4));
+  return pool;
+}
+
+WorkerPool::WorkerPool(size_t threads) {
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this] { Run(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    stats_.max_queued = std::max(stats_.max_queued, tasks_.size());
+  }
+  available_.notify_one();
+}
+
+WorkerPoolStats WorkerPool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  WorkerPoolStats stats = stats_;
+  stats.queued = tasks_.size();
+  return stats;
+}
+
+void WorkerPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      return;
+    }
+    std::function<void()> task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+    ++stats_.completed;
+  }
+}
+
+TaskSequence::TaskSequence(WorkerPool* pool) : pool_(pool) {}
+
+void TaskSequence::Post(std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tasks_.push_back(std::move(task));
+  if (!scheduled_) {
+    scheduled_ = true;
+    pool_->Post([this] { RunNext(); });
+  }
+}
+
+void TaskSequence::RunNext() {
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+  }
+  task();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tasks_.empty()) {
+    scheduled_ = false;
+  } else {
+    // Back of the pool's queue, so a busy sequence does not monopolize a
+    // worker.
+    pool_->Post([this] { RunNext(); });
+  }
+}
+
+}  // namespace flutter_cookie_bridge
@@ -0,0 +1,78 @@
+#ifndef FLUTTER_COOKIE_BRIDGE_WORKER_POOL_H_
+#define FLUTTER_COOKIE_BRIDGE_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace flutter_cookie_bridge {
+
+struct WorkerPoolStats {
+  // Tasks waiting for a worker now, and the most that ever waited.
+  size_t queued = 0;
+  size_t max_queued = 0;
+  uint64_t completed = 0;
+};
+
+// A fixed number of threads running posted tasks, so that work which may
+// block on the disk stays off the GTK main loop without a thread per call.
+class WorkerPool {
+ public:
+  // The pool method call handlers run on.
+  static WorkerPool* Shared();
+
+  explicit WorkerPool(size_t threads);
+  // Runs the tasks still queued, then joins the workers.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void Post(std::function<void()> task);
+
+  WorkerPoolStats stats() const;
+
+ private:
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  WorkerPoolStats stats_;
+  std::vector<std::thread> threads_;
+};
+
+// Runs tasks on a WorkerPool one at a time, in the order they were posted,
+// for work that must not be reordered, such as cookie writes followed by
+// reads. Occupies at most one worker, and none while it has nothing to do.
+class TaskSequence {
+ public:
+  explicit TaskSequence(WorkerPool* pool);
+  // Must not be destroyed while tasks are pending.
+  ~TaskSequence() = default;
+
+  TaskSequence(const TaskSequence&) = delete;
+  TaskSequence& operator=(const TaskSequence&) = delete;
+
+  void Post(std::function<void()> task);
+
+ private:
+  // Runs the next task, then hands the worker back to the pool.
+  void RunNext();
+
+  WorkerPool* const pool_;
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+  // Whether a RunNext is posted to the pool or running.
+  bool scheduled_ = false;
+};
+
+}  // namespace flutter_cookie_bridge
+
+#endif  // FLUTTER_COOKIE_BRIDGE_WORKER_POOL_H_
@@ -0,0 +1,109 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/domain_cookie_jar.dart';
+import 'package:flutter_cookie_bridge/set_cookie_parser.dart';
+
+void main() {
+  List<SetCookie?> parse(List<String> headers) =>
+      headers.map(SetCookieParser.parseDart).toList();
+
+  test('sends cookies only to the hosts and paths they are scoped to', () {
+    final jar = DomainCookieJar();
+    jar.setCookies(Uri.parse('https://a.b.example.com/app/login'), parse([
+      'host=1',
+      'b=2; Domain=b.example.com; Path=/',
+      'root=3; Domain=.example.com; Path=/',
+    ]));
+    jar.setCookies(Uri.parse('https://other.org/'), parse(['other=4']));
+
+    expect(jar.cookieHeader(Uri.parse('https://a.b.example.com/app/x')),
+        'host=1; b=2; root=3');
+    expect(jar.cookieHeader(Uri.parse('https://a.b.example.com/')),
+        'b=2; root=3');
+    expect(jar.cookieHeader(Uri.parse('https://c.b.example.com/')),
+        'b=2; root=3');
+    expect(jar.cookieHeader(Uri.parse('https://example.com/')), 'root=3');
+    expect(jar.cookieHeader(Uri.parse('https://notexample.com/')), isNull);
+    expect(jar.cookieHeader(Uri.parse('https://other.org/')), 'other=4');
+  });
+
+  test('rejects foreign and top-level domains', () {
+    final jar = DomainCookieJar();
+    final changes = jar.setCookies(Uri.parse('https://www.example.com/'),
+        parse(['a=1; Domain=other.com', 'b=2; Domain=com']));
+    expect(changes, isEmpty);
+    expect(jar.cookies, isEmpty);
+  });
+
+  test('replaces, expires and survives encoding', () {
+    final jar = DomainCookieJar();
+    final url = Uri.parse('https://example.com/');
+    jar.setCookies(url, parse(['a=1; Path=/', 'b=2; Path=/; Secure']));
+    jar.setCookies(url, parse(['a=3; Path=/']));
+    expect(jar.cookieHeader(url), 'a=3; b=2');
+    expect(jar.cookieHeader(Uri.parse('http://example.com/')), 'a=3');
+
+    final restored = DomainCookieJar.decode(jar.encode());
+    expect(restored.cookieHeader(url), 'a=3; b=2');
+
+    final changes = restored.setCookies(url, parse(['a=; Path=/; Max-Age=0']));
+    expect(changes.single.removed, isTrue);
+    expect(restored.cookieHeader(url), 'b=2');
+  });
+
+  test('drops expired and least recently stored cookies', () {
+    final jar = DomainCookieJar(
+        limits: const CookieJarLimits(maxCookiesPerDomain: 2, maxCookies: 3));
+    final com = Uri.parse('https://example.com/');
+    jar.setCookies(com, parse(['a=1; Max-Age=60', 'b=2']));
+    jar.setCookies(com, parse(['a=3; Max-Age=60', 'c=4']));
+    expect(jar.cookieHeader(com), 'a=3; c=4');
+
+    jar.setCookies(Uri.parse('https://example.org/'), parse(['d=5', 'e=6']));
+    expect(jar.cookieHeader(com), 'c=4');
+    expect(jar.stats.evicted, 2);
+
+    jar.setCookies(com, parse(['f=7; Max-Age=60']));
+    final changes =
+        jar.removeExpired(DateTime.now().add(const Duration(minutes: 2)));
+    expect(changes.single.name, 'f');
+    expect(jar.stats.expired, 1);
+    expect(jar.cookies.length, 2);
+  });
+
+  test('forks share cookies until either changes them', () {
+    final jar = DomainCookieJar();
+    final com = Uri.parse('https://example.com/');
+    final org = Uri.parse('https://example.org/');
+    jar.setCookies(com, parse(['user=alice; Max-Age=60']));
+    jar.setCookies(org, parse(['theme=dark']));
+
+    final fork = jar.fork();
+    expect(jar.changesTo(fork), isEmpty);
+    fork.setCookies(com, parse(['user=karza; Max-Age=60']));
+    fork.setCookies(Uri.parse('https://partner.test/'), parse(['token=1']));
+    jar.setCookies(org, parse(['theme=; Max-Age=0']));
+
+    expect(jar.cookieHeader(com), 'user=alice');
+    expect(jar.cookieHeader(org), isNull);
+    expect(fork.cookieHeader(com), 'user=karza');
+    expect(fork.cookieHeader(org), 'theme=dark');
+
+    final changes = jar.changesTo(fork);
+    expect(
+        changes.map((c) => '${c.domain} ${c.name}=${c.value}').toSet(),
+        {
+          'example.com user=karza',
+          'example.org theme=dark',
+          'partner.test token=1',
+        });
+    expect(changes.any((c) => c.removed), isFalse);
+    expect(
+        fork.changesTo(jar).map((c) => '${c.name} ${c.removed}').toSet(),
+        {'user false', 'theme true', 'token true'});
+
+    final later = DateTime.now().add(const Duration(minutes: 2));
+    expect(jar.removeExpired(later).single.name, 'user');
+    expect(fork.cookies.length, 3);
+    expect(fork.removeExpired(later).single.name, 'user');
+  });
+}
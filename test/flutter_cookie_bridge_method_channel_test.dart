@@ -1,6 +1,9 @@
+import 'dart:typed_data';
+
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:flutter_cookie_bridge/flutter_cookie_bridge_method_channel.dart';
+import 'package:flutter_cookie_bridge/json_document.dart';
 
 void main() {
   TestWidgetsFlutterBinding.ensureInitialized();
@@ -9,11 +12,75 @@ void main() {
       MethodChannelFlutterCookieBridge();
   const MethodChannel channel = MethodChannel('flutter_cookie_bridge');
 
+  final List<MethodCall> log = [];
+
   setUp(() {
+    log.clear();
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
         .setMockMethodCallHandler(
       channel,
       (MethodCall methodCall) async {
+        log.add(methodCall);
+        switch (methodCall.method) {
+          case 'setCookies':
+            return (methodCall.arguments['cookies'] as List).length;
+          case 'syncCookies':
+            return (methodCall.arguments['cookies'] as Map).length;
+          case 'getCookieHeader':
+            return 'sid=42';
+          case 'getCookies':
+            return ['sid=42'];
+          case 'clear':
+          case 'switchCookiePartition':
+            return null;
+          case 'deleteCookiePartition':
+            return true;
+          case 'download':
+            return {
+              'path': methodCall.arguments['path'],
+              'bytes': 1024,
+              'segments': 2,
+              'resumed': true,
+              'sha256': 'ab',
+            };
+          case 'httpRequest':
+            if (methodCall.arguments['json'] == true) {
+              final document = JsonDocument.fromValue({'a': 1});
+              return {
+                'status': 200,
+                'json': {'tape': document.tape, 'strings': document.strings},
+              };
+            }
+            return {
+              'status': 201,
+              'headers': {
+                'set-cookie': ['a=1', 'b=2'],
+              },
+              'body': Uint8List.fromList([123, 125]),
+              if (methodCall.arguments['cache'] == true) 'cache': 'hit',
+            };
+          case 'configureHttpCache':
+          case 'clearHttpCache':
+          case 'configureCompression':
+            return null;
+          case 'compressionStats':
+            return {
+              'responses': 4,
+              'responseWireBytes': 1000,
+              'responseBytes': 4000,
+              'responsesDecoded': 3,
+              'decodeCpuUs': 250,
+            };
+          case 'httpCacheStats':
+            return {
+              'lookups': 10,
+              'hits': 6,
+              'revalidations': 2,
+              'misses': 2,
+              'bytesSaved': 4096,
+              'entries': 3,
+            };
+        }
         return '42';
       },
     );
@@ -27,4 +94,205 @@ void main() {
   test('getPlatformVersion', () async {
     expect(await platform.getPlatformVersion(), '42');
   });
+
+  test('setCookies sends the url and raw set-cookie values', () async {
+    await platform.setCookies('https://example.com/', ['sid=42; Path=/']);
+    expect(log.single.method, 'setCookies');
+    expect(log.single.arguments, {
+      'url': 'https://example.com/',
+      'cookies': ['sid=42; Path=/'],
+    });
+  });
+
+  test('syncCookies sends the whole set in one call', () async {
+    expect(
+        await platform.syncCookies(
+            'https://example.com/', {'sid': '42', 'theme': 'dark'}),
+        2);
+    expect(log.single.method, 'syncCookies');
+    expect(log.single.arguments, {
+      'url': 'https://example.com/',
+      'cookies': {'sid': '42', 'theme': 'dark'},
+    });
+  });
+
+  test('getCookieHeader', () async {
+    expect(await platform.getCookieHeader('https://example.com/'), 'sid=42');
+    expect(log.single.arguments, {'url': 'https://example.com/'});
+  });
+
+  test('getCookies', () async {
+    expect(await platform.getCookies(), ['sid=42']);
+  });
+
+  test('clearCookies', () async {
+    await platform.clearCookies();
+    expect(log.single.method, 'clear');
+  });
+
+  test('switchCookiePartition forks only when asked to', () async {
+    await platform.switchCookiePartition('karza', from: 'default');
+    await platform.switchCookiePartition('default');
+    expect(log.map((call) => call.arguments), [
+      {'name': 'karza', 'from': 'default'},
+      {'name': 'default'},
+    ]);
+    expect(await platform.deleteCookiePartition('karza'), isTrue);
+    expect(log.last.method, 'deleteCookiePartition');
+  });
+
+  test('download sends the target and decodes the result', () async {
+    final result = await platform.download(
+        'https://example.com/a.pdf', '/tmp/a.pdf',
+        headers: {'Accept': '*/*'},
+        id: '3',
+        progressInterval: const Duration(milliseconds: 250));
+    expect(log.single.method, 'download');
+    expect(log.single.arguments, {
+      'url': 'https://example.com/a.pdf',
+      'path': '/tmp/a.pdf',
+      'headers': {'Accept': '*/*'},
+      'id': '3',
+      'progressIntervalMs': 250,
+    });
+    expect(result.path, '/tmp/a.pdf');
+    expect(result.bytes, 1024);
+    expect(result.segments, 2);
+    expect(result.resumed, isTrue);
+    expect(result.sha256, 'ab');
+  });
+
+  test('httpRequest sends the request and decodes the response', () async {
+    final response = await platform.httpRequest(
+        'POST', 'https://example.com/api',
+        headers: {'Content-Type': 'application/json'},
+        body: Uint8List.fromList([123, 125]),
+        timeout: const Duration(seconds: 5));
+    expect(log.single.method, 'httpRequest');
+    expect(log.single.arguments['method'], 'POST');
+    expect(log.single.arguments['timeoutMs'], 5000);
+    expect(response.status, 201);
+    expect(response.headers['set-cookie'], ['a=1', 'b=2']);
+    expect(response.body, [123, 125]);
+    expect(response.cacheStatus, isNull);
+    expect(log.single.arguments.containsKey('cache'), isFalse);
+  });
+
+  test('httpRequest asks for the cache and reports its answer', () async {
+    final response = await platform
+        .httpRequest('GET', 'https://example.com/api', cache: true);
+    expect(log.single.arguments['cache'], isTrue);
+    expect(response.cacheStatus, 'hit');
+  });
+
+  test('httpRequest asks for a parsed JSON body', () async {
+    final response = await platform
+        .httpRequest('GET', 'https://example.com/api', json: true);
+    expect(log.single.arguments['json'], isTrue);
+    expect(response.body, isEmpty);
+    expect(response.json!.toObject(), {'a': 1});
+  });
+
+  test('configureHttpCache and httpCacheStats', () async {
+    await platform.configureHttpCache(enabled: true, maxBytes: 1 << 20);
+    expect(log.single.method, 'configureHttpCache');
+    expect(log.single.arguments, {'enabled': true, 'maxBytes': 1 << 20});
+
+    final stats = await platform.httpCacheStats();
+    expect(stats.hits, 6);
+    expect(stats.bytesSaved, 4096);
+    expect(stats.evictions, 0);
+    expect(stats.hitRatio, 0.8);
+
+    await platform.clearHttpCache();
+    expect(log.last.method, 'clearHttpCache');
+  });
+
+  test('configureCompression and compressionStats', () async {
+    await platform.configureCompression(
+        host: 'api.example.com',
+        accept: ['zstd', 'gzip'],
+        requestEncoding: 'gzip',
+        minRequestBytes: 2048);
+    expect(log.single.method, 'configureCompression');
+    expect(log.single.arguments, {
+      'host': 'api.example.com',
+      'accept': ['zstd', 'gzip'],
+      'requestEncoding': 'gzip',
+      'minRequestBytes': 2048,
+    });
+
+    final stats = await platform.compressionStats(host: 'api.example.com');
+    expect(log.last.arguments, {'host': 'api.example.com'});
+    expect(stats.responsesDecoded, 3);
+    expect(stats.decodeCpu, const Duration(microseconds: 250));
+    expect(stats.bytesSaved, 3000);
+    expect(stats.responseRatio, 0.25);
+    expect(stats.requestsRefused, 0);
+  });
+
+  test('downloadProgress decodes updates', () async {
+    const EventChannel downloads =
+        EventChannel('flutter_cookie_bridge/downloads');
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(
+      downloads,
+      MockStreamHandler.inline(onListen: (arguments, events) {
+        events.success({
+          'id': '3',
+          'received': 50,
+          'total': 200,
+          'bytesPerSecond': 1000.0,
+          'done': false,
+        });
+      }),
+    );
+
+    final progress = await platform.downloadProgress().first;
+    expect(progress.id, '3');
+    expect(progress.fraction, 0.25);
+    expect(progress.done, isFalse);
+    expect(progress.sha256, isNull);
+
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(downloads, null);
+  });
+
+  test('cookieChanges decodes deltas and passes the version', () async {
+    const EventChannel changes =
+        EventChannel('flutter_cookie_bridge/cookie_changes');
+    Object? listenArguments;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(
+      changes,
+      MockStreamHandler.inline(onListen: (arguments, events) {
+        listenArguments = arguments;
+        events.success({
+          'version': 8,
+          'reset': false,
+          'changes': [
+            {
+              'name': 'sid',
+              'value': '',
+              'domain': 'example.com',
+              'path': '/',
+              'removed': true,
+            },
+          ],
+        });
+      }),
+    );
+
+    final delta = await platform.cookieChanges(since: 5).first;
+    expect(listenArguments, 5);
+    expect(delta.version, 8);
+    expect(delta.reset, isFalse);
+    expect(delta.changes.single.name, 'sid');
+    expect(delta.changes.single.removed, isTrue);
+    expect(delta.changes.single.appliesTo('api.example.com'), isTrue);
+    expect(delta.changes.single.appliesTo('notexample.com'), isFalse);
+
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(changes, null);
+  });
 }
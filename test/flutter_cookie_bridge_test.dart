@@ -1,7 +1,12 @@
+import 'dart:typed_data';
+
 import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/cookie_changes.dart';
+import 'package:flutter_cookie_bridge/download_manager.dart';
 import 'package:flutter_cookie_bridge/flutter_cookie_bridge.dart';
 import 'package:flutter_cookie_bridge/flutter_cookie_bridge_platform_interface.dart';
 import 'package:flutter_cookie_bridge/flutter_cookie_bridge_method_channel.dart';
+import 'package:flutter_cookie_bridge/native_http_client_adapter.dart';
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 class MockFlutterCookieBridgePlatform
@@ -9,6 +14,77 @@ class MockFlutterCookieBridgePlatform
     implements FlutterCookieBridgePlatform {
   @override
   Future<String?> getPlatformVersion() => Future.value('42');
+
+  @override
+  Future<void> setCookies(String url, List<String> setCookieHeaders) =>
+      Future.value();
+
+  @override
+  Future<int> syncCookies(String url, Map<String, String> cookies) =>
+      Future.value(cookies.length);
+
+  @override
+  Future<String?> getCookieHeader(String url) => Future.value('sid=42');
+
+  @override
+  Future<List<String>> getCookies() => Future.value(['sid=42']);
+
+  @override
+  Future<void> clearCookies() => Future.value();
+
+  @override
+  Future<void> switchCookiePartition(String name, {String? from}) =>
+      Future.value();
+
+  @override
+  Future<bool> deleteCookiePartition(String name) => Future.value(true);
+
+  @override
+  Stream<CookieDelta> cookieChanges({int? since}) => const Stream.empty();
+
+  @override
+  Future<DownloadResult> download(String url, String path,
+          {Map<String, String> headers = const {},
+          String? id,
+          Duration? progressInterval}) =>
+      Future.value(DownloadResult(path: path, bytes: 0));
+
+  @override
+  Stream<DownloadProgress> downloadProgress() => const Stream.empty();
+
+  @override
+  Future<NativeHttpResponse> httpRequest(String method, String url,
+          {Map<String, String> headers = const {},
+          Uint8List? body,
+          Duration? timeout,
+          bool cache = false,
+          bool json = false}) =>
+      Future.value(NativeHttpResponse(status: 200, body: Uint8List(0)));
+
+  @override
+  Future<void> configureHttpCache({required bool enabled, int? maxBytes}) =>
+      Future.value();
+
+  @override
+  Future<HttpCacheStats> httpCacheStats() => Future.value(
+      const HttpCacheStats(lookups: 4, hits: 2, revalidations: 1));
+
+  @override
+  Future<void> clearHttpCache() => Future.value();
+
+  @override
+  Future<void> configureCompression(
+          {String? host,
+          List<String>? accept,
+          String? requestEncoding,
+          int? minRequestBytes,
+          int? level,
+          bool reset = false}) =>
+      Future.value();
+
+  @override
+  Future<CompressionStats> compressionStats({String? host}) =>
+      Future.value(const CompressionStats(responses: 2));
 }
 
 void main() {
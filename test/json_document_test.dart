@@ -0,0 +1,125 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/json_document.dart';
+import 'package:flutter_cookie_bridge/lazy_json_transformer.dart';
+
+// Answers every request with [body] as [contentType].
+class FixedAdapter implements HttpClientAdapter {
+  FixedAdapter(this.body, this.contentType);
+
+  final String body;
+  final String contentType;
+
+  @override
+  Future<ResponseBody> fetch(RequestOptions options,
+      Stream<Uint8List>? requestStream, Future<void>? cancelFuture) async {
+    return ResponseBody.fromString(body, 200, headers: {
+      Headers.contentTypeHeader: [contentType],
+    });
+  }
+
+  @override
+  void close({bool force = false}) {}
+}
+
+void main() {
+  const text = '{"account": "XX1234", "balance": -1520.75, "count": 2,'
+      ' "open": true, "note": null, "name": "Café ☕",'
+      ' "items": [{"id": 9007199254740993, "tags": []}, {"id": 2}]}';
+
+  test('reads values off the tape without building the rest', () {
+    final document = JsonDocument.fromValue(jsonDecode(text));
+    final root = document.root;
+    expect(root.type, JsonType.object);
+    expect(root.length, 7);
+    expect(root.keys.toList(),
+        ['account', 'balance', 'count', 'open', 'note', 'name', 'items']);
+    expect(root['account']!.asString, 'XX1234');
+    expect(root['balance']!.asDouble, -1520.75);
+    expect(root['count']!.asInt, 2);
+    expect(root['count']!.asDouble, 2.0);
+    expect(root['open']!.asBool, isTrue);
+    expect(root['note']!.isNull, isTrue);
+    expect(root['name']!.asString, 'Café ☕');
+    expect(root['missing'], isNull);
+    expect(root[0], isNull);
+
+    final items = root['items']!;
+    expect(items.type, JsonType.array);
+    expect(items[0]!['id']!.asInt, 9007199254740993);
+    expect(items[0]!['tags']!.length, 0);
+    expect(items[1]!['id']!.asInt, 2);
+    expect(items[2], isNull);
+    expect(items.children.map((item) => item['id']!.asInt),
+        [9007199254740993, 2]);
+  });
+
+  test('builds what jsonDecode builds', () {
+    final decoded = jsonDecode(text);
+    expect(JsonDocument.fromValue(decoded).toObject(), decoded);
+    for (final value in [null, true, 0, -0.5, '', [], {}]) {
+      expect(JsonDocument.fromValue(value).toObject(), value);
+    }
+  });
+
+  test('decodes on another isolate', () async {
+    final document =
+        await JsonDocument.decode(Uint8List.fromList(utf8.encode(text)));
+    expect(document.toObject(), jsonDecode(text));
+  });
+
+  test('reads a tape from the native transport', () {
+    // {"a": [1]} as the native parser writes it.
+    final tape = Int64List.fromList([
+      0x7b << 56 | 8,
+      1,
+      0x73 << 56 | 0,
+      1,
+      0x5b << 56 | 8,
+      1,
+      0x6c << 56,
+      1,
+    ]);
+    final strings = Uint8List.fromList([0x61]);
+    expect(JsonDocument(tape, strings).toObject(), {
+      'a': [1],
+    });
+  });
+
+  group('LazyJsonTransformer', () {
+    late Dio dio;
+
+    setUp(() {
+      dio = Dio()..transformer = LazyJsonTransformer();
+    });
+
+    test('hands over a document when asked to', () async {
+      dio.httpClientAdapter = FixedAdapter(text, 'application/json');
+      final lazy = await dio.get('https://example.com/',
+          options: Options(extra: {'lazyJson': true}));
+      expect(lazy.data, isA<JsonDocument>());
+      expect((lazy.data as JsonDocument).root['count']!.asInt, 2);
+
+      final eager = await dio.get('https://example.com/');
+      expect(eager.data, jsonDecode(text));
+    });
+
+    test('passes on a document parsed natively', () async {
+      final document = JsonDocument.fromValue({'a': 1});
+      final body = JsonDocumentResponseBody(document, 200);
+      final data = await LazyJsonTransformer().transformResponse(
+          RequestOptions(extra: {'lazyJson': true}), body);
+      expect(identical(data, document), isTrue);
+    });
+
+    test('leaves other bodies as they are', () async {
+      dio.httpClientAdapter = FixedAdapter('<html></html>', 'text/html');
+      final response = await dio.get('https://example.com/',
+          options: Options(extra: {'lazyJson': true}));
+      expect(response.data, '<html></html>');
+    });
+  });
+}
@@ -0,0 +1,130 @@
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/flutter_cookie_bridge_platform_interface.dart';
+import 'package:flutter_cookie_bridge/native_http_client_adapter.dart';
+import 'package:plugin_platform_interface/plugin_platform_interface.dart';
+
+// Answers requests from [routes], keyed by URL, and records their headers.
+class RedirectingPlatform extends FlutterCookieBridgePlatform
+    with MockPlatformInterfaceMixin {
+  RedirectingPlatform(this.routes);
+
+  final Map<String, NativeHttpResponse> routes;
+  final List<MapEntry<String, Map<String, String>>> requests = [];
+
+  @override
+  Future<NativeHttpResponse> httpRequest(String method, String url,
+      {Map<String, String> headers = const {},
+      Uint8List? body,
+      Duration? timeout,
+      bool cache = false,
+      bool json = false}) async {
+    requests.add(MapEntry(url, Map.of(headers)));
+    return routes[url]!;
+  }
+}
+
+NativeHttpResponse _redirect(String location) => NativeHttpResponse(
+    status: 302,
+    headers: {
+      'location': [location],
+    },
+    body: Uint8List(0));
+
+// The value of header [name], whatever the case Dio passed it in.
+String? _header(Map<String, String> headers, String name) {
+  for (final entry in headers.entries) {
+    if (entry.key.toLowerCase() == name.toLowerCase()) {
+      return entry.value;
+    }
+  }
+  return null;
+}
+
+final NativeHttpResponse _ok =
+    NativeHttpResponse(status: 200, body: Uint8List.fromList([111, 107]));
+
+void main() {
+  final FlutterCookieBridgePlatform initialPlatform =
+      FlutterCookieBridgePlatform.instance;
+  late RedirectingPlatform platform;
+
+  setUp(() {
+    platform = RedirectingPlatform({
+      'https://bank.example.com/login':
+          _redirect('https://bank.example.com/home'),
+      'https://bank.example.com/home':
+          _redirect('https://tracker.example.net/pixel'),
+      'https://tracker.example.net/pixel': _ok,
+    });
+    FlutterCookieBridgePlatform.instance = platform;
+  });
+
+  tearDown(() {
+    FlutterCookieBridgePlatform.instance = initialPlatform;
+  });
+
+  Future<Response> get(NativeHttpClientAdapter adapter) {
+    final dio = Dio()..httpClientAdapter = adapter;
+    return dio.get('https://bank.example.com/login',
+        options: Options(responseType: ResponseType.plain, headers: {
+          'Cookie': 'sid=secret',
+          'Authorization': 'Bearer token',
+          'X-Request-Id': '7',
+        }));
+  }
+
+  test('drops credentials on a redirect to another origin', () async {
+    final response = await get(NativeHttpClientAdapter());
+    expect(response.data, 'ok');
+    expect(response.redirects, hasLength(2));
+
+    final sameOrigin = platform.requests[1].value;
+    expect(_header(sameOrigin, 'Cookie'), 'sid=secret');
+    expect(_header(sameOrigin, 'Authorization'), 'Bearer token');
+
+    final crossOrigin = platform.requests[2];
+    expect(crossOrigin.key, 'https://tracker.example.net/pixel');
+    expect(_header(crossOrigin.value, 'Cookie'), isNull);
+    expect(_header(crossOrigin.value, 'Authorization'), isNull);
+    expect(_header(crossOrigin.value, 'X-Request-Id'), '7');
+  });
+
+  test('looks up the cookies of every hop', () async {
+    final asked = <String>[];
+    await get(NativeHttpClientAdapter(cookiesFor: (url) async {
+      asked.add(url);
+      return Uri.parse(url).host == 'tracker.example.net' ? 'tid=1' : null;
+    }));
+    expect(asked, [
+      'https://bank.example.com/home',
+      'https://tracker.example.net/pixel',
+    ]);
+    expect(_header(platform.requests[1].value, 'Cookie'), 'sid=secret');
+    expect(_header(platform.requests[2].value, 'Cookie'), 'tid=1');
+    expect(_header(platform.requests[2].value, 'Authorization'), isNull);
+  });
+
+  test('stores the cookies of a redirect before following it', () async {
+    platform.routes['https://bank.example.com/login'] = NativeHttpResponse(
+        status: 302,
+        headers: {
+          'location': ['https://bank.example.com/home'],
+          'set-cookie': ['session=fresh; Path=/; HttpOnly'],
+        },
+        body: Uint8List(0));
+    final stored = <String, List<String>>{};
+    final jar = <String, String>{};
+    await get(NativeHttpClientAdapter(storeCookies: (url, headers) async {
+      stored[url] = headers;
+      jar[Uri.parse(url).host] = headers.first.split(';').first;
+    }, cookiesFor: (url) async => jar[Uri.parse(url).host]));
+    expect(stored, {
+      'https://bank.example.com/login': ['session=fresh; Path=/; HttpOnly'],
+    });
+    expect(_header(platform.requests[1].value, 'Cookie'), 'session=fresh');
+    expect(_header(platform.requests[2].value, 'Cookie'), isNull);
+  });
+}
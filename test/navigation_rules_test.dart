@@ -0,0 +1,83 @@
+import 'dart:math';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/navigation_rules.dart';
+
+void main() {
+  const android = ['bank.example.com', 'kyc.partner.in/'];
+  const ios = ['bank.example.com'];
+  final rules = NavigationRules(
+    whitelistedUrlsAndroid: android,
+    whitelistedUrlsIos: ios,
+    hostName: 'app.example.com',
+    karzaDomain: 'sbmkyc',
+  );
+
+  test('finds the fixed rules', () {
+    expect(rules.match('ms-outlook://inbox').outlookIntent, isTrue);
+    expect(rules.match('googlegmail://co').gmailIntent, isTrue);
+    expect(rules.match('ymail://').yahooMailIntent, isTrue);
+    expect(rules.match('https://x.in/redirect?status=OK').statusRedirect,
+        isTrue);
+    expect(
+        rules.match('https://x.in/session-expired?status=1').statusRedirect,
+        isTrue);
+    expect(rules.match('https://x.in/api/user/redirect').sessionExpired,
+        isTrue);
+    expect(rules.match('https://x.in/statements/may').download, isTrue);
+    expect(rules.match('https://x.in/logo.png').download, isTrue);
+    expect(rules.match('about:blank').aboutBlank, isTrue);
+    expect(rules.match('https://sbmkyc.karza.in/start').karza, isTrue);
+
+    final plain = rules.match('https://other.org/home');
+    expect(plain.outlookIntent || plain.statusRedirect || plain.download,
+        isFalse);
+    expect(plain.allowedOnAndroid || plain.allowedOnIos || plain.karza,
+        isFalse);
+  });
+
+  test('allows whitelisted urls and the host name per platform', () {
+    expect(rules.match('https://kyc.partner.in/step').allowedOnAndroid, isTrue);
+    expect(rules.match('https://kyc.partner.in/step').allowedOnIos, isFalse);
+    expect(rules.match('https://bank.example.com/').allowedOnIos, isTrue);
+    final host = rules.match('https://app.example.com/');
+    expect(host.allowedOnAndroid, isTrue);
+    expect(host.allowedOnIos, isTrue);
+
+    // On Android the host name only counts alongside a whitelist.
+    final iosOnly = NavigationRules(
+        hostName: 'app.example.com', karzaDomain: 'sbmkyc');
+    expect(iosOnly.match('https://app.example.com/').allowedOnAndroid, isFalse);
+    expect(iosOnly.match('https://app.example.com/').allowedOnIos, isTrue);
+  });
+
+  test('agrees with checking every rule on its own', () {
+    final random = Random(5);
+    String text(int maxLength) => String.fromCharCodes(List.generate(
+        random.nextInt(maxLength + 1),
+        (_) => 'ab/.é'.codeUnitAt(random.nextInt(5))));
+    for (int round = 0; round < 30; round++) {
+      final android = List.generate(20, (_) => text(5));
+      final ios = List.generate(20, (_) => text(5));
+      final hostName = text(4);
+      final rules = NavigationRules(
+        whitelistedUrlsAndroid: android,
+        whitelistedUrlsIos: ios,
+        hostName: hostName,
+        karzaDomain: 'b/a',
+      );
+      for (int i = 0; i < 50; i++) {
+        final url = text(30);
+        final hostMatch = hostName.isNotEmpty && url.contains(hostName);
+        final match = rules.match(url);
+        expect(match.allowedOnAndroid,
+            android.any((white) => url.contains(white) || hostMatch),
+            reason: url);
+        expect(match.allowedOnIos,
+            ios.any((white) => url.contains(white)) || hostMatch,
+            reason: url);
+        expect(match.karza, url.contains('b/a'), reason: url);
+      }
+    }
+  });
+}
@@ -0,0 +1,128 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/network_manager.dart';
+import 'package:flutter_cookie_bridge/session_manager.dart';
+
+class FakeSessionManager implements SessionManager {
+  final List<List<String>> stored = [];
+  final List<String> storedFor = [];
+
+  @override
+  Future<String?> getCookieHeader(String url) => Future.value('sid=1');
+
+  @override
+  Future<void> saveSessionCookies(List<String> cookies) => Future.value();
+
+  @override
+  Future<void> storeResponseCookies(
+      String url, List<String> setCookieHeaders) async {
+    stored.add(setCookieHeaders);
+    storedFor.add(url);
+  }
+
+  @override
+  dynamic noSuchMethod(Invocation invocation) => super.noSuchMethod(invocation);
+}
+
+// Holds every response until [release], so that requests overlap.
+class GatedAdapter implements HttpClientAdapter {
+  final List<RequestOptions> requests = [];
+  final Completer<void> _gate = Completer<void>();
+
+  void release() => _gate.complete();
+
+  @override
+  Future<ResponseBody> fetch(RequestOptions options,
+      Stream<Uint8List>? requestStream, Future<void>? cancelFuture) async {
+    requests.add(options);
+    await _gate.future;
+    return ResponseBody.fromString('ok', 200, headers: {
+      'set-cookie': ['sid=2; Path=/'],
+    });
+  }
+
+  @override
+  void close({bool force = false}) {}
+}
+
+// Answers as if the request had been redirected to [location].
+class RedirectedAdapter implements HttpClientAdapter {
+  RedirectedAdapter(this.location);
+
+  final Uri location;
+
+  @override
+  Future<ResponseBody> fetch(RequestOptions options,
+      Stream<Uint8List>? requestStream, Future<void>? cancelFuture) async {
+    return ResponseBody.fromString('ok', 200,
+        headers: {
+          'set-cookie': ['sid=3; Path=/'],
+        },
+        isRedirect: true,
+        redirects: [RedirectRecord(302, 'GET', location)]);
+  }
+
+  @override
+  void close({bool force = false}) {}
+}
+
+void main() {
+  late FakeSessionManager session;
+  late NetworkManager manager;
+  late GatedAdapter adapter;
+
+  setUp(() {
+    session = FakeSessionManager();
+    manager = NetworkManager(sessionManager: session);
+    adapter = GatedAdapter();
+    manager.dio.httpClientAdapter = adapter;
+  });
+
+  test('identical concurrent GETs share one request', () async {
+    final before = manager.coalescedGets;
+    final responses = [
+      for (int i = 0; i < 3; i++) manager.get('https://example.com/me'),
+    ];
+    await Future<void>.delayed(Duration.zero);
+    adapter.release();
+    final results = await Future.wait(responses);
+
+    expect(adapter.requests, hasLength(1));
+    expect(adapter.requests.single.headers['Cookie'], 'sid=1');
+    expect(results.map((r) => r?.statusCode), [200, 200, 200]);
+    expect(session.stored, hasLength(1));
+    expect(manager.coalescedGets - before, 2);
+  });
+
+  test('GETs that differ are sent separately', () async {
+    final responses = [
+      manager.get('https://example.com/me'),
+      manager.get('https://example.com/me', headers: {'Accept': 'text/html'}),
+      manager.get('https://example.com/other'),
+      manager.post('https://example.com/me', {}),
+    ];
+    await Future<void>.delayed(Duration.zero);
+    adapter.release();
+    await Future.wait(responses);
+
+    expect(adapter.requests, hasLength(4));
+    expect(session.stored, hasLength(4));
+  });
+
+  test('a GET after the last one finished is sent again', () async {
+    adapter.release();
+    await manager.get('https://example.com/me');
+    await manager.get('https://example.com/me');
+    expect(adapter.requests, hasLength(2));
+  });
+
+  test('cookies of a redirected response go to the final URL', () async {
+    manager.dio.httpClientAdapter =
+        RedirectedAdapter(Uri.parse('https://auth.example.net/done'));
+    await manager.get('https://example.com/login');
+    expect(session.storedFor, ['https://auth.example.net/done']);
+  });
+}
@@ -0,0 +1,199 @@
+import 'dart:async';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/request_scheduler.dart';
+
+// Stands in for a server that takes [connections] requests at once and
+// answers each after a latency; further requests wait for a connection, as
+// they would on a saturated link.
+class LatencyServer {
+  LatencyServer({required this.connections});
+
+  final int connections;
+  int _busy = 0;
+  final List<Completer<void>> _waiting = [];
+
+  Future<void> serve(Duration latency) async {
+    if (_busy < connections) {
+      _busy++;
+    } else {
+      final turn = Completer<void>();
+      _waiting.add(turn);
+      await turn.future;
+    }
+    try {
+      await Future<void>.delayed(latency);
+    } finally {
+      if (_waiting.isNotEmpty) {
+        _waiting.removeAt(0).complete();
+      } else {
+        _busy--;
+      }
+    }
+  }
+}
+
+Duration percentile(List<Duration> samples, double fraction) {
+  final sorted = [...samples]..sort();
+  return sorted[((sorted.length - 1) * fraction).round()];
+}
+
+void main() {
+  // Records the order in which scheduled requests start, holding each open
+  // until released.
+  late List<String> started;
+  late Map<String, Completer<void>> open;
+  Future<void> hold(String name) {
+    started.add(name);
+    return (open[name] = Completer<void>()).future;
+  }
+
+  setUp(() {
+    started = [];
+    open = {};
+  });
+
+  test('picks lanes by priority when a slot frees up', () async {
+    final scheduler =
+        RequestScheduler(maxPerHost: 1, reservedForInteractive: 0);
+    const url = 'https://example.com/';
+    final requests = [
+      scheduler.schedule(url, RequestPriority.normal, () => hold('first')),
+      scheduler.schedule(url, RequestPriority.background, () => hold('b')),
+      scheduler.schedule(url, RequestPriority.normal, () => hold('n')),
+      scheduler.schedule(url, RequestPriority.interactive, () => hold('i')),
+    ];
+    expect(started, ['first']);
+    expect(scheduler.stats()[RequestPriority.background]!.queued, 1);
+
+    for (final name in ['first', 'i', 'n', 'b']) {
+      expect(started.last, name);
+      open[name]!.complete();
+      await Future<void>.delayed(Duration.zero);
+    }
+    await Future.wait(requests);
+    expect(started, ['first', 'i', 'n', 'b']);
+    final stats = scheduler.stats();
+    expect(stats[RequestPriority.normal]!.started, 2);
+    expect(stats[RequestPriority.normal]!.maxQueued, 1);
+    expect(stats[RequestPriority.background]!.queued, 0);
+  });
+
+  test('does not starve the background lane', () async {
+    final scheduler =
+        RequestScheduler(maxPerHost: 1, reservedForInteractive: 0);
+    const url = 'https://example.com/';
+    scheduler.schedule(url, RequestPriority.background, () => hold('b0'));
+    scheduler.schedule(url, RequestPriority.background, () => hold('b1'));
+    for (int i = 0; i < 20; i++) {
+      scheduler.schedule(url, RequestPriority.interactive, () => hold('i$i'));
+    }
+    while (started.length < 22) {
+      open[started.last]!.complete();
+      await Future<void>.delayed(Duration.zero);
+    }
+    // Weighted 8 to 1, the second background request gets one of the nine
+    // turns after the first rather than waiting for all twenty interactive
+    // ones.
+    expect(started.indexOf('b1'), lessThanOrEqualTo(10));
+  });
+
+  test('limits each host and keeps a slot for interactive requests',
+      () async {
+    final scheduler =
+        RequestScheduler(maxPerHost: 2, reservedForInteractive: 1);
+    for (int i = 0; i < 3; i++) {
+      scheduler.schedule(
+          'https://a.example/', RequestPriority.background, () => hold('a$i'));
+    }
+    scheduler.schedule(
+        'https://b.example/', RequestPriority.background, () => hold('b'));
+    // One background request per host, since the second slot is reserved.
+    expect(started, ['a0', 'b']);
+    expect(scheduler.inFlightFor('https://a.example/x'), 1);
+
+    scheduler.schedule(
+        'https://a.example/', RequestPriority.interactive, () => hold('tap'));
+    expect(started, ['a0', 'b', 'tap']);
+    expect(scheduler.inFlightFor('https://a.example/'), 2);
+
+    // The reserved slot is still taken, so the next background request
+    // waits for it.
+    open['a0']!.complete();
+    await Future<void>.delayed(Duration.zero);
+    expect(started.last, 'tap');
+    open['tap']!.complete();
+    await Future<void>.delayed(Duration.zero);
+    expect(started.last, 'a1');
+  });
+
+  test('passes results and errors through', () async {
+    final scheduler = RequestScheduler();
+    expect(
+        await scheduler.schedule(
+            'https://example.com/', RequestPriority.normal, () async => 42),
+        42);
+    await expectLater(
+        scheduler.schedule('https://example.com/', RequestPriority.normal,
+            () => Future<int>.error(StateError('failed'))),
+        throwsStateError);
+    await Future<void>.delayed(Duration.zero);
+    expect(scheduler.inFlightFor('https://example.com/'), 0);
+  });
+
+  // Interactive requests every 10 ms while background transfers saturate a
+  // server that serves four at a time: sent straight away they queue behind
+  // the transfers, scheduled they keep their latency from an idle server.
+  test('keeps interactive latency flat under background load', () async {
+    const interactive = Duration(milliseconds: 5);
+    const transfer = Duration(milliseconds: 100);
+    const url = 'https://api.example/';
+
+    Future<List<Duration>> run(
+        {required bool loaded, RequestScheduler? scheduler}) async {
+      final server = LatencyServer(connections: 4);
+      Future<void> send(RequestPriority priority, Duration latency) =>
+          scheduler == null
+              ? server.serve(latency)
+              : scheduler.schedule(
+                  url, priority, () => server.serve(latency));
+
+      final background = [
+        if (loaded)
+          for (int i = 0; i < 24; i++)
+            send(RequestPriority.background, transfer),
+      ];
+      final latencies = <Duration>[];
+      final taps = <Future<void>>[];
+      for (int i = 0; i < 40; i++) {
+        final clock = Stopwatch()..start();
+        taps.add(send(RequestPriority.interactive, interactive)
+            .then((_) => latencies.add(clock.elapsed)));
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+      await Future.wait([...taps, ...background]);
+      return latencies;
+    }
+
+    final idle = await run(loaded: false);
+    final unscheduled = await run(loaded: true);
+    final scheduler =
+        RequestScheduler(maxPerHost: 4, reservedForInteractive: 1);
+    final scheduled = await run(loaded: true, scheduler: scheduler);
+
+    String summary(List<Duration> samples) =>
+        'p50 ${percentile(samples, 0.5).inMilliseconds} ms, '
+        'p99 ${percentile(samples, 0.99).inMilliseconds} ms';
+    // ignore: avoid_print
+    print('interactive, idle server:     ${summary(idle)}\n'
+        'interactive, unscheduled:     ${summary(unscheduled)}\n'
+        'interactive, scheduled:       ${summary(scheduled)}\n'
+        'background lane: ${scheduler.stats()[RequestPriority.background]}');
+
+    expect(percentile(unscheduled, 0.99), greaterThan(transfer));
+    expect(percentile(scheduled, 0.99),
+        lessThan(percentile(idle, 0.99) + const Duration(milliseconds: 20)));
+    expect(scheduler.stats()[RequestPriority.background]!.maxQueued,
+        greaterThan(0));
+  });
+}
@@ -0,0 +1,35 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_cookie_bridge/set_cookie_parser.dart';
+
+void main() {
+  test('parses attributes of a set-cookie header', () {
+    final cookies = SetCookieParser.parseAll([
+      'sid=abc=def; Domain=.example.com; Path=/api; '
+          'Expires=Wed, 21 Oct 2015 07:28:00 GMT; Secure; HttpOnly; '
+          'SameSite=Strict',
+      'broken',
+      'gone=; Max-Age=0',
+    ]);
+
+    expect(cookies, hasLength(3));
+    final sid = cookies[0]!;
+    expect(sid.pair, 'sid=abc=def');
+    expect(sid.domain, '.example.com');
+    expect(sid.path, '/api');
+    expect(sid.expires, DateTime.utc(2015, 10, 21, 7, 28));
+    expect(sid.secure, isTrue);
+    expect(sid.httpOnly, isTrue);
+    expect(sid.sameSite, SameSite.strict);
+    expect(sid.isExpired, isTrue);
+
+    expect(cookies[1], isNull);
+    expect(cookies[2]!.maxAge, 0);
+    expect(cookies[2]!.isExpired, isTrue);
+  });
+
+  test('splits a cookie header into pairs', () {
+    final pairs = SetCookieParser.parseCookieHeader('a=1; b = two ;x; c=x=y');
+    expect(pairs.map((e) => '${e.key}:${e.value}'),
+        ['a:1', 'b:two', 'c:x=y']);
+  });
+}